@@ -12,13 +12,15 @@ include(../core/sharedCore.pro)
 
 SOURCES += main.cpp \
     Session.cpp \
+    ../core/objects/finders/benchmark/Bvh.cpp \
     ../core/objects/finders/benchmark/Finders.cpp \
     ../core/sph/kernel/benchmark/Kernel.cpp \
     ../core/gravity/benchmark/Gravity.cpp \
     ../core/gravity/benchmark/NBodySolver.cpp \
     ../core/objects/containers/benchmark/Map.cpp \
     ../core/sph/solvers/benchmark/Solvers.cpp \
-    ../core/timestepping/benchmark/Timestepping.cpp
+    ../core/timestepping/benchmark/Timestepping.cpp \
+    ../core/thread/benchmark/Scheduler.cpp
 
 HEADERS += \
     Session.h \
@@ -54,7 +54,7 @@ int main(int argc, char** argv) {
     storage.remove(idxs, Storage::IndicesFlag::INDICES_SORTED);
 
     m = storage.getValue<Float>(QuantityId::MASS);
-    Array<Size> comp = Post::findLargestComponent(storage, 1._f, EMPTY_FLAGS);
+    Array<Size> comp = Post::findLargestComponent(SEQUENTIAL, storage, 1._f, EMPTY_FLAGS);
     Float m_core = 0._f;
     for (Size i : comp) {
         m_core += m[i];
@@ -100,7 +100,7 @@ int main(int argc, char** argv) {
         }
         storage.remove(idxs, Storage::IndicesFlag::INDICES_SORTED);
         Array<Size> comps;
-        Post::findComponents(storage, 1._f, Post::ComponentFlag::SORT_BY_MASS, comps);
+        Post::findComponents(SEQUENTIAL, storage, 1._f, Post::ComponentFlag::SORT_BY_MASS, comps);
 
         Size comp1 = std::count(comps.begin(), comps.end(), 0);
         Size comp2 = std::count(comps.begin(), comps.end(), 1);
@@ -8,23 +8,29 @@ SOURCES += \
     common/Assert.cpp \
     gravity/AggregateSolver.cpp \
     gravity/BarnesHut.cpp \
+    gravity/FastMultipole.cpp \
     gravity/Handoff.cpp \
     gravity/NBodySolver.cpp \
+    io/AsyncOutput.cpp \
     io/FileManager.cpp \
     io/FileSystem.cpp \
+    io/FloatCodec.cpp \
     io/Logger.cpp \
     io/Output.cpp \
     io/Path.cpp \
+    io/TextIo.cpp \
     io/Vdb.cpp \
     math/Curve.cpp \
     math/Morton.cpp \
     math/SparseMatrix.cpp \
     math/rng/Rng.cpp \
     objects/containers/String.cpp \
+    objects/finders/ColoredGrid.cpp \
     objects/finders/HashMapFinder.cpp \
     objects/finders/IncrementalFinder.cpp \
     objects/finders/KdTree.cpp \
     objects/finders/NeighborFinder.cpp \
+    objects/finders/NeighborList.cpp \
     objects/finders/PeriodicFinder.cpp \
     objects/finders/UniformGrid.cpp \
     objects/geometry/Delaunay.cpp \
@@ -84,6 +90,7 @@ SOURCES += \
     sph/initial/Stellar.cpp \
 	sph/initial/Equilibrium.cpp \
     sph/initial/UvMapping.cpp \
+    sph/kernel/Kernel.cpp \
     sph/solvers/AsymmetricSolver.cpp \
     sph/solvers/EnergyConservingSolver.cpp \
     sph/solvers/EquilibriumSolver.cpp \
@@ -103,10 +110,12 @@ SOURCES += \
     system/Timer.cpp \
     tests/Setup.cpp \
     thread/CheckFunction.cpp \
+    thread/Numa.cpp \
     thread/OpenMp.cpp \
     thread/Pool.cpp \
     thread/Scheduler.cpp \
     thread/Tbb.cpp \
+    thread/WorkStealing.cpp \
     timestepping/TimeStepCriterion.cpp \
     timestepping/TimeStepping.cpp \
     io/LogWriter.cpp \
@@ -126,20 +135,24 @@ HEADERS += \
     gravity/BruteForceGravity.h \
     gravity/CachedGravity.h \
     gravity/Collision.h \
+    gravity/FastMultipole.h \
     gravity/Handoff.h \
     gravity/IGravity.h \
     gravity/Moments.h \
     gravity/NBodySolver.h \
     gravity/SphericalGravity.h \
     gravity/SymmetricGravity.h \
+    io/AsyncOutput.h \
     io/Column.h \
     io/FileManager.h \
     io/FileSystem.h \
+    io/FloatCodec.h \
     io/Logger.h \
     io/Output.h \
     io/Path.h \
     io/Serializer.h \
     io/Table.h \
+    io/TextIo.h \
     io/Vdb.h \
     math/AffineMatrix.h \
     math/Curve.h \
@@ -159,6 +172,7 @@ HEADERS += \
     objects/containers/Tags.h \
     objects/finders/IncrementalFinder.h \
     objects/finders/NeighborFinder.h \
+    objects/finders/NeighborList.h \
     objects/geometry/Delaunay.h \
     objects/geometry/Plane.h \
     objects/utility/OutputIterators.h \
@@ -192,6 +206,7 @@ HEADERS += \
     objects/finders/BruteForceFinder.h \
     objects/finders/Bvh.h \
     objects/finders/Bvh.inl.h \
+    objects/finders/ColoredGrid.h \
     objects/finders/HashMapFinder.h \
     objects/finders/KdTree.h \
     objects/finders/KdTree.inl.h \
@@ -284,6 +299,7 @@ HEADERS += \
     sph/equations/DeltaSph.h \
     sph/equations/Derivative.h \
     sph/equations/DerivativeHelpers.h \
+    sph/equations/FusedDerivative.h \
     sph/equations/EquationTerm.h \
     sph/equations/Fluids.h \
     sph/equations/Friction.h \
@@ -342,11 +358,13 @@ HEADERS += \
     tests/Setup.h \
     thread/AtomicFloat.h \
     thread/CheckFunction.h \
+    thread/Numa.h \
     thread/OpenMp.h \
     thread/Pool.h \
     thread/Scheduler.h \
     thread/Tbb.h \
     thread/ThreadLocal.h \
+    thread/WorkStealing.h \
     timestepping/ISolver.h \
     timestepping/ISolverr.h \
     timestepping/TimeStepCriterion.h \
@@ -9,469 +9,384 @@
 #include "system/Factory.h"
 #include "system/Statistics.h"
 #include "thread/CheckFunction.h"
+#include <map>
 #include <mutex>
 
 NAMESPACE_SPH_BEGIN
 
 const Vector MAX_SPIN = Vector(0.1_f);
 
-/// \brief Aggregate of particles, moving as a rigid body according to Euler's equations.
-///
-/// \todo
-/// Not owning the particles, bound to a \ref Storage object. Not compatible with mergers.
-class Aggregate : public Noncopyable {
-private:
-    RawPtr<Storage> storage;
-
-    /// Indices of particles belonging to this aggregate
-    /// \todo check performance compared to std::set
-    FlatSet<Size> idxs;
+namespace {
 
-    /// Index of the aggregate. Does not generally correspond to the index of the aggregate in the parent \ref
-    /// AggregateHolder.
-    Size persistentId;
-
-public:
-    /// Needed due to resize
-    Aggregate() = default;
-
-    /// Single particle
-    Aggregate(Storage& storage, const Size particleIdx)
-        : storage(addressOf(storage)) {
-        idxs.insert(particleIdx);
-        persistentId = particleIdx;
-    }
-
-    explicit Aggregate(Storage& storage, IndexSequence seq)
-        : storage(addressOf(storage)) {
-        for (Size i : seq) {
-            idxs.insert(i);
-        }
-        persistentId = *seq.begin();
-    }
-
-    void add(const Size idx) {
-        SPH_ASSERT(!idxs.contains(idx));
-        idxs.insert(idx);
-        //        this->fixVelocities();
-    }
-
-    void remove(const Size idx) {
-        idxs.erase(idxs.find(idx));
-    }
-
-    void clear() {
-        idxs.clear();
-    }
-
-    bool contains(const Size idx) const {
-        return idxs.find(idx) != idxs.end();
-    }
-
-    Size getId() const {
-        return persistentId;
-    }
-
-    /// Modifies velocities according to saved angular frequency
-    void spin() {
-        if (this->size() == 1) {
-            return;
-        }
-
-        ArrayView<Vector> r = storage->getValue<Vector>(QuantityId::POSITION);
-        ArrayView<Vector> v = storage->getDt<Vector>(QuantityId::POSITION);
-        ArrayView<Vector> alpha = storage->getValue<Vector>(QuantityId::PHASE_ANGLE);
-        ArrayView<const Vector> w = storage->getValue<Vector>(QuantityId::ANGULAR_FREQUENCY);
-
-        ArrayView<const Float> m = storage->getValue<Float>(QuantityId::MASS);
-        Float m_ag = 0._f;
-        Vector r_com(0._f);
-        Vector v_com(0._f);
-        for (Size i : idxs) {
-            r_com += m[i] * r[i];
-            v_com += m[i] * v[i];
-            m_ag += m[i];
-        }
-        r_com /= m_ag;
-        v_com /= m_ag;
-        SPH_ASSERT(isReal(r_com) && getLength(r_com) < LARGE, r_com);
-
-        const Vector omega = clamp(w[persistentId], -MAX_SPIN, MAX_SPIN);
-        AffineMatrix rotationMatrix = AffineMatrix::identity();
+/// \brief Range of particles belonging to an aggregate, stored as a circular list.
+class AggregateMembers {
+private:
+    ArrayView<const Size> next;
+    Size first;
+    Size cnt;
 
-        if (alpha[persistentId] != Vector(0._f)) {
-            Vector dir;
-            Float angle;
-            tieToTuple(dir, angle) = getNormalizedWithLength(alpha[persistentId]);
-            alpha[persistentId] = Vector(0._f);
-            rotationMatrix = AffineMatrix::rotateAxis(dir, angle);
-        }
+    class Iterator {
+    private:
+        ArrayView<const Size> next;
+        Size idx;
+        Size cnt;
 
-        for (Size i : idxs) {
-            SPH_ASSERT(alpha[i] == Vector(0._f));
-            Float h = r[i][H];
-            r[i] = r_com + rotationMatrix * (r[i] - r_com);
-            v[i] += cross(omega, r[i] - r_com);
-            r[i][H] = h;
-            v[i][H] = 0._f;
-        }
-    }
+    public:
+        Iterator(ArrayView<const Size> next, const Size idx, const Size cnt)
+            : next(next)
+            , idx(idx)
+            , cnt(cnt) {}
 
-    /// Saves angular frequency, sets velocities to COM movement
-    void integrate() {
-        SPH_ASSERT(this->size() > 0);
-        if (this->size() == 1) {
-            return;
+        Size operator*() const {
+            return idx;
         }
-        ArrayView<Vector> r, v, dv;
-        tie(r, v, dv) = storage->getAll<Vector>(QuantityId::POSITION);
-        ArrayView<const Float> m = storage->getValue<Float>(QuantityId::MASS);
 
-        Float m_ag = 0._f;
-        Vector r_com(0._f);
-        Vector v_com(0._f);
-        Vector dv_com(0._f);
-        for (Size i : idxs) {
-            dv_com += m[i] * dv[i];
-            v_com += m[i] * v[i];
-            r_com += m[i] * r[i];
-            m_ag += m[i];
+        Iterator& operator++() {
+            idx = next[idx];
+            --cnt;
+            return *this;
         }
-        dv_com /= m_ag;
-        v_com /= m_ag;
-        r_com /= m_ag;
 
-        Vector L(0._f);
-        SymmetricTensor I = SymmetricTensor::null(); // inertia tensor
-        Vector M(0._f);                              // torque
-        for (Size i : idxs) {
-            const Vector dr = r[i] - r_com;
-            L += m[i] * cross(dr, v[i] - v_com);
-            I += m[i] * (SymmetricTensor::identity() * getSqrLength(dr) - symmetricOuter(dr, dr));
-            M += m[i] * cross(dr, dv[i] - dv_com);
+        bool operator!=(const Iterator& other) const {
+            return cnt != other.cnt;
         }
+    };
 
-        ArrayView<Vector> w, dw;
-        tie(w, dw) = storage->getAll<Vector>(QuantityId::ANGULAR_FREQUENCY);
-
-
-        const bool singular = I.determinant() == 0._f;
-        Vector omega = Vector(0._f);
-        if (!singular) {
-
-            omega = I.inverse() * L;
-
-            // const Vector w_loc = Em.transpose() * w[index];
-
-            // compute the change of angular velocity using Euler's equations
-            // dw[index] = I_inv * (M - cross(w[index], I * w[index]));
-        }
-
-
-        /*const SymmetricTensor I = Post::getInertiaTensor(m, r, r_com);
-        (void)I;*/
-
-        ArrayView<Vector> alpha, dalpha;
-        tie(alpha, dalpha) = storage->getAll<Vector>(QuantityId::PHASE_ANGLE);
-
-        for (Size i : idxs) {
-            v[i] = v_com;
-            dv[i] = dv_com;
-            w[i] = omega;
-
-            SPH_ASSERT(alpha[i] == Vector(0._f));
-        }
-        alpha[persistentId] = Vector(0._f);
-        dalpha[persistentId] = w[persistentId];
-    }
+public:
+    AggregateMembers(ArrayView<const Size> next, const Size first, const Size cnt)
+        : next(next)
+        , first(first)
+        , cnt(cnt) {}
 
-    // replaces unordered motion with bulk velocity + rotation
-    void fixVelocities() {
-        const Integrals ag = this->getIntegrals();
-        ArrayView<Vector> r, v, dv;
-        tie(r, v, dv) = storage->getAll<Vector>(QuantityId::POSITION);
-        for (Size i : idxs) {
-            v[i] = ag.v_com + cross(ag.omega, r[i] - ag.r_com);
-            v[i][H] = 0._f;
-        }
+    Iterator begin() const {
+        return Iterator(next, first, cnt);
     }
 
-    Float mass() const {
-        ArrayView<const Float> m = storage->getValue<Float>(QuantityId::MASS);
-        Float m_ag = 0._f;
-        for (Size i : idxs) {
-            m_ag += m[i];
-        }
-        return m_ag;
+    Iterator end() const {
+        return Iterator(next, first, 0);
     }
+};
 
-    Vector velocity() const {
-        ArrayView<Vector> r, v, dv;
-        tie(r, v, dv) = storage->getAll<Vector>(QuantityId::POSITION);
-        ArrayView<const Float> m = storage->getValue<Float>(QuantityId::MASS);
-
-        Float m_ag = 0._f;
-        Vector v_com(0._f);
-        for (Size i : idxs) {
-            v_com += m[i] * v[i];
-            m_ag += m[i];
-        }
-        v_com /= m_ag;
-        return v_com;
-    }
+/// \brief Integrals of motion of an aggregate.
+struct AggregateIntegrals {
+    Float m;
+    Vector r_com;
+    Vector v_com;
+    Vector dv_com;
+    SymmetricTensor I;
+    Vector L;
+};
 
-    void displace(const Vector& offset) {
-        SPH_ASSERT(offset[H] == 0._f);
+template <typename TMembers>
+AggregateIntegrals getIntegrals(const TMembers& idxs,
+    ArrayView<const Vector> r,
+    ArrayView<const Vector> v,
+    ArrayView<const Vector> dv,
+    ArrayView<const Float> m) {
+    AggregateIntegrals value;
+    value.m = 0._f;
+    value.r_com = value.v_com = value.dv_com = Vector(0._f);
+    for (Size i : idxs) {
+        value.dv_com += m[i] * dv[i];
+        value.v_com += m[i] * v[i];
+        value.r_com += m[i] * r[i];
+        value.m += m[i];
+    }
+    value.dv_com /= value.m;
+    value.v_com /= value.m;
+    value.r_com /= value.m;
+    SPH_ASSERT(isReal(value.r_com) && getLength(value.r_com) < LARGE, value.r_com);
+
+    value.L = Vector(0._f);
+    value.I = SymmetricTensor::null();
+    for (Size i : idxs) {
+        const Vector dr = r[i] - value.r_com;
+        value.L += m[i] * cross(dr, v[i] - value.v_com);
+        value.I += m[i] * (SymmetricTensor::identity() * getSqrLength(dr) - symmetricOuter(dr, dr));
+    }
+    return value;
+}
 
-        ArrayView<Vector> r = storage->getValue<Vector>(QuantityId::POSITION);
-        for (Size i : idxs) {
-            r[i] += offset;
-        }
+/// \brief Returns the angular velocity of an aggregate, or zero vector for a singular inertia tensor.
+Vector getAngularVelocity(const AggregateIntegrals& value) {
+    if (value.I.determinant() != 0._f) {
+        return value.I.inverse() * value.L;
+    } else {
+        return Vector(0._f);
     }
+}
 
+} // namespace
 
-    Size size() const {
-        return idxs.size();
-    }
+/// \brief Holds aggregates of particles, moving as rigid bodies according to Euler's equations.
+///
+/// Aggregates are disjoint sets of particles, each identified by one of its particles (the root), which also
+/// holds the persistent data of the aggregate, i.e. the angular frequency and the phase angle. Every particle
+/// stores the root of its aggregate, so that particle-to-aggregate queries take constant time. When merged,
+/// particles of the smaller set are relabeled; unlike a forest with path compression, this allows to remove
+/// particles from aggregates. Members of each aggregate are linked in a circular list stored in flat arrays,
+/// and for the integration, they are packed into contiguous ranges, so that the aggregates can be processed
+/// in parallel.
+///
+/// Bound to \ref Storage object. Modifying functions must not be called concurrently.
+class AggregateHolder : public IAggregateObserver, public Noncopyable {
+private:
+    RawPtr<Storage> storage;
 
-    bool empty() const {
-        return idxs.empty();
-    }
+    IScheduler& scheduler;
 
-    auto begin() const {
-        return idxs.begin();
-    }
+    /// Root of the aggregate containing given particle. Isolated particles are their own roots.
+    Array<Size> roots;
 
-    auto end() const {
-        return idxs.end();
-    }
+    /// Number of particles in the aggregate; only valid for roots.
+    Array<Size> sizes;
 
-private:
-    struct Integrals {
-        Float m;
-        Vector r_com;
-        Vector v_com;
-        Vector omega;
-        SymmetricTensor I;
-        Vector L;
-    };
+    /// Next and previous particle in the circular list of aggregate members.
+    Array<Size> next;
+    Array<Size> prev;
 
-    Integrals getIntegrals() const {
-        ArrayView<Vector> r, v, dv;
-        tie(r, v, dv) = storage->getAll<Vector>(QuantityId::POSITION);
-        ArrayView<const Float> m = storage->getValue<Float>(QuantityId::MASS);
-
-        Float m_ag = 0._f;
-        Vector r_com(0._f);
-        Vector v_com(0._f);
-        for (Size i : idxs) {
-            v_com += m[i] * v[i];
-            r_com += m[i] * r[i];
-            m_ag += m[i];
-        }
-        v_com /= m_ag;
-        r_com /= m_ag;
-
-        Vector L(0._f);
-        SymmetricTensor I = SymmetricTensor::null(); // inertia tensor
-        for (Size i : idxs) {
-            const Vector dr = r[i] - r_com;
-            L += m[i] * cross(dr, v[i] - v_com);
-            I += m[i] * (SymmetricTensor::identity() * getSqrLength(dr) - symmetricOuter(dr, dr));
-        }
+    /// Members of aggregates with more than one particle, packed into contiguous ranges.
+    struct {
+        /// Roots of the aggregates
+        Array<Size> roots;
 
-        Integrals value;
-        value.m = m_ag;
-        value.r_com = r_com;
-        value.v_com = v_com;
-        value.I = I;
-        value.L = L;
+        /// Index of the first member of each aggregate; has one more element than the number of aggregates
+        Array<Size> offsets;
 
-        if (I.determinant() != 0._f) {
-            value.omega = clamp(I.inverse() * L, -MAX_SPIN, MAX_SPIN);
-        } else {
-            value.omega = Vector(0._f);
-        }
-        return value;
-    }
-};
+        /// Indices of particles, sorted within each aggregate
+        Array<Size> indices;
 
-/// \brief Holds a set of aggregates.
-///
-/// Bound to \ref Storage object. Thread-safe??
-class AggregateHolder : public IAggregateObserver, public Noncopyable {
-private:
-    /// Holds all aggregates for the storage given in constructor.
-    Array<Aggregate> aggregates;
+        /// Set to true if the aggregates changed since the members have been packed
+        bool dirty = true;
 
-    /// Contains a pointer to aggregate containing the particle with given index.
-    ///
-    /// The array is precomputed in constructor and maintained during aggregate merging, it is necessary for
-    /// fast particle-to-aggregate queries.
-    Array<RawPtr<Aggregate>> particleToAggregate;
+    } packed;
 
     /// Lock needed for thread-safe access to aggregates via \ref IAggregateObserver interface.
     mutable std::mutex mutex;
 
 public:
-    AggregateHolder(Storage& storage, const AggregateEnum source) {
-        // create an aggregate for each particle, even if its empty, so we can add particles to it later
-        // without reallocations
+    AggregateHolder(IScheduler& scheduler, Storage& storage, const AggregateEnum source)
+        : storage(addressOf(storage))
+        , scheduler(scheduler) {
         const Size n = storage.getParticleCnt();
-        aggregates.resize(n);
+        roots.resize(n);
+        sizes.resize(n);
+        next.resize(n);
+        prev.resize(n);
+        for (Size i = 0; i < n; ++i) {
+            roots[i] = next[i] = prev[i] = i;
+            sizes[i] = 1;
+        }
 
         switch (source) {
-        case AggregateEnum::PARTICLES: {
-            for (Size i = 0; i < n; ++i) {
-                aggregates[i] = Aggregate(storage, i);
-                particleToAggregate.emplaceBack(addressOf(aggregates[i]));
-            }
+        case AggregateEnum::PARTICLES:
             break;
-        }
         case AggregateEnum::MATERIALS: {
             for (Size matId = 0; matId < storage.getMaterialCnt(); ++matId) {
                 MaterialView mat = storage.getMaterial(matId);
-                IndexSequence seq = mat.sequence();
-                // need to create all aggregates to storage pointer to storage
-                for (Size i : seq) {
-                    aggregates[i] = Aggregate(storage, i);
-                    aggregates[i].clear();
-                }
-
-                const Size idx = *seq.begin();
-                aggregates[idx] = Aggregate(storage, seq);
-
-                for (Size i = 0; i < seq.size(); ++i) {
-                    particleToAggregate.emplaceBack(addressOf(aggregates[idx]));
+                const Size first = *mat.sequence().begin();
+                for (Size i : mat.sequence()) {
+                    this->unite(first, i);
                 }
             }
             break;
         }
+        case AggregateEnum::FLAGS: {
+            ArrayView<const Size> flags = storage.getValue<Size>(QuantityId::FLAG);
+            std::map<Size, Size> firsts;
+            for (Size i = 0; i < n; ++i) {
+                const Size first = firsts.emplace(flags[i], i).first->second;
+                this->unite(first, i);
+            }
+            break;
+        }
         default:
             NOT_IMPLEMENTED;
         }
     }
 
-    /// \brief Returns the aggregate holding the given particle.
-    Aggregate& getAggregate(const Size particleIdx) {
-        Aggregate& ag = *particleToAggregate[particleIdx];
-        SPH_ASSERT(ag.contains(particleIdx));
-        return ag;
+    /// \brief Returns the root of the aggregate holding the given particle.
+    Size getAggregate(const Size particleIdx) const {
+        return roots[particleIdx];
     }
 
-    /// \copydoc getAggregate
-    const Aggregate& getAggregate(const Size particleIdx) const {
-        const Aggregate& ag = *particleToAggregate[particleIdx];
-        SPH_ASSERT(ag.contains(particleIdx));
-        return ag;
+    /// \brief Returns the number of particles in the aggregate.
+    Size size(const Size ag) const {
+        SPH_ASSERT(roots[ag] == ag);
+        return sizes[ag];
+    }
+
+    /// \brief Returns the particles of the aggregate.
+    AggregateMembers members(const Size ag) const {
+        SPH_ASSERT(roots[ag] == ag);
+        return AggregateMembers(next, ag, sizes[ag]);
     }
 
     /// \brief Merges two aggregates.
-    /*merge(Aggregate& ag1, Aggregate& ag2) {
-         CHECK_FUNCTION(CheckFunction::NON_REENRANT);
-         std::unique_lock<std::mutex> lock(mutex);
-
-         if (ag1.size() > ag1.size()) {
-             ag1.merge(ag2);
-         } else {
-             ag2.merge(ag1);
-         }
-         // SPH_ASSERT(ag1.contains(ag1.getId()));
-         // relink pointers of ag2 particles to ag1
-         for (Size i : ag2) {
-             particleToAggregate[i] = addressOf(ag1);
-         }
-
-         // remove all particles from ag2; we actually keep the aggregate in the holder (with zero particles)
-         // for simplicity, otherwise we would have to shift the aggregates in the array, invalidating the
-         // pointers held in particleToAggregate.
-         ag2.clear();
-         SPH_ASSERT(ag2.size() == 0);
-     }*/
-
-    void merge(Aggregate& ag1, Aggregate& ag2) {
-        if (ag1.size() < ag2.size()) {
+    ///
+    /// Single particle is added to the other aggregate; if both aggregates contain more particles, the
+    /// smaller one is disbanded instead.
+    void merge(const Size ag1, const Size ag2) {
+        if (sizes[ag1] < sizes[ag2]) {
             this->merge(ag2, ag1);
             return;
         }
 
-        SPH_ASSERT(ag1.size() >= ag2.size());
-        // accumulate single particle
-        if (ag2.size() == 1) {
-            const Size id = ag2.getId();
-            ag1.add(id);
-            particleToAggregate[id] = &ag1;
-            ag2.clear();
+        SPH_ASSERT(sizes[ag1] >= sizes[ag2]);
+        if (sizes[ag2] == 1) {
+            // accumulate single particle
+            this->unite(ag1, ag2);
         } else {
-
             // break the aggregate
             this->disband(ag2);
         }
 
-        ag1.fixVelocities();
+        this->fixVelocities(ag1);
     }
 
-    void separate(Aggregate& ag, const Size idx) {
-
-        if (ag.getId() == idx) {
+    /// \brief Removes the particle from the aggregate, unless it is the root.
+    void separate(const Size ag, const Size idx) {
+        SPH_ASSERT(roots[idx] == ag);
+        if (ag == idx) {
             return; /// \todo ?? how to do this
         }
 
-        aggregates[idx].add(idx);
-        particleToAggregate[idx] = addressOf(aggregates[idx]);
-        ag.remove(idx);
-        ag.fixVelocities();
+        this->detach(idx);
+        this->fixVelocities(ag);
     }
 
-    void disband(Aggregate& ag) {
-        const Size mainId = ag.getId();
-        for (Size i : ag) {
-            // put the particle back to its original aggregate
-            if (i != mainId) {
-                aggregates[i].add(i);
-                particleToAggregate[i] = addressOf(aggregates[i]);
-            }
+    /// \brief Breaks the aggregate into individual particles.
+    void disband(const Size ag) {
+        SPH_ASSERT(roots[ag] == ag);
+        while (sizes[ag] > 1) {
+            this->detach(next[ag]);
+        }
+    }
+
+    /// \brief Returns the total mass of the aggregate.
+    Float mass(const Size ag) const {
+        ArrayView<const Float> m = storage->getValue<Float>(QuantityId::MASS);
+        Float m_ag = 0._f;
+        for (Size i : this->members(ag)) {
+            m_ag += m[i];
+        }
+        return m_ag;
+    }
+
+    /// \brief Moves all particles of the aggregate by given offset.
+    void displace(const Size ag, const Vector& offset) {
+        SPH_ASSERT(offset[H] == 0._f);
+        ArrayView<Vector> r = storage->getValue<Vector>(QuantityId::POSITION);
+        for (Size i : this->members(ag)) {
+            r[i] += offset;
         }
+    }
 
-        ag.clear();
-        ag.add(mainId);
+    /// \brief Replaces unordered motion of particles with bulk velocity and rotation.
+    void fixVelocities(const Size ag) {
+        ArrayView<Vector> r, v, dv;
+        tie(r, v, dv) = storage->getAll<Vector>(QuantityId::POSITION);
+        ArrayView<const Float> m = storage->getValue<Float>(QuantityId::MASS);
+        const AggregateIntegrals value = getIntegrals(this->members(ag), r, v, dv, m);
+        const Vector omega = clamp(getAngularVelocity(value), -MAX_SPIN, MAX_SPIN);
+        for (Size i : this->members(ag)) {
+            v[i] = value.v_com + cross(omega, r[i] - value.r_com);
+            v[i][H] = 0._f;
+        }
     }
 
+    /// \brief Rotates all aggregates by their phase angles and adds the rotational velocities.
     void spin() {
-        // std::unique_lock<std::mutex> lock(mutex);
-        for (Aggregate& ag : aggregates) {
-            if (!ag.empty()) {
-                ag.spin();
+        this->pack();
+
+        ArrayView<Vector> r = storage->getValue<Vector>(QuantityId::POSITION);
+        ArrayView<Vector> v = storage->getDt<Vector>(QuantityId::POSITION);
+        ArrayView<Vector> alpha = storage->getValue<Vector>(QuantityId::PHASE_ANGLE);
+        ArrayView<const Vector> w = storage->getValue<Vector>(QuantityId::ANGULAR_FREQUENCY);
+        ArrayView<const Float> m = storage->getValue<Float>(QuantityId::MASS);
+
+        parallelFor(scheduler, 0, packed.roots.size(), [&](const Size k) {
+            const Size ag = packed.roots[k];
+            ArrayView<const Size> idxs =
+                packed.indices.view().subset(packed.offsets[k], packed.offsets[k + 1] - packed.offsets[k]);
+
+            Float m_ag = 0._f;
+            Vector r_com(0._f);
+            for (Size i : idxs) {
+                r_com += m[i] * r[i];
+                m_ag += m[i];
             }
-        }
+            r_com /= m_ag;
+            SPH_ASSERT(isReal(r_com) && getLength(r_com) < LARGE, r_com);
+
+            const Vector omega = clamp(w[ag], -MAX_SPIN, MAX_SPIN);
+            AffineMatrix rotationMatrix = AffineMatrix::identity();
+            if (alpha[ag] != Vector(0._f)) {
+                Vector dir;
+                Float angle;
+                tieToTuple(dir, angle) = getNormalizedWithLength(alpha[ag]);
+                alpha[ag] = Vector(0._f);
+                rotationMatrix = AffineMatrix::rotateAxis(dir, angle);
+            }
+
+            for (Size i : idxs) {
+                SPH_ASSERT(alpha[i] == Vector(0._f));
+                const Float h = r[i][H];
+                r[i] = r_com + rotationMatrix * (r[i] - r_com);
+                v[i] += cross(omega, r[i] - r_com);
+                r[i][H] = h;
+                v[i][H] = 0._f;
+            }
+        });
     }
 
-    /// \brief Integrates all aggregates
+    /// \brief Integrates all aggregates.
+    ///
+    /// Saves the angular frequencies of aggregates and sets the particle velocities to the velocities of
+    /// their centers of mass.
     void integrate() {
-        // std::unique_lock<std::mutex> lock(mutex);
+        this->pack();
+
+        ArrayView<Vector> r, v, dv;
+        tie(r, v, dv) = storage->getAll<Vector>(QuantityId::POSITION);
+        ArrayView<Vector> w = storage->getValue<Vector>(QuantityId::ANGULAR_FREQUENCY);
+        ArrayView<Vector> alpha, dalpha;
+        tie(alpha, dalpha) = storage->getAll<Vector>(QuantityId::PHASE_ANGLE);
+        ArrayView<const Float> m = storage->getValue<Float>(QuantityId::MASS);
 
-        for (Aggregate& ag : aggregates) {
-            if (!ag.empty()) {
-                ag.integrate();
+        parallelFor(scheduler, 0, packed.roots.size(), [&](const Size k) {
+            const Size ag = packed.roots[k];
+            ArrayView<const Size> idxs =
+                packed.indices.view().subset(packed.offsets[k], packed.offsets[k + 1] - packed.offsets[k]);
+
+            const AggregateIntegrals value = getIntegrals(idxs, r, v, dv, m);
+            const Vector omega = getAngularVelocity(value);
+            for (Size i : idxs) {
+                v[i] = value.v_com;
+                dv[i] = value.dv_com;
+                w[i] = omega;
+                SPH_ASSERT(alpha[i] == Vector(0._f));
             }
-        }
+            alpha[ag] = Vector(0._f);
+            dalpha[ag] = w[ag];
+        });
     }
 
-    Optional<Size> getAggregateId(const Size particleIdx) const {
+    /// \brief Stores the aggregate IDs of all particles, using Size(-1) for isolated particles.
+    void getAggregateIds(ArrayView<Size> ids) const {
         std::unique_lock<std::mutex> lock(mutex);
-        const Aggregate& ag = getAggregate(particleIdx);
-        if (ag.size() > 1) {
-            return ag.getId();
-        } else {
-            return NOTHING;
-        }
+        SPH_ASSERT(ids.size() == roots.size());
+        parallelFor(scheduler, 0, ids.size(), [this, &ids](const Size i) {
+            const Size ag = roots[i];
+            ids[i] = sizes[ag] > 1 ? ag : Size(-1);
+        });
     }
 
     virtual Size count() const override {
         std::unique_lock<std::mutex> lock(mutex);
         Size cnt = 0;
-        for (const Aggregate& ag : aggregates) {
-            if (ag.size() > 1) {
+        for (Size i = 0; i < roots.size(); ++i) {
+            if (roots[i] == i && sizes[i] > 1) {
                 cnt++;
             }
         }
@@ -479,11 +394,134 @@ public:
     }
 
     virtual void remove(ArrayView<const Size> idxs) override {
-        for (Size i : reverse(idxs)) {
-            Aggregate& ag = getAggregate(i);
-            ag.remove(i);
-            particleToAggregate.remove(i);
+        for (Size i : idxs) {
+            const Size ag = roots[i];
+            if (ag == i && sizes[ag] > 1) {
+                // move the aggregate to another particle
+                const Size newRoot = next[ag];
+                for (Size j : this->members(ag)) {
+                    roots[j] = newRoot;
+                }
+                sizes[newRoot] = sizes[ag];
+            }
+            this->detach(i);
+        }
+
+        Array<Size> mapping(roots.size());
+        Size removedCnt = 0;
+        for (Size i = 0; i < roots.size(); ++i) {
+            if (removedCnt < idxs.size() && idxs[removedCnt] == i) {
+                mapping[i] = Size(-1);
+                ++removedCnt;
+            } else {
+                mapping[i] = i - removedCnt;
+            }
+        }
+        Array<Size> newRoots, newSizes, newNext, newPrev;
+        for (Size i = 0; i < roots.size(); ++i) {
+            if (mapping[i] != Size(-1)) {
+                newRoots.push(mapping[roots[i]]);
+                newSizes.push(sizes[i]);
+                newNext.push(mapping[next[i]]);
+                newPrev.push(mapping[prev[i]]);
+            }
+        }
+        roots = std::move(newRoots);
+        sizes = std::move(newSizes);
+        next = std::move(newNext);
+        prev = std::move(newPrev);
+        packed.dirty = true;
+    }
+
+    virtual void reorder(ArrayView<const Size> order) override {
+        SPH_ASSERT(roots.size() == order.size());
+        Array<Size> inverse(order.size());
+        for (Size i = 0; i < order.size(); ++i) {
+            inverse[order[i]] = i;
+        }
+
+        // roots stay the same particles, only their indices change
+        Array<Size> newRoots(order.size()), newSizes(order.size()), newNext(order.size()),
+            newPrev(order.size());
+        for (Size i = 0; i < order.size(); ++i) {
+            newRoots[i] = inverse[roots[order[i]]];
+            newSizes[i] = sizes[order[i]];
+            newNext[i] = inverse[next[order[i]]];
+            newPrev[i] = inverse[prev[order[i]]];
+        }
+        roots = std::move(newRoots);
+        sizes = std::move(newSizes);
+        next = std::move(newNext);
+        prev = std::move(newPrev);
+        packed.dirty = true;
+    }
+
+private:
+    /// \brief Merges the aggregate containing particle j into the aggregate containing particle i.
+    void unite(const Size i, const Size j) {
+        Size ag1 = roots[i];
+        Size ag2 = roots[j];
+        if (ag1 == ag2) {
+            return;
+        }
+        if (sizes[ag1] < sizes[ag2]) {
+            // relabel the smaller aggregate
+            std::swap(ag1, ag2);
+        }
+        for (Size k : this->members(ag2)) {
+            roots[k] = ag1;
+        }
+        // splice the circular lists
+        const Size last1 = prev[ag1];
+        const Size last2 = prev[ag2];
+        next[last1] = ag2;
+        prev[ag2] = last1;
+        next[last2] = ag1;
+        prev[ag1] = last2;
+
+        sizes[ag1] += sizes[ag2];
+        packed.dirty = true;
+    }
+
+    /// \brief Removes a non-root particle from its aggregate, making it an isolated particle.
+    void detach(const Size i) {
+        const Size ag = roots[i];
+        if (ag == i) {
+            SPH_ASSERT(sizes[ag] == 1);
+            return;
+        }
+        next[prev[i]] = next[i];
+        prev[next[i]] = prev[i];
+        next[i] = prev[i] = roots[i] = i;
+        sizes[i] = 1;
+        sizes[ag]--;
+        packed.dirty = true;
+    }
+
+    /// \brief Packs the members of aggregates into contiguous ranges, if the aggregates changed.
+    void pack() {
+        if (!packed.dirty) {
+            return;
+        }
+        packed.roots.clear();
+        packed.offsets.clear();
+        packed.offsets.push(0);
+        for (Size i = 0; i < roots.size(); ++i) {
+            if (roots[i] == i && sizes[i] > 1) {
+                packed.roots.push(i);
+                packed.offsets.push(packed.offsets.back() + sizes[i]);
+            }
         }
+        packed.indices.resize(packed.offsets.back());
+        parallelFor(scheduler, 0, packed.roots.size(), [this](const Size k) {
+            Size* idxs = &packed.indices[packed.offsets[k]];
+            for (Size i : this->members(packed.roots[k])) {
+                *idxs++ = i;
+            }
+            // sort to get the same order of summation regardless of the order of merging
+            std::sort(&packed.indices[packed.offsets[k]], idxs);
+        });
+        packed.dirty = false;
     }
 };
 
@@ -521,9 +559,9 @@ public:
         // this function SHOULD be called by one thread only, so we do not need to lock here
         CHECK_FUNCTION(CheckFunction::NON_REENRANT);
 
-        Aggregate& ag_i = holder->getAggregate(i);
-        Aggregate& ag_j = holder->getAggregate(j);
-        if (addressOf(ag_i) == addressOf(ag_j)) {
+        const Size ag_i = holder->getAggregate(i);
+        const Size ag_j = holder->getAggregate(j);
+        if (ag_i == ag_j) {
             // particles belong to the same aggregate, do not process collision
             return CollisionResult::NONE;
         }
@@ -544,11 +582,11 @@ public:
 
         // particle are moved back after collision handling, so we need to make sure they have correct
         // velocities to not move them away from the aggregate
-        ag_i.fixVelocities();
-        ag_j.fixVelocities();
+        holder->fixVelocities(ag_i);
+        holder->fixVelocities(ag_j);
 
         /*
-                if (ag_i.size() > ag_j.size()) {
+                if (holder->size(ag_i) > holder->size(ag_j)) {
                     holder->disband(ag_j);
                 } else {
                     holder->disband(ag_i);
@@ -570,6 +608,11 @@ public:
         }
     }
 
+    virtual bool isLocal() const override {
+        // modifies all particles of the collided aggregates
+        return false;
+    }
+
 private:
     /// \todo copied from bounce handler, deduplicate!!
     INLINE Vector reflect(const Vector& v_particle, const Vector& v_com, const Vector& dir) const {
@@ -607,9 +650,9 @@ public:
 
     virtual bool overlaps(const Size i, const Size j) const override {
         // this is called from multiple threads, but we are not doing any merging here
-        const Aggregate& ag_i = holder->getAggregate(i);
-        const Aggregate& ag_j = holder->getAggregate(j);
-        if (addressOf(ag_i) == addressOf(ag_j)) {
+        const Size ag_i = holder->getAggregate(i);
+        const Size ag_j = holder->getAggregate(j);
+        if (ag_i == ag_j) {
             // false as in "overlap does not have to be handled"
             return false;
         }
@@ -620,12 +663,12 @@ public:
         // this function SHOULD be called by one thread only, so we do not need to lock here
         CHECK_FUNCTION(CheckFunction::NON_REENRANT);
 
-        Aggregate& ag_i = holder->getAggregate(i);
-        Aggregate& ag_j = holder->getAggregate(j);
+        const Size ag_i = holder->getAggregate(i);
+        const Size ag_j = holder->getAggregate(j);
 
         // even though we previously checked for this in function overlaps, the particles might have been
         // assinged to the same aggregate during collision processing, so we have to check again
-        if (addressOf(ag_i) == addressOf(ag_j)) {
+        if (ag_i == ag_j) {
             return;
         }
 
@@ -639,15 +682,19 @@ public:
             return;
         }
 
-        const Float m1 = ag_i.mass(); /// \todo precompute
-        const Float m2 = ag_j.mass();
+        const Float m1 = holder->mass(ag_i); /// \todo precompute
+        const Float m2 = holder->mass(ag_j);
         const Float x1 = (r[i][H] + r[j][H] - dist) / (1._f + m1 / m2);
         const Float x2 = m1 / m2 * x1;
-        ag_i.displace(dir * x1);
-        ag_j.displace(-dir * x2);
+        holder->displace(ag_i, dir * x1);
+        holder->displace(ag_j, -dir * x2);
 
         handler.collide(i, j, toRemove);
     }
+
+    virtual bool isLocal() const override {
+        return false;
+    }
 };
 
 AggregateSolver::AggregateSolver(IScheduler& scheduler, const RunSettings& settings)
@@ -655,7 +702,8 @@ AggregateSolver::AggregateSolver(IScheduler& scheduler, const RunSettings& setti
           settings,
           Factory::getGravity(settings),
           makeAuto<AggregateCollisionHandler>(settings),
-          makeAuto<AggregateOverlapHandler>(settings)) {}
+          makeAuto<AggregateOverlapHandler>(settings))
+    , scheduler(scheduler) {}
 // makeAuto<RepelHandler<AggregateCollisionHandler>>(settings)) {}
 
 
@@ -667,10 +715,7 @@ void AggregateSolver::integrate(Storage& storage, Statistics& stats) {
     holder->integrate();
 
     // storage IDs and aggregate stats
-    ArrayView<Size> aggregateIds = storage.getValue<Size>(QuantityId::AGGREGATE_ID);
-    for (Size i = 0; i < aggregateIds.size(); ++i) {
-        aggregateIds[i] = holder->getAggregateId(i).valueOr(Size(-1));
-    }
+    holder->getAggregateIds(storage.getValue<Size>(QuantityId::AGGREGATE_ID));
     stats.set(StatisticsId::AGGREGATE_COUNT, int(holder->count()));
 }
 
@@ -689,7 +734,7 @@ void AggregateSolver::create(Storage& storage, IMaterial& material) const {
 }
 
 void AggregateSolver::createAggregateData(Storage& storage, const AggregateEnum source) {
-    holder = makeShared<AggregateHolder>(storage, source);
+    holder = makeShared<AggregateHolder>(scheduler, storage, source);
     storage.setUserData(holder);
 }
 
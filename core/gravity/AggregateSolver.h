@@ -27,11 +27,13 @@ enum class AggregateEnum {
 static RegisterEnum<AggregateEnum> sAggregate({
     { AggregateEnum::PARTICLES, "particles", "Aggregate is created for each particles" },
     { AggregateEnum::MATERIALS, "materials", "" },
-    { AggregateEnum::FLAGS, "flags", "" },
+    { AggregateEnum::FLAGS, "flags", "Aggregate is created for each distinct particle flag" },
 });
 
 class AggregateSolver : public HardSphereSolver {
 private:
+    IScheduler& scheduler;
+
     /// Holds all aggregates in the simulation.
     ///
     /// Shared with storage.
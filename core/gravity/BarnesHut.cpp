@@ -15,6 +15,272 @@ static_assert(sizeof(InnerNode<BarnesHutNode>) == sizeof(LeafNode<BarnesHutNode>
 static_assert(alignof(InnerNode<BarnesHutNode>) == alignof(LeafNode<BarnesHutNode>),
     "Invalid alignment of BarnesHut nodes");
 
+namespace {
+
+/// View of a tile of particles in structure-of-arrays layout
+struct TileView {
+    const Float* x;
+    const Float* y;
+    const Float* z;
+    const Float* m;
+    const Float* h;
+};
+
+/// Size of the temporary buffers used to evaluate interactions with softened particles
+constexpr Size CHUNK_SIZE = 64;
+
+#if defined(__AVX2__) && !defined(SPH_SINGLE_PRECISION)
+
+INLINE double horizontalSum(const __m256d v) {
+    const __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+}
+
+/// Sums the accelerations due to the largest multiple of 4 point masses, returns the number of processed
+/// particles.
+Size sumPointMassesAvx(const TileView& tile, const Size count, const Vector& r0, Vector& f) {
+    const __m256d x0 = _mm256_set1_pd(r0[X]);
+    const __m256d y0 = _mm256_set1_pd(r0[Y]);
+    const __m256d z0 = _mm256_set1_pd(r0[Z]);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.);
+    __m256d fx = zero, fy = zero, fz = zero;
+    Size k = 0;
+    for (; k + 4 <= count; k += 4) {
+        const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(tile.x + k), x0);
+        const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(tile.y + k), y0);
+        const __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(tile.z + k), z0);
+        const __m256d rSqr =
+            _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), _mm256_mul_pd(dz, dz));
+        // particles with zero distance (including the evaluated particle itself) are masked out
+        const __m256d valid = _mm256_cmp_pd(rSqr, zero, _CMP_GT_OQ);
+        const __m256d rSqrSafe = _mm256_blendv_pd(one, rSqr, valid);
+        const __m256d factor = _mm256_and_pd(
+            _mm256_div_pd(_mm256_loadu_pd(tile.m + k), _mm256_mul_pd(rSqrSafe, _mm256_sqrt_pd(rSqrSafe))),
+            valid);
+        fx = _mm256_add_pd(fx, _mm256_mul_pd(factor, dx));
+        fy = _mm256_add_pd(fy, _mm256_mul_pd(factor, dy));
+        fz = _mm256_add_pd(fz, _mm256_mul_pd(factor, dz));
+    }
+    f = Vector(horizontalSum(fx), horizontalSum(fy), horizontalSum(fz));
+    return k;
+}
+
+/// Computes squared distances and symmetrized smoothing lengths of the largest multiple of 4 particles,
+/// returns the number of processed particles.
+Size computeDistancesAvx(const TileView& tile, const Size count, const Vector& r0, Float* rSqr, Float* h) {
+    const __m256d x0 = _mm256_set1_pd(r0[X]);
+    const __m256d y0 = _mm256_set1_pd(r0[Y]);
+    const __m256d z0 = _mm256_set1_pd(r0[Z]);
+    const __m256d h0 = _mm256_set1_pd(r0[H]);
+    const __m256d half = _mm256_set1_pd(0.5);
+    Size k = 0;
+    for (; k + 4 <= count; k += 4) {
+        const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(tile.x + k), x0);
+        const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(tile.y + k), y0);
+        const __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(tile.z + k), z0);
+        _mm256_storeu_pd(rSqr + k,
+            _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)), _mm256_mul_pd(dz, dz)));
+        _mm256_storeu_pd(h + k, _mm256_mul_pd(half, _mm256_add_pd(h0, _mm256_loadu_pd(tile.h + k))));
+    }
+    return k;
+}
+
+/// Sums the accelerations of the largest multiple of 4 particles, given the gradient factors. Returns the
+/// number of processed particles.
+Size sumGradientsAvx(const TileView& tile, const Size count, const Vector& r0, const Float* grad, Vector& f) {
+    const __m256d x0 = _mm256_set1_pd(r0[X]);
+    const __m256d y0 = _mm256_set1_pd(r0[Y]);
+    const __m256d z0 = _mm256_set1_pd(r0[Z]);
+    __m256d fx = _mm256_setzero_pd(), fy = _mm256_setzero_pd(), fz = _mm256_setzero_pd();
+    Size k = 0;
+    for (; k + 4 <= count; k += 4) {
+        const __m256d factor = _mm256_mul_pd(_mm256_loadu_pd(tile.m + k), _mm256_loadu_pd(grad + k));
+        fx = _mm256_add_pd(fx, _mm256_mul_pd(factor, _mm256_sub_pd(_mm256_loadu_pd(tile.x + k), x0)));
+        fy = _mm256_add_pd(fy, _mm256_mul_pd(factor, _mm256_sub_pd(_mm256_loadu_pd(tile.y + k), y0)));
+        fz = _mm256_add_pd(fz, _mm256_mul_pd(factor, _mm256_sub_pd(_mm256_loadu_pd(tile.z + k), z0)));
+    }
+    f = Vector(horizontalSum(fx), horizontalSum(fy), horizontalSum(fz));
+    return k;
+}
+
+/// Four values processed by AVX instructions, used to evaluate multipole expansions at four particles.
+struct Lanes {
+    __m256d v;
+
+    INLINE Lanes(const __m256d v)
+        : v(v) {}
+
+    INLINE Lanes(const double f)
+        : v(_mm256_set1_pd(f)) {}
+
+    INLINE friend Lanes operator+(const Lanes& l1, const Lanes& l2) {
+        return _mm256_add_pd(l1.v, l2.v);
+    }
+
+    INLINE friend Lanes operator-(const Lanes& l1, const Lanes& l2) {
+        return _mm256_sub_pd(l1.v, l2.v);
+    }
+
+    INLINE friend Lanes operator*(const Lanes& l1, const Lanes& l2) {
+        return _mm256_mul_pd(l1.v, l2.v);
+    }
+
+    INLINE friend Lanes operator/(const Lanes& l1, const Lanes& l2) {
+        return _mm256_div_pd(l1.v, l2.v);
+    }
+
+    INLINE Lanes& operator+=(const Lanes& other) {
+        v = _mm256_add_pd(v, other.v);
+        return *this;
+    }
+
+    INLINE friend Lanes sqrt(const Lanes& l) {
+        return _mm256_sqrt_pd(l.v);
+    }
+};
+
+#else
+
+Size sumPointMassesAvx(const TileView&, const Size, const Vector&, Vector& f) {
+    // AVX2 not available, everything is processed by the scalar loop
+    f = Vector(0._f);
+    return 0;
+}
+
+Size computeDistancesAvx(const TileView&, const Size, const Vector&, Float*, Float*) {
+    return 0;
+}
+
+Size sumGradientsAvx(const TileView&, const Size, const Vector&, const Float*, Vector& f) {
+    f = Vector(0._f);
+    return 0;
+}
+
+#endif
+
+/// Sums the accelerations due to point masses in the tile; particles with zero distance are skipped.
+Vector sumPointMasses(const TileView& tile, const Size count, const Vector& r0) {
+    Vector f;
+    for (Size k = sumPointMassesAvx(tile, count, r0, f); k < count; ++k) {
+        const Vector dr(tile.x[k] - r0[X], tile.y[k] - r0[Y], tile.z[k] - r0[Z]);
+        const Float rSqr = getSqrLength(dr);
+        if (rSqr > 0._f) {
+            f += tile.m[k] / (rSqr * sqrt(rSqr)) * dr;
+        }
+    }
+    return f;
+}
+
+/// Sums the accelerations due to particles in the tile, using the gravitational kernel with symmetrized
+/// smoothing lengths.
+Vector sumSoftened(const TileView& tile, const Size count, const Vector& r0, const GravityLutKernel& kernel) {
+    Float rSqr[CHUNK_SIZE];
+    Float h[CHUNK_SIZE];
+    Float grad[CHUNK_SIZE];
+    Vector f(0._f);
+    for (Size from = 0; from < count; from += CHUNK_SIZE) {
+        const Size chunk = min(CHUNK_SIZE, count - from);
+        const TileView view{ tile.x + from, tile.y + from, tile.z + from, tile.m + from, tile.h + from };
+        for (Size k = computeDistancesAvx(view, chunk, r0, rSqr, h); k < chunk; ++k) {
+            rSqr[k] = sqr(view.x[k] - r0[X]) + sqr(view.y[k] - r0[Y]) + sqr(view.z[k] - r0[Z]);
+            h[k] = 0.5_f * (r0[H] + view.h[k]);
+        }
+        kernel.gradBatch(rSqr, h, grad, chunk);
+
+        Vector df;
+        for (Size k = sumGradientsAvx(view, chunk, r0, grad, df); k < chunk; ++k) {
+            const Vector dr(view.x[k] - r0[X], view.y[k] - r0[Y], view.z[k] - r0[Z]);
+            df += view.m[k] * grad[k] * dr;
+        }
+        f += df;
+    }
+    return f;
+}
+
+/// Independent components of gravitational moments, traceless moments are stored in the order xx, xy, xz,
+/// yy, yz, zz and xxx, xxy, xxz, xyy, xyz, xzz, yyy, yyz, yzz, zzz.
+struct MomentComponents {
+    Float M;
+    Float q2[6];
+    Float q3[10];
+
+    MomentComponents() = default;
+
+    MomentComponents(const MultipoleExpansion<3>& moments)
+        : M(moments.order<0>().value())
+        , q2{ moments.order<2>().value<0, 0>(),
+            moments.order<2>().value<0, 1>(),
+            moments.order<2>().value<0, 2>(),
+            moments.order<2>().value<1, 1>(),
+            moments.order<2>().value<1, 2>(),
+            moments.order<2>().value<2, 2>() }
+        , q3{ moments.order<3>().value<0, 0, 0>(),
+            moments.order<3>().value<0, 0, 1>(),
+            moments.order<3>().value<0, 0, 2>(),
+            moments.order<3>().value<0, 1, 1>(),
+            moments.order<3>().value<0, 1, 2>(),
+            moments.order<3>().value<0, 2, 2>(),
+            moments.order<3>().value<1, 1, 1>(),
+            moments.order<3>().value<1, 1, 2>(),
+            moments.order<3>().value<1, 2, 2>(),
+            moments.order<3>().value<2, 2, 2>() } {}
+};
+
+/// \brief Adds the acceleration due to the multipole expansion at given position relative to the center of
+/// mass.
+///
+/// The potential of traceless moments \f$q_n\f$ is \f$ -\sum_n (2n-1)!!/n! \, q_n \cdot x^n / r^{2n+1} \f$.
+/// Can be evaluated for a single value or for several values at once.
+template <typename T>
+INLINE void addMultipoleAcceleration(const MomentComponents& c,
+    const MultipoleOrder order,
+    const T& x,
+    const T& y,
+    const T& z,
+    T& ax,
+    T& ay,
+    T& az) {
+    const T r2Inv = T(1._f) / (x * x + y * y + z * z);
+    const T r3Inv = r2Inv * sqrt(r2Inv);
+    T g = T(-c.M) * r3Inv;
+    if (order >= MultipoleOrder::QUADRUPOLE) {
+        const T r5Inv = r3Inv * r2Inv;
+        const T r7Inv = r5Inv * r2Inv;
+        const T vx = T(c.q2[0]) * x + T(c.q2[1]) * y + T(c.q2[2]) * z;
+        const T vy = T(c.q2[1]) * x + T(c.q2[3]) * y + T(c.q2[4]) * z;
+        const T vz = T(c.q2[2]) * x + T(c.q2[4]) * y + T(c.q2[5]) * z;
+        const T p2 = x * vx + y * vy + z * vz;
+        const T s2 = T(3._f) * r5Inv;
+        ax += s2 * vx;
+        ay += s2 * vy;
+        az += s2 * vz;
+        g = g - T(7.5_f) * p2 * r7Inv;
+
+        if (order >= MultipoleOrder::OCTUPOLE) {
+            const T xx = x * x, xy = T(2._f) * x * y, xz = T(2._f) * x * z;
+            const T yy = y * y, yz = T(2._f) * y * z, zz = z * z;
+            const T wx = T(c.q3[0]) * xx + T(c.q3[1]) * xy + T(c.q3[2]) * xz + T(c.q3[3]) * yy +
+                         T(c.q3[4]) * yz + T(c.q3[5]) * zz;
+            const T wy = T(c.q3[1]) * xx + T(c.q3[3]) * xy + T(c.q3[4]) * xz + T(c.q3[6]) * yy +
+                         T(c.q3[7]) * yz + T(c.q3[8]) * zz;
+            const T wz = T(c.q3[2]) * xx + T(c.q3[4]) * xy + T(c.q3[5]) * xz + T(c.q3[7]) * yy +
+                         T(c.q3[8]) * yz + T(c.q3[9]) * zz;
+            const T p3 = x * wx + y * wy + z * wz;
+            const T s3 = T(7.5_f) * r7Inv;
+            ax += s3 * wx;
+            ay += s3 * wy;
+            az += s3 * wz;
+            g = g - T(17.5_f) * p3 * r7Inv * r2Inv;
+        }
+    }
+    ax += g * x;
+    ay += g * y;
+    az += g * z;
+}
+
+} // namespace
+
 BarnesHut::BarnesHut(const Float theta,
     const MultipoleOrder order,
     const Size leafSize,
@@ -48,6 +314,14 @@ BarnesHut::BarnesHut(const Float theta,
 }
 
 void BarnesHut::build(IScheduler& scheduler, const Storage& storage) {
+    this->buildTree(scheduler, storage, false);
+}
+
+void BarnesHut::refit(IScheduler& scheduler, const Storage& storage) {
+    this->buildTree(scheduler, storage, true);
+}
+
+void BarnesHut::buildTree(IScheduler& scheduler, const Storage& storage, const bool refit) {
     VERBOSE_LOG
 
     // save source data
@@ -62,12 +336,18 @@ void BarnesHut::build(IScheduler& scheduler, const Storage& storage) {
         },
         [&] {
             // build K-d Tree; no need for rank as we are never searching neighbors
-            kdTree.build(scheduler, r, FinderFlag::SKIP_RANK);
+            if (refit) {
+                kdTree.refit(scheduler, r, FinderFlag::SKIP_RANK);
+            } else {
+                kdTree.build(scheduler, r, FinderFlag::SKIP_RANK);
+            }
         });
 
     if (SPH_UNLIKELY(r.empty())) {
         return;
     }
+    tiles.resize(r.size());
+
     // constructs nodes
     auto functor = [this](BarnesHutNode& node, BarnesHutNode* left, BarnesHutNode* right) INL {
         if (node.isLeaf()) {
@@ -314,36 +594,38 @@ void BarnesHut::evalNode(IScheduler& scheduler,
 void BarnesHut::evalParticleList(const LeafNode<BarnesHutNode>& leaf,
     ArrayView<Size> particleList,
     ArrayView<Vector> dv) const {
-    // needs to symmetrize smoothing length to keep the total momentum conserved
-    SymmetrizeSmoothingLengths<const GravityLutKernel&> actKernel(kernel);
-    // go through all nodes in the list and compute the pair-wise interactions
-    LeafIndexSequence seq1 = kdTree.getLeafIndices(leaf);
     SPH_ASSERT(allUnique(particleList), particleList);
-    for (Size idx : particleList) {
-        // the particle lists do not have to be necessarily symmetric, we have to do each node separately
-        SPH_ASSERT(idx < kdTree.getNodeCnt(), idx, kdTree.getNodeCnt());
-        const BarnesHutNode& node = kdTree.getNode(idx);
-        SPH_ASSERT(node.isLeaf());
-        LeafIndexSequence seq2 =
-            kdTree.getLeafIndices(reinterpret_cast<const LeafNode<BarnesHutNode>&>(node));
-        for (Size i : seq1) {
-            SPH_ASSERT(r[i][H] > 0._f, r[i][H]);
-            for (Size j : seq2) {
-                SPH_ASSERT(r[j][H] > 0._f, r[j][H]);
-                const Vector grad = actKernel.grad(r[j], r[i]);
-                dv[i] += m[j] * grad;
+    const bool pointMasses = kernel.radius() == 0._f;
+    LeafIndexSequence seq1 = kdTree.getLeafIndices(leaf);
+    for (Size n = leaf.from; n < leaf.to; ++n) {
+        const Vector r0(tiles.x[n], tiles.y[n], tiles.z[n], tiles.h[n]);
+        SPH_ASSERT(r0[H] > 0._f, r0[H]);
+        Vector f(0._f);
+        auto addLeaf = [&](const LeafNode<BarnesHutNode>& node) {
+            if (node.size() == 0) {
+                return;
             }
+            const Size from = node.from;
+            const TileView tile{
+                &tiles.x[from], &tiles.y[from], &tiles.z[from], &tiles.m[from], &tiles.h[from]
+            };
+            if (pointMasses) {
+                f += sumPointMasses(tile, node.size(), r0);
+            } else {
+                f += sumSoftened(tile, node.size(), r0, kernel);
+            }
+        };
+        // go through all nodes in the list and compute the pair-wise interactions
+        for (Size idx : particleList) {
+            SPH_ASSERT(idx < kdTree.getNodeCnt(), idx, kdTree.getNodeCnt());
+            const BarnesHutNode& node = kdTree.getNode(idx);
+            SPH_ASSERT(node.isLeaf());
+            addLeaf(reinterpret_cast<const LeafNode<BarnesHutNode>&>(node));
         }
-    }
-    // evaluate intra-leaf interactions (the leaf itself is not included in the list)
-    for (Size n1 = leaf.from; n1 < leaf.to; ++n1) {
-        for (Size n2 = n1 + 1; n2 < leaf.to; ++n2) {
-            const Size i = seq1.map(n1);
-            const Size j = seq1.map(n2);
-            const Vector grad = actKernel.grad(r[j], r[i]);
-            dv[i] += m[j] * grad;
-            dv[j] -= m[i] * grad;
-        }
+        // evaluate intra-leaf interactions; the particle itself is skipped as it has zero distance
+        addLeaf(leaf);
+
+        dv[seq1.map(n)] += f;
     }
 }
 
@@ -352,11 +634,58 @@ void BarnesHut::evalNodeList(const LeafNode<BarnesHutNode>& leaf,
     ArrayView<Vector> dv) const {
     SPH_ASSERT(allUnique(nodeList), nodeList);
     LeafIndexSequence seq1 = kdTree.getLeafIndices(leaf);
-    for (Size idx : nodeList) {
-        const BarnesHutNode& node = kdTree.getNode(idx);
-        SPH_ASSERT(seq1.size() > 0);
-        for (Size i : seq1) {
-            dv[i] += evaluateGravity(r[i] - node.com, node.moments, order);
+    SPH_ASSERT(seq1.size() > 0);
+    constexpr Size NODE_CHUNK_SIZE = 32;
+    MomentComponents components[NODE_CHUNK_SIZE];
+    Vector coms[NODE_CHUNK_SIZE];
+    for (Size from = 0; from < nodeList.size(); from += NODE_CHUNK_SIZE) {
+        const Size chunk = min(NODE_CHUNK_SIZE, nodeList.size() - from);
+        for (Size k = 0; k < chunk; ++k) {
+            const BarnesHutNode& node = kdTree.getNode(nodeList[from + k]);
+            components[k] = MomentComponents(node.moments);
+            coms[k] = node.com;
+        }
+
+        Size n = leaf.from;
+#if defined(__AVX2__) && !defined(SPH_SINGLE_PRECISION)
+        // evaluate the moments at four particles at once
+        for (; n + 4 <= leaf.to; n += 4) {
+            const Lanes x = _mm256_loadu_pd(&tiles.x[n]);
+            const Lanes y = _mm256_loadu_pd(&tiles.y[n]);
+            const Lanes z = _mm256_loadu_pd(&tiles.z[n]);
+            Lanes ax(0.), ay(0.), az(0.);
+            for (Size k = 0; k < chunk; ++k) {
+                addMultipoleAcceleration(components[k],
+                    order,
+                    x - coms[k][X],
+                    y - coms[k][Y],
+                    z - coms[k][Z],
+                    ax,
+                    ay,
+                    az);
+            }
+            alignas(32) double fx[4], fy[4], fz[4];
+            _mm256_store_pd(fx, ax.v);
+            _mm256_store_pd(fy, ay.v);
+            _mm256_store_pd(fz, az.v);
+            for (Size l = 0; l < 4; ++l) {
+                dv[seq1.map(n + l)] += Vector(fx[l], fy[l], fz[l]);
+            }
+        }
+#endif
+        for (; n < leaf.to; ++n) {
+            Float ax = 0._f, ay = 0._f, az = 0._f;
+            for (Size k = 0; k < chunk; ++k) {
+                addMultipoleAcceleration(components[k],
+                    order,
+                    tiles.x[n] - coms[k][X],
+                    tiles.y[n] - coms[k][Y],
+                    tiles.z[n] - coms[k][Z],
+                    ax,
+                    ay,
+                    az);
+            }
+            dv[seq1.map(n)] += Vector(ax, ay, az);
         }
     }
 }
@@ -376,6 +705,17 @@ Vector BarnesHut::evalExact(const LeafNode<BarnesHutNode>& leaf, const Vector& r
 void BarnesHut::buildLeaf(BarnesHutNode& node) {
     LeafNode<BarnesHutNode>& leaf = (LeafNode<BarnesHutNode>&)node;
 
+    // copy the particle data into the tile of the leaf
+    LeafIndexSequence sequence = kdTree.getLeafIndices(leaf);
+    for (Size n = leaf.from; n < leaf.to; ++n) {
+        const Size i = sequence.map(n);
+        tiles.x[n] = r[i][X];
+        tiles.y[n] = r[i][Y];
+        tiles.z[n] = r[i][Z];
+        tiles.m[n] = m[i];
+        tiles.h[n] = r[i][H];
+    }
+
     switch (leaf.size()) {
     case 0:
         // empty leaf - set to zero to correctly compute mass and com of parent nodes
@@ -388,7 +728,7 @@ void BarnesHut::buildLeaf(BarnesHutNode& node) {
         return;
     case 1:
         // single particle - requires special handling to avoid numerical problems
-        const Size i = *kdTree.getLeafIndices(leaf).begin();
+        const Size i = *sequence.begin();
         leaf.com = r[i];
         leaf.box.extend(r[i]);
         leaf.moments.order<0>() = m[i];
@@ -401,7 +741,6 @@ void BarnesHut::buildLeaf(BarnesHutNode& node) {
     // compute the center of gravity (the box is already done)
     leaf.com = Vector(0._f);
     Float m_leaf = 0._f;
-    LeafIndexSequence sequence = kdTree.getLeafIndices(leaf);
     for (Size i : sequence) {
         leaf.com += m[i] * r[i];
         m_leaf += m[i];
@@ -488,6 +827,14 @@ void BarnesHut::buildInner(BarnesHutNode& node, BarnesHutNode& left, BarnesHutNo
     inner.moments.order<3>() += parallelAxisTheorem(Mr3, Mr2, mr, d);
 }
 
+void BarnesHut::ParticleTiles::resize(const Size size) {
+    x.resize(size);
+    y.resize(size);
+    z.resize(size);
+    m.resize(size);
+    h.resize(size);
+}
+
 MultipoleExpansion<3> BarnesHut::getMoments() const {
     // masses are premultiplied by gravitational constants, so we have to divide
     return kdTree.getNode(0).moments.multiply(1._f / G);
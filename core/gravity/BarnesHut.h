@@ -52,6 +52,22 @@ protected:
     /// K-d tree storing gravitational moments
     KdTree<BarnesHutNode> kdTree;
 
+    /// \brief Particle data in structure-of-arrays layout, stored in the order of the K-d tree.
+    ///
+    /// Particles of each leaf form a contiguous tile, so that the interactions of leafs can be evaluated
+    /// using vector instructions.
+    struct ParticleTiles {
+        Array<Float> x, y, z;
+
+        /// Masses multiplied by gravitational constant
+        Array<Float> m;
+
+        /// Smoothing lengths
+        Array<Float> h;
+
+        void resize(const Size size);
+    } tiles;
+
     /// Kernel used to evaluate gravity of close particles
     GravityLutKernel kernel;
 
@@ -102,6 +118,9 @@ public:
     /// Masses of particles must be strictly positive, otherwise center of mass would be undefined.
     virtual void build(IScheduler& pool, const Storage& storage) override;
 
+    /// Refits the K-d tree (see \ref KdTree::refitImpl) and recomputes the multipole moments of nodes.
+    virtual void refit(IScheduler& pool, const Storage& storage) override;
+
     virtual void evalSelfGravity(IScheduler& pool, ArrayView<Vector> dv, Statistics& stats) const override;
 
     virtual void evalAttractors(IScheduler& scheduler,
@@ -178,16 +197,23 @@ protected:
         TreeWalkState data,
         TreeWalkResult& result) const;
 
+    /// \brief Evaluates pair-wise interactions of particles in the leaf with particles in given leafs.
+    ///
+    /// Interactions of particles within the leaf are also evaluated; the leaf itself shall not be included in
+    /// the list.
     void evalParticleList(const LeafNode<BarnesHutNode>& leaf,
         ArrayView<Size> particleList,
         ArrayView<Vector> dv) const;
 
+    /// \brief Evaluates multipole expansions of given nodes at particles in the leaf.
     void evalNodeList(const LeafNode<BarnesHutNode>& leaf,
         ArrayView<Size> nodeList,
         ArrayView<Vector> dv) const;
 
     Vector evalExact(const LeafNode<BarnesHutNode>& node, const Vector& r0, const Size idx) const;
 
+    void buildTree(IScheduler& scheduler, const Storage& storage, const bool refit);
+
     void buildLeaf(BarnesHutNode& node);
 
     void buildInner(BarnesHutNode& node, BarnesHutNode& left, BarnesHutNode& right);
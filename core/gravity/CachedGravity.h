@@ -44,6 +44,10 @@ public:
         gravity->build(scheduler, storage);
     }
 
+    virtual void refit(IScheduler& scheduler, const Storage& storage) override {
+        gravity->refit(scheduler, storage);
+    }
+
     virtual void evalSelfGravity(IScheduler& scheduler,
         ArrayView<Vector> dv,
         Statistics& stats) const override {
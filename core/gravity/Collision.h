@@ -40,10 +40,21 @@ public:
     ///                 collision handler should only add new indices and it shall not clear the storage.
     /// \return True if the collision took place, false to reject the collision.
     ///
+    /// Unless \ref isLocal returns false, the function may only modify quantities of i-th and j-th particle,
+    /// as collisions of distant particles can be resolved concurrently.
+    ///
     /// \todo Needs to be generatelized for fragmentation handlers. Currently the function CANNOT change the
     /// number of particles as it would invalidate arrayviews and we would lost the track of i-th and j-th
     /// particle (which we need for decreasing movement time).
     virtual CollisionResult collide(const Size i, const Size j, FlatSet<Size>& toRemove) = 0;
+
+    /// \brief Returns true if the handler only modifies the collided particles.
+    ///
+    /// Handlers modifying other particles (for example whole aggregates) have to return false; their
+    /// collisions are then always resolved serially.
+    virtual bool isLocal() const {
+        return true;
+    }
 };
 
 /// \brief Handles overlaps of particles.
@@ -64,8 +75,14 @@ public:
     /// \brief Handles the overlap of two particles.
     ///
     /// When called, the particles must actually overlap (\ref overlaps must return true). This is checked by
-    /// assert.
+    /// assert. Similarly to \ref ICollisionHandler::collide, only i-th and j-th particle may be modified,
+    /// unless \ref isLocal returns false.
     virtual void handle(const Size i, const Size j, FlatSet<Size>& toRemove) = 0;
+
+    /// \brief Returns true if the handler only modifies the overlapping particles.
+    virtual bool isLocal() const {
+        return true;
+    }
 };
 
 /// \brief Helper function sorting two values
@@ -351,6 +368,10 @@ public:
             return result;
         }
     }
+
+    virtual bool isLocal() const override {
+        return primary.isLocal() && fallback.isLocal();
+    }
 };
 
 class FragmentationHandler : public ICollisionHandler {
@@ -462,6 +483,10 @@ public:
         // Now when the two particles are touching, handle the collision using the followup handler.
         handler.collide(i, j, toRemove);
     }
+
+    virtual bool isLocal() const override {
+        return handler.isLocal();
+    }
 };
 
 /// \brief Overlap handler performing a bounce of particles.
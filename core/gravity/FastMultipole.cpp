@@ -0,0 +1,440 @@
+#include "gravity/FastMultipole.h"
+#include "gravity/Moments.h"
+#include "objects/utility/Algorithm.h"
+#include "quantities/Storage.h"
+#include "system/Profiler.h"
+#include "system/Statistics.h"
+#include "thread/Scheduler.h"
+
+NAMESPACE_SPH_BEGIN
+
+namespace {
+
+/// Maximum order of the local expansion; one order higher than the highest multipole moments.
+constexpr Size MAX_ORDER = 4;
+
+/// Returns the number of Cartesian expansion coefficients up to given order (inclusive).
+constexpr Size getCoefficientCnt(const Size order) {
+    return (order + 1) * (order + 2) * (order + 3) / 6;
+}
+
+/// Number of coefficients of the local expansion
+constexpr Size LOCAL_CNT = getCoefficientCnt(MAX_ORDER);
+
+/// Number of coefficients of the multipole moments
+constexpr Size MOMENT_CNT = getCoefficientCnt(MAX_ORDER - 1);
+
+/// \brief Precomputed index tables of the Cartesian expansion.
+///
+/// Coefficients are labeled by multi-indices (kx, ky, kz), sorted by their degree kx + ky + kz, so the
+/// coefficients up to given order form a prefix of the expansion. The multipole moments of a node are
+/// stored as \f$ M_k = \sum_j m_j s_j^k / k! \f$, where \f$s_j\f$ is the position of the particle relative
+/// to the center of mass. The local expansion of the evaluated node contains the derivatives of the
+/// potential \f$ L_n \f$, so that the acceleration in the node is \f$ a_i(y) = \sum_n L_{n + e_i} y^n / n!
+/// \f$, where \f$y\f$ is the position relative to the center of mass of the node.
+struct ExpansionTables {
+    /// Exponents of the multi-index
+    Size k[LOCAL_CNT][3];
+
+    /// Index of the multi-index with one of the exponents decreased by one
+    Size parent[LOCAL_CNT];
+
+    /// Axis of the decreased exponent
+    Size axis[LOCAL_CNT];
+
+    /// Indices of multi-indices with exponents decreased by one and two; Size(-1) if not defined
+    Size down1[LOCAL_CNT][3];
+    Size down2[LOCAL_CNT][3];
+
+    /// Coefficients of the recurrence relation for derivatives of 1/r
+    Float coeff1[LOCAL_CNT][3];
+    Float coeff2[LOCAL_CNT][3];
+
+    /// Indices of multi-indices with one of the exponents increased by one
+    Size up[LOCAL_CNT][3];
+
+    /// Pair of multi-indices n, k and the index of the sum n + k
+    struct Term {
+        Size n;
+        Size k;
+        Size nk;
+        Float sign;
+    };
+
+    /// Terms of the multipole-to-local translation, sorted by the degree of n + k
+    Array<Term> m2l;
+
+    /// Number of terms of the multipole-to-local translation for given order of the local expansion
+    Size m2lCnt[MAX_ORDER + 1];
+
+    /// Terms of the local-to-local translation, sorted by the degree of n + k
+    Array<Term> l2l;
+
+    /// Number of terms of the local-to-local translation for given order of the local expansion
+    Size l2lCnt[MAX_ORDER + 1];
+
+    ExpansionTables() {
+        Size lookup[MAX_ORDER + 1][MAX_ORDER + 1][MAX_ORDER + 1];
+        Size idx = 0;
+        for (Size degree = 0; degree <= MAX_ORDER; ++degree) {
+            for (Size kx = degree + 1; kx-- > 0;) {
+                for (Size ky = degree - kx + 1; ky-- > 0;) {
+                    const Size kz = degree - kx - ky;
+                    k[idx][0] = kx;
+                    k[idx][1] = ky;
+                    k[idx][2] = kz;
+                    lookup[kx][ky][kz] = idx;
+                    ++idx;
+                }
+            }
+        }
+        SPH_ASSERT(idx == LOCAL_CNT);
+
+        auto getIndex = [&lookup](const Size kx, const Size ky, const Size kz) {
+            return kx + ky + kz <= MAX_ORDER ? lookup[kx][ky][kz] : Size(-1);
+        };
+        auto getDegree = [this](const Size i) { return k[i][0] + k[i][1] + k[i][2]; };
+
+        for (Size i = 0; i < LOCAL_CNT; ++i) {
+            const Size degree = getDegree(i);
+            parent[i] = axis[i] = Size(-1);
+            for (Size a = 0; a < 3; ++a) {
+                Size k1[3] = { k[i][0], k[i][1], k[i][2] };
+                ++k1[a];
+                up[i][a] = getIndex(k1[0], k1[1], k1[2]);
+
+                down1[i][a] = down2[i][a] = Size(-1);
+                coeff1[i][a] = coeff2[i][a] = 0._f;
+                if (k[i][a] >= 1) {
+                    k1[a] -= 2;
+                    down1[i][a] = getIndex(k1[0], k1[1], k1[2]);
+                    coeff1[i][a] = -Float(2 * degree - 1) * k[i][a] / degree;
+                    if (parent[i] == Size(-1)) {
+                        parent[i] = down1[i][a];
+                        axis[i] = a;
+                    }
+                }
+                if (k[i][a] >= 2) {
+                    --k1[a];
+                    down2[i][a] = getIndex(k1[0], k1[1], k1[2]);
+                    coeff2[i][a] = -Float(degree - 1) * k[i][a] * (k[i][a] - 1) / degree;
+                }
+            }
+        }
+
+        for (Size degree = 0; degree <= MAX_ORDER; ++degree) {
+            for (Size n = 1; n < LOCAL_CNT; ++n) {
+                for (Size j = 0; j < LOCAL_CNT; ++j) {
+                    if (getDegree(n) + getDegree(j) != degree) {
+                        continue;
+                    }
+                    const Size nk = getIndex(k[n][0] + k[j][0], k[n][1] + k[j][1], k[n][2] + k[j][2]);
+                    SPH_ASSERT(nk != Size(-1));
+                    l2l.push(Term{ n, j, nk, 1._f });
+                    if (j < MOMENT_CNT) {
+                        m2l.push(Term{ n, j, nk, getDegree(j) % 2 == 0 ? 1._f : -1._f });
+                    }
+                }
+            }
+            m2lCnt[degree] = m2l.size();
+            l2lCnt[degree] = l2l.size();
+        }
+    }
+};
+
+const ExpansionTables& getTables() {
+    static ExpansionTables tables;
+    return tables;
+}
+
+/// Computes the scaled powers \f$ d^k / k! \f$ for all multi-indices up to given order.
+INLINE void computePowers(const ExpansionTables& tables, const Vector& d, const Size cnt, Float* powers) {
+    powers[0] = 1._f;
+    for (Size i = 1; i < cnt; ++i) {
+        const Size a = tables.axis[i];
+        powers[i] = powers[tables.parent[i]] * d[a] / tables.k[i][a];
+    }
+}
+
+/// Computes derivatives of 1/r for all multi-indices up to given order, using the recurrence relation
+/// \f$ |k| r^2 D_k = -(2|k| - 1) \sum_i k_i R_i D_{k - e_i} - (|k| - 1) \sum_i k_i (k_i - 1) D_{k - 2e_i} \f$.
+INLINE void computeDerivatives(const ExpansionTables& tables, const Vector& R, const Size cnt, Float* D) {
+    const Float rSqrInv = 1._f / getSqrLength(R);
+    D[0] = sqrt(rSqrInv);
+    for (Size i = 1; i < cnt; ++i) {
+        Float value = 0._f;
+        for (Size a = 0; a < 3; ++a) {
+            if (tables.down1[i][a] != Size(-1)) {
+                value += tables.coeff1[i][a] * R[a] * D[tables.down1[i][a]];
+            }
+            if (tables.down2[i][a] != Size(-1)) {
+                value += tables.coeff2[i][a] * D[tables.down2[i][a]];
+            }
+        }
+        D[i] = value * rSqrInv;
+    }
+}
+
+/// Converts the traceless moments into coefficients of the Cartesian expansion. As the derivatives of 1/r
+/// are traceless, the traceless moments give the same field as the full moments.
+void convertMoments(const MultipoleExpansion<3>& moments, const MultipoleOrder order, Float* M) {
+    std::fill(M, M + MOMENT_CNT, 0._f);
+    M[0] = moments.order<0>().value();
+    if (Size(order) < 1) {
+        return;
+    }
+    const TracelessMultipole<1>& q1 = moments.order<1>();
+    M[1] = q1.value<0>();
+    M[2] = q1.value<1>();
+    M[3] = q1.value<2>();
+    if (Size(order) < 2) {
+        return;
+    }
+    const TracelessMultipole<2>& q2 = moments.order<2>();
+    M[4] = q2.value<0, 0>() / 2._f;
+    M[5] = q2.value<0, 1>();
+    M[6] = q2.value<0, 2>();
+    M[7] = q2.value<1, 1>() / 2._f;
+    M[8] = q2.value<1, 2>();
+    M[9] = q2.value<2, 2>() / 2._f;
+    if (Size(order) < 3) {
+        return;
+    }
+    const TracelessMultipole<3>& q3 = moments.order<3>();
+    M[10] = q3.value<0, 0, 0>() / 6._f;
+    M[11] = q3.value<0, 0, 1>() / 2._f;
+    M[12] = q3.value<0, 0, 2>() / 2._f;
+    M[13] = q3.value<0, 1, 1>() / 2._f;
+    M[14] = q3.value<0, 1, 2>();
+    M[15] = q3.value<0, 2, 2>() / 2._f;
+    M[16] = q3.value<1, 1, 1>() / 6._f;
+    M[17] = q3.value<1, 1, 2>() / 2._f;
+    M[18] = q3.value<1, 2, 2>() / 2._f;
+    M[19] = q3.value<2, 2, 2>() / 6._f;
+}
+
+/// Returns the order of the local expansion corresponding to given order of multipole moments. Monopole
+/// moments also use the second order, as the dipole moment with a respect to the center of mass is zero.
+INLINE Size getLocalOrder(const MultipoleOrder order) {
+    return max(Size(order), Size(1)) + 1;
+}
+
+} // namespace
+
+FastMultipole::FastMultipole(const Float theta,
+    const MultipoleOrder order,
+    const Size leafSize,
+    const Size maxDepth,
+    const Float gravityConstant)
+    : BarnesHut(theta, order, leafSize, maxDepth, gravityConstant) {
+    SPH_ASSERT(getLocalOrder(order) <= MAX_ORDER);
+}
+
+FastMultipole::FastMultipole(const Float theta,
+    const MultipoleOrder order,
+    GravityLutKernel&& kernel,
+    const Size leafSize,
+    const Size maxDepth,
+    const Float gravityConstant)
+    : BarnesHut(theta, order, std::move(kernel), leafSize, maxDepth, gravityConstant) {
+    SPH_ASSERT(getLocalOrder(order) <= MAX_ORDER);
+}
+
+void FastMultipole::build(IScheduler& scheduler, const Storage& storage) {
+    BarnesHut::build(scheduler, storage);
+    this->buildExpansions(scheduler);
+}
+
+void FastMultipole::refit(IScheduler& scheduler, const Storage& storage) {
+    BarnesHut::refit(scheduler, storage);
+    this->buildExpansions(scheduler);
+}
+
+void FastMultipole::buildExpansions(IScheduler& scheduler) {
+    VERBOSE_LOG
+
+    const Size nodeCnt = r.empty() ? 0 : kdTree.getNodeCnt();
+    nodeMoments.resize(nodeCnt * MOMENT_CNT);
+    radii.resize(nodeCnt);
+    parallelFor(scheduler, 0, nodeCnt, 64, [this](const Size nodeIdx) {
+        const BarnesHutNode& node = kdTree.getNode(nodeIdx);
+        convertMoments(node.moments, order, &nodeMoments[nodeIdx * MOMENT_CNT]);
+        if (node.r_open == 0._f) {
+            // empty node or a single particle
+            radii[nodeIdx] = 0._f;
+        } else {
+            const Vector r_max = max(node.com - node.box.lower(), node.box.upper() - node.com);
+            radii[nodeIdx] = getLength(r_max);
+        }
+    });
+}
+
+class FastMultipole::FmmTask : public Noncopyable {
+private:
+    const FastMultipole& fmm;
+    IScheduler& scheduler;
+    ArrayView<Vector> dv;
+    ArrayView<Float> locals;
+    Size nodeIdx;
+    Array<Size> checkList;
+    Size depth;
+    BarnesHut::TreeWalkResult& result;
+
+public:
+    FmmTask(const FastMultipole& fmm,
+        IScheduler& scheduler,
+        ArrayView<Vector> dv,
+        ArrayView<Float> locals,
+        const Size nodeIdx,
+        Array<Size>&& checkList,
+        const Size depth,
+        BarnesHut::TreeWalkResult& result)
+        : fmm(fmm)
+        , scheduler(scheduler)
+        , dv(dv)
+        , locals(locals)
+        , nodeIdx(nodeIdx)
+        , checkList(std::move(checkList))
+        , depth(depth)
+        , result(result) {}
+
+    void operator()() {
+        fmm.evalNode(scheduler, dv, locals, nodeIdx, std::move(checkList), depth, result);
+    }
+};
+
+void FastMultipole::evalSelfGravity(IScheduler& scheduler, ArrayView<Vector> dv, Statistics& stats) const {
+    VERBOSE_LOG
+
+    TreeWalkResult result;
+    if (!r.empty()) {
+        Array<Float> locals(kdTree.getNodeCnt() * LOCAL_CNT);
+        std::fill(locals.begin(), locals.begin() + LOCAL_CNT, 0._f);
+        ArrayView<Float> localsView = locals;
+        SharedPtr<ITask> rootTask = scheduler.submit([this, &scheduler, dv, localsView, &result] {
+            this->evalNode(scheduler, dv, localsView, 0, Array<Size>{ 0 }, 0, result);
+        });
+        rootTask->wait();
+    }
+
+    stats.set<int>(StatisticsId::GRAVITY_NODES_APPROX, result.approximatedNodes);
+    stats.set<int>(StatisticsId::GRAVITY_NODES_EXACT, result.exactNodes);
+    stats.set<int>(StatisticsId::GRAVITY_NODE_COUNT, kdTree.getNodeCnt());
+}
+
+void FastMultipole::evalNode(IScheduler& scheduler,
+    ArrayView<Vector> dv,
+    ArrayView<Float> locals,
+    const Size evaluatedNodeIdx,
+    Array<Size>&& checkList,
+    const Size depth,
+    TreeWalkResult& result) const {
+    const BarnesHutNode& evaluatedNode = kdTree.getNode(evaluatedNodeIdx);
+    if (evaluatedNode.moments.order<0>().value() == 0._f) {
+        // no particles in the node, skip
+        return;
+    }
+
+    const ExpansionTables& tables = getTables();
+    const Size localOrder = getLocalOrder(order);
+    const Float thetaSqr = 1._f / sqr(thetaInv);
+    const Float radius = radii[evaluatedNodeIdx];
+    ArrayView<Float> local = locals.subset(evaluatedNodeIdx * LOCAL_CNT, LOCAL_CNT);
+
+    // nodes passed to children or (in leafs) evaluated pair-wise
+    Array<Size> nextList;
+    Size approximatedNodes = 0;
+    while (!checkList.empty()) {
+        const Size idx = checkList.pop();
+        const BarnesHutNode& node = kdTree.getNode(idx);
+        if (node.moments.order<0>().value() == 0._f) {
+            continue;
+        }
+
+        const Vector dr = evaluatedNode.com - node.com;
+        if (radii[idx] > 0._f && sqr(radius + radii[idx]) < thetaSqr * getSqrLength(dr)) {
+            // well separated nodes, translate the multipole expansion into the local expansion
+            Float D[LOCAL_CNT];
+            computeDerivatives(tables, dr, getCoefficientCnt(localOrder), D);
+            const Float* M = &nodeMoments[idx * MOMENT_CNT];
+            for (Size t = 0; t < tables.m2lCnt[localOrder]; ++t) {
+                const ExpansionTables::Term& term = tables.m2l[t];
+                local[term.n] += term.sign * M[term.k] * D[term.nk];
+            }
+            ++approximatedNodes;
+        } else if (node.isLeaf()) {
+            // interactions within the evaluated leaf are evaluated separately
+            if (idx != evaluatedNodeIdx) {
+                nextList.push(idx);
+            }
+        } else if (evaluatedNode.isLeaf() || radii[idx] > radius) {
+            // open the larger node
+            const InnerNode<BarnesHutNode>& inner = reinterpret_cast<const InnerNode<BarnesHutNode>&>(node);
+            checkList.push(inner.left);
+            checkList.push(inner.right);
+        } else {
+            // open the evaluated node, i.e. pass the node to children
+            nextList.push(idx);
+        }
+    }
+    result.approximatedNodes += approximatedNodes;
+
+    if (evaluatedNode.isLeaf()) {
+        const LeafNode<BarnesHutNode>& leaf = reinterpret_cast<const LeafNode<BarnesHutNode>&>(evaluatedNode);
+        this->evalLeaf(leaf, local, nextList, dv);
+        result.exactNodes += nextList.size();
+        return;
+    }
+
+    // shift the local expansion into the children
+    const InnerNode<BarnesHutNode>& inner = reinterpret_cast<const InnerNode<BarnesHutNode>&>(evaluatedNode);
+    for (Size childIdx : { inner.left, inner.right }) {
+        const BarnesHutNode& child = kdTree.getNode(childIdx);
+        ArrayView<Float> childLocal = locals.subset(childIdx * LOCAL_CNT, LOCAL_CNT);
+        std::fill(childLocal.begin(), childLocal.end(), 0._f);
+        if (child.moments.order<0>().value() == 0._f) {
+            continue;
+        }
+        Float powers[LOCAL_CNT];
+        computePowers(tables, child.com - evaluatedNode.com, getCoefficientCnt(localOrder), powers);
+        for (Size t = 0; t < tables.l2lCnt[localOrder]; ++t) {
+            const ExpansionTables::Term& term = tables.l2l[t];
+            childLocal[term.n] += local[term.nk] * powers[term.k];
+        }
+    }
+
+    // evaluate the left child from a (possibly) different thread, see BarnesHut::evalNode
+    auto task = makeShared<FmmTask>(
+        *this, scheduler, dv, locals, inner.left, nextList.clone(), depth + 1, result);
+    if (depth + 1 < maxDepth) {
+        scheduler.submit(std::move(task));
+    } else {
+        (*task)();
+    }
+    this->evalNode(scheduler, dv, locals, inner.right, std::move(nextList), depth + 1, result);
+}
+
+void FastMultipole::evalLeaf(const LeafNode<BarnesHutNode>& leaf,
+    ArrayView<const Float> local,
+    ArrayView<Size> particleList,
+    ArrayView<Vector> dv) const {
+    const ExpansionTables& tables = getTables();
+    const Size cnt = getCoefficientCnt(getLocalOrder(order) - 1);
+    LeafIndexSequence seq1 = kdTree.getLeafIndices(leaf);
+
+    // evaluate the local expansion
+    for (Size i : seq1) {
+        Float powers[LOCAL_CNT];
+        computePowers(tables, r[i] - leaf.com, cnt, powers);
+        Vector f(0._f);
+        for (Size n = 0; n < cnt; ++n) {
+            f += powers[n] * Vector(local[tables.up[n][X]], local[tables.up[n][Y]], local[tables.up[n][Z]]);
+        }
+        dv[i] += f;
+    }
+
+    // evaluate the particle list, including the intra-leaf interactions
+    this->evalParticleList(leaf, particleList, dv);
+}
+
+NAMESPACE_SPH_END
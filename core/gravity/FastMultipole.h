@@ -0,0 +1,100 @@
+#pragma once
+
+/// \file FastMultipole.h
+/// \brief Fast multipole method for computation of gravitational acceleration
+/// \author Pavel Sevecek (sevecek at sirrah.troja.mff.cuni.cz)
+/// \date 2016-2021
+
+#include "gravity/BarnesHut.h"
+
+NAMESPACE_SPH_BEGIN
+
+/// \brief Fast multipole method (FMM) using the K-d tree and the multipole moments of \ref BarnesHut.
+///
+/// Instead of evaluating the multipole expansion of each distant node at every particle, the multipole
+/// expansions are translated into local (Taylor) expansions of the gravitational field around centers of
+/// mass of the evaluated nodes (multipole-to-local translations). Interacting pairs of nodes are found by a
+/// dual tree traversal, opening the larger of the nodes until the pair satisfies the acceptance criterion
+///  \f$ (r_A + r_B) < \theta |com_A - com_B| \f$, where \f$r_A\f$, \f$r_B\f$ are the radii of the nodes
+/// measured from their centers of mass. The local expansions are then shifted down the tree and evaluated
+/// at the particles, so the cost of the method scales as O(N).
+///
+/// The expansions are computed in Cartesian coordinates; the local expansion is one order higher than the
+/// order of the multipole moments, so that the truncation error of the accelerations matches the error of
+/// \ref BarnesHut with the same multipole order. Evaluation of gravity at a single point and the
+/// interactions with attractors are inherited from \ref BarnesHut.
+class FastMultipole : public BarnesHut {
+private:
+    /// Multipole moments of nodes, stored as coefficients of the Cartesian expansion
+    Array<Float> nodeMoments;
+
+    /// Radii of the nodes, measured from the center of mass; zero for empty nodes and single particles
+    Array<Float> radii;
+
+    /// Helper task for parallelization of treewalk
+    class FmmTask;
+
+public:
+    /// \brief Constructs the FMM gravity assuming point-like particles (with zero radius).
+    ///
+    /// \param theta Opening angle; lower value means higher precision, but slower computation
+    /// \param order Order of multipole moments
+    /// \param leafSize Maximum number of particles in a leaf
+    /// \param maxDepth Maximum parallel depth for tree contruction and evaluation
+    FastMultipole(const Float theta,
+        const MultipoleOrder order,
+        const Size leafSize = 25,
+        const Size maxDepth = 50,
+        const Float gravityConstant = Constants::gravity);
+
+    /// \brief Constructs the FMM gravity with given smoothing kernel
+    ///
+    /// \param theta Opening angle; lower value means higher precision, but slower computation
+    /// \param order Order of multipole moments
+    /// \param kernel Precomputed gravity smoothing kernel
+    /// \param leafSize Maximum number of particles in a leaf
+    /// \param maxDepth Maximum parallel depth for tree contruction and evaluation
+    FastMultipole(const Float theta,
+        const MultipoleOrder order,
+        GravityLutKernel&& kernel,
+        const Size leafSize = 25,
+        const Size maxDepth = 50,
+        const Float gravityConstant = Constants::gravity);
+
+    virtual void build(IScheduler& scheduler, const Storage& storage) override;
+
+    virtual void refit(IScheduler& scheduler, const Storage& storage) override;
+
+    virtual void evalSelfGravity(IScheduler& scheduler, ArrayView<Vector> dv, Statistics& stats) const override;
+
+private:
+    /// \brief Performs a recursive dual treewalk evaluating gravity for all particles.
+    ///
+    /// Nodes from the checklist are either approximated by multipole-to-local translation into the local
+    /// expansion of the evaluated node, opened, or passed to the children of the evaluated node. In leafs,
+    /// the local expansion is evaluated at particles and the remaining nodes are summed pair-wise.
+    /// \param scheduler Scheduler used for (potential) parallelization
+    /// \param dv Output buffer where computed accelerations are stored
+    /// \param locals Local expansions of all nodes; the expansion of the evaluated node must already contain
+    ///               the contribution shifted from its parent.
+    /// \param nodeIdx Index of the evaluated node
+    /// \param checkList Indices of nodes interacting with the evaluated node
+    /// \param depth Current depth in the tree; root node has depth equal to zero.
+    /// \param result Statistics incremented by the node.
+    void evalNode(IScheduler& scheduler,
+        ArrayView<Vector> dv,
+        ArrayView<Float> locals,
+        const Size nodeIdx,
+        Array<Size>&& checkList,
+        const Size depth,
+        TreeWalkResult& result) const;
+
+    void buildExpansions(IScheduler& scheduler);
+
+    void evalLeaf(const LeafNode<BarnesHutNode>& leaf,
+        ArrayView<const Float> local,
+        ArrayView<Size> particleList,
+        ArrayView<Vector> dv) const;
+};
+
+NAMESPACE_SPH_END
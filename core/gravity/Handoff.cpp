@@ -184,7 +184,7 @@ void mergeOverlappingSpheres(IScheduler& scheduler,
         // find connected components
         Array<Size> indices;
         const InnerParticleChecker checker(surface);
-        const Size numComponents = Post::findComponents(storage, 2._f, checker, indices);
+        const Size numComponents = Post::findComponents(scheduler, storage, 2._f, checker, indices);
         Array<Size> componentSizes(numComponents);
         componentSizes.fill(0);
         for (Size i = 0; i < indices.size(); ++i) {
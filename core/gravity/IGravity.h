@@ -22,6 +22,16 @@ public:
     ///                 (single-threaded) execution.
     virtual void build(IScheduler& scheduler, const Storage& storage) = 0;
 
+    /// \brief Updates the accelerating structure after particles moved.
+    ///
+    /// Can be called instead of \ref build if the particles of the storage are the same as in the previous
+    /// call, only their positions (and other quantities) changed. Implementations may re-use the structure
+    /// created by the previous call and only update the cached data, falling back to the full build when
+    /// necessary. The default implementation simply calls \ref build.
+    virtual void refit(IScheduler& scheduler, const Storage& storage) {
+        this->build(scheduler, storage);
+    }
+
     /// \brief Evaluates the self-gravitational accelerations of particles.
     ///
     /// The function is blocking, it must exit after the gravity is evaluated.
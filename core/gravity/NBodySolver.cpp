@@ -2,8 +2,11 @@
 #include "gravity/BruteForceGravity.h"
 #include "gravity/Collision.h"
 #include "io/Logger.h"
+#include "objects/finders/Bvh.h"
 #include "objects/finders/NeighborFinder.h"
+#include "objects/geometry/Box.h"
 #include "quantities/Quantity.h"
+#include "quantities/Utility.h"
 #include "sph/Diagnostics.h"
 #include "system/Factory.h"
 #include "system/Settings.h"
@@ -35,7 +38,7 @@ HardSphereSolver::HardSphereSolver(IScheduler& scheduler,
     , scheduler(scheduler)
     , threadData(scheduler) {
     collision.handler = std::move(collisionHandler);
-    collision.finder = Factory::getFinder(settings);
+    collision.broadphase = makeAuto<Bvh<BvhBox>>();
     collision.maxBounces = settings.get<int>(RunSettingsId::COLLISION_MAX_BOUNCES);
     overlap.handler = std::move(overlapHandler);
     overlap.allowedRatio = settings.get<Float>(RunSettingsId::COLLISION_ALLOWED_OVERLAP);
@@ -98,7 +101,7 @@ void HardSphereSolver::integrate(Storage& storage, Statistics& stats) {
     VERBOSE_LOG;
 
     Timer timer;
-    gravity->build(scheduler, storage);
+    gravity->refit(scheduler, storage);
 
     ArrayView<Vector> dv = storage.getD2t<Vector>(QuantityId::POSITION);
     SPH_ASSERT_UNEVAL(std::all_of(dv.begin(), dv.end(), [](const Vector& a) { return a == Vector(0._f); }));
@@ -117,9 +120,6 @@ void HardSphereSolver::integrate(Storage& storage, Statistics& stats) {
 }
 
 class CollisionStats {
-private:
-    Statistics& stats;
-
 public:
     /// Number of all collisions (does not count overlaps)
     Size collisionCount = 0;
@@ -133,10 +133,15 @@ public:
     /// Number of overlaps handled
     Size overlapCount = 0;
 
-    explicit CollisionStats(Statistics& stats)
-        : stats(stats) {}
+    CollisionStats& operator+=(const CollisionStats& other) {
+        collisionCount += other.collisionCount;
+        mergerCount += other.mergerCount;
+        bounceCount += other.bounceCount;
+        overlapCount += other.overlapCount;
+        return *this;
+    }
 
-    ~CollisionStats() {
+    void save(Statistics& stats) const {
         stats.set(StatisticsId::TOTAL_COLLISION_COUNT, int(collisionCount));
         stats.set(StatisticsId::BOUNCE_COUNT, int(bounceCount));
         stats.set(StatisticsId::MERGER_COUNT, int(mergerCount));
@@ -243,6 +248,13 @@ public:
         checkConsistency();
     }
 
+    void insert(const CollisionSet& other) {
+        for (const CollisionRecord& col : other.collisions) {
+            insert(col);
+        }
+        checkConsistency();
+    }
+
     const CollisionRecord& top() const {
         return *collisions.begin();
     }
@@ -326,6 +338,74 @@ private:
     }
 };
 
+struct HardSphereSolver::Island {
+    /// Index of the island
+    Size index;
+
+    /// Region that contains all particles of the island during the resolution. As long as the particles stay
+    /// within the region, the island cannot interact with particles of other islands.
+    Box safeBox;
+
+    /// Collisions of the island that have not been resolved yet
+    CollisionSet collisions;
+
+    /// Particles removed by the collisions of the island
+    FlatSet<Size> removed;
+
+    /// Statistics of collisions resolved in the island
+    CollisionStats stats;
+
+    /// Set to true if a particle of the island left the safe region
+    bool paused = false;
+};
+
+/// Island index of particles outside of all islands
+const Size NO_ISLAND = Size(-1);
+
+/// Maximum number of iterations of the island construction, before falling back to the serial resolution
+const Size MAX_ISLAND_ITERATIONS = 16;
+
+static Size findRoot(ArrayView<Size> parents, Size i) {
+    while (parents[i] != i) {
+        parents[i] = parents[parents[i]];
+        i = parents[i];
+    }
+    return i;
+}
+
+static bool unite(ArrayView<Size> parents, const Size i, const Size j) {
+    const Size ri = findRoot(parents, i);
+    const Size rj = findRoot(parents, j);
+    if (ri == rj) {
+        return false;
+    }
+    // link under the lower index, so that the result does not depend on the order of unions
+    parents[max(ri, rj)] = min(ri, rj);
+    return true;
+}
+
+static Box extendBox(const Box& box, const Float padding) {
+    return Box(box.lower() - Vector(padding), box.upper() + Vector(padding));
+}
+
+/// \brief Returns the box enclosing the sphere moving with given velocity during the time step.
+static Box getSweptBox(const Vector& r, const Vector& v, const Float dt) {
+    Box box;
+    box.extend(r);
+    box.extend(r + v * dt);
+    return extendBox(box, r[H]);
+}
+
+/// \brief Sets the owner of the search radius of given particle.
+///
+/// The particle with the highest index is kept, which corresponds to the last write in the sequential order.
+static void setSearchOwner(ArrayView<std::atomic<Size>> owners, const Size idx, const Size owner) {
+    Size current = owners[idx].load(std::memory_order_relaxed);
+    while (current < owner + 1 &&
+           !owners[idx].compare_exchange_weak(current, owner + 1, std::memory_order_relaxed)) {
+    }
+}
+
 void HardSphereSolver::collide(Storage& storage, Statistics& stats, const Float dt) {
     VERBOSE_LOG
 
@@ -342,20 +422,26 @@ void HardSphereSolver::collide(Storage& storage, Statistics& stats, const Float
     ArrayView<Vector> a;
     tie(r, v, a) = storage.getAll<Vector>(QuantityId::POSITION);
 
-    // find the radius of possible colliders
-    // const Float searchRadius = getSearchRadius(r, v, dt);
-
-    // tree for finding collisions
-    collision.finder->buildWithRank(scheduler, r, [this, dt](const Size i, const Size j) {
-        return r[i][H] + getLength(v[i]) * dt < r[j][H] + getLength(v[j]) * dt;
-    });
+    // hierarchy of particle trajectories for finding collisions; the hierarchy from the previous time step is
+    // refitted if the particles have not been added or removed
+    Array<BvhBox> boxes;
+    boxes.reserve(r.size());
+    for (Size i = 0; i < r.size(); ++i) {
+        BvhBox& box = boxes.emplaceBack(getSweptBox(r[i], v[i], dt));
+        box.userData = i;
+    }
+    collision.broadphase->refit(scheduler, std::move(boxes));
 
     // handler determining collision outcomes
     collision.handler->initialize(storage);
     overlap.handler->initialize(storage);
 
-    searchRadii.resize(r.size());
-    searchRadii.fill(0._f);
+    if (searchOwners.size() != r.size()) {
+        searchOwners = Array<std::atomic<Size>>(r.size());
+    }
+    for (std::atomic<Size>& owner : searchOwners) {
+        owner.store(0, std::memory_order_relaxed);
+    }
 
     numBounces.resize(r.size());
     numBounces.fill(0);
@@ -364,43 +450,236 @@ void HardSphereSolver::collide(Storage& storage, Statistics& stats, const Float
         data.collisions.clear();
     }
 
+    removed.clear();
+    islandIdxs.resize(r.size());
+    islandIdxs.fill(NO_ISLAND);
+
     // first pass - find all collisions and sort them by collision time
     parallelFor(scheduler, threadData, 0, r.size(), [&](const Size i, ThreadData& data) {
-        if (CollisionRecord col =
-                this->findClosestCollision(i, SearchEnum::FIND_LOWER_RANK, Interval(0._f, dt), data.neighs)) {
+        if (CollisionRecord col = this->findClosestCollision(
+                i, SearchEnum::FIND_LOWER_RANK, Interval(0._f, dt), removed, NO_ISLAND, data.neighs)) {
             SPH_ASSERT(isReal(col));
             data.collisions.push(col);
         }
     });
 
-    // Holds all detected collisions.
-    CollisionSet collisions;
+    searchRadii.resize(r.size());
+    parallelFor(scheduler, 0, r.size(), [&](const Size i) {
+        const Size owner = searchOwners[i].load(std::memory_order_relaxed);
+        searchRadii[i] = owner > 0 ? r[owner - 1][H] + getLength(v[owner - 1]) * dt : 0._f;
+    });
 
     // reduce thread-local containers
-    {
-        ThreadData* main = nullptr;
-        for (ThreadData& data : threadData) {
-            if (!main) {
-                main = &data;
-            } else {
-                main->collisions.pushAll(data.collisions);
-                data.collisions.clear();
+    ThreadData* main = nullptr;
+    for (ThreadData& data : threadData) {
+        if (!main) {
+            main = &data;
+        } else {
+            main->collisions.pushAll(data.collisions);
+            data.collisions.clear();
+        }
+    }
+    // sort to get a deterministic order in index-to-collision maps
+    std::sort(main->collisions.begin(), main->collisions.end());
+
+    // Collisions have to be processed in order, sorted according to collision time. Collisions of different
+    // islands cannot interact, though, so the islands can be processed concurrently.
+    Array<Island> islands;
+    if (scheduler.getThreadCnt() > 1 && collision.handler->isLocal() && overlap.handler->isLocal()) {
+        islands = this->findIslands(main->collisions, dt);
+    }
+
+    CollisionStats cs;
+    bool resolved = false;
+    if (islands.size() > 1) {
+        // save the island particles, in case the concurrent resolution has to be discarded
+        Array<Size> members;
+        for (Size i = 0; i < islandIdxs.size(); ++i) {
+            if (islandIdxs[i] != NO_ISLAND) {
+                members.push(i);
+            }
+        }
+        ParticleBackup backup(storage, std::move(members));
+
+        // the broad-phase may still return particles of other islands, these are skipped by the island index
+        std::atomic<bool> paused{ false };
+        parallelFor(scheduler, threadData, 0, islands.size(), 1, [&](const Size k, ThreadData& data) {
+            if (paused.load(std::memory_order_relaxed)) {
+                // result is discarded anyway
+                return;
+            }
+            Island& island = islands[k];
+            this->resolveCollisions(
+                island.collisions, island.removed, island.stats, &island, dt, data.neighs);
+            if (island.paused) {
+                paused.store(true, std::memory_order_relaxed);
+            }
+        });
+
+        if (!paused) {
+            Array<Size> islandRemoved;
+            for (Island& island : islands) {
+                cs += island.stats;
+                islandRemoved.pushAll(island.removed.begin(), island.removed.end());
             }
+            removed.insert(islandRemoved.begin(), islandRemoved.end());
+            resolved = true;
+        } else {
+            // Particles of an island might interact with other islands, so the result could differ from the
+            // serial resolution. Undo the changes and resolve all collisions serially.
+            backup.restore(storage);
+            numBounces.fill(0);
         }
-        // sort to get a deterministic order in index-to-collision maps
-        std::sort(main->collisions.begin(), main->collisions.end());
+    }
+    if (!resolved) {
+        CollisionSet collisions;
         collisions.insert(main->collisions.begin(), main->collisions.end());
+        this->resolveCollisions(collisions, removed, cs, nullptr, dt, neighs);
     }
+    cs.save(stats);
 
-    CollisionStats cs(stats);
-    removed.clear();
+    // apply the removal list
+    if (!removed.empty()) {
+        // remove it also from all dependent storages, since this is a permanent action
+        storage.remove(removed, Storage::IndicesFlag::INDICES_SORTED | Storage::IndicesFlag::PROPAGATE);
+    }
+    SPH_ASSERT(storage.isValid());
+
+    stats.set(StatisticsId::COLLISION_EVAL_TIME, int(timer.elapsed(TimerUnit::MILLISECOND)));
+}
+
+Array<HardSphereSolver::Island> HardSphereSolver::findIslands(ArrayView<const CollisionRecord> collisions,
+    const Float dt) {
+    // Particles of each collision form an island. Collided particles only move within the sphere given by
+    // their search radius, so the island is extended by the search radius to get the safe region. The
+    // resolution searches for new collisions up to twice the search radius from the safe region; all
+    // particles in this reach are added into the island and islands with overlapping reach are merged.
+    ArrayView<Size> parents = islandIdxs;
+    Array<Size> members;
+    auto add = [&](const Size i) {
+        if (parents[i] == NO_ISLAND) {
+            parents[i] = i;
+            members.push(i);
+        }
+    };
+    for (const CollisionRecord& col : collisions) {
+        add(col.i);
+        add(col.j);
+        unite(parents, col.i, col.j);
+    }
+
+    Array<Size> roots;
+    Array<Size> order;
+    Array<Size> groupRoots;
+    Array<Box> safeBoxes;
+    Array<Box> reachBoxes;
+    for (Size iteration = 0;; ++iteration) {
+        if (iteration == MAX_ISLAND_ITERATIONS) {
+            return Array<Island>();
+        }
+
+        // group the members by their roots
+        roots.resize(members.size());
+        order.resize(members.size());
+        for (Size k = 0; k < members.size(); ++k) {
+            roots[k] = findRoot(parents, members[k]);
+            order[k] = k;
+        }
+        std::sort(order.begin(), order.end(), [&roots](const Size k1, const Size k2) {
+            return roots[k1] < roots[k2];
+        });
+
+        groupRoots.clear();
+        safeBoxes.clear();
+        reachBoxes.clear();
+        for (Size k1 = 0; k1 < order.size();) {
+            const Size root = roots[order[k1]];
+            Box box;
+            Float maxRadius = 0._f;
+            Size k2 = k1;
+            for (; k2 < order.size() && roots[order[k2]] == root; ++k2) {
+                const Size i = members[order[k2]];
+                box.extend(r[i]);
+                maxRadius = max(maxRadius, searchRadii[i], r[i][H] + getLength(v[i]) * dt);
+            }
+            groupRoots.push(root);
+            safeBoxes.push(extendBox(box, 2._f * maxRadius));
+            reachBoxes.push(extendBox(box, 4._f * maxRadius));
+            k1 = k2;
+        }
+        if (groupRoots.size() < 2) {
+            return Array<Island>();
+        }
+
+        bool changed = false;
+        // add all particles within the reach of the island
+        for (Size g = 0; g < groupRoots.size(); ++g) {
+            const Box& reach = reachBoxes[g];
+            // trajectories contain the initial positions, so all particles within the reach are found
+            collision.broadphase->getOverlaps(reach, [&](const BvhBox& box) {
+                const Size i = box.userData;
+                if (reach.contains(r[i])) {
+                    add(i);
+                    changed |= unite(parents, i, groupRoots[g]);
+                }
+            });
+        }
 
-    /// \todo
-    /// We have to process the all collision in order, sorted according to collision time, but this is
-    /// hardly parallelized. We can however process collisions concurrently, as long as the collided
-    /// particles don't intersect the spheres with radius equal to the search radius. Note that this works
-    /// as long as the search radius does not increase during collision handling.
+        // merge islands with overlapping reach
+        Array<Size>& sorted = order;
+        sorted.resize(groupRoots.size());
+        for (Size g = 0; g < groupRoots.size(); ++g) {
+            sorted[g] = g;
+        }
+        std::sort(sorted.begin(), sorted.end(), [&reachBoxes](const Size g1, const Size g2) {
+            return reachBoxes[g1].lower()[X] < reachBoxes[g2].lower()[X];
+        });
+        for (Size k1 = 0; k1 < sorted.size(); ++k1) {
+            const Box& box1 = reachBoxes[sorted[k1]];
+            for (Size k2 = k1 + 1; k2 < sorted.size(); ++k2) {
+                const Box& box2 = reachBoxes[sorted[k2]];
+                if (box2.lower()[X] > box1.upper()[X]) {
+                    break;
+                }
+                if (box1.overlaps(box2)) {
+                    changed |= unite(parents, groupRoots[sorted[k1]], groupRoots[sorted[k2]]);
+                }
+            }
+        }
+
+        if (!changed) {
+            break;
+        }
+    }
 
+    // groups are stable now, assign the island indices to the particles
+    Array<Island> islands(groupRoots.size());
+    for (Size g = 0; g < groupRoots.size(); ++g) {
+        islands[g].index = g;
+        islands[g].safeBox = safeBoxes[g];
+    }
+    for (Size k = 0; k < members.size(); ++k) {
+        roots[k] = findRoot(parents, members[k]);
+    }
+    for (Size k = 0; k < members.size(); ++k) {
+        const auto iter = std::lower_bound(groupRoots.begin(), groupRoots.end(), roots[k]);
+        SPH_ASSERT(iter != groupRoots.end() && *iter == roots[k]);
+        islandIdxs[members[k]] = Size(iter - groupRoots.begin());
+    }
+    for (const CollisionRecord& col : collisions) {
+        SPH_ASSERT(islandIdxs[col.i] == islandIdxs[col.j]);
+        islands[islandIdxs[col.i]].collisions.insert(col);
+    }
+    return islands;
+}
+
+void HardSphereSolver::resolveCollisions(CollisionSet& collisions,
+    FlatSet<Size>& toRemove,
+    CollisionStats& cs,
+    Island* island,
+    const Float dt,
+    Array<NeighborRecord>& neighs) {
+    const Size islandIdx = island ? island->index : NO_ISLAND;
     FlatSet<Size> invalidIdxs;
     while (!collisions.empty()) {
         // find first collision in the list
@@ -419,11 +698,11 @@ void HardSphereSolver::collide(Storage& storage, Statistics& stats, const Float
         // check and handle overlaps
         CollisionResult result;
         if (col.isOverlap()) {
-            overlap.handler->handle(i, j, removed);
+            overlap.handler->handle(i, j, toRemove);
             result = CollisionResult::BOUNCE; ///\todo
             cs.overlapCount++;
         } else {
-            result = collision.handler->collide(i, j, removed);
+            result = collision.handler->collide(i, j, toRemove);
             cs.clasify(result);
         }
 
@@ -448,40 +727,50 @@ void HardSphereSolver::collide(Storage& storage, Statistics& stats, const Float
         numBounces[i]++;
         numBounces[j]++;
 
-        const Interval interval(t_coll + EPS, dt);
-        if (!interval.empty()) {
-            for (Size idx : invalidIdxs) {
-                // here we shouldn't search any removed particle
-                if (removed.find(idx) != removed.end()) {
-                    continue;
-                }
-                if (numBounces[idx] > collision.maxBounces) {
-                    // limit reached
-                    continue;
-                }
-                if (CollisionRecord c =
-                        this->findClosestCollision(idx, SearchEnum::USE_RADII, interval, neighs)) {
-                    SPH_ASSERT(isReal(c));
-                    SPH_ASSERT(removed.find(c.i) == removed.end() && removed.find(c.j) == removed.end());
-                    if ((c.i == i && c.j == j) || (c.j == i && c.i == j)) {
-                        // don't process the same pair twice in a row
-                        continue;
-                    }
-
-                    collisions.insert(c);
-                }
-            }
+        if (island && (!island->safeBox.contains(r[i]) || !island->safeBox.contains(r[j]))) {
+            // particles might now interact with other islands, the island cannot be resolved independently
+            island->paused = true;
+            return;
         }
+
+        this->findNewCollisions(collisions, invalidIdxs, toRemove, i, j, t_coll, islandIdx, dt, neighs);
     }
+}
 
-    // apply the removal list
-    if (!removed.empty()) {
-        // remove it also from all dependent storages, since this is a permanent action
-        storage.remove(removed, Storage::IndicesFlag::INDICES_SORTED | Storage::IndicesFlag::PROPAGATE);
+void HardSphereSolver::findNewCollisions(CollisionSet& collisions,
+    const FlatSet<Size>& invalidIdxs,
+    const FlatSet<Size>& toRemove,
+    const Size i,
+    const Size j,
+    const Float t_coll,
+    const Size islandIdx,
+    const Float dt,
+    Array<NeighborRecord>& neighs) {
+    const Interval interval(t_coll + EPS, dt);
+    if (interval.empty()) {
+        return;
     }
-    SPH_ASSERT(storage.isValid());
+    for (Size idx : invalidIdxs) {
+        // here we shouldn't search any removed particle
+        if (toRemove.find(idx) != toRemove.end()) {
+            continue;
+        }
+        if (numBounces[idx] > collision.maxBounces) {
+            // limit reached
+            continue;
+        }
+        if (CollisionRecord c = this->findClosestCollision(
+                idx, SearchEnum::USE_RADII, interval, toRemove, islandIdx, neighs)) {
+            SPH_ASSERT(isReal(c));
+            SPH_ASSERT(toRemove.find(c.i) == toRemove.end() && toRemove.find(c.j) == toRemove.end());
+            if ((c.i == i && c.j == j) || (c.j == i && c.i == j)) {
+                // don't process the same pair twice in a row
+                continue;
+            }
 
-    stats.set(StatisticsId::COLLISION_EVAL_TIME, int(timer.elapsed(TimerUnit::MILLISECOND)));
+            collisions.insert(c);
+        }
+    }
 }
 
 void HardSphereSolver::create(Storage& storage, IMaterial& UNUSED(material)) const {
@@ -509,16 +798,34 @@ void HardSphereSolver::create(Storage& storage, IMaterial& UNUSED(material)) con
 CollisionRecord HardSphereSolver::findClosestCollision(const Size i,
     const SearchEnum opt,
     const Interval interval,
+    const FlatSet<Size>& toRemove,
+    const Size islandIdx,
     Array<NeighborRecord>& neighs) {
     SPH_ASSERT(!interval.empty());
+    neighs.clear();
     if (opt == SearchEnum::FIND_LOWER_RANK) {
-        // maximum travel of i-th particle
-        const Float radius = r[i][H] + getLength(v[i]) * interval.upper();
-        collision.finder->findLowerRank(i, 2._f * radius, neighs);
+        // particles can only collide if the boxes enclosing their trajectories intersect
+        const Float dt = interval.upper();
+        const Float travel = r[i][H] + getLength(v[i]) * dt;
+        collision.broadphase->getOverlaps(getSweptBox(r[i], v[i], dt), [&](const BvhBox& box) {
+            const Size j = box.userData;
+            const Float travelj = r[j][H] + getLength(v[j]) * dt;
+            if (travelj < travel || (travelj == travel && j < i)) {
+                neighs.push(NeighborRecord{ j, getSqrLength(r[i] - r[j]) });
+            }
+        });
     } else {
         SPH_ASSERT(isReal(searchRadii[i]));
         if (searchRadii[i] > 0._f) {
-            collision.finder->findAll(i, 2._f * searchRadii[i], neighs);
+            const Float radius = 2._f * searchRadii[i];
+            const Box box(r[i] - Vector(radius), r[i] + Vector(radius));
+            collision.broadphase->getOverlaps(box, [&](const BvhBox& other) {
+                const Size j = other.userData;
+                const Float distSqr = getSqrLength(r[i] - r[j]);
+                if (distSqr < sqr(radius)) {
+                    neighs.push(NeighborRecord{ j, distSqr });
+                }
+            });
         } else {
             return CollisionRecord{};
         }
@@ -528,12 +835,17 @@ CollisionRecord HardSphereSolver::findClosestCollision(const Size i,
     for (NeighborRecord& n : neighs) {
         const Size j = n.index;
         if (opt == SearchEnum::FIND_LOWER_RANK) {
-            searchRadii[i] = searchRadii[j] = r[i][H] + getLength(v[i]) * interval.upper();
+            setSearchOwner(searchOwners, i, i);
+            setSearchOwner(searchOwners, j, i);
         }
-        if (i == j || removed.find(j) != removed.end()) {
+        if (i == j || toRemove.find(j) != toRemove.end()) {
             // particle already removed, skip
             continue;
         }
+        if (islandIdx != NO_ISLAND && islandIdxs[j] != islandIdx) {
+            // particle belongs to a different island
+            continue;
+        }
         if (numBounces[j] > collision.maxBounces) {
             // limit reached
             continue;
@@ -607,6 +919,8 @@ SoftSphereSolver::SoftSphereSolver(IScheduler& scheduler,
     , threadData(scheduler) {
     force.repel = settings.get<Float>(RunSettingsId::SOFT_REPEL_STRENGTH);
     force.friction = settings.get<Float>(RunSettingsId::SOFT_FRICTION_STRENGTH);
+    contacts.finder = Factory::getFinder(settings);
+    contacts.skin = settings.get<Float>(RunSettingsId::SOFT_CONTACT_SKIN);
 }
 
 SoftSphereSolver::~SoftSphereSolver() = default;
@@ -615,7 +929,7 @@ void SoftSphereSolver::integrate(Storage& storage, Statistics& stats) {
     VERBOSE_LOG;
 
     Timer timer;
-    gravity->build(scheduler, storage);
+    gravity->refit(scheduler, storage);
 
     ArrayView<Float> m = storage.getValue<Float>(QuantityId::MASS);
     ArrayView<Vector> r, v, dv;
@@ -628,31 +942,37 @@ void SoftSphereSolver::integrate(Storage& storage, Statistics& stats) {
 
     stats.set(StatisticsId::GRAVITY_EVAL_TIME, int(timer.elapsed(TimerUnit::MILLISECOND)));
     timer.restart();
-    const IBasicFinder& finder = *gravity->getFinder();
 
-    // precompute the search radii
-    Float maxRadius = 0._f;
-    for (Size i = 0; i < r.size(); ++i) {
-        maxRadius = max(maxRadius, r[i][H]);
+    ArrayView<const Size> ids = storage.getValue<Size>(QuantityId::PERSISTENT_INDEX);
+    if (this->needsRebuild(r, ids)) {
+        this->rebuildContacts(r, ids);
     }
 
-    auto functor = [this, r, maxRadius, m, &v, &dv, &finder](Size i, ThreadData& data) {
-        finder.findAll(i, 2._f * maxRadius, data.neighs);
+    ArrayView<const Size> offsets = contacts.offsets;
+    ArrayView<const Size> neighbors = contacts.neighbors;
+    ArrayView<ContactHistory> history = contacts.history;
+    auto functor = [this, r, m, &v, &dv, offsets, neighbors, &history](const Size i) {
         Vector f(0._f);
-        for (auto& n : data.neighs) {
-            const Size j = n.index;
+        for (Size k = offsets[i]; k < offsets[i + 1]; ++k) {
+            const Size j = neighbors[k];
             const Float hi = r[i][H];
             const Float hj = r[j][H];
-            if (i == j || n.distanceSqr >= sqr(hi + hj)) {
+            Vector dr = r[i] - r[j];
+            dr[H] = 0._f;
+            const Float distSqr = getSqrLength(dr);
+            ContactHistory& contact = history[k];
+            if (distSqr >= sqr(hi + hj)) {
                 // aren't actual neighbors
+                contact.shear = Vector(0._f);
+                contact.dr = dr;
                 continue;
             }
             const Float hbar = 0.5_f * (hi + hj);
             // dimensionless acceleration to SI
             const Float unit = Constants::gravity / sqr(hbar);
-            const Float dist = sqrt(n.distanceSqr);
+            const Float dist = sqrt(distSqr);
             const Float radialForce = force.repel * pow<6>((hi + hj) / dist);
-            const Vector dir = getNormalized(r[i] - r[j]);
+            const Vector dir = dr / dist;
             f += unit * m[j] * dir * radialForce;
 
             const Float vsqr = getSqrLength(v[i] - v[j]);
@@ -660,6 +980,11 @@ void SoftSphereSolver::integrate(Storage& storage, Statistics& stats) {
                 const Vector velocityDir = getNormalized(v[i] - v[j]);
                 f -= unit * m[j] * velocityDir * force.friction;
             }
+
+            // accumulate the tangential displacement, projected to the current tangent plane
+            contact.shear += dr - contact.dr;
+            contact.shear -= dir * dot(dir, contact.shear);
+            contact.dr = dr;
         }
         dv[i] += f;
 
@@ -667,10 +992,118 @@ void SoftSphereSolver::integrate(Storage& storage, Statistics& stats) {
         v[i][H] = 0._f;
         dv[i][H] = 0._f;
     };
-    parallelFor(scheduler, threadData, 0, r.size(), functor);
+    parallelFor(scheduler, 0, r.size(), functor);
     stats.set(StatisticsId::COLLISION_EVAL_TIME, int(timer.elapsed(TimerUnit::MILLISECOND)));
 }
 
-void SoftSphereSolver::create(Storage& UNUSED(storage), IMaterial& UNUSED(material)) const {}
+void SoftSphereSolver::create(Storage& storage, IMaterial& UNUSED(material)) const {
+    // the history of contacts is tied to particles, it has to persist when the storage is reordered
+    if (!storage.has(QuantityId::PERSISTENT_INDEX)) {
+        setPersistentIndices(storage);
+    }
+}
+
+bool SoftSphereSolver::needsRebuild(ArrayView<const Vector> r, ArrayView<const Size> ids) const {
+    if (contacts.positions.size() != r.size() ||
+        !std::equal(ids.begin(), ids.end(), contacts.ids.begin(), contacts.ids.end())) {
+        return true;
+    }
+    // Particles outside of the contact list were separated by at least the skin width times the sum of their
+    // radii, so they cannot touch until one of them moves by more than the skin width times its radius.
+    std::atomic_bool rebuild{ false };
+    ArrayView<const Vector> r0 = contacts.positions;
+    const Float skin = contacts.skin;
+    parallelFor(scheduler, 0, r.size(), [r, r0, skin, &rebuild](const Size i) {
+        if (r[i][H] != r0[i][H] || getSqrLength(r[i] - r0[i]) >= sqr(skin * r0[i][H])) {
+            rebuild = true;
+        }
+    });
+    return rebuild;
+}
+
+void SoftSphereSolver::rebuildContacts(ArrayView<const Vector> r, ArrayView<const Size> ids) {
+    // each pair is found by the particle with the larger radius, so that the search radius of a particle does
+    // not depend on the radii of other particles
+    const Float skin = contacts.skin;
+    contacts.finder->buildWithRank(
+        scheduler, r, [r](const Size i, const Size j) { return r[i][H] < r[j][H]; });
+    for (ThreadData& data : threadData) {
+        data.pairs.clear();
+    }
+    parallelFor(scheduler, threadData, 0, r.size(), [&](const Size i, ThreadData& data) {
+        contacts.finder->findLowerRank(i, 2._f * (1._f + skin) * r[i][H], data.neighs);
+        for (const NeighborRecord& n : data.neighs) {
+            const Size j = n.index;
+            if (i != j && n.distanceSqr < sqr((1._f + skin) * (r[i][H] + r[j][H]))) {
+                data.pairs.push(Pair<Size>{ i, j });
+            }
+        }
+    });
+
+    // convert the pairs into compressed rows
+    const Size particleCnt = r.size();
+    Array<Size> offsets(particleCnt + 1);
+    offsets.fill(0);
+    for (ThreadData& data : threadData) {
+        for (const Pair<Size>& p : data.pairs) {
+            offsets[p[0] + 1]++;
+            offsets[p[1] + 1]++;
+        }
+    }
+    for (Size i = 0; i < particleCnt; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+    Array<Size> neighbors(offsets[particleCnt]);
+    Array<Size> next(particleCnt);
+    std::copy(offsets.begin(), offsets.begin() + particleCnt, next.begin());
+    for (ThreadData& data : threadData) {
+        for (const Pair<Size>& p : data.pairs) {
+            neighbors[next[p[0]]++] = p[1];
+            neighbors[next[p[1]]++] = p[0];
+        }
+    }
+
+    // map persistent indices to particle indices of the previous list, as the particles might have been
+    // reordered or removed since the last build
+    Size idCnt = 0;
+    for (const Size id : contacts.ids) {
+        idCnt = max(idCnt, id + 1);
+    }
+    Array<Size> previous(idCnt);
+    previous.fill(Size(-1));
+    for (Size i0 = 0; i0 < contacts.ids.size(); ++i0) {
+        previous[contacts.ids[i0]] = i0;
+    }
+    auto getPrevious = [&previous](const Size id) { return id < previous.size() ? previous[id] : Size(-1); };
+
+    // sort the rows to get a deterministic order and keep the history of persisting contacts
+    Array<ContactHistory> history(neighbors.size());
+    parallelFor(scheduler, 0, particleCnt, [&](const Size i) {
+        std::sort(neighbors.begin() + offsets[i], neighbors.begin() + offsets[i + 1]);
+        const Size i0 = getPrevious(ids[i]);
+        const auto begin0 = contacts.neighbors.begin() + (i0 != Size(-1) ? contacts.offsets[i0] : 0);
+        const auto end0 = contacts.neighbors.begin() + (i0 != Size(-1) ? contacts.offsets[i0 + 1] : 0);
+        for (Size k = offsets[i]; k < offsets[i + 1]; ++k) {
+            const Size j = neighbors[k];
+            // rows of the previous list are sorted by the previous indices
+            const Size j0 = getPrevious(ids[j]);
+            const auto k0 = std::lower_bound(begin0, end0, j0);
+            if (j0 != Size(-1) && k0 != end0 && *k0 == j0) {
+                history[k] = contacts.history[k0 - contacts.neighbors.begin()];
+            } else {
+                history[k].dr = r[i] - r[j];
+                history[k].dr[H] = 0._f;
+            }
+        }
+    });
+
+    contacts.offsets = std::move(offsets);
+    contacts.neighbors = std::move(neighbors);
+    contacts.history = std::move(history);
+    contacts.positions.resize(particleCnt);
+    std::copy(r.begin(), r.end(), contacts.positions.begin());
+    contacts.ids.resize(particleCnt);
+    std::copy(ids.begin(), ids.end(), contacts.ids.begin());
+}
 
 NAMESPACE_SPH_END
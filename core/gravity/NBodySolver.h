@@ -6,16 +6,22 @@
 /// \date 2016-2021
 
 #include "objects/containers/FlatSet.h"
+#include "objects/containers/StaticArray.h"
 #include "thread/ThreadLocal.h"
 #include "timestepping/ISolver.h"
+#include <atomic>
 
 NAMESPACE_SPH_BEGIN
 
 class ISymmetricFinder;
+class BvhBox;
+template <typename TBvhObject>
+class Bvh;
 class ICollisionHandler;
 class IOverlapHandler;
 class IGravity;
 struct CollisionRecord;
+class CollisionSet;
 class CollisionStats;
 enum class CollisionResult;
 enum class OverlapEnum;
@@ -49,6 +55,13 @@ private:
     /// Maximum distance to search for impactors, per particle.
     Array<Float> searchRadii;
 
+    /// Particle with the highest index that found given particle in the first pass, shifted by one (zero
+    /// means no such particle). Determines the search radii independently of the order of the search.
+    Array<std::atomic<Size>> searchOwners;
+
+    /// Index of the island containing given particle, or Size(-1) for particles outside of all islands.
+    Array<Size> islandIdxs;
+
     /// Number of bounces this time step, per particle.
     Array<Size> numBounces;
 
@@ -57,8 +70,8 @@ private:
         /// Handler used to resolve particle collisions
         AutoPtr<ICollisionHandler> handler;
 
-        /// Finder for searching the neighbors
-        AutoPtr<ISymmetricFinder> finder;
+        /// Bounding volume hierarchy of boxes enclosing the trajectories of particles in the time step
+        AutoPtr<Bvh<BvhBox>> broadphase;
 
         /// Maximal number of bounces per particle per time step
         Size maxBounces = 100;
@@ -115,17 +128,58 @@ private:
     void rotateLocalFrame(Storage& storage, const Float dt);
 
     enum class SearchEnum {
-        /// Finds only particles with lower rank. This option also updates the search radii for each particle,
-        /// so that USE_RADII can be used afterwards.
+        /// Finds only particles with lower rank, given by the maximum travel of particles, and with
+        /// trajectories possibly intersecting the trajectory of the particle. This option also updates the
+        /// owners of search radii for each particle, so that USE_RADII can be used afterwards.
         FIND_LOWER_RANK,
 
         /// Uses search radius generated with FIND_LOWER_RANK.
         USE_RADII,
     };
 
+    /// \brief Group of particles whose collisions can be resolved independently of other particles.
+    struct Island;
+
+    /// \brief Finds the closest collision of i-th particle in given interval.
+    ///
+    /// \param toRemove Particles removed so far; these are skipped by the search.
+    /// \param islandIdx If not equal to Size(-1), only particles of the island with given index are
+    ///                  considered.
     CollisionRecord findClosestCollision(const Size i,
         const SearchEnum opt,
         const Interval interval,
+        const FlatSet<Size>& toRemove,
+        const Size islandIdx,
+        Array<NeighborRecord>& neighs);
+
+    /// \brief Partitions the particles into islands, so that the collisions of different islands cannot
+    /// interfere with each other.
+    ///
+    /// Returns an empty array if the collisions cannot be partitioned into independent islands.
+    Array<Island> findIslands(ArrayView<const CollisionRecord> collisions, const Float dt);
+
+    /// \brief Resolves collisions in the order of the collision time.
+    ///
+    /// New collisions of the collided particles are searched for and added into the set.
+    /// \param island If not nullptr, only particles of given island are considered. The resolution is
+    ///               stopped if any particle leaves the safe region of the island.
+    void resolveCollisions(CollisionSet& collisions,
+        FlatSet<Size>& toRemove,
+        CollisionStats& cs,
+        Island* island,
+        const Float dt,
+        Array<NeighborRecord>& neighs);
+
+    /// \brief Searches new collisions of particles whose collisions were invalidated by collision of i-th
+    /// and j-th particle at time t_coll.
+    void findNewCollisions(CollisionSet& collisions,
+        const FlatSet<Size>& invalidIdxs,
+        const FlatSet<Size>& toRemove,
+        const Size i,
+        const Size j,
+        const Float t_coll,
+        const Size islandIdx,
+        const Float dt,
         Array<NeighborRecord>& neighs);
 
     /// \brief Checks for collision between particles at positions r1 and r2.
@@ -149,6 +203,9 @@ class SoftSphereSolver : public ISolver {
     struct ThreadData {
         /// Neighbors for parallelized queries
         Array<NeighborRecord> neighs;
+
+        /// Pairs of particles found by this thread
+        Array<Pair<Size>> pairs;
     };
 
     ThreadLocal<ThreadData> threadData;
@@ -159,6 +216,44 @@ class SoftSphereSolver : public ISolver {
         Float friction;
     } force;
 
+    /// \brief History of a contact, persisting as long as the particles stay in the contact list.
+    struct ContactHistory {
+        /// Accumulated tangential displacement of the particles while in contact; zero if the particles do
+        /// not touch.
+        Vector shear = Vector(0._f);
+
+        /// Relative position of the particles at the previous evaluation.
+        Vector dr = Vector(0._f);
+    };
+
+    /// \brief Persistent list of particle pairs closer than the sum of their radii enlarged by the skin.
+    ///
+    /// Stored in compressed sparse row format; each pair is stored twice, once for each particle.
+    struct {
+        /// Finder used to (re)build the list
+        AutoPtr<ISymmetricFinder> finder;
+
+        /// Relative width of the skin
+        Float skin;
+
+        /// Indices of the first contact of each particle; has one more element than the number of particles
+        Array<Size> offsets;
+
+        /// Indices of the contact particles, sorted for each particle
+        Array<Size> neighbors;
+
+        /// History of each contact
+        Array<ContactHistory> history;
+
+        /// Positions of particles when the list was built
+        Array<Vector> positions;
+
+        /// Persistent indices of particles when the list was built, used to identify the particles after
+        /// they have been reordered or removed
+        Array<Size> ids;
+
+    } contacts;
+
 public:
     SoftSphereSolver(IScheduler& scheduler, const RunSettings& settings);
 
@@ -169,6 +264,16 @@ public:
     virtual void integrate(Storage& storage, Statistics& stats) override;
 
     virtual void create(Storage& storage, IMaterial& material) const override;
+
+private:
+    /// \brief Checks whether any particle moved by more than the skin width since the last build or whether
+    /// the particles have been reordered.
+    bool needsRebuild(ArrayView<const Vector> r, ArrayView<const Size> ids) const;
+
+    /// \brief Builds the contact list, keeping the history of contacts present in the previous list.
+    ///
+    /// Contacts are matched by persistent indices of the particles, not by their current indices.
+    void rebuildContacts(ArrayView<const Vector> r, ArrayView<const Size> ids);
 };
 
 NAMESPACE_SPH_END
@@ -1,6 +1,7 @@
 #include "bench/Session.h"
 #include "gravity/BarnesHut.h"
 #include "gravity/BruteForceGravity.h"
+#include "gravity/FastMultipole.h"
 #include "gravity/Moments.h"
 #include "system/Settings.h"
 #include "tests/Setup.h"
@@ -51,6 +52,16 @@ BENCHMARK("BarnesHut Octupole 5", "[gravity]", Benchmark::Context& context) {
     benchmarkGravity(gravity, 500000, context);
 }
 
+BENCHMARK("FastMultipole Octupole 0.5", "[gravity]", Benchmark::Context& context) {
+    FastMultipole gravity(0.5_f, MultipoleOrder::OCTUPOLE);
+    benchmarkGravity(gravity, 500000, context);
+}
+
+BENCHMARK("FastMultipole Octupole 0.8", "[gravity]", Benchmark::Context& context) {
+    FastMultipole gravity(0.8_f, MultipoleOrder::OCTUPOLE);
+    benchmarkGravity(gravity, 500000, context);
+}
+
 BENCHMARK("BarnesHut Monopole 0.2", "[gravity]", Benchmark::Context& context) {
     BarnesHut gravity(0.2_f, MultipoleOrder::MONOPOLE);
     benchmarkGravity(gravity, 500000, context);
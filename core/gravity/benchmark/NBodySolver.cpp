@@ -1,6 +1,8 @@
 #include "gravity/NBodySolver.h"
 #include "bench/Session.h"
+#include "gravity/AggregateSolver.h"
 #include "math/rng/VectorRng.h"
+#include "quantities/IMaterial.h"
 #include "quantities/Iterate.h"
 #include "system/Settings.h"
 #include "tests/Setup.h"
@@ -46,3 +48,65 @@ BENCHMARK("HardSphereSolver merge", "[nbody]", Benchmark::Context& context) {
     settings.set(RunSettingsId::COLLISION_OVERLAP, OverlapEnum::FORCE_MERGE);
     benchmarkNBody(settings, context);
 }
+
+static Storage getAggregates(const Size aggregateCnt, const Size particleCnt) {
+    Storage storage(makeAuto<NullMaterial>(EMPTY_SETTINGS));
+    Array<Vector> r;
+    Array<Size> flags;
+    VectorRng<UniformRng> rng;
+    const Size side = Size(std::cbrt(aggregateCnt)) + 1;
+    for (Size k = 0; k < aggregateCnt; ++k) {
+        const Vector center = 10._f * Vector(Float(k % side), Float((k / side) % side), Float(k / sqr(side)));
+        for (Size i = 0; i < particleCnt; ++i) {
+            r.push(center + 2._f * rng());
+            r.back()[H] = 0.1_f;
+            flags.push(k);
+        }
+    }
+    storage.insert<Vector>(QuantityId::POSITION, OrderEnum::SECOND, std::move(r));
+    ArrayView<Vector> v = storage.getDt<Vector>(QuantityId::POSITION);
+    for (Size i = 0; i < v.size(); ++i) {
+        v[i] = rng() - Vector(0.5_f);
+    }
+    storage.insert<Float>(QuantityId::MASS, OrderEnum::ZERO, 1._f);
+    storage.insert<Size>(QuantityId::FLAG, OrderEnum::ZERO, std::move(flags));
+    return storage;
+}
+
+BENCHMARK("AggregateSolver integrate", "[nbody]", Benchmark::Context& context) {
+    RunSettings settings;
+    settings.set(RunSettingsId::GRAVITY_SOLVER, GravityEnum::BARNES_HUT);
+    Storage storage = getAggregates(20000, 8);
+    Tbb& pool = *Tbb::getGlobalInstance();
+    AggregateSolver solver(pool, settings);
+    solver.create(storage, storage.getMaterial(0));
+    solver.createAggregateData(storage, AggregateEnum::FLAGS);
+
+    Statistics stats;
+    while (context.running()) {
+        storage.zeroHighestDerivatives(pool);
+        solver.integrate(storage, stats);
+    }
+}
+
+BENCHMARK("AggregateSolver merge", "[nbody]", Benchmark::Context& context) {
+    RunSettings settings;
+    settings.set(RunSettingsId::GRAVITY_SOLVER, GravityEnum::BARNES_HUT);
+    Tbb& pool = *Tbb::getGlobalInstance();
+
+    Statistics stats;
+    while (context.running()) {
+        // single particles, merging into aggregates when they collide
+        Storage storage = getAggregates(20000, 1);
+        ArrayView<Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+        for (Size i = 0; i < r.size(); ++i) {
+            r[i] *= 0.05_f;
+            r[i][H] = 0.1_f;
+        }
+        AggregateSolver solver(pool, settings);
+        solver.create(storage, storage.getMaterial(0));
+        solver.createAggregateData(storage, AggregateEnum::PARTICLES);
+        solver.integrate(storage, stats);
+        solver.collide(storage, stats, 1._f);
+    }
+}
@@ -0,0 +1,142 @@
+#include "gravity/AggregateSolver.h"
+#include "catch.hpp"
+#include "math/rng/VectorRng.h"
+#include "quantities/IMaterial.h"
+#include "quantities/Quantity.h"
+#include "system/Statistics.h"
+#include "tests/Approx.h"
+#include "thread/Pool.h"
+#include "utils/SequenceTest.h"
+
+using namespace Sph;
+
+/// Creates clusters of particles, particles of each cluster share the flag.
+static Storage getClusters(const Size clusterCnt, const Size particleCnt) {
+    Storage storage(makeAuto<NullMaterial>(EMPTY_SETTINGS));
+    Array<Vector> r;
+    Array<Vector> v;
+    Array<Size> flags;
+    VectorRng<BenzAsphaugRng> rng(1234);
+    for (Size k = 0; k < clusterCnt; ++k) {
+        const Vector center(10._f * k, 0._f, 0._f);
+        for (Size i = 0; i < particleCnt; ++i) {
+            r.push(center + 2._f * rng() - Vector(1._f));
+            r.back()[H] = 0.01_f;
+            v.push(rng() - Vector(0.5_f));
+            flags.push(k);
+        }
+    }
+    storage.insert<Vector>(QuantityId::POSITION, OrderEnum::SECOND, std::move(r));
+    storage.getDt<Vector>(QuantityId::POSITION) = std::move(v);
+    storage.insert<Float>(QuantityId::MASS, OrderEnum::ZERO, 1._f);
+    storage.insert<Size>(QuantityId::FLAG, OrderEnum::ZERO, std::move(flags));
+    return storage;
+}
+
+TEST_CASE("Aggregate flags", "[aggregate]") {
+    const Size clusterCnt = 20;
+    const Size particleCnt = 5;
+    Storage storage = getClusters(clusterCnt, particleCnt);
+    ThreadPool pool(4);
+    AggregateSolver solver(pool, RunSettings::getDefaults());
+    solver.create(storage, storage.getMaterial(0));
+    solver.createAggregateData(storage, AggregateEnum::FLAGS);
+
+    Array<Vector> v0 = storage.getDt<Vector>(QuantityId::POSITION).clone();
+    Statistics stats;
+    stats.set(StatisticsId::RUN_TIME, 0._f);
+    solver.integrate(storage, stats);
+    REQUIRE(stats.get<int>(StatisticsId::AGGREGATE_COUNT) == int(clusterCnt));
+    RawPtr<IAggregateObserver> observer = dynamicCast<IAggregateObserver>(storage.getUserData().get());
+    REQUIRE(observer->count() == clusterCnt);
+
+    ArrayView<const Size> ids = storage.getValue<Size>(QuantityId::AGGREGATE_ID);
+    ArrayView<const Vector> v = storage.getDt<Vector>(QuantityId::POSITION);
+    ArrayView<const Vector> w = storage.getValue<Vector>(QuantityId::ANGULAR_FREQUENCY);
+    auto test = [&](const Size k) -> Outcome {
+        const Size first = k * particleCnt;
+        Vector v_com(0._f);
+        for (Size i = first; i < first + particleCnt; ++i) {
+            if (ids[i] != ids[first] || (k > 0 && ids[i] == ids[first - 1])) {
+                return makeFailed("Incorrect aggregate ID {} of particle {}", ids[i], i);
+            }
+            if (v[i] != v[first] || w[i] != w[first]) {
+                return makeFailed("Particles of aggregate {} do not move as a rigid body", k);
+            }
+            v_com += v0[i] / particleCnt;
+        }
+        if (v[first] != approx(v_com)) {
+            return makeFailed("Momentum not conserved: {} == {}", v[first], v_com);
+        }
+        if (w[first] == Vector(0._f)) {
+            return makeFailed("Zero angular velocity of aggregate {}", k);
+        }
+        return SUCCESS;
+    };
+    REQUIRE_SEQUENCE(test, 0, clusterCnt);
+}
+
+TEST_CASE("Aggregate remove", "[aggregate]") {
+    Storage storage = getClusters(3, 4);
+    AggregateSolver solver(SEQUENTIAL, RunSettings::getDefaults());
+    solver.create(storage, storage.getMaterial(0));
+    solver.createAggregateData(storage, AggregateEnum::FLAGS);
+
+    // remove the root of the first aggregate and all but one particle of the second aggregate
+    storage.remove(Array<Size>{ 0, 4, 5, 6 }, Storage::IndicesFlag::INDICES_SORTED);
+    REQUIRE(storage.getParticleCnt() == 8);
+
+    Statistics stats;
+    stats.set(StatisticsId::RUN_TIME, 0._f);
+    solver.integrate(storage, stats);
+    REQUIRE(stats.get<int>(StatisticsId::AGGREGATE_COUNT) == 2);
+
+    ArrayView<const Size> ids = storage.getValue<Size>(QuantityId::AGGREGATE_ID);
+    REQUIRE(ids[0] == ids[1]);
+    REQUIRE(ids[0] == ids[2]);
+    REQUIRE(ids[3] == Size(-1));
+    REQUIRE(ids[4] == ids[7]);
+    REQUIRE(ids[4] != ids[0]);
+}
+
+static Storage simulate(IScheduler& scheduler, const AggregateEnum source, const Float radius) {
+    Storage storage = getClusters(50, 8);
+    ArrayView<Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+    for (Size i = 0; i < r.size(); ++i) {
+        r[i][H] = radius;
+    }
+    // heavy particles, so that the collided particles are bound
+    storage.getValue<Float>(QuantityId::MASS).fill(1.e12_f);
+    AggregateSolver solver(scheduler, RunSettings::getDefaults());
+    solver.create(storage, storage.getMaterial(0));
+    solver.createAggregateData(storage, source);
+    Statistics stats;
+    stats.set(StatisticsId::RUN_TIME, 0._f);
+    for (Size i = 0; i < 3; ++i) {
+        storage.zeroHighestDerivatives(scheduler);
+        solver.integrate(storage, stats);
+        solver.collide(storage, stats, 0.1_f);
+    }
+    RawPtr<IAggregateObserver> observer = dynamicCast<IAggregateObserver>(storage.getUserData().get());
+    REQUIRE(observer->count() > 0);
+    return storage;
+}
+
+TEST_CASE("Aggregate scheduler independence", "[aggregate]") {
+    ThreadPool pool(4);
+    auto test = [&pool](const AggregateEnum source, const Float radius) {
+        Storage storage1 = simulate(SEQUENTIAL, source, radius);
+        Storage storage2 = simulate(pool, source, radius);
+        for (QuantityId id : { QuantityId::POSITION, QuantityId::ANGULAR_FREQUENCY }) {
+            ArrayView<const Vector> values1 = storage1.getValue<Vector>(id);
+            ArrayView<const Vector> values2 = storage2.getValue<Vector>(id);
+            REQUIRE(std::equal(values1.begin(), values1.end(), values2.begin()));
+        }
+        ArrayView<const Vector> v1 = storage1.getDt<Vector>(QuantityId::POSITION);
+        ArrayView<const Vector> v2 = storage2.getDt<Vector>(QuantityId::POSITION);
+        REQUIRE(std::equal(v1.begin(), v1.end(), v2.begin()));
+    };
+    test(AggregateEnum::FLAGS, 0.01_f);
+    // particles have to merge into aggregates
+    test(AggregateEnum::PARTICLES, 0.3_f);
+}
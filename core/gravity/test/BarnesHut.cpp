@@ -79,6 +79,100 @@ TEMPLATE_TEST_CASE("BarnesHut zero opening angle", "[gravity]", ThreadPool, Tbb)
     testOpeningAngle<TestType>(MultipoleOrder::OCTUPOLE);
 }
 
+TEST_CASE("BarnesHut softened zero opening angle", "[gravity]") {
+    Storage storage = getGravityStorage(100);
+    // make the particles overlap, so that the smoothing kernel is used
+    ArrayView<Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+    for (Vector& v : r) {
+        v[H] *= 3._f;
+    }
+
+    BarnesHut bh(EPS, MultipoleOrder::OCTUPOLE, GravityKernel<CubicSpline<3>>(), 5);
+    BruteForceGravity bf(GravityKernel<CubicSpline<3>>{});
+
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+    bf.build(pool, storage);
+    bh.build(pool, storage);
+    Array<Vector> a_bf(r.size());
+    Array<Vector> a_bh(r.size());
+    a_bf.fill(Vector(0._f));
+    a_bh.fill(Vector(0._f));
+    Statistics stats;
+    bf.evalSelfGravity(pool, a_bf, stats);
+    bh.evalSelfGravity(pool, a_bh, stats);
+
+    auto test = [&](const Size i) -> Outcome {
+        if (a_bf[i] != approx(a_bh[i])) {
+            return makeFailed("Incorrect acceleration: {} == {}", a_bh[i], a_bf[i]);
+        }
+        return SUCCESS;
+    };
+    REQUIRE_SEQUENCE(test, 0, r.size());
+}
+
+TEST_CASE("BarnesHut multipole accuracy", "[gravity]") {
+    Storage storage = getGravityStorage(5000);
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+    Statistics stats;
+
+    BruteForceGravity bf;
+    bf.build(pool, storage);
+    Array<Vector> a_bf(storage.getParticleCnt());
+    a_bf.fill(Vector(0._f));
+    bf.evalSelfGravity(pool, a_bf, stats);
+
+    // RMS of relative errors; the multipole expansions are evaluated using vector instructions
+    auto getError = [&](const MultipoleOrder order) {
+        BarnesHut bh(0.5_f, order, 5);
+        bh.build(pool, storage);
+        Array<Vector> a_bh(storage.getParticleCnt());
+        a_bh.fill(Vector(0._f));
+        bh.evalSelfGravity(pool, a_bh, stats);
+        Float error = 0._f;
+        for (Size i = 0; i < a_bh.size(); ++i) {
+            error += getSqrLength(a_bh[i] - a_bf[i]) / getSqrLength(a_bf[i]);
+        }
+        return sqrt(error / a_bh.size());
+    };
+    const Float errorMonopole = getError(MultipoleOrder::MONOPOLE);
+    const Float errorQuadrupole = getError(MultipoleOrder::QUADRUPOLE);
+    const Float errorOctupole = getError(MultipoleOrder::OCTUPOLE);
+    REQUIRE(errorMonopole < 0.02_f);
+    REQUIRE(errorQuadrupole < 0.004_f);
+    REQUIRE(errorOctupole < 0.002_f);
+}
+
+TEST_CASE("BarnesHut refit", "[gravity]") {
+    Storage storage = getGravityStorage(5000);
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+    Statistics stats;
+
+    BarnesHut bh(0.5_f, MultipoleOrder::OCTUPOLE, 5);
+    bh.build(pool, storage);
+
+    // move particles, so that some of them cross split planes of the tree
+    ArrayView<Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+    for (Size i = 0; i < r.size(); ++i) {
+        r[i] += Vector(0.05_f * r[i][H] * Sph::sin(Float(i)), 0._f, 0._f);
+    }
+    bh.refit(pool, storage);
+
+    BruteForceGravity bf;
+    bf.build(pool, storage);
+    Array<Vector> a_bf(r.size());
+    a_bf.fill(Vector(0._f));
+    bf.evalSelfGravity(pool, a_bf, stats);
+
+    Array<Vector> a_bh(r.size());
+    a_bh.fill(Vector(0._f));
+    bh.evalSelfGravity(pool, a_bh, stats);
+    Float error = 0._f;
+    for (Size i = 0; i < r.size(); ++i) {
+        error += getSqrLength(a_bh[i] - a_bf[i]) / getSqrLength(a_bf[i]);
+    }
+    REQUIRE(sqrt(error / r.size()) < 0.002_f);
+}
+
 /*TEST_CASE("BarnesHut empty", "[gravity]") {
     // no particles = no acceleration
     BarnesHut bh(0.5_f, MultipoleOrder::OCTUPOLE);
@@ -0,0 +1,90 @@
+#include "gravity/FastMultipole.h"
+#include "catch.hpp"
+#include "gravity/BruteForceGravity.h"
+#include "gravity/Moments.h"
+#include "quantities/Quantity.h"
+#include "tests/Approx.h"
+#include "tests/Setup.h"
+#include "thread/Tbb.h"
+#include "utils/SequenceTest.h"
+
+using namespace Sph;
+
+static Storage getGravityStorage(const Size particleCnt = 1000) {
+    const Float r0 = 1.e7_f;
+    const Float rho0 = 100._f;
+    BodySettings settings;
+    settings.set(BodySettingsId::DENSITY, rho0);
+    return Tests::getGassStorage(particleCnt, settings, r0);
+}
+
+static Array<Vector> evalGravity(IGravity& gravity, IScheduler& scheduler, const Storage& storage) {
+    gravity.build(scheduler, storage);
+    Array<Vector> dv(storage.getParticleCnt());
+    dv.fill(Vector(0._f));
+    Statistics stats;
+    gravity.evalSelfGravity(scheduler, dv, stats);
+    return dv;
+}
+
+/// Returns the RMS of relative errors of accelerations.
+static Float getError(ArrayView<const Vector> dv, ArrayView<const Vector> expected) {
+    Float error = 0._f;
+    for (Size i = 0; i < dv.size(); ++i) {
+        error += getSqrLength(dv[i] - expected[i]) / getSqrLength(expected[i]);
+    }
+    return sqrt(error / dv.size());
+}
+
+TEMPLATE_TEST_CASE("FastMultipole zero opening angle", "[gravity]", ThreadPool, Tbb) {
+    Storage storage = getGravityStorage(100);
+    TestType& pool = *TestType::getGlobalInstance();
+
+    // with theta = 0, all interactions are evaluated pair-wise
+    BruteForceGravity bf;
+    const Array<Vector> a_bf = evalGravity(bf, pool, storage);
+    for (MultipoleOrder order :
+        { MultipoleOrder::MONOPOLE, MultipoleOrder::QUADRUPOLE, MultipoleOrder::OCTUPOLE }) {
+        FastMultipole fmm(EPS, order, 5);
+        const Array<Vector> a_fmm = evalGravity(fmm, pool, storage);
+        auto test = [&](const Size i) -> Outcome {
+            if (a_bf[i] != approx(a_fmm[i])) {
+                return makeFailed("Incorrect acceleration: {} == {}", a_fmm[i], a_bf[i]);
+            }
+            return SUCCESS;
+        };
+        REQUIRE_SEQUENCE(test, 0, a_bf.size());
+    }
+}
+
+TEST_CASE("FastMultipole accuracy", "[gravity]") {
+    Storage storage = getGravityStorage(5000);
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+
+    BruteForceGravity bf;
+    const Array<Vector> a_bf = evalGravity(bf, pool, storage);
+    Float lastError = 0._f;
+    for (Float theta : { 0.2_f, 0.5_f, 0.8_f }) {
+        // error should be comparable to Barnes-Hut with the same opening angle
+        BarnesHut bh(theta, MultipoleOrder::OCTUPOLE, 5);
+        FastMultipole fmm(theta, MultipoleOrder::OCTUPOLE, 5);
+        const Float errorBh = getError(evalGravity(bh, pool, storage), a_bf);
+        const Float errorFmm = getError(evalGravity(fmm, pool, storage), a_bf);
+        REQUIRE(errorFmm < 1.5_f * errorBh);
+
+        // error should increase with the opening angle
+        REQUIRE(errorFmm > lastError);
+        lastError = errorFmm;
+    }
+}
+
+TEST_CASE("FastMultipole scheduler independence", "[gravity]") {
+    Storage storage = getGravityStorage();
+
+    FastMultipole gravity(0.5_f, MultipoleOrder::OCTUPOLE);
+    const Array<Vector> dv1 = evalGravity(gravity, SEQUENTIAL, storage);
+    const Array<Vector> dv2 = evalGravity(gravity, *ThreadPool::getGlobalInstance(), storage);
+    const Array<Vector> dv3 = evalGravity(gravity, *Tbb::getGlobalInstance(), storage);
+    REQUIRE(dv1 == dv2);
+    REQUIRE(dv1 == dv3);
+}
@@ -1,6 +1,8 @@
 #include "gravity/NBodySolver.h"
 #include "catch.hpp"
+#include "gravity/BruteForceGravity.h"
 #include "gravity/Collision.h"
+#include "math/rng/Rng.h"
 #include "physics/Integrals.h"
 #include "quantities/IMaterial.h"
 #include "quantities/Quantity.h"
@@ -515,3 +517,178 @@ TEMPLATE_TEST_CASE("Collision cloud bounce", "[nbody]", EulerExplicit, LeapFrog)
     HardSphereSolver solver(pool, settings);
     REQUIRE_NOTHROW(runCloud<TestType>(settings, 50));
 }
+
+static SharedPtr<Storage> runClusters(HardSphereSolver& solver, Size& collisionCnt) {
+    // several distant clusters of particles fired into their centers
+    const Size clusterCnt = 8;
+    SharedPtr<Storage> storage = makeShared<Storage>(Tests::getStorage(500));
+    solver.create(*storage, storage->getMaterial(0));
+
+    ArrayView<Vector> r, v, dv;
+    tie(r, v, dv) = storage->getAll<Vector>(QuantityId::POSITION);
+    UniformRng rng;
+    for (Size i = 0; i < r.size(); ++i) {
+        const Vector center(5._f * (i % clusterCnt), 0._f, 0._f);
+        const Vector offset(rng() - 0.5_f, rng() - 0.5_f, rng() - 0.5_f);
+        r[i] = center + offset;
+        r[i][H] = 0.02_f;
+        v[i] = -4._f * offset;
+    }
+
+    const Float dt = 0.02_f;
+    Statistics stats;
+    collisionCnt = 0;
+    for (Size step = 0; step < 15; ++step) {
+        solver.collide(*storage, stats, dt);
+        collisionCnt += stats.get<int>(StatisticsId::TOTAL_COLLISION_COUNT);
+        tie(r, v, dv) = storage->getAll<Vector>(QuantityId::POSITION);
+        for (Size i = 0; i < r.size(); ++i) {
+            r[i] += v[i] * dt;
+        }
+    }
+    return storage;
+}
+
+static void compareClusters(HardSphereSolver& solver1, HardSphereSolver& solver2) {
+    Size collisionCnt1, collisionCnt2;
+    SharedPtr<Storage> storage1 = runClusters(solver1, collisionCnt1);
+    SharedPtr<Storage> storage2 = runClusters(solver2, collisionCnt2);
+    REQUIRE(collisionCnt1 > 100);
+    REQUIRE(collisionCnt1 == collisionCnt2);
+    REQUIRE(storage1->getParticleCnt() == storage2->getParticleCnt());
+
+    ArrayView<const Vector> r1 = storage1->getValue<Vector>(QuantityId::POSITION);
+    ArrayView<const Vector> v1 = storage1->getDt<Vector>(QuantityId::POSITION);
+    ArrayView<const Vector> r2 = storage2->getValue<Vector>(QuantityId::POSITION);
+    ArrayView<const Vector> v2 = storage2->getDt<Vector>(QuantityId::POSITION);
+    auto test = [&](const Size i) -> Outcome {
+        if (r1[i] != r2[i] || v1[i] != v2[i]) {
+            return makeFailed("Different results:\n{} == {}\n{} == {}", r1[i], r2[i], v1[i], v2[i]);
+        }
+        return SUCCESS;
+    };
+    REQUIRE_SEQUENCE(test, 0, r1.size());
+}
+
+TEST_CASE("Collision scheduler independence", "[nbody]") {
+    // collisions of distant clusters are resolved concurrently, check that the result is the same as for
+    // sequential resolution
+    ThreadPool pool(4);
+    RunSettings settings;
+    settings.set(RunSettingsId::NBODY_INERTIA_TENSOR, false);
+    auto handlers = { std::make_pair(CollisionHandlerEnum::PERFECT_MERGING, OverlapEnum::FORCE_MERGE),
+        std::make_pair(CollisionHandlerEnum::ELASTIC_BOUNCE, OverlapEnum::REPEL),
+        std::make_pair(CollisionHandlerEnum::MERGE_OR_BOUNCE, OverlapEnum::PASS_OR_MERGE) };
+    for (auto handler : handlers) {
+        settings.set(RunSettingsId::COLLISION_HANDLER, handler.first)
+            .set(RunSettingsId::COLLISION_OVERLAP, handler.second);
+        HardSphereSolver solver1(SEQUENTIAL, settings);
+        HardSphereSolver solver2(pool, settings);
+        compareClusters(solver1, solver2);
+    }
+}
+
+namespace {
+
+/// Handler strongly accelerating the collided particles, so that they leave the safe region of their island.
+class ExplosiveBounceHandler : public ICollisionHandler {
+private:
+    ArrayView<Vector> v;
+
+public:
+    virtual void initialize(Storage& storage) override {
+        v = storage.getDt<Vector>(QuantityId::POSITION);
+    }
+
+    virtual CollisionResult collide(const Size i, const Size j, FlatSet<Size>& UNUSED(toRemove)) override {
+        const Vector dv = v[i] - v[j];
+        v[i] -= 20._f * dv;
+        v[j] += 20._f * dv;
+        return CollisionResult::BOUNCE;
+    }
+};
+
+} // namespace
+
+TEST_CASE("Collision scheduler independence with pause", "[nbody]") {
+    // islands are paused, the concurrent resolution has to be discarded and the result has to be the same as
+    // for sequential resolution
+    ThreadPool pool(4);
+    RunSettings settings;
+    settings.set(RunSettingsId::NBODY_INERTIA_TENSOR, false);
+    HardSphereSolver solver1(SEQUENTIAL,
+        settings,
+        makeAuto<BruteForceGravity>(0._f),
+        makeAuto<ExplosiveBounceHandler>(),
+        makeAuto<NullOverlapHandler>());
+    HardSphereSolver solver2(pool,
+        settings,
+        makeAuto<BruteForceGravity>(0._f),
+        makeAuto<ExplosiveBounceHandler>(),
+        makeAuto<NullOverlapHandler>());
+    compareClusters(solver1, solver2);
+}
+
+TEST_CASE("SoftSphereSolver contact list", "[nbody]") {
+    RunSettings settings;
+    settings.set(RunSettingsId::SOFT_CONTACT_SKIN, 0.2_f);
+    SoftSphereSolver solver(*ThreadPool::getGlobalInstance(), settings, makeAuto<BruteForceGravity>(0._f));
+    Storage storage = Tests::getStorage(300);
+    NullMaterial mtl(BodySettings::getDefaults());
+    solver.create(storage, mtl);
+    REQUIRE(storage.has(QuantityId::PERSISTENT_INDEX));
+
+    ArrayView<Vector> r, v, dv;
+    tie(r, v, dv) = storage.getAll<Vector>(QuantityId::POSITION);
+    ArrayView<const Float> m = storage.getValue<Float>(QuantityId::MASS);
+    UniformRng rng;
+    for (Size i = 0; i < r.size(); ++i) {
+        r[i][H] *= 0.5_f + rng();
+        v[i] = Vector(rng() - 0.5_f, rng() - 0.5_f, rng() - 0.5_f);
+    }
+
+    const Float repel = settings.get<Float>(RunSettingsId::SOFT_REPEL_STRENGTH);
+    const Float friction = settings.get<Float>(RunSettingsId::SOFT_FRICTION_STRENGTH);
+    for (Size step = 0; step < 10; ++step) {
+        if (step % 3 == 2) {
+            // reverse the order of particles; the contact list has to follow the particles
+            Array<Size> order(r.size());
+            for (Size i = 0; i < order.size(); ++i) {
+                order[i] = order.size() - i - 1;
+            }
+            storage.reorder(SEQUENTIAL, order);
+            tie(r, v, dv) = storage.getAll<Vector>(QuantityId::POSITION);
+            m = storage.getValue<Float>(QuantityId::MASS);
+        }
+        std::fill(dv.begin(), dv.end(), Vector(0._f));
+        Statistics stats;
+        solver.integrate(storage, stats);
+        REQUIRE(std::count(dv.begin(), dv.end(), Vector(0._f)) < r.size() / 2);
+
+        // compare with forces computed from all pairs of particles
+        auto test = [&](const Size i) -> Outcome {
+            Vector f(0._f);
+            for (Size j = 0; j < r.size(); ++j) {
+                const Float dist = getLength(r[i] - r[j]);
+                if (i == j || dist >= r[i][H] + r[j][H]) {
+                    continue;
+                }
+                const Float unit = Constants::gravity / sqr(0.5_f * (r[i][H] + r[j][H]));
+                f += unit * m[j] * getNormalized(r[i] - r[j]) * repel * pow<6>((r[i][H] + r[j][H]) / dist);
+                f -= unit * m[j] * getNormalized(v[i] - v[j]) * friction;
+            }
+            f[H] = 0._f;
+            if (dv[i] != approx(f, 1.e-6_f)) {
+                return makeFailed("Incorrect acceleration in step {}:\n{} == {}", step, dv[i], f);
+            }
+            return SUCCESS;
+        };
+        REQUIRE_SEQUENCE(test, 0, r.size());
+
+        // move particles, every other step by more than the skin
+        const Float shift = (step % 2 == 0) ? 0.02_f : 0.5_f;
+        for (Size i = 0; i < r.size(); ++i) {
+            r[i] += shift * r[i][H] * Vector(rng() - 0.5_f, rng() - 0.5_f, rng() - 0.5_f);
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#include "io/AsyncOutput.h"
+#include "thread/Scheduler.h"
+
+NAMESPACE_SPH_BEGIN
+
+AsyncOutput::AsyncOutput(const OutputFile& fileMask,
+    AutoPtr<IOutput>&& output,
+    SharedPtr<IScheduler> scheduler,
+    const Size snapshotCnt)
+    : IOutput(fileMask)
+    , output(std::move(output))
+    , scheduler(std::move(scheduler)) {
+    SPH_ASSERT(this->output && this->scheduler);
+    SPH_ASSERT(snapshotCnt > 0);
+    for (Size i = 0; i < snapshotCnt; ++i) {
+        unused.push(makeAuto<Snapshot>());
+    }
+    thread = std::thread([this] { this->run(); });
+}
+
+AsyncOutput::~AsyncOutput() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stop = true;
+        writeVar.notify_one();
+    }
+    // the thread writes all pending snapshots before exiting
+    thread.join();
+}
+
+Expected<Path> AsyncOutput::dump(const Storage& storage, const Statistics& stats) {
+    AutoPtr<Snapshot> snapshot;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        // wait until a staging storage is available
+        doneVar.wait(lock, [this] { return !unused.empty(); });
+        snapshot = std::move(unused.front());
+        unused.pop();
+    }
+
+    // copy the data outside of the lock, so that the previous snapshot can be written meanwhile
+    storage.copyInto(*scheduler, snapshot->storage);
+    snapshot->stats = stats;
+    // the wrapped output generates the same sequence of paths, as the snapshots are written in order
+    const Path path = output->getDumpPath(paths.getNextPath(stats));
+
+    Outcome result = SUCCESS;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        pending.push(std::move(snapshot));
+        result = this->popErrors();
+        writeVar.notify_one();
+    }
+    if (result) {
+        return path;
+    } else {
+        return makeUnexpected<Path>(result.error());
+    }
+}
+
+Outcome AsyncOutput::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    doneVar.wait(lock, [this] { return pending.empty() && writingCnt == 0; });
+    return this->popErrors();
+}
+
+void AsyncOutput::run() {
+    while (true) {
+        AutoPtr<Snapshot> snapshot;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            writeVar.wait(lock, [this] { return stop || !pending.empty(); });
+            if (pending.empty()) {
+                // stopped and nothing left to write
+                return;
+            }
+            snapshot = std::move(pending.front());
+            pending.pop();
+            ++writingCnt;
+        }
+
+        Expected<Path> result = makeUnexpected<Path>("");
+        try {
+            result = output->dump(snapshot->storage, snapshot->stats);
+        } catch (const std::exception& e) {
+            result = makeUnexpected<Path>(exceptionMessage(e));
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!result) {
+            errors.push(result.error());
+        }
+        unused.push(std::move(snapshot));
+        --writingCnt;
+        doneVar.notify_all();
+    }
+}
+
+Outcome AsyncOutput::popErrors() {
+    if (errors.empty()) {
+        return SUCCESS;
+    }
+    String message = errors[0];
+    for (Size i = 1; i < errors.size(); ++i) {
+        message += "\n" + errors[i];
+    }
+    errors.clear();
+    return makeFailed(message);
+}
+
+NAMESPACE_SPH_END
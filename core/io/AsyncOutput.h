@@ -0,0 +1,92 @@
+#pragma once
+
+/// \file AsyncOutput.h
+/// \brief Output writing the files on a background thread
+/// \author Pavel Sevecek (sevecek at sirrah.troja.mff.cuni.cz)
+/// \date 2016-2021
+
+#include "io/Output.h"
+#include "system/Statistics.h"
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+NAMESPACE_SPH_BEGIN
+
+/// \brief Output writing the files on a background thread, so that the simulation can continue meanwhile.
+///
+/// Wraps another output. Function \ref dump only copies the particle data into a staging storage, the file
+/// is then written by the wrapped output on a background thread. Staging storages are reused for subsequent
+/// dumps, so the memory is not reallocated unless quantities in the storage change.
+///
+/// The number of staging storages is limited; if all of them are waiting to be written, \ref dump blocks
+/// until the oldest one is written. This bounds the memory usage if the output is slower than the
+/// simulation. All pending files are written in \ref flush and in the destructor.
+class AsyncOutput : public IOutput {
+private:
+    struct Snapshot {
+        Storage storage;
+        Statistics stats;
+    };
+
+    /// Output writing the files
+    AutoPtr<IOutput> output;
+
+    /// Scheduler used to copy the particle data
+    SharedPtr<IScheduler> scheduler;
+
+    /// Snapshots waiting to be written, the oldest one first.
+    std::queue<AutoPtr<Snapshot>> pending;
+
+    /// Staging storages not used at the moment
+    std::queue<AutoPtr<Snapshot>> unused;
+
+    /// Number of snapshots currently being written (zero or one)
+    Size writingCnt = 0;
+
+    /// Errors of writes that have not been reported yet
+    Array<String> errors;
+
+    std::mutex mutex;
+    std::condition_variable writeVar;
+    std::condition_variable doneVar;
+    bool stop = false;
+
+    std::thread thread;
+
+public:
+    /// \brief Creates the asynchronous output.
+    ///
+    /// \param fileMask File mask of the wrapped output. Used to determine the paths returned by \ref dump.
+    /// \param output Output writing the files. It is called from the background thread, so it should not use
+    ///               the scheduler of the run.
+    /// \param scheduler Scheduler used to copy the particle data into staging storages.
+    /// \param snapshotCnt Maximal number of snapshots held in memory, must be at least 1.
+    AsyncOutput(const OutputFile& fileMask,
+        AutoPtr<IOutput>&& output,
+        SharedPtr<IScheduler> scheduler,
+        const Size snapshotCnt = 1);
+
+    /// \brief Writes all pending snapshots and stops the background thread.
+    ~AsyncOutput();
+
+    /// \brief Copies the particle data and schedules writing of the file.
+    ///
+    /// The returned path is the path of the file that will be written. If writing of a previous snapshot
+    /// failed, the function returns the error instead; the current snapshot is scheduled nevertheless.
+    virtual Expected<Path> dump(const Storage& storage, const Statistics& stats) override;
+
+    virtual Outcome flush() override;
+
+    virtual Path getDumpPath(const Path& nextPath) const override {
+        return output->getDumpPath(nextPath);
+    }
+
+private:
+    void run();
+
+    Outcome popErrors();
+};
+
+NAMESPACE_SPH_END
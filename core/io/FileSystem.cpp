@@ -1,4 +1,5 @@
 #include "io/FileSystem.h"
+#include "objects/Exceptions.h"
 #include "objects/containers/StaticArray.h"
 #include "objects/utility/Streams.h"
 #include <sstream>
@@ -8,7 +9,9 @@
 #include <windows.h>
 #else
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/file.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -67,6 +70,30 @@ std::size_t FileSystem::fileSize(const Path& path) {
     return ifs.tellg();
 }
 
+Expected<int64_t> FileSystem::lastWriteTime(const Path& path) {
+#ifndef SPH_WIN
+    struct stat buffer;
+    if (stat(path.native(), &buffer) != 0) {
+        return makeUnexpected<int64_t>("Cannot retrieve modification time of the file");
+    }
+#ifdef __APPLE__
+    const struct timespec& time = buffer.st_mtimespec;
+#else
+    const struct timespec& time = buffer.st_mtim;
+#endif
+    return int64_t(time.tv_sec) * 1000000000 + int64_t(time.tv_nsec);
+#else
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(path.native(), GetFileExInfoStandard, &data)) {
+        return makeUnexpected<int64_t>(getLastErrorMessage());
+    }
+    // 100-nanosecond intervals
+    const int64_t time =
+        (int64_t(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+    return time * 100;
+#endif
+}
+
 bool FileSystem::isDirectoryWritable(const Path& path) {
     SPH_ASSERT(pathType(path).valueOr(PathType::OTHER) == PathType::DIRECTORY);
 #ifndef SPH_WIN
@@ -594,4 +621,49 @@ Array<Path> FileSystem::getFilesInDirectory(const Path& directory) {
     return paths;
 }
 
+FileSystem::MappedFile::MappedFile(const Path& path) {
+#ifndef SPH_WIN
+    const int fd = open(path.native(), O_RDONLY);
+    if (fd < 0) {
+        throw IoError(format("Cannot open file {} for reading.", path.string()));
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw IoError(format("Cannot get the size of file {}.", path.string()));
+    }
+    length = std::size_t(info.st_size);
+    if (length > 0) {
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            throw IoError(format("Cannot map file {} into memory.", path.string()));
+        }
+        ptr = static_cast<const char*>(mapped);
+    }
+    // the mapping is kept after closing the descriptor
+    close(fd);
+#else
+    std::ifstream ifs(path.native(), std::ios::in | std::ios::binary | std::ios::ate);
+    if (!ifs) {
+        throw IoError(format("Cannot open file {} for reading.", path.string()));
+    }
+    length = std::size_t(ifs.tellg());
+    buffer.resize(Size(length));
+    ifs.seekg(0);
+    if (length > 0) {
+        ifs.read(&buffer[0], length);
+        ptr = &buffer[0];
+    }
+#endif
+}
+
+FileSystem::MappedFile::~MappedFile() {
+#ifndef SPH_WIN
+    if (ptr) {
+        munmap(const_cast<char*>(ptr), length);
+    }
+#endif
+}
+
 NAMESPACE_SPH_END
@@ -26,6 +26,12 @@ bool pathExists(const Path& path);
 /// The file must exist and be accessible, checked by assert.
 std::size_t fileSize(const Path& path);
 
+/// \brief Returns the time of the last modification of a file.
+///
+/// The time is given in nanoseconds since an unspecified epoch; it is only meaningful when compared with
+/// other values returned by the function.
+Expected<int64_t> lastWriteTime(const Path& path);
+
 /// \brief Checks whether the given directory is writable.
 bool isDirectoryWritable(const Path& path);
 
@@ -193,6 +199,38 @@ DirectoryAdapter iterateDirectory(const Path& directory);
 /// Returns relative paths with respect to the given parent directory.
 Array<Path> getFilesInDirectory(const Path& directory);
 
+/// \brief Read-only view of a file mapped into memory.
+///
+/// Pages of the file are read by the operating system when accessed for the first time, so only the
+/// accessed parts of the file are actually loaded. On Windows, the whole file is read into memory instead.
+class MappedFile : public Noncopyable {
+private:
+    const char* ptr = nullptr;
+    std::size_t length = 0;
+
+#ifdef SPH_WIN
+    Array<char> buffer;
+#endif
+
+public:
+    /// \brief Maps the file at given path.
+    ///
+    /// \throw IoError if the file cannot be opened or mapped.
+    explicit MappedFile(const Path& path);
+
+    ~MappedFile();
+
+    /// \brief Returns the pointer to the first byte of the file.
+    const char* data() const {
+        return ptr;
+    }
+
+    /// \brief Returns the size of the file in bytes.
+    std::size_t size() const {
+        return length;
+    }
+};
+
 } // namespace FileSystem
 
 NAMESPACE_SPH_END
@@ -0,0 +1,194 @@
+#include "io/FloatCodec.h"
+#include "math/MathUtils.h"
+#include <cstring>
+
+NAMESPACE_SPH_BEGIN
+
+namespace FloatCodec {
+
+/// Minimal length of a match, shorter matches are stored as literals.
+const Size MIN_MATCH = 4;
+
+/// Maximal distance of a match from the current position.
+const Size MAX_OFFSET = 65535;
+
+/// Number of bits of the hash table used to find the matches.
+const Size HASH_BITS = 14;
+
+/// Marks an empty entry in the hash table.
+const Size NO_POSITION = Size(-1);
+
+INLINE uint32_t read32(const uint8_t* ptr) {
+    uint32_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+template <typename TOut, typename TIn>
+INLINE TOut* bytes(ArrayView<TIn> view) {
+    return view.empty() ? nullptr : reinterpret_cast<TOut*>(&view[0]);
+}
+
+INLINE Size hash(const uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/// Writes the part of a length exceeding the 4 bits of the token.
+static void writeLength(Array<char>& output, Size length) {
+    while (length >= 255) {
+        output.push(char(255));
+        length -= 255;
+    }
+    output.push(char(length));
+}
+
+/// Writes a sequence of literals, optionally followed by a match.
+static void writeSequence(Array<char>& output,
+    const uint8_t* literals,
+    const Size literalCnt,
+    const Size offset,
+    const Size matchLength) {
+    const Size matchCode = matchLength > 0 ? matchLength - MIN_MATCH : 0;
+    output.push(char((min<Size>(literalCnt, 15) << 4) | min<Size>(matchCode, 15)));
+    if (literalCnt >= 15) {
+        writeLength(output, literalCnt - 15);
+    }
+    for (Size i = 0; i < literalCnt; ++i) {
+        output.push(char(literals[i]));
+    }
+    if (matchLength > 0) {
+        output.push(char(offset & 0xff));
+        output.push(char(offset >> 8));
+        if (matchCode >= 15) {
+            writeLength(output, matchCode - 15);
+        }
+    }
+}
+
+Array<char> compressBytes(ArrayView<const char> input) {
+    const uint8_t* src = bytes<const uint8_t>(input);
+    const Size size = input.size();
+    Array<char> output;
+    output.reserve(size / 4 + 16);
+
+    Array<Size> table(1 << HASH_BITS);
+    table.fill(NO_POSITION);
+    Size anchor = 0;
+    Size i = 0;
+    while (i + MIN_MATCH <= size) {
+        const uint32_t sequence = read32(src + i);
+        Size& entry = table[hash(sequence)];
+        const Size candidate = entry;
+        entry = i;
+        if (candidate == NO_POSITION || i - candidate > MAX_OFFSET || read32(src + candidate) != sequence) {
+            ++i;
+            continue;
+        }
+        Size length = MIN_MATCH;
+        while (i + length < size && src[candidate + length] == src[i + length]) {
+            ++length;
+        }
+        writeSequence(output, src + anchor, i - anchor, i - candidate, length);
+        i += length;
+        anchor = i;
+    }
+    // the last sequence only contains literals
+    writeSequence(output, src + anchor, size - anchor, 0, 0);
+    return output;
+}
+
+/// Reads the part of a length exceeding the 4 bits of the token.
+static bool readLength(const uint8_t*& in, const uint8_t* end, Size& length) {
+    uint8_t byte;
+    do {
+        if (in == end) {
+            return false;
+        }
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool decompressBytes(ArrayView<const char> input, ArrayView<char> output) {
+    const uint8_t* in = bytes<const uint8_t>(input);
+    const uint8_t* inEnd = in + input.size();
+    uint8_t* out = bytes<uint8_t>(output);
+    const uint8_t* outBegin = out;
+    const uint8_t* outEnd = out + output.size();
+
+    while (in < inEnd) {
+        const uint8_t token = *in++;
+        Size literalCnt = token >> 4;
+        if (literalCnt == 15 && !readLength(in, inEnd, literalCnt)) {
+            return false;
+        }
+        if (Size(inEnd - in) < literalCnt || Size(outEnd - out) < literalCnt) {
+            return false;
+        }
+        for (Size i = 0; i < literalCnt; ++i) {
+            *out++ = *in++;
+        }
+
+        if (in == inEnd) {
+            // last sequence
+            break;
+        }
+        if (inEnd - in < 2) {
+            return false;
+        }
+        const Size offset = Size(in[0]) | (Size(in[1]) << 8);
+        in += 2;
+        Size matchLength = token & 0x0f;
+        if (matchLength == 15 && !readLength(in, inEnd, matchLength)) {
+            return false;
+        }
+        matchLength += MIN_MATCH;
+        if (offset == 0 || Size(out - outBegin) < offset || Size(outEnd - out) < matchLength) {
+            return false;
+        }
+        // copy byte by byte, the match can overlap the output
+        const uint8_t* match = out - offset;
+        for (Size i = 0; i < matchLength; ++i) {
+            *out++ = *match++;
+        }
+    }
+    return out == outEnd;
+}
+
+Array<char> encode(ArrayView<const uint32_t> words) {
+    const Size size = words.size();
+    Array<char> shuffled(4 * size);
+    uint32_t last = 0;
+    for (Size i = 0; i < size; ++i) {
+        const uint32_t delta = words[i] ^ last;
+        last = words[i];
+        for (Size b = 0; b < 4; ++b) {
+            // most significant bytes first
+            shuffled[b * size + i] = char(delta >> (8 * (3 - b)));
+        }
+    }
+    return compressBytes(shuffled);
+}
+
+bool decode(ArrayView<const char> data, ArrayView<uint32_t> words) {
+    const Size size = words.size();
+    Array<char> shuffled(4 * size);
+    if (!decompressBytes(data, shuffled)) {
+        return false;
+    }
+    uint32_t last = 0;
+    for (Size i = 0; i < size; ++i) {
+        uint32_t delta = 0;
+        for (Size b = 0; b < 4; ++b) {
+            delta = (delta << 8) | uint8_t(shuffled[b * size + i]);
+        }
+        last ^= delta;
+        words[i] = last;
+    }
+    return true;
+}
+
+} // namespace FloatCodec
+
+NAMESPACE_SPH_END
@@ -0,0 +1,47 @@
+#pragma once
+
+/// \file FloatCodec.h
+/// \brief Lossless compression of arrays of floating-point values
+/// \author Pavel Sevecek (sevecek at sirrah.troja.mff.cuni.cz)
+/// \date 2016-2021
+
+#include "objects/containers/Array.h"
+
+NAMESPACE_SPH_BEGIN
+
+/// \brief Lossless codec for arrays of 32-bit words, intended for floating-point values.
+///
+/// Each word is first XOR-ed with the previous one. For smoothly varying values (for example quantities of
+/// particles sorted along a space-filling curve), the sign, exponent and the leading bits of the mantissa
+/// of adjacent values are mostly the same, so the XOR produces words with many leading zeros. The bytes of
+/// the words are then shuffled into four planes, the first plane containing the most significant bytes of
+/// all words, etc. This creates long runs of zero bytes, which are finally compressed by a fast LZ77-type
+/// coder, using the byte format of LZ4.
+///
+/// The arrays are encoded independently, so that large arrays can be split into blocks and compressed in
+/// parallel.
+namespace FloatCodec {
+
+/// \brief Compresses the given array of words.
+Array<char> encode(ArrayView<const uint32_t> words);
+
+/// \brief Decompresses an array previously compressed with \ref encode.
+///
+/// \param data Compressed data.
+/// \param words Output array, must have the same size as the array passed to \ref encode.
+/// \return False if the data are corrupted or do not match the size of the output array.
+bool decode(ArrayView<const char> data, ArrayView<uint32_t> words);
+
+/// \brief Compresses the given bytes with the LZ77-type coder.
+Array<char> compressBytes(ArrayView<const char> input);
+
+/// \brief Decompresses bytes previously compressed with \ref compressBytes.
+///
+/// \param input Compressed bytes.
+/// \param output Decompressed bytes, must have the same size as the array passed to \ref compressBytes.
+/// \return False if the data are corrupted or do not match the size of the output array.
+bool decompressBytes(ArrayView<const char> input, ArrayView<char> output);
+
+} // namespace FloatCodec
+
+NAMESPACE_SPH_END
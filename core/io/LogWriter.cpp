@@ -70,6 +70,7 @@ void StandardLogWriter::write(const Storage& storage, const Statistics& stats) {
     logger->write(" - timestep:    ", dt, " (set by ", String::fromAscii(ss.str().c_str()), ")");
 
     // clang-format off
+    printStat<int>(*logger, stats, StatisticsId::TIMESTEP_SUBSTEP_COUNT,       "    * substeps:  ");
     printStat<int>(*logger, stats, StatisticsId::TIMESTEP_ELAPSED,             " - time spent:  ", "ms");
     printStat<int>(*logger, stats, StatisticsId::SPH_EVAL_TIME,                "    * SPH evaluation:       ", "ms");
     printStat<int>(*logger, stats, StatisticsId::GRAVITY_EVAL_TIME,            "    * gravity evaluation:   ", "ms");
@@ -78,7 +79,10 @@ void StandardLogWriter::write(const Storage& storage, const Statistics& stats) {
     printStat<int>(*logger, stats, StatisticsId::POSTPROCESS_EVAL_TIME,        "    * visualization:        ", "ms");
     logger->write(                                                             " - particles:   ", storage.getParticleCnt());
     logger->write(                                                             " - attractors:  ", storage.getAttractorCnt());
+    printStat<int>(*logger, stats, StatisticsId::REORDER_COUNT,                "    * reorders:  ");
     printStat<MinMaxMean>(*logger, stats, StatisticsId::NEIGHBOR_COUNT,        " - neighbors:   ");
+    printStat<int>(*logger, stats, StatisticsId::NEIGHBOR_LIST_BUILDS,         "    * list builds:  ");
+    printStat<int>(*logger, stats, StatisticsId::NEIGHBOR_LIST_REUSES,         "    * list reuses:  ");
     printStat<int>(*logger, stats, StatisticsId::TOTAL_COLLISION_COUNT,        " - collisions:  ");
     printStat<int>(*logger, stats, StatisticsId::BOUNCE_COUNT,                 "    * bounces:  ");
     printStat<int>(*logger, stats, StatisticsId::MERGER_COUNT,                 "    * mergers:  ");
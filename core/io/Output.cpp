@@ -1,13 +1,19 @@
 #include "io/Output.h"
 #include "io/Column.h"
 #include "io/FileSystem.h"
+#include "io/FloatCodec.h"
 #include "io/Logger.h"
 #include "io/Serializer.h"
+#include "io/TextIo.h"
 #include "objects/finders/Order.h"
 #include "post/TwoBody.h"
 #include "quantities/Attractor.h"
+#include "math/Morton.h"
 #include "quantities/IMaterial.h"
 #include "system/Factory.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <fstream>
 
 #ifdef SPH_USE_HDF5
@@ -181,15 +187,70 @@ struct DumpAllVisitor {
 TextOutput::TextOutput(const OutputFile& fileMask,
     const String& runName,
     const Flags<OutputQuantityFlag> quantities,
-    const Flags<Options> options)
+    const Flags<Options> options,
+    SharedPtr<IScheduler> scheduler)
     : IOutput(fileMask)
     , runName(runName)
-    , options(options) {
+    , options(options)
+    , scheduler(scheduler) {
     addColumns(quantities, columns);
 }
 
 TextOutput::~TextOutput() = default;
 
+/// Width of a single value in the text file
+constexpr Size TEXT_COLUMN_WIDTH = 20;
+
+static void appendDynamic(Array<char>& buffer, const Dynamic& value, const bool scientific) {
+    switch (value.getType()) {
+    case DynamicId::SIZE:
+        TextIo::appendIndex(buffer, value.get<Size>(), TEXT_COLUMN_WIDTH);
+        break;
+    case DynamicId::FLOAT:
+        TextIo::appendFloat(buffer, value.get<Float>(), TEXT_COLUMN_WIDTH, scientific);
+        break;
+    case DynamicId::VECTOR: {
+        const Vector& v = value.get<Vector>();
+        for (Size i = 0; i < 3; ++i) {
+            TextIo::appendFloat(buffer, v[i], TEXT_COLUMN_WIDTH, scientific);
+        }
+        break;
+    }
+    case DynamicId::TENSOR: {
+        const Tensor& t = value.get<Tensor>();
+        for (Size i = 0; i < 3; ++i) {
+            for (Size j = 0; j < 3; ++j) {
+                TextIo::appendFloat(buffer, t(i, j), TEXT_COLUMN_WIDTH, scientific);
+            }
+        }
+        break;
+    }
+    case DynamicId::SYMMETRIC_TENSOR: {
+        const SymmetricTensor& t = value.get<SymmetricTensor>();
+        for (const Vector& v : { t.diagonal(), t.offDiagonal() }) {
+            for (Size i = 0; i < 3; ++i) {
+                TextIo::appendFloat(buffer, v[i], TEXT_COLUMN_WIDTH, scientific);
+            }
+        }
+        break;
+    }
+    case DynamicId::TRACELESS_TENSOR: {
+        const TracelessTensor& t = value.get<TracelessTensor>();
+        for (Float c : { t(0, 0), t(1, 1), t(0, 1), t(0, 2), t(1, 2) }) {
+            TextIo::appendFloat(buffer, c, TEXT_COLUMN_WIDTH, scientific);
+        }
+        break;
+    }
+    default: {
+        // other types are not used by columns of particle quantities, write them using the stream
+        std::stringstream ss;
+        ss << std::setprecision(PRECISION) << value;
+        const std::string str = ss.str();
+        buffer.pushAll(str.begin(), str.end());
+    }
+    }
+}
+
 Expected<Path> TextOutput::dump(const Storage& storage, const Statistics& stats) {
     if (options.has(Options::DUMP_ALL)) {
         columns.clear();
@@ -230,19 +291,17 @@ Expected<Path> TextOutput::dump(const Storage& storage, const Statistics& stats)
             printHeader(ofs, asciiName, column->getType());
         }
         ofs << std::endl;
-        // print data lines, starting with second-order quantities
-        for (Size i = 0; i < storage.getParticleCnt(); ++i) {
-            for (const auto& column : columns) {
-                // write one extra space to be sure numbers won't merge
-                if (options.has(Options::SCIENTIFIC)) {
-                    ofs << std::scientific << std::setprecision(PRECISION)
-                        << column->evaluate(storage, stats, i);
-                } else {
-                    ofs << std::setprecision(PRECISION) << column->evaluate(storage, stats, i);
+        // print data lines
+        const bool scientific = options.has(Options::SCIENTIFIC);
+        TextIo::writeLines(*scheduler,
+            ofs,
+            storage.getParticleCnt(),
+            [this, &storage, &stats, scientific](const Size i, Array<char>& buffer) {
+                for (const auto& column : columns) {
+                    appendDynamic(buffer, column->evaluate(storage, stats, i), scientific);
                 }
-            }
-            ofs << std::endl;
-        }
+                buffer.push('\n');
+            });
         ofs.close();
         return fileName;
     } catch (const std::exception& e) {
@@ -255,63 +314,103 @@ TextOutput& TextOutput::addColumn(AutoPtr<ITextColumn>&& column) {
     return *this;
 }
 
-TextInput::TextInput(Flags<OutputQuantityFlag> quantities) {
+TextInput::TextInput(Flags<OutputQuantityFlag> quantities, SharedPtr<IScheduler> scheduler)
+    : scheduler(scheduler) {
     addColumns(quantities, columns);
 }
 
+static Size getComponentCnt(const ValueEnum type) {
+    switch (type) {
+    case ValueEnum::INDEX:
+    case ValueEnum::SCALAR:
+        return 1;
+    case ValueEnum::VECTOR:
+        return 3;
+    case ValueEnum::TRACELESS_TENSOR:
+        return 5;
+    default:
+        NOT_IMPLEMENTED;
+    }
+}
+
 Outcome TextInput::load(const Path& path, Storage& storage, Statistics& UNUSED(stats)) {
     try {
-        std::ifstream ifs(path.native());
-        if (!ifs) {
+        if (!FileSystem::pathExists(path)) {
             return makeFailed("Failed to open the file");
         }
+        FileSystem::MappedFile file(path);
+
+        Array<Size> offsets;
+        Size componentCnt = 0;
+        for (AutoPtr<ITextColumn>& column : columns) {
+            offsets.push(componentCnt);
+            componentCnt += getComponentCnt(column->getType());
+        }
 
         storage.removeAll();
         // storage currently requires at least one quantity for insertion by value
         storage.insert<Size>(QuantityId::FLAG, OrderEnum::ZERO, Array<Size>{ 0 });
 
+        // process the file by segments to limit the size of the buffer with parsed values
+        constexpr std::size_t SEGMENT_SIZE = 1 << 26;
+        const char* segmentBegin = file.data();
+        const char* fileEnd = segmentBegin + file.size();
+        Array<double> values;
         Size particleCnt = 0;
-        std::string line;
-        while (std::getline(ifs, line)) {
-            if (line[0] == '#') { // comment
-                continue;
+        while (segmentBegin < fileEnd) {
+            const char* segmentEnd = segmentBegin + min(SEGMENT_SIZE, std::size_t(fileEnd - segmentBegin));
+            if (segmentEnd < fileEnd) {
+                const void* newline = std::memchr(segmentEnd, '\n', std::size_t(fileEnd - segmentEnd));
+                segmentEnd = newline ? static_cast<const char*>(newline) + 1 : fileEnd;
             }
-            std::stringstream ss(line);
-            for (AutoPtr<ITextColumn>& column : columns) {
-                switch (column->getType()) {
-                /// \todo de-duplicate the loading (used in Settings)
-                case ValueEnum::INDEX: {
-                    Size i;
-                    ss >> i;
-                    column->accumulate(storage, i, particleCnt);
-                    break;
-                }
-                case ValueEnum::SCALAR: {
-                    Float f;
-                    ss >> f;
-                    column->accumulate(storage, f, particleCnt);
-                    break;
-                }
-                case ValueEnum::VECTOR: {
-                    Vector v(0._f);
-                    ss >> v[X] >> v[Y] >> v[Z];
-                    column->accumulate(storage, v, particleCnt);
-                    break;
-                }
-                case ValueEnum::TRACELESS_TENSOR: {
-                    Float xx, yy, xy, xz, yz;
-                    ss >> xx >> yy >> xy >> xz >> yz;
-                    TracelessTensor t(xx, yy, xy, xz, yz);
-                    column->accumulate(storage, t, particleCnt);
-                    break;
-                }
-                default:
-                    NOT_IMPLEMENTED;
+            const TextIo::LineIndex lines(
+                *scheduler, ArrayView<const char>(segmentBegin, Size(segmentEnd - segmentBegin)));
+            segmentBegin = segmentEnd;
+
+            // parse all values in parallel, one row per particle
+            values.resize(lines.size() * componentCnt);
+            Optional<Size> failedLine = lines.forEach(
+                *scheduler, [&values, componentCnt](const Size lineIdx, const char* begin, const char* end) {
+                    double* row = &values[lineIdx * componentCnt];
+                    for (Size i = 0; i < componentCnt; ++i) {
+                        begin = TextIo::parseFloat(begin, end, row[i]);
+                        if (!begin) {
+                            return false;
+                        }
+                    }
+                    return true;
+                });
+            if (failedLine) {
+                return makeFailed("Invalid values in data line {}", particleCnt + failedLine.value() + 1);
+            }
+
+            for (Size lineIdx = 0; lineIdx < lines.size(); ++lineIdx) {
+                const double* row = &values[lineIdx * componentCnt];
+                const Size particleIdx = particleCnt + lineIdx;
+                for (Size columnIdx = 0; columnIdx < columns.size(); ++columnIdx) {
+                    ITextColumn& column = *columns[columnIdx];
+                    const double* v = row + offsets[columnIdx];
+                    switch (column.getType()) {
+                    case ValueEnum::INDEX:
+                        column.accumulate(storage, Size(v[0]), particleIdx);
+                        break;
+                    case ValueEnum::SCALAR:
+                        column.accumulate(storage, Float(v[0]), particleIdx);
+                        break;
+                    case ValueEnum::VECTOR:
+                        column.accumulate(storage, Vector(v[0], v[1], v[2]), particleIdx);
+                        break;
+                    case ValueEnum::TRACELESS_TENSOR:
+                        column.accumulate(
+                            storage, TracelessTensor(v[0], v[1], v[2], v[3], v[4]), particleIdx);
+                        break;
+                    default:
+                        NOT_IMPLEMENTED;
+                    }
                 }
             }
-            particleCnt++;
+            particleCnt += lines.size();
         }
-        ifs.close();
 
         // resize the flag quantity to make the storage consistent
         Quantity& flags = storage.getQuantity(QuantityId::FLAG);
@@ -474,9 +573,133 @@ Attractor readAttractor(Deserializer<Precise>& deserializer) {
 
 } // namespace
 
-BinaryOutput::BinaryOutput(const OutputFile& fileMask, const RunTypeEnum runTypeId)
+/// Size of data blocks compared by delta checkpoints.
+const Size CHECKPOINT_BLOCK_SIZE = 1 << 16;
+
+/// Index of the block terminating the list of blocks in delta checkpoints.
+const Size CHECKPOINT_END = Size(-1);
+
+/// Maximal number of delta checkpoints referencing each other, to detect cyclic references.
+const Size CHECKPOINT_MAX_CHAIN = 10000;
+
+INLINE uint64_t rotateLeft(const uint64_t value, const int shift) {
+    return (value << shift) | (value >> (64 - shift));
+}
+
+INLINE uint64_t mixHash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+/// Output stream splitting the data into blocks and computing their hashes. In full dumps, all data are
+/// written into the file; delta checkpoints only contain blocks with hashes different from the previous dump.
+class BinaryOutput::CheckpointStream : public IBinaryOutputStream {
+private:
+    std::ofstream ofs;
+    ArrayView<const BlockHash> previous;
+    Array<BlockHash>& hashes;
+    bool delta;
+
+    Array<char> block;
+    Size blockSize = 0;
+    uint64_t totalSize = 0;
+
+public:
+    /// \param reference File name of the previous dump, or NOTHING for full dump.
+    CheckpointStream(const Path& path,
+        const Optional<Path>& reference,
+        ArrayView<const BlockHash> previous,
+        Array<BlockHash>& hashes)
+        : ofs(path.native(), std::ios::out | std::ios::binary)
+        , previous(previous)
+        , hashes(hashes)
+        , delta(bool(reference))
+        , block(CHECKPOINT_BLOCK_SIZE) {
+        if (delta) {
+            Array<char> header;
+            Serializer<true> serializer(makeAuto<MemoryBinaryOutputStream>(header));
+            serializer.serialize(
+                "SPHDLT", BinaryIoVersion::LATEST, reference->string(), CHECKPOINT_BLOCK_SIZE);
+            ofs.write(&header[0], header.size());
+        }
+    }
+
+    virtual bool write(ArrayView<const char> buffer) override {
+        Size written = 0;
+        while (written < buffer.size()) {
+            const Size cnt = min(buffer.size() - written, CHECKPOINT_BLOCK_SIZE - blockSize);
+            std::memcpy(&block[blockSize], &buffer[written], cnt);
+            blockSize += cnt;
+            written += cnt;
+            if (blockSize == CHECKPOINT_BLOCK_SIZE) {
+                this->flushBlock();
+            }
+        }
+        totalSize += buffer.size();
+        return bool(ofs);
+    }
+
+    /// Writes the last block and closes the file, returns false if the file could not be written.
+    bool close() {
+        if (blockSize > 0) {
+            this->flushBlock();
+        }
+        if (delta) {
+            this->writeInts(CHECKPOINT_END, totalSize);
+        }
+        ofs.close();
+        return bool(ofs);
+    }
+
+private:
+    void flushBlock() {
+        const BlockHash hash = hashBlock(&block[0], blockSize);
+        const Size blockIdx = hashes.size();
+        hashes.push(hash);
+        if (!delta) {
+            ofs.write(&block[0], blockSize);
+        } else if (blockIdx >= previous.size() || previous[blockIdx].h1 != hash.h1 ||
+                   previous[blockIdx].h2 != hash.h2) {
+            this->writeInts(blockIdx, blockSize);
+            ofs.write(&block[0], blockSize);
+        }
+        blockSize = 0;
+    }
+
+    /// Writes two integers, using the same representation as Serializer<true>.
+    void writeInts(const int64_t value1, const int64_t value2) {
+        const int64_t values[] = { value1, value2 };
+        ofs.write(reinterpret_cast<const char*>(values), sizeof(values));
+    }
+
+    /// Computes a 128-bit hash of the block, so that the probability of collision is negligible.
+    static BlockHash hashBlock(const char* data, const Size size) {
+        uint64_t h1 = 0x9e3779b97f4a7c15ull ^ size;
+        uint64_t h2 = 0x6a09e667f3bcc909ull;
+        Size i = 0;
+        for (; i + 16 <= size; i += 16) {
+            uint64_t k1, k2;
+            std::memcpy(&k1, data + i, sizeof(k1));
+            std::memcpy(&k2, data + i + 8, sizeof(k2));
+            h1 = rotateLeft(h1 ^ (k1 * 0x87c37b91114253d5ull), 27) * 5 + 0x52dce729;
+            h2 = rotateLeft(h2 ^ (k2 * 0x4cf5ad432745937full), 31) * 5 + 0x38495ab5;
+        }
+        uint64_t tail[2] = { 0, 0 };
+        std::memcpy(tail, data + i, size - i);
+        h1 = mixHash(h1 ^ (tail[0] * 0x87c37b91114253d5ull));
+        h2 = mixHash(h2 ^ (tail[1] * 0x4cf5ad432745937full));
+        return BlockHash{ h1 + h2, h2 + h1 * 3 };
+    }
+};
+
+BinaryOutput::BinaryOutput(const OutputFile& fileMask, const RunTypeEnum runTypeId, const Size checkpointPeriod)
     : IOutput(fileMask)
-    , runTypeId(runTypeId) {}
+    , runTypeId(runTypeId)
+    , checkpointPeriod(max(checkpointPeriod, 1u)) {}
 
 Expected<Path> BinaryOutput::dump(const Storage& storage, const Statistics& stats) {
     VERBOSE_LOG
@@ -488,11 +711,41 @@ Expected<Path> BinaryOutput::dump(const Storage& storage, const Statistics& stat
             "Cannot create directory {}: {}", fileName.parentPath().string(), dirResult.error());
     }
 
+    if (checkpointPeriod == 1) {
+        Serializer<true> serializer(makeAuto<FileBinaryOutputStream>(fileName));
+        serialize(serializer, storage, stats, runTypeId);
+        return fileName;
+    }
+
+    // delta checkpoint must reference a different file in the same directory
+    Optional<Path> reference;
+    if (dumpCnt % checkpointPeriod != 0 && !blockHashes.empty() && lastPath != fileName &&
+        lastPath.parentPath() == fileName.parentPath()) {
+        reference = lastPath.fileName();
+    }
+    Array<BlockHash> hashes;
+    AutoPtr<CheckpointStream> stream = makeAuto<CheckpointStream>(fileName, reference, blockHashes, hashes);
+    RawPtr<CheckpointStream> streamPtr = stream.get();
+    Serializer<true> serializer(std::move(stream));
+    serialize(serializer, storage, stats, runTypeId);
+    if (!streamPtr->close()) {
+        blockHashes.clear();
+        return makeUnexpected<Path>("Cannot write file '{}'", fileName.string());
+    }
+
+    blockHashes = std::move(hashes);
+    lastPath = fileName;
+    ++dumpCnt;
+    return fileName;
+}
+
+void BinaryOutput::serialize(Serializer<true>& serializer,
+    const Storage& storage,
+    const Statistics& stats,
+    const RunTypeEnum runTypeId) {
     const Float runTime = stats.getOr<Float>(StatisticsId::RUN_TIME, 0._f);
     const Size wallclockTime = stats.getOr<int>(StatisticsId::WALLCLOCK_TIME, 0);
 
-    Serializer<true> serializer(makeAuto<FileBinaryOutputStream>(fileName));
-
     // file format identifier
     const Size materialCnt = storage.getMaterialCnt();
     const Size quantityCnt = storage.getQuantityCnt() - int(storage.has(QuantityId::MATERIAL_ID));
@@ -577,8 +830,6 @@ Expected<Path> BinaryOutput::dump(const Storage& storage, const Statistics& stat
     for (const Attractor& a : storage.getAttractors()) {
         writeAttractor(serializer, a);
     }
-
-    return fileName;
 }
 
 template <typename TId, typename T>
@@ -694,9 +945,94 @@ static Optional<String> readBuildDate(char* buffer, const BinaryIoVersion versio
     }
 }
 
+/// Reads the data of a dump into the buffer, reading at most given number of bytes. Delta checkpoints are
+/// reconstructed recursively from the previous dumps.
+static void readCheckpoint(const Path& path, Array<char>& data, const std::size_t maxSize, const Size depth) {
+    if (depth > CHECKPOINT_MAX_CHAIN) {
+        throw SerializerException("Chain of delta checkpoints is too long or cyclic");
+    }
+    if (!FileSystem::pathExists(path)) {
+        throw SerializerException("Missing file '" + path.string() + "'");
+    }
+    Deserializer<true> deserializer(makeAuto<FileBinaryInputStream>(path));
+    String identifier;
+    deserializer.deserialize(identifier);
+    if (identifier == "SPH") {
+        const std::size_t size = min(FileSystem::fileSize(path), maxSize);
+        data.resize(Size(size));
+        std::ifstream ifs(path.native(), std::ios::in | std::ios::binary);
+        ifs.read(&data[0], size);
+        if (!ifs) {
+            throw SerializerException("Cannot read file '" + path.string() + "'");
+        }
+        return;
+    } else if (identifier != "SPHDLT") {
+        throw SerializerException("Invalid format specifier: expected SPH or SPHDLT, got " + identifier);
+    }
+
+    BinaryIoVersion version;
+    String reference;
+    Size blockSize;
+    deserializer.deserialize(version, reference, blockSize);
+    readCheckpoint(path.parentPath() / Path(reference), data, maxSize, depth + 1);
+
+    while (true) {
+        Size blockIdx;
+        deserializer.deserialize(blockIdx);
+        if (blockIdx == CHECKPOINT_END) {
+            std::size_t totalSize;
+            deserializer.deserialize(totalSize);
+            totalSize = min(totalSize, maxSize);
+            if (totalSize > data.size()) {
+                throw SerializerException("Incomplete delta checkpoint");
+            }
+            data.resize(Size(totalSize));
+            return;
+        }
+        Size size;
+        deserializer.deserialize(size);
+        const std::size_t offset = std::size_t(blockIdx) * blockSize;
+        if (size > blockSize || (offset < maxSize && offset > data.size())) {
+            throw SerializerException("Invalid block in delta checkpoint");
+        }
+        const Size readSize = Size(min(std::size_t(size), maxSize - min(offset, maxSize)));
+        if (readSize > 0) {
+            if (offset + readSize > data.size()) {
+                data.resize(Size(offset + readSize));
+            }
+            deserializer.readBytes(ArrayView<char>(&data[Size(offset)], readSize));
+        }
+        deserializer.skip(size - readSize);
+    }
+}
+
+/// Opens the stream with the data of a dump. Full dumps are read from the file directly, delta checkpoints
+/// are reconstructed into the buffer.
+static AutoPtr<IBinaryInputStream> openBinaryInput(const Path& path,
+    Array<char>& buffer,
+    const std::size_t maxSize = std::size_t(-1)) {
+    {
+        Deserializer<true> deserializer(makeAuto<FileBinaryInputStream>(path));
+        String identifier;
+        deserializer.deserialize(identifier);
+        if (identifier != "SPHDLT") {
+            return makeAuto<FileBinaryInputStream>(path);
+        }
+    }
+    readCheckpoint(path, buffer, maxSize, 0);
+    return makeAuto<MemoryBinaryInputStream>(buffer.empty() ? nullptr : &buffer[0], buffer.size());
+}
+
 Outcome BinaryInput::load(const Path& path, Storage& storage, Statistics& stats) {
     storage.removeAll();
-    Deserializer<true> deserializer(makeAuto<FileBinaryInputStream>(path));
+    Array<char> checkpoint;
+    AutoPtr<IBinaryInputStream> stream;
+    try {
+        stream = openBinaryInput(path, checkpoint);
+    } catch (const Exception& e) {
+        return makeFailed("Cannot read file '{}'. {}", path.string(), exceptionMessage(e));
+    }
+    Deserializer<true> deserializer(std::move(stream));
     String identifier;
     Float time, timeStep;
     Size wallclockTime;
@@ -808,7 +1144,9 @@ Expected<BinaryInput::Info> BinaryInput::getInfo(const Path& path) {
     char dateBuffer[16];
     String identifier;
     try {
-        Deserializer<true> deserializer(makeAuto<FileBinaryInputStream>(path));
+        // only the header is needed
+        Array<char> checkpoint;
+        Deserializer<true> deserializer(openBinaryInput(path, checkpoint, 256));
         deserializer.deserialize(identifier,
             info.runTime,
             info.particleCnt,
@@ -842,10 +1180,14 @@ Expected<BinaryInput::Info> BinaryInput::getInfo(const Path& path) {
 
 CompressedOutput::CompressedOutput(const OutputFile& fileMask,
     const CompressionEnum compression,
-    const RunTypeEnum runTypeId)
+    const RunTypeEnum runTypeId,
+    SharedPtr<IScheduler> scheduler,
+    const QuantizationParams& quantization)
     : IOutput(fileMask)
     , compression(compression)
-    , runTypeId(runTypeId) {}
+    , runTypeId(runTypeId)
+    , scheduler(std::move(scheduler))
+    , quantization(quantization) {}
 
 const int MAGIC_NUMBER = 42;
 
@@ -932,6 +1274,356 @@ static void decompressQuantity(Deserializer<false>& deserializer,
     }
 }
 
+/// Number of values of a single component compressed as one block by \ref FloatCodec.
+const Size CODEC_BLOCK_SIZE = 1 << 16;
+
+template <typename T>
+struct CodecTraits;
+
+template <>
+struct CodecTraits<Float> {
+    static constexpr Size COMPONENT_CNT = 1;
+
+    INLINE static Float get(const Float value, const Size UNUSED(j)) {
+        return value;
+    }
+    INLINE static void set(Float& value, const Size UNUSED(j), const Float component) {
+        value = component;
+    }
+};
+
+template <>
+struct CodecTraits<Vector> {
+    static constexpr Size COMPONENT_CNT = 4;
+
+    INLINE static Float get(const Vector& value, const Size j) {
+        return value[j];
+    }
+    INLINE static void set(Vector& value, const Size j, const Float component) {
+        value[j] = component;
+    }
+};
+
+/// Returns the bits of the value converted to single precision, as written by Serializer<false>.
+INLINE uint32_t toCodecWord(const Float value) {
+    const float f = float(value);
+    uint32_t word;
+    std::memcpy(&word, &f, sizeof(word));
+    return word;
+}
+
+INLINE Float fromCodecWord(const uint32_t word) {
+    float f;
+    std::memcpy(&f, &word, sizeof(word));
+    return Float(f);
+}
+
+/// Compresses the words in blocks and writes them. Words are stored by components, each component containing
+/// given number of values.
+static void writeCodecBlocks(Serializer<false>& serializer,
+    IScheduler& scheduler,
+    ArrayView<const uint32_t> words,
+    const Size valueCnt) {
+    const Size blockCnt = (valueCnt + CODEC_BLOCK_SIZE - 1) / CODEC_BLOCK_SIZE;
+    const Size componentCnt = valueCnt > 0 ? words.size() / valueCnt : 0;
+    Array<Array<char>> blocks(componentCnt * blockCnt);
+    parallelFor(scheduler, 0, blocks.size(), 1, [&](const Size b) {
+        const Size from = (b % blockCnt) * CODEC_BLOCK_SIZE;
+        const Size to = min(from + CODEC_BLOCK_SIZE, valueCnt);
+        const Size offset = (b / blockCnt) * valueCnt;
+        blocks[b] = FloatCodec::encode(words.subset(offset + from, to - from));
+    });
+    for (const Array<char>& block : blocks) {
+        serializer.serialize(block.size());
+        serializer.writeBytes(block);
+    }
+}
+
+/// Reads the blocks written by \ref writeCodecBlocks and decompresses them into the words.
+static void readCodecBlocks(Deserializer<false>& deserializer,
+    IScheduler& scheduler,
+    ArrayView<uint32_t> words,
+    const Size valueCnt) {
+    const Size blockCnt = (valueCnt + CODEC_BLOCK_SIZE - 1) / CODEC_BLOCK_SIZE;
+    const Size componentCnt = valueCnt > 0 ? words.size() / valueCnt : 0;
+    Array<Array<char>> blocks(componentCnt * blockCnt);
+    for (Array<char>& block : blocks) {
+        Size size;
+        deserializer.deserialize(size);
+        // guard against allocating a huge buffer for corrupted files
+        if (size > 8 * sizeof(uint32_t) * CODEC_BLOCK_SIZE) {
+            throw SerializerException("Invalid size of compressed block");
+        }
+        block.resize(size);
+        deserializer.readBytes(block);
+    }
+    std::atomic<bool> valid{ true };
+    parallelFor(scheduler, 0, blocks.size(), 1, [&](const Size b) {
+        const Size from = (b % blockCnt) * CODEC_BLOCK_SIZE;
+        const Size to = min(from + CODEC_BLOCK_SIZE, valueCnt);
+        const Size offset = (b / blockCnt) * valueCnt;
+        if (!FloatCodec::decode(blocks[b], words.subset(offset + from, to - from))) {
+            valid = false;
+        }
+    });
+    if (!valid) {
+        throw SerializerException("Corrupted compressed data");
+    }
+}
+
+/// Returns the order of particles along the Morton curve.
+static Array<Size> getCodecOrder(IScheduler& scheduler, ArrayView<const Vector> r) {
+    Array<Size> order(r.size());
+    for (Size i = 0; i < r.size(); ++i) {
+        order[i] = i;
+    }
+    Box box;
+    for (const Vector& p : r) {
+        box.extend(p);
+    }
+    if (r.empty() || !isReal(box.lower()) || !isReal(box.upper())) {
+        // cannot compute the Morton codes, keep the original order
+        return order;
+    }
+    const Float eps = max(0.01_f * maxElement(box.size()), EPS);
+    box.extend(box.lower() - Vector(eps));
+    box.extend(box.upper() + Vector(eps));
+    Array<Size> codes(r.size());
+    parallelFor(scheduler, 0, r.size(), [&](const Size i) { codes[i] = morton(r[i], box); });
+    std::sort(order.begin(), order.end(), [&codes](const Size i1, const Size i2) {
+        return codes[i1] < codes[i2] || (codes[i1] == codes[i2] && i1 < i2);
+    });
+    return order;
+}
+
+/// Writes the order of particles as differences between consecutive indices.
+static void writeCodecOrder(Serializer<false>& serializer,
+    IScheduler& scheduler,
+    ArrayView<const Size> order) {
+    serializer.serialize(MAGIC_NUMBER, CODEC_BLOCK_SIZE);
+    Array<uint32_t> deltas(order.size());
+    Size last = 0;
+    for (Size k = 0; k < order.size(); ++k) {
+        // zigzag encoding of the signed difference
+        const int64_t delta = int64_t(order[k]) - int64_t(last);
+        deltas[k] = uint32_t((delta << 1) ^ (delta >> 63));
+        last = order[k];
+    }
+    writeCodecBlocks(serializer, scheduler, deltas, order.size());
+}
+
+static Array<Size> readCodecOrder(Deserializer<false>& deserializer,
+    IScheduler& scheduler,
+    const Size particleCnt) {
+    int magic;
+    Size blockSize;
+    deserializer.deserialize(magic, blockSize);
+    if (magic != MAGIC_NUMBER || blockSize != CODEC_BLOCK_SIZE) {
+        throw SerializerException("Invalid compression");
+    }
+    Array<uint32_t> deltas(particleCnt);
+    readCodecBlocks(deserializer, scheduler, deltas, particleCnt);
+    Array<Size> order(particleCnt);
+    Array<bool> used(particleCnt);
+    used.fill(false);
+    int64_t last = 0;
+    for (Size k = 0; k < particleCnt; ++k) {
+        const int64_t delta = int64_t(deltas[k] >> 1) ^ -int64_t(deltas[k] & 1);
+        last += delta;
+        if (last < 0 || last >= int64_t(particleCnt) || used[last]) {
+            throw SerializerException("Invalid order of particles");
+        }
+        used[last] = true;
+        order[k] = Size(last);
+    }
+    return order;
+}
+
+template <typename T>
+static void compressCodecQuantity(Serializer<false>& serializer,
+    IScheduler& scheduler,
+    ArrayView<const Size> order,
+    const Array<T>& values) {
+    constexpr Size componentCnt = CodecTraits<T>::COMPONENT_CNT;
+    const Size size = values.size();
+    Array<uint32_t> words(componentCnt * size);
+    parallelFor(scheduler, 0, size, [&](const Size k) {
+        const T& value = values[order[k]];
+        for (Size j = 0; j < componentCnt; ++j) {
+            words[j * size + k] = toCodecWord(CodecTraits<T>::get(value, j));
+        }
+    });
+    writeCodecBlocks(serializer, scheduler, words, size);
+}
+
+template <typename T>
+static void decompressCodecQuantity(Deserializer<false>& deserializer,
+    IScheduler& scheduler,
+    ArrayView<const Size> order,
+    Array<T>& values) {
+    constexpr Size componentCnt = CodecTraits<T>::COMPONENT_CNT;
+    const Size size = values.size();
+    Array<uint32_t> words(componentCnt * size);
+    readCodecBlocks(deserializer, scheduler, words, size);
+    parallelFor(scheduler, 0, size, [&](const Size k) {
+        T& value = values[order[k]];
+        for (Size j = 0; j < componentCnt; ++j) {
+            CodecTraits<T>::set(value, j, fromCodecWord(words[j * size + k]));
+        }
+    });
+}
+
+/// Returns true if particles are stored in the order given by \ref getCodecOrder.
+INLINE bool usesCodecOrder(const CompressionEnum compression) {
+    return compression == CompressionEnum::XOR_SHUFFLE || compression == CompressionEnum::QUANTIZED;
+}
+
+/// Limit of the absolute value of quantized integers. Rounded values are at most 2^30 - 1 in absolute value,
+/// so differences of consecutive values are within +-(2^31 - 2) and their zigzag encoding fits into 32 bits.
+const Float QUANTIZED_LIMIT = Float((1 << 30) - 1);
+
+/// Returns the absolute error bound of given values. The returned value is exactly representable by the
+/// serializer.
+template <typename T>
+static Float getAbsoluteBound(const QuantizationParams::Bound& bound, const Array<T>& values) {
+    // smoothing lengths are not included in the range
+    constexpr Size componentCnt = CodecTraits<T>::COMPONENT_CNT > 3 ? 3 : CodecTraits<T>::COMPONENT_CNT;
+    Float error = bound.value;
+    if (bound.relative) {
+        Float range = 0._f;
+        for (Size j = 0; j < componentCnt; ++j) {
+            Interval interval;
+            for (const T& value : values) {
+                interval.extend(CodecTraits<T>::get(value, j));
+            }
+            if (!interval.empty()) {
+                range = max(range, interval.size());
+            }
+        }
+        error *= range;
+    }
+    if (!isReal(error) || error <= 0._f) {
+        return 0._f;
+    }
+    return Float(float(error));
+}
+
+/// Converts a component of values to quantized integers, stored as zigzag-encoded differences between
+/// consecutive particles. If the values cannot be quantized with given error bound, the words contain the
+/// values converted to single precision and zero step is returned.
+template <typename T>
+static Float quantizeComponent(IScheduler& scheduler,
+    ArrayView<const Size> order,
+    const Array<T>& values,
+    const Size j,
+    const Float bound,
+    ArrayView<uint32_t> words,
+    Float& offset) {
+    const Size size = values.size();
+    Interval range;
+    for (const T& value : values) {
+        range.extend(CodecTraits<T>::get(value, j));
+    }
+    // both the offset and the step must be exactly representable by the serializer; the step is slightly
+    // smaller than twice the bound to cover round-off errors
+    offset = range.empty() ? 0._f : Float(float(range.lower()));
+    const Float step = Float(float(1.998_f * bound));
+    std::atomic<bool> quantized{ bound > 0._f && step > 0._f && isReal(range.lower()) &&
+                                 isReal(range.upper()) && (range.upper() - offset) / step < QUANTIZED_LIMIT &&
+                                 (offset - range.lower()) / step < QUANTIZED_LIMIT };
+    if (quantized) {
+        parallelFor(scheduler, 0, size, [&](const Size k) {
+            const Float value = CodecTraits<T>::get(values[order[k]], j);
+            if (!isReal(value)) {
+                quantized = false;
+                return;
+            }
+            const Float q = std::round((value - offset) / step);
+            // reconstruct the value the same way as the input to make sure the error bound holds
+            if (abs(q) > QUANTIZED_LIMIT || abs(offset + q * step - value) > bound) {
+                quantized = false;
+            }
+            words[k] = uint32_t(int32_t(q));
+        });
+    }
+    if (!quantized) {
+        parallelFor(scheduler, 0, size, [&](const Size k) {
+            words[k] = toCodecWord(CodecTraits<T>::get(values[order[k]], j));
+        });
+        offset = 0._f;
+        return 0._f;
+    }
+    // predict the value from the previous particle along the curve
+    int64_t last = 0;
+    for (Size k = 0; k < size; ++k) {
+        const int64_t q = int32_t(words[k]);
+        const int64_t delta = q - last;
+        words[k] = uint32_t((delta << 1) ^ (delta >> 63));
+        last = q;
+    }
+    return step;
+}
+
+/// Writes the quantity quantized with given error bound, components that cannot be quantized are stored
+/// without quantization.
+template <typename T>
+static void compressQuantizedQuantity(Serializer<false>& serializer,
+    IScheduler& scheduler,
+    ArrayView<const Size> order,
+    const Array<T>& values,
+    const Float bound) {
+    constexpr Size componentCnt = CodecTraits<T>::COMPONENT_CNT;
+    const Size size = values.size();
+    Array<uint32_t> words(componentCnt * size);
+    ArrayView<uint32_t> view = words;
+    for (Size j = 0; j < componentCnt; ++j) {
+        // smoothing lengths (and their derivatives) are always stored without quantization
+        const Float componentBound = j < 3 ? bound : 0._f;
+        Float offset;
+        const Float step = quantizeComponent(
+            scheduler, order, values, j, componentBound, view.subset(j * size, size), offset);
+        serializer.serialize(offset, step);
+    }
+    writeCodecBlocks(serializer, scheduler, words, size);
+}
+
+template <typename T>
+static void decompressQuantizedQuantity(Deserializer<false>& deserializer,
+    IScheduler& scheduler,
+    ArrayView<const Size> order,
+    Array<T>& values) {
+    constexpr Size componentCnt = CodecTraits<T>::COMPONENT_CNT;
+    const Size size = values.size();
+    StaticArray<Float, componentCnt> offsets, steps;
+    for (Size j = 0; j < componentCnt; ++j) {
+        deserializer.deserialize(offsets[j], steps[j]);
+    }
+    Array<uint32_t> words(componentCnt * size);
+    readCodecBlocks(deserializer, scheduler, words, size);
+    for (Size j = 0; j < componentCnt; ++j) {
+        if (steps[j] == 0._f) {
+            continue;
+        }
+        int64_t q = 0;
+        for (Size k = 0; k < size; ++k) {
+            uint32_t& word = words[j * size + k];
+            q += int64_t(word >> 1) ^ -int64_t(word & 1);
+            word = uint32_t(int32_t(q));
+        }
+    }
+    parallelFor(scheduler, 0, size, [&](const Size k) {
+        T& value = values[order[k]];
+        for (Size j = 0; j < componentCnt; ++j) {
+            const uint32_t word = words[j * size + k];
+            if (steps[j] == 0._f) {
+                CodecTraits<T>::set(value, j, fromCodecWord(word));
+            } else {
+                CodecTraits<T>::set(value, j, offsets[j] + Float(int32_t(word)) * steps[j]);
+            }
+        }
+    });
+}
+
 Expected<Path> CompressedOutput::dump(const Storage& storage, const Statistics& stats) {
     VERBOSE_LOG
 
@@ -950,11 +1642,47 @@ Expected<Path> CompressedOutput::dump(const Storage& storage, const Statistics&
     /// \todo runType as string
     serializer.serialize(runTypeId);
     serializer.serialize(storage.getAttractorCnt());
-    serializer.addPadding(226);
+
+    ErrorBounds bounds;
+    if (compression == CompressionEnum::QUANTIZED) {
+        bounds.position =
+            getAbsoluteBound(quantization.position, storage.getValue<Vector>(QuantityId::POSITION));
+        bounds.velocity =
+            getAbsoluteBound(quantization.velocity, storage.getDt<Vector>(QuantityId::POSITION));
+        if (storage.has(QuantityId::DENSITY)) {
+            bounds.density =
+                getAbsoluteBound(quantization.density, storage.getValue<Float>(QuantityId::DENSITY));
+        }
+        if (storage.has(QuantityId::ENERGY)) {
+            bounds.energy =
+                getAbsoluteBound(quantization.energy, storage.getValue<Float>(QuantityId::ENERGY));
+        }
+        if (storage.has(QuantityId::DAMAGE)) {
+            bounds.damage =
+                getAbsoluteBound(quantization.damage, storage.getValue<Float>(QuantityId::DAMAGE));
+        }
+    }
+    serializer.serialize(bounds.position, bounds.velocity, bounds.density, bounds.energy, bounds.damage);
+    serializer.addPadding(206);
+
+    Array<Size> order;
+    if (usesCodecOrder(compression)) {
+        order = getCodecOrder(*scheduler, storage.getValue<Vector>(QuantityId::POSITION));
+        writeCodecOrder(serializer, *scheduler, order);
+    }
+    auto compress = [&](const auto& values, const Float bound) {
+        if (compression == CompressionEnum::QUANTIZED) {
+            compressQuantizedQuantity(serializer, *scheduler, order, values, bound);
+        } else if (compression == CompressionEnum::XOR_SHUFFLE) {
+            compressCodecQuantity(serializer, *scheduler, order, values);
+        } else {
+            compressQuantity(serializer, compression, values);
+        }
+    };
 
     // mandatory, without prefix
-    compressQuantity(serializer, compression, storage.getValue<Vector>(QuantityId::POSITION));
-    compressQuantity(serializer, compression, storage.getDt<Vector>(QuantityId::POSITION));
+    compress(storage.getValue<Vector>(QuantityId::POSITION), bounds.position);
+    compress(storage.getDt<Vector>(QuantityId::POSITION), bounds.velocity);
 
     Array<QuantityId> expectedIds{
         QuantityId::MASS, QuantityId::DENSITY, QuantityId::ENERGY, QuantityId::DAMAGE
@@ -971,7 +1699,20 @@ Expected<Path> CompressedOutput::dump(const Storage& storage, const Statistics&
 
     for (QuantityId id : ids) {
         serializer.serialize(id);
-        compressQuantity(serializer, compression, storage.getValue<Float>(id));
+        switch (id) {
+        case QuantityId::DENSITY:
+            compress(storage.getValue<Float>(id), bounds.density);
+            break;
+        case QuantityId::ENERGY:
+            compress(storage.getValue<Float>(id), bounds.energy);
+            break;
+        case QuantityId::DAMAGE:
+            compress(storage.getValue<Float>(id), bounds.damage);
+            break;
+        default:
+            // masses are never quantized
+            compress(storage.getValue<Float>(id), 0._f);
+        }
     }
 
     for (const Attractor& a : storage.getAttractors()) {
@@ -981,6 +1722,9 @@ Expected<Path> CompressedOutput::dump(const Storage& storage, const Statistics&
     return fileName;
 }
 
+CompressedInput::CompressedInput(SharedPtr<IScheduler> scheduler)
+    : scheduler(std::move(scheduler)) {}
+
 Outcome CompressedInput::load(const Path& path, Storage& storage, Statistics& stats) {
     // create any material
     storage = Storage(Factory::getMaterial(BodySettings::getDefaults()));
@@ -1011,18 +1755,33 @@ Outcome CompressedInput::load(const Path& path, Storage& storage, Statistics& st
 
     stats.set(StatisticsId::RUN_TIME, time);
     try {
+        // error bounds are only informative, the quantization parameters are stored with the quantities
         deserializer.skip(226);
     } catch (SerializerException&) {
         return makeFailed("Incorrect header size");
     }
 
     try {
+        Array<Size> order;
+        if (usesCodecOrder(compression)) {
+            order = readCodecOrder(deserializer, *scheduler, particleCnt);
+        }
+        auto decompress = [&](auto& values) {
+            if (compression == CompressionEnum::QUANTIZED) {
+                decompressQuantizedQuantity(deserializer, *scheduler, order, values);
+            } else if (compression == CompressionEnum::XOR_SHUFFLE) {
+                decompressCodecQuantity(deserializer, *scheduler, order, values);
+            } else {
+                decompressQuantity(deserializer, compression, values);
+            }
+        };
+
         Array<Vector> positions(particleCnt);
-        decompressQuantity(deserializer, compression, positions);
+        decompress(positions);
         storage.insert<Vector>(QuantityId::POSITION, OrderEnum::SECOND, std::move(positions));
 
         Array<Vector> velocities(particleCnt);
-        decompressQuantity(deserializer, compression, velocities);
+        decompress(velocities);
         storage.getDt<Vector>(QuantityId::POSITION) = std::move(velocities);
 
         Size count;
@@ -1031,7 +1790,7 @@ Outcome CompressedInput::load(const Path& path, Storage& storage, Statistics& st
             QuantityId id;
             deserializer.deserialize(id);
             Array<Float> values(particleCnt);
-            decompressQuantity(deserializer, compression, values);
+            decompress(values);
             storage.insert<Float>(id, OrderEnum::ZERO, std::move(values));
         }
 
@@ -1056,10 +1815,15 @@ Expected<CompressedInput::Info> CompressedInput::getInfo(const Path& path) {
     CompressedIoVersion version;
     CompressionEnum compression;
     RunTypeEnum runTypeId;
+    ErrorBounds bounds;
     try {
         Deserializer<false> deserializer(makeAuto<FileBinaryInputStream>(path));
         deserializer.deserialize(
             identifier, time, particleCnt, compression, version, runTypeId, attractorCnt);
+        if (version >= CompressedIoVersion::V2026_10_16) {
+            deserializer.deserialize(
+                bounds.position, bounds.velocity, bounds.density, bounds.energy, bounds.damage);
+        }
     } catch (const SerializerException&) {
         return makeUnexpected<Info>("Cannot read file '{}', invalid file format.", path.string());
     } catch (const Exception& e) {
@@ -1075,6 +1839,8 @@ Expected<CompressedInput::Info> CompressedInput::getInfo(const Path& path) {
     info.runTime = time;
     info.runType = runTypeId;
     info.version = version;
+    info.compression = compression;
+    info.errorBounds = bounds;
     if (version >= CompressedIoVersion::V2021_08_08) {
         info.attractorCnt = attractorCnt;
     } else {
@@ -1084,32 +1850,913 @@ Expected<CompressedInput::Info> CompressedInput::getInfo(const Path& path) {
 }
 
 // ----------------------------------------------------------------------------------------------------------
-// VtkOutput
+// MappedInput
 // ----------------------------------------------------------------------------------------------------------
 
-static void writeDataArray(std::ofstream& of,
-    const Storage& storage,
-    const Statistics& stats,
-    const ITextColumn& column) {
-    switch (column.getType()) {
+namespace {
+
+/// Deserializer reading from a memory-mapped file, allowing to jump to arbitrary offsets.
+template <bool Precise>
+class MappedDeserializer : public Deserializer<Precise> {
+private:
+    MemoryBinaryInputStream* stream;
+
+public:
+    explicit MappedDeserializer(const FileSystem::MappedFile& file)
+        : MappedDeserializer(file.data(), file.size()) {}
+
+    MappedDeserializer(const char* data, const std::size_t size)
+        : MappedDeserializer(new MemoryBinaryInputStream(data, size)) {}
+
+    void seek(const std::size_t offset) {
+        if (!stream->seek(offset)) {
+            throw SerializerException("Unexpected end of file");
+        }
+    }
+
+    /// Skips a buffer of given size; unlike \ref skip, the size is not limited by the range of Size.
+    void skipBuffer(const std::size_t size) {
+        this->seek(stream->position() + size);
+    }
+
+    std::size_t position() const {
+        return stream->position();
+    }
+
+private:
+    explicit MappedDeserializer(MemoryBinaryInputStream* stream)
+        : Deserializer<Precise>(AutoPtr<IBinaryInputStream>(stream))
+        , stream(stream) {}
+};
+
+/// Returns the size of a value of given type in the binary file.
+Size getSerializedSize(const ValueEnum type) {
+    switch (type) {
     case ValueEnum::SCALAR:
-        of << R"(      <DataArray type="Float32" Name=")" << column.getName().toAscii()
-           << R"(" format="ascii">)";
-        break;
-    case ValueEnum::VECTOR:
-        of << R"(      <DataArray type="Float32" Name=")" << column.getName().toAscii()
-           << R"(" NumberOfComponents="3" format="ascii">)";
-        break;
     case ValueEnum::INDEX:
-        of << R"(      <DataArray type="Int32" Name=")" << column.getName().toAscii()
-           << R"(" format="ascii">)";
-        break;
+        return 8;
+    case ValueEnum::VECTOR:
+        return 4 * 8;
+    case ValueEnum::TENSOR:
+        return 9 * 8;
     case ValueEnum::SYMMETRIC_TENSOR:
-        of << R"(      <DataArray type="Float32" Name=")" << column.getName().toAscii()
-           << R"(" NumberOfComponents="6" format="ascii">)";
-        break;
+        return 6 * 8;
     case ValueEnum::TRACELESS_TENSOR:
-        of << R"(      <DataArray type="Float32" Name=")" << column.getName().toAscii()
+        return 5 * 8;
+    default:
+        NOT_IMPLEMENTED;
+    }
+}
+
+/// Returns true if the values of given type are stored in the binary file with the same memory layout as in
+/// \ref Storage.
+bool hasSameLayout(const ValueEnum type) {
+    return std::is_same<Float, double>::value && sizeof(Vector) == getSerializedSize(ValueEnum::VECTOR) &&
+           (type == ValueEnum::SCALAR || type == ValueEnum::VECTOR);
+}
+
+template <typename TValue>
+Array<TValue> readMappedValues(const char* data, const Size cnt) {
+    Array<TValue> values(cnt);
+    if (cnt == 0) {
+        return values;
+    }
+    const ValueEnum type = GetValueEnum<TValue>::type;
+    if (hasSameLayout(type)) {
+        std::memcpy(static_cast<void*>(&values[0]), data, std::size_t(cnt) * sizeof(TValue));
+    } else {
+        const std::size_t size = std::size_t(cnt) * getSerializedSize(type);
+        Deserializer<true> deserializer(makeAuto<MemoryBinaryInputStream>(data, size));
+        for (TValue& value : values) {
+            deserializer.read(value);
+        }
+    }
+    return values;
+}
+
+struct LoadMappedBuffersVisitor {
+    template <typename TValue>
+    void visit(Storage& storage,
+        const char* data,
+        const Size blockSize,
+        const Size first,
+        const Size cnt,
+        const QuantityId id,
+        const OrderEnum order) {
+        const std::size_t valueSize = getSerializedSize(GetValueEnum<TValue>::type);
+        for (Size k = 0; k <= Size(order); ++k) {
+            const char* buffer = data + (std::size_t(k) * blockSize + first) * valueSize;
+            Array<TValue> values = readMappedValues<TValue>(buffer, cnt);
+            if (k == 0) {
+                storage.insert<TValue>(id, order, std::move(values));
+            } else {
+                storage.getAll<TValue>(id)[k] = std::move(values);
+            }
+        }
+    }
+};
+
+/// Skips a quantity in a compressed file.
+template <typename T>
+void skipCompressedQuantity(MappedDeserializer<false>& deserializer,
+    const CompressionEnum compression,
+    const Size particleCnt) {
+    constexpr Size componentCnt = CodecTraits<T>::COMPONENT_CNT;
+    switch (compression) {
+    case CompressionEnum::NONE:
+        deserializer.skipBuffer(std::size_t(particleCnt) * componentCnt * sizeof(float));
+        break;
+    case CompressionEnum::RLE: {
+        // the length of the data is not known without decompressing them
+        Array<T> values(particleCnt);
+        decompressQuantity(deserializer, compression, values);
+        break;
+    }
+    case CompressionEnum::QUANTIZED:
+        // offset and step of each component
+        deserializer.skipBuffer(std::size_t(componentCnt) * 2 * sizeof(float));
+        SPH_FALLTHROUGH
+    case CompressionEnum::XOR_SHUFFLE: {
+        const Size blockCnt = (particleCnt + CODEC_BLOCK_SIZE - 1) / CODEC_BLOCK_SIZE;
+        for (Size b = 0; b < componentCnt * blockCnt; ++b) {
+            Size size;
+            deserializer.deserialize(size);
+            deserializer.skipBuffer(size);
+        }
+        break;
+    }
+    default:
+        NOT_IMPLEMENTED;
+    }
+}
+
+/// Header info and offsets of quantity buffers in a binary snapshot, relative to the beginning of the snapshot.
+struct BinaryLayout {
+    struct QuantityRecord {
+        QuantityId id;
+        OrderEnum order;
+        ValueEnum type;
+    };
+
+    struct BlockRecord {
+        /// Offset of the material parameters, or NOTHING if the snapshot has no materials
+        Optional<std::size_t> materialOffset;
+
+        /// Particles stored in the block
+        Size from, to;
+
+        /// Offsets of quantity buffers, in the same order as the quantity records
+        Array<std::size_t> offsets;
+    };
+
+    BinaryIoVersion version;
+    Float runTime;
+    Float timeStep;
+    Optional<Size> wallclockTime;
+    Size particleCnt;
+    Size attractorCnt;
+    std::size_t attractorOffset;
+    Array<QuantityRecord> records;
+    Array<BlockRecord> blocks;
+
+    /// Reads the header and skips over all quantity buffers. Expects the format identifier has been already
+    /// read.
+    void read(MappedDeserializer<true>& deserializer) {
+        Size quantityCnt, materialCnt, wallclock;
+        char runTypeBuffer[16];
+        char buildDateBuffer[16];
+        deserializer.deserialize(runTime,
+            particleCnt,
+            quantityCnt,
+            materialCnt,
+            timeStep,
+            version,
+            runTypeBuffer,
+            buildDateBuffer,
+            wallclock,
+            attractorCnt);
+        if (version >= BinaryIoVersion::V2021_03_20) {
+            wallclockTime = wallclock;
+        }
+        if (version < BinaryIoVersion::V2021_08_08) {
+            attractorCnt = 0;
+        }
+        deserializer.skip(BinaryOutput::PADDING_SIZE);
+
+        records.resize(quantityCnt);
+        for (Size i = 0; i < quantityCnt; ++i) {
+            deserializer.deserialize(records[i].id, records[i].order, records[i].type);
+        }
+
+        const bool hasMaterials = materialCnt > 0;
+        for (Size matIdx = 0; matIdx < max(materialCnt, Size(1)); ++matIdx) {
+            BlockRecord block;
+            if (hasMaterials) {
+                block.materialOffset = deserializer.position();
+                Expected<Storage> material = loadMaterial(matIdx, deserializer, this->getIds(), version);
+                if (!material) {
+                    throw SerializerException(material.error());
+                }
+            } else {
+                String identifier;
+                deserializer.deserialize(identifier);
+                if (identifier != "NOMAT") {
+                    throw SerializerException(
+                        "Unexpected missing material identifier, expected NOMAT, got " + identifier);
+                }
+            }
+            deserializer.deserialize(block.from, block.to);
+            if (block.from > block.to || block.to > particleCnt) {
+                throw SerializerException("Invalid range of particles");
+            }
+            for (const QuantityRecord& record : records) {
+                block.offsets.push(deserializer.position());
+                const std::size_t bufferSize = std::size_t(block.to - block.from) * getSerializedSize(record.type);
+                deserializer.skipBuffer((Size(record.order) + 1) * bufferSize);
+            }
+            blocks.push(std::move(block));
+        }
+        attractorOffset = deserializer.position();
+    }
+
+    /// Writes the layout into an index entry of \ref ArchiveOutput.
+    void serialize(Serializer<true>& serializer) const {
+        serializer.serialize(version, runTime, timeStep, bool(wallclockTime), wallclockTime.valueOr(0));
+        serializer.serialize(particleCnt, attractorCnt, attractorOffset, records.size(), blocks.size());
+        for (const QuantityRecord& record : records) {
+            serializer.serialize(record.id, record.order, record.type);
+        }
+        for (const BlockRecord& block : blocks) {
+            serializer.serialize(bool(block.materialOffset), block.materialOffset.valueOr(0), block.from, block.to);
+            for (std::size_t offset : block.offsets) {
+                serializer.serialize(offset);
+            }
+        }
+    }
+
+    /// Reads the layout from an index entry of \ref ArchiveOutput.
+    void deserialize(Deserializer<true>& deserializer) {
+        bool hasWallclock;
+        Size wallclock, recordCnt, blockCnt;
+        deserializer.deserialize(version, runTime, timeStep, hasWallclock, wallclock);
+        if (hasWallclock) {
+            wallclockTime = wallclock;
+        }
+        deserializer.deserialize(particleCnt, attractorCnt, attractorOffset, recordCnt, blockCnt);
+        records.resize(recordCnt);
+        for (QuantityRecord& record : records) {
+            deserializer.deserialize(record.id, record.order, record.type);
+        }
+        blocks.resize(blockCnt);
+        for (BlockRecord& block : blocks) {
+            bool hasMaterial;
+            std::size_t materialOffset;
+            deserializer.deserialize(hasMaterial, materialOffset, block.from, block.to);
+            if (hasMaterial) {
+                block.materialOffset = materialOffset;
+            }
+            block.offsets.resize(recordCnt);
+            for (std::size_t& offset : block.offsets) {
+                deserializer.deserialize(offset);
+            }
+        }
+    }
+
+    Array<QuantityId> getIds() const {
+        Array<QuantityId> ids;
+        for (const QuantityRecord& record : records) {
+            ids.push(record.id);
+        }
+        return ids;
+    }
+};
+
+bool isQuantitySelected(ArrayView<const QuantityId> quantities, const QuantityId id) {
+    return quantities.empty() || std::find(quantities.begin(), quantities.end(), id) != quantities.end();
+}
+
+IndexSequence getSelectedParticles(const Optional<IndexSequence>& particles, const Size particleCnt) {
+    if (!particles) {
+        return IndexSequence(0, particleCnt);
+    }
+    const Size to = min(Size(*particles->end()), particleCnt);
+    const Size from = min(Size(*particles->begin()), to);
+    return IndexSequence(from, to);
+}
+
+/// Loads selected quantities and particles of a binary snapshot with given layout.
+void loadBinary(const char* data,
+    const std::size_t size,
+    const BinaryLayout& layout,
+    ArrayView<const QuantityId> quantities,
+    const Optional<IndexSequence>& particles,
+    Storage& storage,
+    Statistics& stats) {
+    storage.removeAll();
+    const IndexSequence selected = getSelectedParticles(particles, layout.particleCnt);
+    MappedDeserializer<true> deserializer(data, size);
+    for (Size matIdx = 0; matIdx < layout.blocks.size(); ++matIdx) {
+        const BinaryLayout::BlockRecord& block = layout.blocks[matIdx];
+        const Size from = clamp(Size(*selected.begin()), block.from, block.to);
+        const Size to = clamp(Size(*selected.end()), block.from, block.to);
+        if (particles && from == to) {
+            continue;
+        }
+        Storage bodyStorage;
+        if (block.materialOffset) {
+            deserializer.seek(block.materialOffset.value());
+            Expected<Storage> material = loadMaterial(matIdx, deserializer, layout.getIds(), layout.version);
+            if (!material) {
+                throw SerializerException(material.error());
+            }
+            bodyStorage = std::move(material.value());
+        }
+        LoadMappedBuffersVisitor visitor;
+        for (Size i = 0; i < layout.records.size(); ++i) {
+            const BinaryLayout::QuantityRecord& record = layout.records[i];
+            if (!isQuantitySelected(quantities, record.id)) {
+                continue;
+            }
+            const std::size_t bufferSize =
+                (Size(record.order) + 1) * std::size_t(block.to - block.from) * getSerializedSize(record.type);
+            if (block.offsets[i] + bufferSize > size) {
+                throw SerializerException("Unexpected end of file");
+            }
+            dispatch(record.type,
+                visitor,
+                bodyStorage,
+                data + block.offsets[i],
+                block.to - block.from,
+                from - block.from,
+                to - from,
+                record.id,
+                record.order);
+        }
+        storage.merge(std::move(bodyStorage));
+    }
+
+    if (layout.attractorCnt > 0) {
+        deserializer.seek(layout.attractorOffset);
+        for (Size i = 0; i < layout.attractorCnt; ++i) {
+            storage.addAttractor(readAttractor(deserializer));
+        }
+    }
+
+    stats.set(StatisticsId::RUN_TIME, layout.runTime);
+    stats.set(StatisticsId::TIMESTEP_VALUE, layout.timeStep);
+    if (layout.wallclockTime) {
+        stats.set(StatisticsId::WALLCLOCK_TIME, int(layout.wallclockTime.value()));
+    }
+}
+
+} // namespace
+
+class MappedInput::Index : public Noncopyable {
+public:
+    Path path;
+
+    /// Modification time of the file when it was indexed
+    int64_t writeTime;
+
+    FileSystem::MappedFile file;
+
+    /// True for .sdf/.scf files, false for .ssf files
+    bool compressed;
+
+    // binary files
+    BinaryLayout layout;
+
+    // compressed files
+    Float runTime;
+    Size particleCnt;
+    Size attractorCnt;
+    std::size_t attractorOffset;
+    CompressionEnum compression;
+    std::size_t orderOffset;
+    Array<Size> order;
+    std::size_t positionOffset;
+    std::size_t velocityOffset;
+    Array<std::pair<QuantityId, std::size_t>> scalarOffsets;
+
+    Index(const Path& path, const int64_t writeTime)
+        : path(path)
+        , writeTime(writeTime)
+        , file(path) {
+        MappedDeserializer<true> deserializer(file);
+        String identifier;
+        deserializer.deserialize(identifier);
+        if (identifier == "SPH") {
+            compressed = false;
+            layout.read(deserializer);
+        } else if (identifier == "CPRSPH") {
+            compressed = true;
+            MappedDeserializer<false> compressedDeserializer(file);
+            compressedDeserializer.seek(deserializer.position());
+            this->indexCompressed(compressedDeserializer);
+        } else {
+            throw SerializerException("Invalid format specifier: expected SPH or CPRSPH, got " + identifier);
+        }
+    }
+
+    /// Loads values of a quantity in a compressed file, only keeping the selected particles.
+    template <typename T>
+    Array<T> loadCompressedValues(MappedDeserializer<false>& deserializer,
+        IScheduler& scheduler,
+        const std::size_t offset,
+        const Size from,
+        const Size to) const {
+        constexpr Size componentCnt = CodecTraits<T>::COMPONENT_CNT;
+        if (compression == CompressionEnum::NONE) {
+            // values can be read directly
+            deserializer.seek(offset + std::size_t(from) * componentCnt * sizeof(float));
+            Array<T> values(to - from);
+            for (T& value : values) {
+                deserializer.read(value);
+            }
+            return values;
+        }
+
+        deserializer.seek(offset);
+        Array<T> values(particleCnt);
+        if (compression == CompressionEnum::QUANTIZED) {
+            decompressQuantizedQuantity(deserializer, scheduler, order, values);
+        } else if (compression == CompressionEnum::XOR_SHUFFLE) {
+            decompressCodecQuantity(deserializer, scheduler, order, values);
+        } else {
+            decompressQuantity(deserializer, compression, values);
+        }
+        if (from == 0 && to == particleCnt) {
+            return values;
+        }
+        Array<T> selected(to - from);
+        for (Size i = from; i < to; ++i) {
+            selected[i - from] = values[i];
+        }
+        return selected;
+    }
+
+private:
+    void indexCompressed(MappedDeserializer<false>& deserializer) {
+        CompressedIoVersion compressedVersion;
+        RunTypeEnum runTypeId;
+        deserializer.deserialize(runTime, particleCnt, compression, compressedVersion, runTypeId, attractorCnt);
+        if (compressedVersion < CompressedIoVersion::V2021_08_08) {
+            attractorCnt = 0;
+        }
+        deserializer.skip(226);
+
+        if (usesCodecOrder(compression)) {
+            orderOffset = deserializer.position();
+            int magic;
+            Size blockSize;
+            deserializer.deserialize(magic, blockSize);
+            skipCompressedQuantity<Float>(deserializer, CompressionEnum::XOR_SHUFFLE, particleCnt);
+        }
+        positionOffset = deserializer.position();
+        skipCompressedQuantity<Vector>(deserializer, compression, particleCnt);
+        velocityOffset = deserializer.position();
+        skipCompressedQuantity<Vector>(deserializer, compression, particleCnt);
+
+        Size count;
+        deserializer.deserialize(count);
+        for (Size i = 0; i < count; ++i) {
+            QuantityId id;
+            deserializer.deserialize(id);
+            scalarOffsets.push(std::make_pair(id, deserializer.position()));
+            skipCompressedQuantity<Float>(deserializer, compression, particleCnt);
+        }
+        attractorOffset = deserializer.position();
+    }
+};
+
+MappedInput::MappedInput(Array<QuantityId>&& quantities,
+    const Optional<IndexSequence> particles,
+    SharedPtr<IScheduler> scheduler)
+    : quantities(std::move(quantities))
+    , particles(particles)
+    , scheduler(std::move(scheduler)) {}
+
+MappedInput::~MappedInput() = default;
+
+bool MappedInput::isSupported(const Path& path) {
+    const String ext = path.extension().string();
+    return ext == "ssf" || ext == "sdf" || ext == "scf";
+}
+
+void MappedInput::select(Array<QuantityId>&& newQuantities, const Optional<IndexSequence> newParticles) {
+    quantities = std::move(newQuantities);
+    particles = newParticles;
+}
+
+void MappedInput::open(const Path& path) {
+    const Expected<int64_t> writeTime = FileSystem::lastWriteTime(path);
+    if (!writeTime) {
+        throw IoError(writeTime.error());
+    }
+    // the file might have been rewritten with the same size, so check also the modification time
+    if (index && index->path == path && index->writeTime == writeTime.value() &&
+        FileSystem::fileSize(path) == index->file.size()) {
+        // already indexed
+        return;
+    }
+    index.reset();
+    index = makeAuto<Index>(path, writeTime.value());
+}
+
+
+Outcome MappedInput::load(const Path& path, Storage& storage, Statistics& stats) {
+    try {
+        this->open(path);
+    } catch (const Exception& e) {
+        return makeFailed("Cannot read file '{}'. {}", path.string(), exceptionMessage(e));
+    }
+
+    try {
+        if (!index->compressed) {
+            loadBinary(
+                index->file.data(), index->file.size(), index->layout, quantities, particles, storage, stats);
+            return SUCCESS;
+        }
+
+        storage = Storage(Factory::getMaterial(BodySettings::getDefaults()));
+        const IndexSequence selected = getSelectedParticles(particles, index->particleCnt);
+        const Size from = *selected.begin();
+        const Size to = *selected.end();
+        MappedDeserializer<false> deserializer(index->file);
+        if (usesCodecOrder(index->compression) && index->order.empty()) {
+            deserializer.seek(index->orderOffset);
+            index->order = readCodecOrder(deserializer, *scheduler, index->particleCnt);
+        }
+        if (isQuantitySelected(quantities, QuantityId::POSITION)) {
+            Array<Vector> positions =
+                index->loadCompressedValues<Vector>(deserializer, *scheduler, index->positionOffset, from, to);
+            storage.insert<Vector>(QuantityId::POSITION, OrderEnum::SECOND, std::move(positions));
+            storage.getDt<Vector>(QuantityId::POSITION) =
+                index->loadCompressedValues<Vector>(deserializer, *scheduler, index->velocityOffset, from, to);
+        }
+        for (const auto& element : index->scalarOffsets) {
+            if (isQuantitySelected(quantities, element.first)) {
+                Array<Float> values =
+                    index->loadCompressedValues<Float>(deserializer, *scheduler, element.second, from, to);
+                storage.insert<Float>(element.first, OrderEnum::ZERO, std::move(values));
+            }
+        }
+
+        if (index->attractorCnt > 0) {
+            deserializer.seek(index->attractorOffset);
+            for (Size i = 0; i < index->attractorCnt; ++i) {
+                storage.addAttractor(readAttractor(deserializer));
+            }
+        }
+    } catch (const Exception& e) {
+        return makeFailed("Cannot read file '{}'. {}", path.string(), exceptionMessage(e));
+    }
+
+    stats.set(StatisticsId::RUN_TIME, index->runTime);
+    return SUCCESS;
+}
+
+const char* MappedInput::mapBuffer(const Path& path,
+    const QuantityId id,
+    const OrderEnum order,
+    const Size matIdx,
+    const ValueEnum type,
+    const Size valueSize,
+    Size& size) {
+    try {
+        this->open(path);
+    } catch (const Exception& UNUSED(e)) {
+        return nullptr;
+    }
+    const BinaryLayout& layout = index->layout;
+    if (index->compressed || matIdx >= layout.blocks.size() || !hasSameLayout(type) ||
+        getSerializedSize(type) != valueSize) {
+        return nullptr;
+    }
+    for (Size i = 0; i < layout.records.size(); ++i) {
+        const BinaryLayout::QuantityRecord& record = layout.records[i];
+        if (record.id == id && record.type == type && order <= record.order) {
+            const BinaryLayout::BlockRecord& block = layout.blocks[matIdx];
+            size = block.to - block.from;
+            return index->file.data() + block.offsets[i] + std::size_t(order) * size * valueSize;
+        }
+    }
+    return nullptr;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ArchiveOutput
+// ----------------------------------------------------------------------------------------------------------
+
+/// Offset of the frame count in the archive header.
+static const std::size_t ARCHIVE_FRAME_CNT_OFFSET = sizeof("SPHARC") + sizeof(int64_t);
+
+static Path getArchivePath(const Path& mask) {
+    String path = mask.string();
+    for (const String& wildcard : { "_%d"_s, "%d"_s, "_%t"_s, "%t"_s }) {
+        path.replaceAll(wildcard, "");
+    }
+    return Path(path);
+}
+
+/// Index of frames in the archive, used by \ref ArchiveInput to locate the frames and by \ref ArchiveOutput to
+/// continue in an existing archive.
+class ArchiveInput::Index : public Noncopyable {
+public:
+    struct Frame {
+        /// Offset and size of the snapshot data
+        std::size_t offset;
+        std::size_t size;
+
+        /// Offset of the index entry of the frame
+        std::size_t entryOffset;
+
+        /// Layout of the snapshot, with offsets relative to the beginning of the snapshot
+        BinaryLayout layout;
+    };
+
+    Path path;
+    AutoPtr<FileSystem::MappedFile> file;
+    Array<Frame> frames;
+
+    explicit Index(const Path& path)
+        : path(path) {}
+
+    /// Reads index entries of frames appended since the last update.
+    void update() {
+        try {
+            this->read();
+        } catch (const SerializerException&) {
+            // the header might have been read while being updated by the writer, so that the frame count and
+            // the offset of the last entry do not match; try again with the updated header
+            this->read();
+        }
+    }
+
+private:
+    void read() {
+        Size frameCnt;
+        std::size_t lastEntryOffset;
+        {
+            Deserializer<true> deserializer(makeAuto<FileBinaryInputStream>(path));
+            String identifier;
+            ArchiveIoVersion version;
+            deserializer.deserialize(identifier, version, frameCnt, lastEntryOffset);
+            if (identifier != "SPHARC") {
+                throw SerializerException("Invalid format specifier: expected SPHARC, got " + identifier);
+            }
+        }
+        if (frameCnt < frames.size() ||
+            (frameCnt == frames.size() && frameCnt > 0 && lastEntryOffset != frames.back().entryOffset)) {
+            // archive has been overwritten or the frames have been replaced by a resumed run
+            frames.clear();
+        }
+        if (frameCnt == frames.size()) {
+            return;
+        }
+
+        // map the file again, including the new frames
+        file.reset();
+        file = makeAuto<FileSystem::MappedFile>(path);
+        MappedDeserializer<true> deserializer(*file);
+
+        // entries are linked from the last one, read them in reverse order
+        Array<Frame> newFrames(frameCnt - frames.size());
+        std::size_t entryOffset = lastEntryOffset;
+        for (Size i = frameCnt; i-- > frames.size();) {
+            deserializer.seek(entryOffset);
+            String identifier;
+            Size frameIdx;
+            Frame& frame = newFrames[i - frames.size()];
+            frame.entryOffset = entryOffset;
+            deserializer.deserialize(identifier, frameIdx, entryOffset, frame.offset, frame.size);
+            if (identifier != "FRAME" || frameIdx != i || frame.offset + frame.size > file->size()) {
+                throw SerializerException("Invalid index entry of frame " + toString(i));
+            }
+            frame.layout.deserialize(deserializer);
+        }
+        if (!frames.empty() && entryOffset != frames.back().entryOffset) {
+            // the new frames do not follow the indexed ones, some frames have been replaced by a resumed run
+            frames.clear();
+            this->read();
+            return;
+        }
+        frames.pushAll(std::move(newFrames));
+    }
+};
+
+ArchiveOutput::ArchiveOutput(const OutputFile& fileMask, const RunTypeEnum runTypeId)
+    : IOutput(fileMask)
+    , path(getArchivePath(fileMask.getMask()))
+    , runTypeId(runTypeId) {}
+
+Outcome ArchiveOutput::open() {
+    Outcome dirResult = FileSystem::createDirectory(path.parentPath());
+    if (!dirResult) {
+        return makeFailed("Cannot create directory {}: {}", path.parentPath().string(), dirResult.error());
+    }
+
+    if (FileSystem::pathExists(path) && FileSystem::fileSize(path) > 0) {
+        // continue in existing archive
+        try {
+            ArchiveInput::Index index(path);
+            index.update();
+            for (const ArchiveInput::Index::Frame& frame : index.frames) {
+                entries.push(Entry{ frame.layout.runTime, frame.entryOffset });
+            }
+        } catch (const SerializerException& e) {
+            return makeFailed("Cannot read archive '{}'. {}", path.string(), exceptionMessage(e));
+        }
+    } else {
+        Serializer<true> serializer(makeAuto<FileBinaryOutputStream>(path));
+        serializer.serialize("SPHARC", ArchiveIoVersion::LATEST, Size(0), std::size_t(0));
+        serializer.addPadding(HEADER_SIZE - ARCHIVE_FRAME_CNT_OFFSET - 2 * sizeof(int64_t));
+    }
+    opened = true;
+    return SUCCESS;
+}
+
+Expected<Path> ArchiveOutput::dump(const Storage& storage, const Statistics& stats) {
+    VERBOSE_LOG
+
+    if (!opened) {
+        Outcome result = this->open();
+        if (!result) {
+            return makeUnexpected<Path>(result.error());
+        }
+    }
+
+    Array<char> frame;
+    Serializer<true> frameSerializer(makeAuto<MemoryBinaryOutputStream>(frame));
+    BinaryOutput::serialize(frameSerializer, storage, stats, runTypeId);
+
+    BinaryLayout layout;
+    try {
+        MappedDeserializer<true> deserializer(&frame[0], frame.size());
+        String identifier;
+        deserializer.deserialize(identifier);
+        layout.read(deserializer);
+    } catch (const SerializerException& e) {
+        return makeUnexpected<Path>("Cannot index the frame. {}", exceptionMessage(e));
+    }
+
+    // the run might have been resumed from an earlier snapshot; unlink the frames it is going to replace, so
+    // that the frames in the index remain sorted by the run time
+    while (!entries.empty() && entries.back().runTime > layout.runTime) {
+        entries.pop();
+    }
+    const Size frameCnt = entries.size();
+    const std::size_t lastEntryOffset = entries.empty() ? 0 : entries.back().offset;
+
+    std::fstream ofs(path.native(), std::ios::in | std::ios::out | std::ios::binary);
+    ofs.seekp(0, std::ios::end);
+    const std::size_t frameOffset = std::size_t(ofs.tellp());
+    const std::size_t entryOffset = frameOffset + frame.size();
+
+    Array<char> entry;
+    Serializer<true> entrySerializer(makeAuto<MemoryBinaryOutputStream>(entry));
+    entrySerializer.serialize("FRAME", frameCnt, lastEntryOffset, frameOffset, frame.size());
+    layout.serialize(entrySerializer);
+
+    ofs.write(&frame[0], frame.size());
+    ofs.write(&entry[0], entry.size());
+    ofs.flush();
+
+    // publish the frame only after all its data are written
+    Array<char> header;
+    Serializer<true> headerSerializer(makeAuto<MemoryBinaryOutputStream>(header));
+    headerSerializer.serialize(frameCnt + 1, entryOffset);
+    ofs.seekp(ARCHIVE_FRAME_CNT_OFFSET);
+    ofs.write(&header[0], header.size());
+    ofs.flush();
+    if (!ofs) {
+        return makeUnexpected<Path>("Cannot write into archive '{}'", path.string());
+    }
+
+    entries.push(Entry{ layout.runTime, entryOffset });
+    return path;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ArchiveInput
+// ----------------------------------------------------------------------------------------------------------
+
+ArchiveInput::ArchiveInput(Array<QuantityId>&& quantities, const Optional<IndexSequence> particles)
+    : quantities(std::move(quantities))
+    , particles(particles) {}
+
+ArchiveInput::~ArchiveInput() = default;
+
+bool ArchiveInput::isSupported(const Path& path) {
+    return path.extension().string() == "sar";
+}
+
+void ArchiveInput::update(const Path& path) {
+    if (!index || index->path != path) {
+        index = makeAuto<Index>(path);
+    }
+    index->update();
+}
+
+Outcome ArchiveInput::load(const Path& path, Storage& storage, Statistics& stats) {
+    Expected<Size> frameCnt = this->getFrameCnt(path);
+    if (!frameCnt) {
+        return makeFailed(frameCnt.error());
+    }
+    if (frameCnt.value() == 0) {
+        return makeFailed("Archive '{}' contains no frames", path.string());
+    }
+    return this->loadFrame(path, frameCnt.value() - 1, storage, stats);
+}
+
+Outcome ArchiveInput::loadFrame(const Path& path, const Size frameIdx, Storage& storage, Statistics& stats) {
+    try {
+        if (!index || index->path != path || frameIdx >= index->frames.size()) {
+            this->update(path);
+        }
+        if (frameIdx >= index->frames.size()) {
+            return makeFailed("Frame {} not found in archive '{}'", frameIdx, path.string());
+        }
+        const Index::Frame& frame = index->frames[frameIdx];
+        loadBinary(index->file->data() + frame.offset,
+            frame.size,
+            frame.layout,
+            quantities,
+            particles,
+            storage,
+            stats);
+    } catch (const Exception& e) {
+        return makeFailed("Cannot read archive '{}'. {}", path.string(), exceptionMessage(e));
+    }
+    return SUCCESS;
+}
+
+Expected<Size> ArchiveInput::getFrameCnt(const Path& path) {
+    try {
+        this->update(path);
+    } catch (const Exception& e) {
+        return makeUnexpected<Size>("Cannot read archive '{}'. {}", path.string(), exceptionMessage(e));
+    }
+    return index->frames.size();
+}
+
+Expected<ArchiveInput::FrameInfo> ArchiveInput::getFrameInfo(const Path& path, const Size frameIdx) {
+    Expected<Size> frameCnt = this->getFrameCnt(path);
+    if (!frameCnt) {
+        return makeUnexpected<FrameInfo>(frameCnt.error());
+    }
+    if (frameIdx >= frameCnt.value()) {
+        return makeUnexpected<FrameInfo>("Frame {} not found in archive '{}'", frameIdx, path.string());
+    }
+    const BinaryLayout& layout = index->frames[frameIdx].layout;
+    FrameInfo info;
+    info.runTime = layout.runTime;
+    info.particleCnt = layout.particleCnt;
+    return info;
+}
+
+Expected<Size> ArchiveInput::findFrame(const Path& path, const Float time) {
+    Expected<Size> frameCnt = this->getFrameCnt(path);
+    if (!frameCnt) {
+        return frameCnt;
+    }
+    if (frameCnt.value() == 0) {
+        return makeUnexpected<Size>("Archive '{}' contains no frames", path.string());
+    }
+    ArrayView<const Index::Frame> frames = index->frames;
+    auto iter = std::upper_bound(frames.begin(), frames.end(), time, [](const Float t, const Index::Frame& f) {
+        return t < f.layout.runTime;
+    });
+    return iter == frames.begin() ? 0 : Size(iter - frames.begin() - 1);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// VtkOutput
+// ----------------------------------------------------------------------------------------------------------
+
+static void writeDataArray(std::ofstream& of,
+    const Storage& storage,
+    const Statistics& stats,
+    const ITextColumn& column) {
+    switch (column.getType()) {
+    case ValueEnum::SCALAR:
+        of << R"(      <DataArray type="Float32" Name=")" << column.getName().toAscii()
+           << R"(" format="ascii">)";
+        break;
+    case ValueEnum::VECTOR:
+        of << R"(      <DataArray type="Float32" Name=")" << column.getName().toAscii()
+           << R"(" NumberOfComponents="3" format="ascii">)";
+        break;
+    case ValueEnum::INDEX:
+        of << R"(      <DataArray type="Int32" Name=")" << column.getName().toAscii()
+           << R"(" format="ascii">)";
+        break;
+    case ValueEnum::SYMMETRIC_TENSOR:
+        of << R"(      <DataArray type="Float32" Name=")" << column.getName().toAscii()
+           << R"(" NumberOfComponents="6" format="ascii">)";
+        break;
+    case ValueEnum::TRACELESS_TENSOR:
+        of << R"(      <DataArray type="Float32" Name=")" << column.getName().toAscii()
            << R"(" NumberOfComponents="5" format="ascii">)";
         break;
     default:
@@ -1315,62 +2962,121 @@ static Float computeRadius(const Float H, const Float albedo) {
     return 0.5_f * d * 1.e3_f;
 }
 
-static void parseMpcorp(std::ifstream& ifs, Storage& storage, const Float rho, const Float albedo) {
-    std::string line;
-    // skip header
-    while (std::getline(ifs, line)) {
-        if (line.size() >= 5 && line.substr(0, 5) == "-----") {
+/// Returns the range of the next whitespace-separated token in the line.
+static std::pair<const char*, const char*> nextToken(const char* first, const char* last) {
+    while (first < last && std::isspace(*first)) {
+        ++first;
+    }
+    const char* tokenEnd = first;
+    while (tokenEnd < last && !std::isspace(*tokenEnd)) {
+        ++tokenEnd;
+    }
+    return { first, tokenEnd };
+}
+
+struct MpcorpRecord {
+    Vector r;
+    Vector v;
+    Float m;
+    Size flag;
+    bool valid;
+};
+
+static bool parseMpcorpLine(const char* first,
+    const char* last,
+    const Float rho,
+    const Float albedo,
+    MpcorpRecord& record) {
+    // designation, absolute magnitude, slope parameter, epoch
+    const char* tokenEnd = nextToken(first, last).second;
+    double mag;
+    tokenEnd = TextIo::parseFloat(tokenEnd, last, mag);
+    if (!tokenEnd) {
+        return false;
+    }
+    for (Size i = 0; i < 2; ++i) {
+        tokenEnd = nextToken(tokenEnd, last).second;
+    }
+    // orbital elements
+    double elements[7];
+    for (double& element : elements) {
+        tokenEnd = TextIo::parseFloat(tokenEnd, last, element);
+        if (!tokenEnd) {
+            return false;
+        }
+    }
+    const Float M = Float(elements[0]) * DEG_TO_RAD;
+    const Float omega = Float(elements[1]) * DEG_TO_RAD;
+    const Float Omega = Float(elements[2]) * DEG_TO_RAD;
+    const Float I = Float(elements[3]) * DEG_TO_RAD;
+    const Float e = Float(elements[4]);
+    const Float n = Float(elements[5]) * DEG_TO_RAD / Constants::day;
+    const Float a = Float(elements[6]) * Constants::au;
+
+    // skip reference, number of oppositions, etc., up to the flags
+    std::pair<const char*, const char*> flag;
+    for (Size i = 0; i < 10; ++i) {
+        flag = nextToken(tokenEnd, last);
+        tokenEnd = flag.second;
+    }
+
+    const Float E = Kepler::solveKeplersEquation(M, e);
+    const AffineMatrix R_Omega = AffineMatrix::rotateZ(Omega);
+    const AffineMatrix R_I = AffineMatrix::rotateX(I);
+    const AffineMatrix R_omega = AffineMatrix::rotateZ(omega);
+    const AffineMatrix R = R_Omega * R_I * R_omega;
+
+    record.r = a * R * Vector(cos(E) - e, sqrt(1 - sqr(e)) * sin(E), 0);
+    SPH_ASSERT(isReal(record.r), record.r);
+    record.v = a * R * n / (1 - e * cos(E)) * Vector(-sin(E), sqrt(1 - sqr(e)) * cos(E), 0);
+    SPH_ASSERT(isReal(record.v), record.v);
+    record.r[H] = computeRadius(Float(mag), albedo);
+    record.v[H] = 0._f;
+    record.m = sphereVolume(record.r[H]) * rho;
+
+    if (flag.first < flag.second && std::isdigit(flag.second[-1])) {
+        record.flag = flag.second[-1] - '0';
+    } else {
+        record.flag = 0;
+    }
+    return true;
+}
+
+static void parseMpcorp(IScheduler& scheduler,
+    const FileSystem::MappedFile& file,
+    Storage& storage,
+    const Float rho,
+    const Float albedo) {
+    // skip header, terminated by a line of dashes
+    const char* end = file.data() + file.size();
+    const char* begin = end;
+    for (const char* line = file.data(); line < end;) {
+        const void* newline = std::memchr(line, '\n', std::size_t(end - line));
+        const char* lineEnd = newline ? static_cast<const char*>(newline) : end;
+        const char* next = min(lineEnd + 1, end);
+        if (lineEnd - line >= 5 && std::strncmp(line, "-----", 5) == 0) {
+            begin = next;
             break;
         }
+        line = next;
     }
 
-    std::string dummy;
+    const TextIo::LineIndex lines(scheduler, ArrayView<const char>(begin, Size(end - begin)));
+    Array<MpcorpRecord> records(lines.size());
+    lines.forEach(scheduler, [&records, rho, albedo](const Size lineIdx, const char* first, const char* last) {
+        records[lineIdx].valid = parseMpcorpLine(first, last, rho, albedo, records[lineIdx]);
+        return true;
+    });
+
     Array<Vector> positions, velocities;
     Array<Float> masses;
     Array<Size> flags;
-    while (std::getline(ifs, line)) {
-        if (line.empty()) {
-            continue;
-        }
-        std::stringstream ss(line);
-        Float mag;
-        ss >> dummy >> mag >> dummy >> dummy;
-        if (!ss.good()) {
-            continue;
-        }
-        Float M, omega, Omega, I, e, n, a;
-        ss >> M >> omega >> Omega >> I >> e >> n >> a;
-        M *= DEG_TO_RAD;
-        omega *= DEG_TO_RAD;
-        Omega *= DEG_TO_RAD;
-        I *= DEG_TO_RAD;
-        a *= Constants::au;
-        n *= DEG_TO_RAD / Constants::day;
-        std::string flag;
-        ss >> dummy >> dummy >> dummy >> dummy >> dummy >> dummy >> dummy >> dummy >> dummy >> flag;
-
-        const Float E = Kepler::solveKeplersEquation(M, e);
-        const AffineMatrix R_Omega = AffineMatrix::rotateZ(Omega);
-        const AffineMatrix R_I = AffineMatrix::rotateX(I);
-        const AffineMatrix R_omega = AffineMatrix::rotateZ(omega);
-        const AffineMatrix R = R_Omega * R_I * R_omega;
-
-        Vector r = a * R * Vector(cos(E) - e, sqrt(1 - sqr(e)) * sin(E), 0);
-        SPH_ASSERT(isReal(r), r);
-        Vector v = a * R * n / (1 - e * cos(E)) * Vector(-sin(E), sqrt(1 - sqr(e)) * cos(E), 0);
-        SPH_ASSERT(isReal(v), v);
-        r[H] = computeRadius(mag, albedo);
-        v[H] = 0._f;
-        positions.push(r);
-        velocities.push(v);
-
-        const Float m = sphereVolume(r[H]) * rho;
-        masses.push(m);
-
-        if (std::isdigit(flag.back())) {
-            flags.push(flag.back() - '0');
-        } else {
-            flags.push(0);
+    for (const MpcorpRecord& record : records) {
+        if (record.valid) {
+            positions.push(record.r);
+            velocities.push(record.v);
+            masses.push(record.m);
+            flags.push(record.flag);
         }
     }
 
@@ -1382,11 +3088,11 @@ static void parseMpcorp(std::ifstream& ifs, Storage& storage, const Float rho, c
 
 Outcome MpcorpInput::load(const Path& path, Storage& storage, Statistics& UNUSED(stats)) {
     try {
-        std::ifstream ifs(path.native());
-        if (!ifs) {
+        if (!FileSystem::pathExists(path)) {
             return makeFailed("Failed to open file '{}'", path.string());
         }
-        parseMpcorp(ifs, storage, rho, albedo);
+        FileSystem::MappedFile file(path);
+        parseMpcorp(*scheduler, file, storage, rho, albedo);
         return SUCCESS;
     } catch (const std::exception& e) {
         return makeFailed("Cannot load file '{}'\n{}", path.string(), exceptionMessage(e));
@@ -1398,9 +3104,12 @@ Outcome MpcorpInput::load(const Path& path, Storage& storage, Statistics& UNUSED
 // PkdgravOutput/Input
 // ----------------------------------------------------------------------------------------------------------
 
-PkdgravOutput::PkdgravOutput(const OutputFile& fileMask, PkdgravParams&& params)
+PkdgravOutput::PkdgravOutput(const OutputFile& fileMask,
+    PkdgravParams&& params,
+    SharedPtr<IScheduler> scheduler)
     : IOutput(fileMask)
-    , params(std::move(params)) {
+    , params(std::move(params))
+    , scheduler(scheduler) {
     SPH_ASSERT(almostEqual(this->params.conversion.velocity, 2.97853e4_f, 1.e-4_f));
 }
 
@@ -1415,31 +3124,39 @@ Expected<Path> PkdgravOutput::dump(const Storage& storage, const Statistics& sta
     ArrayView<const Size> flags = storage.getValue<Size>(QuantityId::FLAG);
 
     std::ofstream ofs(fileName.native());
-    ofs << std::setprecision(PRECISION) << std::scientific;
 
-    Size idx = 0;
+    // vaporized particles are skipped
+    Size particleCnt = 0;
     for (Size i = 0; i < r.size(); ++i) {
-        if (u[i] > params.vaporThreshold) {
-            continue;
+        particleCnt += (u[i] <= params.vaporThreshold);
+    }
+
+    constexpr Size WIDTH = 25;
+    constexpr Size COMPONENT_WIDTH = 20;
+    auto appendVector = [](Array<char>& buffer, const Vector& v) {
+        for (Size i = 0; i < 3; ++i) {
+            TextIo::appendFloat(buffer, v[i], COMPONENT_WIDTH, true);
         }
+    };
+    TextIo::writeLines(*scheduler, ofs, particleCnt, [&](const Size idx, Array<char>& buffer) {
         const Float radius = this->getRadius(r[idx][H], m[idx], rho[idx]);
         const Vector v_in = v[idx] + cross(params.omega, r[idx]);
         SPH_ASSERT(flags[idx] < params.colors.size(), flags[idx], params.colors.size());
-        ofs << std::setw(25) << idx <<                                   //
-            std::setw(25) << idx <<                                      //
-            std::setw(25) << m[idx] / params.conversion.mass <<          //
-            std::setw(25) << radius / params.conversion.distance <<      //
-            std::setw(25) << r[idx] / params.conversion.distance <<      //
-            std::setw(25) << v_in / params.conversion.velocity <<        //
-            std::setw(25) << Vector(0._f) /* zero initial rotation */ << //
-            std::setw(25) << params.colors[flags[idx]] << std::endl;
-        idx++;
-    }
+        TextIo::appendIndex(buffer, idx, WIDTH);
+        TextIo::appendIndex(buffer, idx, WIDTH);
+        TextIo::appendFloat(buffer, m[idx] / params.conversion.mass, WIDTH, true);
+        TextIo::appendFloat(buffer, radius / params.conversion.distance, WIDTH, true);
+        appendVector(buffer, r[idx] / params.conversion.distance);
+        appendVector(buffer, v_in / params.conversion.velocity);
+        appendVector(buffer, Vector(0._f)); // zero initial rotation
+        TextIo::appendIndex(buffer, params.colors[flags[idx]], WIDTH);
+        buffer.push('\n');
+    });
     return fileName;
 }
 
 Outcome PkdgravInput::load(const Path& path, Storage& storage, Statistics& stats) {
-    TextInput input(EMPTY_FLAGS);
+    TextInput input(EMPTY_FLAGS, scheduler);
 
     // 1) Particle index -- we don't really need that, just add dummy columnm
     class DummyColumn : public ITextColumn {
@@ -1538,9 +3255,9 @@ Outcome PkdgravInput::load(const Path& path, Storage& storage, Statistics& stats
 // TabInput
 // ----------------------------------------------------------------------------------------------------------
 
-TabInput::TabInput() {
+TabInput::TabInput(SharedPtr<IScheduler> scheduler) {
     input = makeAuto<TextInput>(
-        OutputQuantityFlag::MASS | OutputQuantityFlag::POSITION | OutputQuantityFlag::VELOCITY);
+        OutputQuantityFlag::MASS | OutputQuantityFlag::POSITION | OutputQuantityFlag::VELOCITY, scheduler);
 }
 
 TabInput::~TabInput() = default;
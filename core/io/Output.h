@@ -11,9 +11,14 @@
 #include "objects/wrappers/Outcome.h"
 #include "physics/Constants.h"
 #include "quantities/Storage.h"
+#include "system/Settings.h"
+#include "thread/Scheduler.h"
 
 NAMESPACE_SPH_BEGIN
 
+template <bool Precise>
+class Serializer;
+
 /// \brief Helper file generating file names for output files.
 ///
 /// This class only operates with paths and path masks. It does not perform any I/O operations to check for
@@ -86,6 +91,23 @@ public:
     /// Returns the filename of the dump, generated from file mask given in constructor, or an error message
     /// in case writing the output file failed.
     virtual Expected<Path> dump(const Storage& storage, const Statistics& stats) = 0;
+
+    /// \brief Blocks until all data passed to \ref dump are written.
+    ///
+    /// Only needed by outputs writing the files asynchronously, other outputs write the file before \ref dump
+    /// returns.
+    /// \return Error message if writing of some files failed.
+    virtual Outcome flush() {
+        return SUCCESS;
+    }
+
+    /// \brief Returns the path of the file written by \ref dump, given the path generated from the file mask.
+    ///
+    /// Needed by outputs that do not write the file immediately. Outputs writing a different file than the
+    /// one given by the file mask have to override the function. Must be thread-safe.
+    virtual Path getDumpPath(const Path& nextPath) const {
+        return nextPath;
+    }
 };
 
 /// \brief Interface for loading quantities of SPH particles from a file.
@@ -168,6 +190,9 @@ private:
     /// Value columns saved into the file
     Array<AutoPtr<ITextColumn>> columns;
 
+    /// Scheduler used to format the values
+    SharedPtr<IScheduler> scheduler;
+
 public:
     /// \brief Creates a new text file output.
     ///
@@ -177,10 +202,12 @@ public:
     /// \param quantities List of quantities to store. Note that arbitrary quantities can be later added using
     ///                   \ref addColumn.
     /// \param options Parameters of the file, see \ref Options enum.
+    /// \param scheduler Scheduler used to format the values; lines are formatted in parallel by blocks.
     TextOutput(const OutputFile& fileMask,
         const String& runName,
         Flags<OutputQuantityFlag> quantities,
-        Flags<Options> options = EMPTY_FLAGS);
+        Flags<Options> options = EMPTY_FLAGS,
+        SharedPtr<IScheduler> scheduler = SequentialScheduler::getGlobalInstance());
 
     ~TextOutput();
 
@@ -199,12 +226,19 @@ public:
 ///
 /// Note that this loader cannot be used to resume a simulation (at least not directly), as the text file does
 /// not contains all the necessary data.
+///
+/// The file is mapped into memory and split into chunks of lines, which are parsed in parallel. Lines
+/// starting with '#' and empty lines are skipped.
 class TextInput : public IInput {
 private:
     Array<AutoPtr<ITextColumn>> columns;
 
+    /// Scheduler used to parse the file
+    SharedPtr<IScheduler> scheduler;
+
 public:
-    explicit TextInput(Flags<OutputQuantityFlag> quantities);
+    explicit TextInput(Flags<OutputQuantityFlag> quantities,
+        SharedPtr<IScheduler> scheduler = SequentialScheduler::getGlobalInstance());
 
     TextInput& addColumn(AutoPtr<ITextColumn>&& column);
 
@@ -243,7 +277,8 @@ enum class BinaryIoVersion : int64_t {
     V2018_10_24 = 20181024, ///< reverted enum (storing zero instead of hash), storing type of simulation
     V2021_03_20 = 20210320, ///< added wallclock time and build date
     V2021_08_08 = 20210808, ///< added attractors
-    LATEST = V2021_08_08,
+    V2026_10_16 = 20261016, ///< added delta checkpoints
+    LATEST = V2026_10_16,
 };
 
 /// \brief Output saving data to binary data without loss of precision.
@@ -315,6 +350,22 @@ enum class BinaryIoVersion : int64_t {
 ///
 /// The file ends immediately after the last attractor is saved.
 ///
+/// \subsection Delta checkpoints
+/// If the output is created with checkpoint period larger than one, only every n-th dump is written in the
+/// format described above (full dump). The dumps in between are delta checkpoints, storing only the parts of
+/// the data that changed since the previous dump. The data of the dump (in the format of the full dump) are
+/// split into blocks of fixed size and the hashes of the blocks are compared with the hashes of the previous
+/// dump. The delta checkpoint consists of:
+///  - file format identifier "SPHDLT" (including terminating zero)
+///  - version of the file format [Size]
+///  - file name of the previous dump in the same directory [string with terminating zero]
+///  - size of the blocks [Size]
+///  - for every changed block: index of the block [Size], number of bytes in the block [Size] and the bytes
+///  - index -1 [Size] terminating the list, followed by the total size of the data [Size].
+/// The data are reconstructed by applying the changed blocks to the reconstructed data of the previous dump,
+/// so the whole chain up to the last full dump must be kept. Delta checkpoints can be loaded by
+/// \ref BinaryInput, but not by \ref MappedInput or \ref ArchiveInput.
+///
 /// \todo Possible todos & fixes:
 ///  - arbitrary precision: store doubles as floats or halfs and size_t as uint32 or uint16, based on data in
 ///    header
@@ -323,21 +374,53 @@ enum class BinaryIoVersion : int64_t {
 ///    the settings it holds. This should be enforced somehow.
 class BinaryOutput : public IOutput {
     friend class BinaryInput;
+    friend class ArchiveOutput;
 
 private:
-    static constexpr Size PADDING_SIZE = 156;
-
     RunTypeEnum runTypeId;
 
+    /// Number of dumps between two full dumps.
+    Size checkpointPeriod;
+
+    /// Number of dumps written so far.
+    Size dumpCnt = 0;
+
+    struct BlockHash {
+        uint64_t h1, h2;
+    };
+
+    class CheckpointStream;
+
+    /// Hashes of data blocks of the previous dump; empty if the previous dump has not been written.
+    Array<BlockHash> blockHashes;
+
+    /// Path of the previous dump.
+    Path lastPath;
+
 public:
-    explicit BinaryOutput(const OutputFile& fileMask, const RunTypeEnum runTypeId = RunTypeEnum::SPH);
+    static constexpr Size PADDING_SIZE = 156;
+
+    /// \brief Creates the output.
+    ///
+    /// \param checkpointPeriod Number of dumps between two full dumps; dumps in between are written as delta
+    ///                         checkpoints. If one, all dumps are full.
+    explicit BinaryOutput(const OutputFile& fileMask,
+        const RunTypeEnum runTypeId = RunTypeEnum::SPH,
+        const Size checkpointPeriod = 1);
 
     virtual Expected<Path> dump(const Storage& storage, const Statistics& stats) override;
+
+private:
+    static void serialize(Serializer<true>& serializer,
+        const Storage& storage,
+        const Statistics& stats,
+        const RunTypeEnum runTypeId);
 };
 
 /// \brief Input for the binary file, generated by \ref BinaryOutput.
 ///
-/// Storage loaded by this class can be used to continue a simulation.
+/// Storage loaded by this class can be used to continue a simulation. Delta checkpoints are reconstructed
+/// from the chain of the previous dumps; the result is identical to the full dump of the same data.
 class BinaryInput : public IInput {
 public:
     virtual Outcome load(const Path& path, Storage& storage, Statistics& stats) override;
@@ -400,29 +483,87 @@ public:
 enum class CompressedIoVersion : int {
     FIRST = 0,
     V2021_08_08 = 20210808, ///< added attractors
-    LATEST = V2021_08_08,
+    V2026_10_16 = 20261016, ///< added error bounds of quantized quantities
+    LATEST = V2026_10_16,
 };
 
-enum class CompressionEnum {
-    NONE,
-    RLE,
+/// \brief Absolute error bounds of quantities stored with \ref CompressionEnum::QUANTIZED.
+///
+/// Zero bound means that the quantity is stored without quantization.
+struct ErrorBounds {
+    /// Maximal error of particle positions; smoothing lengths are never quantized
+    Float position = 0._f;
+
+    /// Maximal error of particle velocities
+    Float velocity = 0._f;
+
+    /// Maximal error of density
+    Float density = 0._f;
+
+    /// Maximal error of specific internal energy
+    Float energy = 0._f;
+
+    /// Maximal error of damage
+    Float damage = 0._f;
+};
+
+/// \brief Parameters of \ref CompressionEnum::QUANTIZED.
+struct QuantizationParams {
+    struct Bound {
+        /// Maximal error of the quantity; zero means the quantity is not quantized
+        Float value;
+
+        /// If true, the error is relative to the range of values in the saved snapshot (size of the bounding
+        /// box for positions), otherwise it is an absolute error.
+        bool relative;
+    };
+
+    Bound position{ 1.e-4_f, true };
+
+    Bound velocity{ 1.e-3_f, true };
+
+    Bound density{ 1.e-3_f, true };
+
+    Bound energy{ 1.e-3_f, true };
+
+    Bound damage{ 1.e-3_f, false };
 };
 
+/// \brief Output saving only selected quantities, optionally compressed.
+///
+/// With \ref CompressionEnum::XOR_SHUFFLE and \ref CompressionEnum::QUANTIZED, quantities are split into
+/// blocks which are compressed in parallel using given scheduler.
 class CompressedOutput : public IOutput {
 private:
     CompressionEnum compression;
     RunTypeEnum runTypeId;
+    SharedPtr<IScheduler> scheduler;
+    QuantizationParams quantization;
 
 public:
+    /// \brief Creates the output.
+    ///
+    /// \param quantization Error bounds of quantities, only used by \ref CompressionEnum::QUANTIZED.
     explicit CompressedOutput(const OutputFile& fileMask,
         const CompressionEnum compression,
-        const RunTypeEnum runTypeId = RunTypeEnum::SPH);
+        const RunTypeEnum runTypeId = RunTypeEnum::SPH,
+        SharedPtr<IScheduler> scheduler = SequentialScheduler::getGlobalInstance(),
+        const QuantizationParams& quantization = QuantizationParams());
 
     virtual Expected<Path> dump(const Storage& storage, const Statistics& stats) override;
 };
 
 class CompressedInput : public IInput {
+private:
+    SharedPtr<IScheduler> scheduler;
+
 public:
+    /// \brief Creates the input.
+    ///
+    /// \param scheduler Scheduler used to decompress data compressed by \ref CompressionEnum::XOR_SHUFFLE
+    ///                  and \ref CompressionEnum::QUANTIZED.
+    explicit CompressedInput(SharedPtr<IScheduler> scheduler = SequentialScheduler::getGlobalInstance());
+
     virtual Outcome load(const Path& path, Storage& storage, Statistics& stats) override;
 
     struct Info {
@@ -440,11 +581,241 @@ public:
 
         /// Format version of the file
         CompressedIoVersion version;
+
+        /// Compression of the quantities
+        CompressionEnum compression;
+
+        /// Absolute error bounds of quantities; all zero unless the file is compressed with
+        /// \ref CompressionEnum::QUANTIZED.
+        ErrorBounds errorBounds;
     };
 
     static Expected<Info> getInfo(const Path& path);
 };
 
+/// \brief Input loading only selected quantities and particles from .ssf and .sdf/.scf files.
+///
+/// The file is mapped into memory and the offsets of all quantity buffers are indexed when the file is
+/// loaded for the first time. Subsequent loads of the same file, possibly with different selection, reuse
+/// the index, unless the file has been modified since. Only buffers of the requested quantities and particles
+/// are then read; buffers of binary files stored with the same memory layout as in \ref Storage are copied as
+/// a whole or accessed directly with \ref map, without copying.
+///
+/// Without selection, the loaded storage is the same as the one loaded by \ref BinaryInput or
+/// \ref CompressedInput.
+class MappedInput : public IInput {
+private:
+    class Index;
+
+    /// Quantities to load; if empty, all quantities are loaded.
+    Array<QuantityId> quantities;
+
+    /// Particles to load; if NOTHING, all particles are loaded.
+    Optional<IndexSequence> particles;
+
+    /// Scheduler used to decompress data.
+    SharedPtr<IScheduler> scheduler;
+
+    /// Index of the last loaded file.
+    AutoPtr<Index> index;
+
+public:
+    /// \brief Creates the input.
+    ///
+    /// \param quantities Quantities to load. Quantities not present in the file are ignored. If empty, all
+    ///                   quantities are loaded.
+    /// \param particles Range of particle indices to load. If NOTHING, all particles are loaded.
+    /// \param scheduler Scheduler used to decompress data of compressed files.
+    explicit MappedInput(Array<QuantityId>&& quantities = {},
+        const Optional<IndexSequence> particles = NOTHING,
+        SharedPtr<IScheduler> scheduler = SequentialScheduler::getGlobalInstance());
+
+    ~MappedInput();
+
+    /// \brief Changes the quantities and particles loaded by subsequent calls of \ref load.
+    ///
+    /// The index of the last loaded file is kept.
+    void select(Array<QuantityId>&& quantities, const Optional<IndexSequence> particles = NOTHING);
+
+    virtual Outcome load(const Path& path, Storage& storage, Statistics& stats) override;
+
+    /// \brief Returns the buffer of a quantity stored in a binary file, without copying.
+    ///
+    /// The buffer can be only mapped if it is stored with the same memory layout as in \ref Storage and
+    /// properly aligned, which currently holds for scalar and vector quantities of double-precision builds.
+    /// The returned view is valid until another file is mapped or loaded by this object.
+    /// \param path Path to the .ssf file.
+    /// \param id Quantity to map.
+    /// \param order Derivative to map, zero corresponds to quantity values.
+    /// \param matIdx Index of the material; particles of each material are stored separately.
+    /// \return Mapped buffer or NOTHING if the buffer cannot be mapped.
+    template <typename T>
+    Optional<ArrayView<const T>> map(const Path& path,
+        const QuantityId id,
+        const OrderEnum order,
+        const Size matIdx = 0) {
+        Size size;
+        const char* data = this->mapBuffer(path, id, order, matIdx, GetValueEnum<T>::type, sizeof(T), size);
+        if (!data || reinterpret_cast<std::uintptr_t>(data) % alignof(T) != 0) {
+            return NOTHING;
+        }
+        return ArrayView<const T>(reinterpret_cast<const T*>(data), size);
+    }
+
+    /// \brief Returns true if the file can be loaded by \ref MappedInput, based on its extension.
+    static bool isSupported(const Path& path);
+
+private:
+    void open(const Path& path);
+
+    const char* mapBuffer(const Path& path,
+        const QuantityId id,
+        const OrderEnum order,
+        const Size matIdx,
+        const ValueEnum type,
+        const Size valueSize,
+        Size& size);
+};
+
+enum class ArchiveIoVersion : int64_t {
+    FIRST = 0,
+    LATEST = FIRST,
+};
+
+/// \brief Output appending all snapshots of the run into a single archive file.
+///
+/// Each snapshot (frame) is stored in the same format as written by \ref BinaryOutput, so the archive
+/// can be used to continue the simulation from any frame. The archive is append-only; frames are never
+/// modified once written.
+///
+/// \subsection Format specification
+/// The file starts with a header of 64 bytes, containing:
+///  - file format identifier "SPHARC" (including terminating zero)
+///  - format version [Size]
+///  - number of frames [Size]
+///  - offset of the index entry of the last frame [Size]
+///  - zero padding
+///
+/// Each frame is followed by its index entry, containing:
+///  - identifier "FRAME" (including terminating zero)
+///  - index of the frame [Size]
+///  - offset of the index entry of the previous frame [Size]
+///  - offset and size of the snapshot data [Size]
+///  - run time, time step and particle count of the snapshot
+///  - quantity info and offsets of all quantity buffers in the snapshot, for each material
+///
+/// The header is updated only after the frame and its index entry are written and flushed, so the archive can
+/// be read by \ref ArchiveInput while the run is still appending new frames.
+///
+/// When a run is resumed from an earlier snapshot, frames with run time larger than the run time of the
+/// dumped frame are unlinked from the index. Their data remain in the file, but the frames listed in the
+/// index are always sorted by the run time.
+class ArchiveOutput : public IOutput {
+private:
+    static constexpr Size HEADER_SIZE = 64;
+
+    Path path;
+    RunTypeEnum runTypeId;
+
+    struct Entry {
+        /// Run time of the frame
+        Float runTime;
+
+        /// Offset of the index entry of the frame
+        std::size_t offset;
+    };
+
+    /// Index entries of frames written into the archive, including frames written by previous runs.
+    Array<Entry> entries;
+
+    /// True if the archive has been already opened.
+    bool opened = false;
+
+public:
+    /// \brief Creates the output.
+    ///
+    /// All frames are written into a single file, so any wildcards in the file mask are removed. If the file
+    /// already exists, new frames are appended to it, allowing to continue in the archive after the run is
+    /// resumed. Frames newer than the first dumped frame are then unlinked from the index.
+    explicit ArchiveOutput(const OutputFile& fileMask, const RunTypeEnum runTypeId = RunTypeEnum::SPH);
+
+    virtual Expected<Path> dump(const Storage& storage, const Statistics& stats) override;
+
+    virtual Path getDumpPath(const Path& UNUSED(nextPath)) const override {
+        return path;
+    }
+
+private:
+    Outcome open();
+
+    friend class ArchiveInput;
+};
+
+/// \brief Input for the archive file, generated by \ref ArchiveOutput.
+///
+/// The index of frames is read when the archive is loaded for the first time; subsequent loads only read
+/// index entries of frames appended since then, so the archive can be monitored while the run is writing
+/// it. Any frame can be then loaded without reading the previous frames. Similarly to \ref MappedInput, it is
+/// possible to load only selected quantities and particles.
+class ArchiveInput : public IInput {
+public:
+    struct FrameInfo {
+        /// Run time of the frame
+        Float runTime;
+
+        /// Number of particles in the frame
+        Size particleCnt;
+    };
+
+private:
+    class Index;
+
+    friend class ArchiveOutput;
+
+    /// Quantities to load; if empty, all quantities are loaded.
+    Array<QuantityId> quantities;
+
+    /// Particles to load; if NOTHING, all particles are loaded.
+    Optional<IndexSequence> particles;
+
+    /// Index of the last loaded archive.
+    AutoPtr<Index> index;
+
+public:
+    /// \brief Creates the input.
+    ///
+    /// \param quantities Quantities to load. Quantities not present in the file are ignored. If empty, all
+    ///                   quantities are loaded.
+    /// \param particles Range of particle indices to load. If NOTHING, all particles are loaded.
+    explicit ArchiveInput(Array<QuantityId>&& quantities = {},
+        const Optional<IndexSequence> particles = NOTHING);
+
+    ~ArchiveInput();
+
+    /// \brief Loads the last frame of the archive.
+    virtual Outcome load(const Path& path, Storage& storage, Statistics& stats) override;
+
+    /// \brief Loads the frame with given index.
+    Outcome loadFrame(const Path& path, const Size frameIdx, Storage& storage, Statistics& stats);
+
+    /// \brief Returns the current number of frames in the archive.
+    Expected<Size> getFrameCnt(const Path& path);
+
+    /// \brief Returns the run time and the particle count of given frame.
+    Expected<FrameInfo> getFrameInfo(const Path& path, const Size frameIdx);
+
+    /// \brief Returns the index of the last frame with run time not larger than given time.
+    ///
+    /// If all frames have larger run time, the first frame is returned.
+    Expected<Size> findFrame(const Path& path, const Float time);
+
+    /// \brief Returns true if the file is an archive, based on its extension.
+    static bool isSupported(const Path& path);
+
+private:
+    void update(const Path& path);
+};
+
 /// \brief XML-based output format used by Visualization ToolKit (VTK)
 ///
 /// See https://www.vtk.org/VTK/img/file-formats.pdf
@@ -475,11 +846,15 @@ class MpcorpInput : public IInput {
 private:
     Float rho;
     Float albedo;
+    SharedPtr<IScheduler> scheduler;
 
 public:
-    explicit MpcorpInput(const Float rho = 2700._f, const Float albedo = 0.2_f)
+    explicit MpcorpInput(const Float rho = 2700._f,
+        const Float albedo = 0.2_f,
+        SharedPtr<IScheduler> scheduler = SequentialScheduler::getGlobalInstance())
         : rho(rho)
-        , albedo(albedo) {}
+        , albedo(albedo)
+        , scheduler(scheduler) {}
 
     virtual Outcome load(const Path& path, Storage& storage, Statistics& stats) override;
 };
@@ -532,8 +907,13 @@ private:
     /// Parameters of the SPH->pkdgrav conversion
     PkdgravParams params;
 
+    /// Scheduler used to format the values
+    SharedPtr<IScheduler> scheduler;
+
 public:
-    PkdgravOutput(const OutputFile& fileMask, PkdgravParams&& params);
+    PkdgravOutput(const OutputFile& fileMask,
+        PkdgravParams&& params,
+        SharedPtr<IScheduler> scheduler = SequentialScheduler::getGlobalInstance());
 
     virtual Expected<Path> dump(const Storage& storage, const Statistics& stats) override;
 
@@ -556,7 +936,13 @@ private:
 /// Mainly indended for analysis of the result, creating histograms, etc. Cannot be used to continue a
 /// simulation.
 class PkdgravInput : public IInput {
+private:
+    SharedPtr<IScheduler> scheduler;
+
 public:
+    explicit PkdgravInput(SharedPtr<IScheduler> scheduler = SequentialScheduler::getGlobalInstance())
+        : scheduler(scheduler) {}
+
     virtual Outcome load(const Path& path, Storage& storage, Statistics& stats) override;
 };
 
@@ -569,7 +955,7 @@ private:
     AutoPtr<TextInput> input;
 
 public:
-    TabInput();
+    explicit TabInput(SharedPtr<IScheduler> scheduler = SequentialScheduler::getGlobalInstance());
 
     ~TabInput();
 
@@ -585,6 +971,10 @@ public:
     virtual Expected<Path> dump(const Storage& UNUSED(storage), const Statistics& UNUSED(stats)) override {
         return Path();
     }
+
+    virtual Path getDumpPath(const Path& UNUSED(nextPath)) const override {
+        return Path();
+    }
 };
 
 
@@ -106,6 +106,11 @@ public:
         return this->serialize(s);
     }
 
+    /// Writes raw bytes into the stream.
+    void writeBytes(ArrayView<const char> bytes) {
+        stream->write(bytes);
+    }
+
     View addPadding(const Size size) {
         buffer.resize(size);
         buffer.fill('\0');
@@ -210,6 +215,13 @@ public:
         this->deserialize(s);
     }
 
+    /// Reads raw bytes from the stream, filling the whole given buffer.
+    void readBytes(ArrayView<char> bytes) {
+        if (!stream->read(bytes)) {
+            this->fail("Failed to read {} bytes from the stream", bytes.size());
+        }
+    }
+
     /// Skip a number of bytes in the stream; used to skip unused parameters or padding bytes.
     void skip(const Size size) {
         if (!stream->skip(size)) {
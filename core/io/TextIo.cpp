@@ -0,0 +1,813 @@
+#include "io/TextIo.h"
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#ifdef SPH_WIN
+#include <locale.h>
+#elif defined(__APPLE__)
+#include <xlocale.h>
+#else
+#include <locale.h>
+#endif
+
+NAMESPACE_SPH_BEGIN
+
+namespace {
+
+// ----------------------------------------------------------------------------------------------------------
+// Locale-independent conversions
+// ----------------------------------------------------------------------------------------------------------
+
+/// Conversions using "C" locale, regardless of the global (or thread) locale set by the application.
+#ifdef SPH_WIN
+
+_locale_t getCLocale() {
+    static _locale_t locale = _create_locale(LC_NUMERIC, "C");
+    return locale;
+}
+
+double toDouble(const char* str, char** end) {
+    return _strtod_l(str, end, getCLocale());
+}
+
+int printScientific(char* buffer, const Size size, const int precision, const double value) {
+    return _snprintf_s_l(buffer, size, _TRUNCATE, "%.*e", getCLocale(), precision, value);
+}
+
+#else
+
+locale_t getCLocale() {
+    static locale_t locale = newlocale(LC_NUMERIC_MASK, "C", locale_t(0));
+    return locale;
+}
+
+/// Switches the locale of the calling thread to "C" for the lifetime of the object.
+class CLocaleGuard : public Noncopyable {
+private:
+    locale_t previous;
+
+public:
+    CLocaleGuard() {
+        previous = uselocale(getCLocale());
+    }
+
+    ~CLocaleGuard() {
+        uselocale(previous);
+    }
+};
+
+double toDouble(const char* str, char** end) {
+    return strtod_l(str, end, getCLocale());
+}
+
+int printScientific(char* buffer, const Size size, const int precision, const double value) {
+    CLocaleGuard guard;
+    return std::snprintf(buffer, size, "%.*e", precision, value);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------------------------------------
+// Parsing
+// ----------------------------------------------------------------------------------------------------------
+
+INLINE bool isDigit(const char c) {
+    return c >= '0' && c <= '9';
+}
+
+INLINE const char* skipSpaces(const char* first, const char* last) {
+    while (first < last && (*first == ' ' || *first == '\t')) {
+        ++first;
+    }
+    return first;
+}
+
+bool matchesIgnoreCase(const char* first, const char* last, const char* word) {
+    for (; *word; ++word, ++first) {
+        if (first == last || (*first | 0x20) != *word) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Parses the number using strtod; used for values that cannot be converted exactly by the fast path.
+const char* parseFloatSlow(const char* first, const char* last, double& value) {
+    char buffer[128];
+    const std::size_t length = std::size_t(last - first);
+    if (length >= sizeof(buffer)) {
+        // ridiculously long number, probably a lot of trailing zeros; use a dynamic buffer
+        std::string str(first, last);
+        value = toDouble(str.c_str(), nullptr);
+        return last;
+    }
+    std::memcpy(buffer, first, length);
+    buffer[length] = '\0';
+    value = toDouble(buffer, nullptr);
+    return last;
+}
+
+constexpr double INFINITE = std::numeric_limits<double>::infinity();
+
+// Special values and the sign are classified using the bit pattern, as functions like std::isnan or
+// std::signbit may be folded into constants when the code is compiled with -ffast-math.
+constexpr uint64_t SIGN_BIT = uint64_t(1) << 63;
+constexpr uint64_t EXPONENT_BITS = uint64_t(0x7FF) << 52;
+
+uint64_t getBits(const double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double fromBits(const uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool isNegative(const double value) {
+    return (getBits(value) & SIGN_BIT) != 0;
+}
+
+bool isFinite(const double value) {
+    return (getBits(value) & EXPONENT_BITS) != EXPONENT_BITS;
+}
+
+bool isNan(const double value) {
+    return (getBits(value) & ~SIGN_BIT) > EXPONENT_BITS;
+}
+
+/// Flips the sign of the value, including zeros, infinities and NaNs.
+double negate(const double value) {
+    return fromBits(getBits(value) ^ SIGN_BIT);
+}
+
+constexpr double EXACT_POWERS_OF_10[] = { 1.e0,
+    1.e1,
+    1.e2,
+    1.e3,
+    1.e4,
+    1.e5,
+    1.e6,
+    1.e7,
+    1.e8,
+    1.e9,
+    1.e10,
+    1.e11,
+    1.e12,
+    1.e13,
+    1.e14,
+    1.e15,
+    1.e16,
+    1.e17,
+    1.e18,
+    1.e19,
+    1.e20,
+    1.e21,
+    1.e22 };
+
+// ----------------------------------------------------------------------------------------------------------
+// Formatting
+// ----------------------------------------------------------------------------------------------------------
+
+/// Decimal digits and exponent of a floating-point value, value = 0.d1d2d3... * 10^(exponent + 1)
+struct Decimal {
+    char digits[20];
+    int digitCnt;
+    int exponent;
+    bool negative;
+};
+
+/// Splits the output of printf's %e specifier into digits and exponent, removing trailing zeros.
+void splitScientific(const char* str, Decimal& decimal) {
+    decimal.negative = *str == '-';
+    if (decimal.negative) {
+        ++str;
+    }
+    decimal.digitCnt = 0;
+    for (; *str != 'e'; ++str) {
+        if (isDigit(*str)) {
+            decimal.digits[decimal.digitCnt++] = *str;
+        }
+    }
+    decimal.exponent = std::atoi(str + 1);
+    while (decimal.digitCnt > 1 && decimal.digits[decimal.digitCnt - 1] == '0') {
+        --decimal.digitCnt;
+    }
+}
+
+/// Floating-point number with 64-bit significand, value = f * 2^e
+struct DiyFp {
+    uint64_t f;
+    int e;
+
+    static constexpr int SIGNIFICAND_SIZE = 52;
+    static constexpr uint64_t HIDDEN_BIT = uint64_t(1) << SIGNIFICAND_SIZE;
+    static constexpr uint64_t SIGNIFICAND_MASK = HIDDEN_BIT - 1;
+    static constexpr int EXPONENT_BIAS = 0x3FF + SIGNIFICAND_SIZE;
+
+    DiyFp(const uint64_t f, const int e)
+        : f(f)
+        , e(e) {}
+
+    explicit DiyFp(const double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const int biasedExponent = int((bits >> SIGNIFICAND_SIZE) & 0x7FF);
+        const uint64_t significand = bits & SIGNIFICAND_MASK;
+        if (biasedExponent != 0) {
+            f = significand + HIDDEN_BIT;
+            e = biasedExponent - EXPONENT_BIAS;
+        } else {
+            // denormal number
+            f = significand;
+            e = 1 - EXPONENT_BIAS;
+        }
+    }
+
+    DiyFp operator-(const DiyFp& other) const {
+        SPH_ASSERT(e == other.e && f >= other.f);
+        return DiyFp(f - other.f, e);
+    }
+
+    /// Multiplies the numbers, rounding the result to 64 bits.
+    DiyFp operator*(const DiyFp& other) const {
+        constexpr uint64_t MASK_32 = 0xFFFFFFFF;
+        const uint64_t a = f >> 32;
+        const uint64_t b = f & MASK_32;
+        const uint64_t c = other.f >> 32;
+        const uint64_t d = other.f & MASK_32;
+        const uint64_t ac = a * c;
+        const uint64_t bc = b * c;
+        const uint64_t ad = a * d;
+        const uint64_t bd = b * d;
+        uint64_t tmp = (bd >> 32) + (ad & MASK_32) + (bc & MASK_32);
+        tmp += uint64_t(1) << 31; // round
+        return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + other.e + 64);
+    }
+
+    DiyFp normalize() const {
+        DiyFp result = *this;
+        while (!(result.f & (uint64_t(1) << 63))) {
+            result.f <<= 1;
+            result.e--;
+        }
+        return result;
+    }
+
+    /// Returns the normalized boundaries of the rounding interval of the value.
+    void getBoundaries(DiyFp& minus, DiyFp& plus) const {
+        plus = DiyFp((f << 1) + 1, e - 1).normalize();
+        // the lower boundary is closer for powers of 2
+        minus = (f == HIDDEN_BIT) ? DiyFp((f << 2) - 1, e - 2) : DiyFp((f << 1) - 1, e - 1);
+        minus.f <<= minus.e - plus.e;
+        minus.e = plus.e;
+    }
+};
+
+/// Normalized powers 10^k, k = -348 + 8i, rounded to 64 bits.
+///
+/// 10^k = CACHED_POWERS_F[i] * 2^CACHED_POWERS_E[i]
+constexpr uint64_t CACHED_POWERS_F[] = {
+    0xfa8fd5a0081c0288, 0xbaaee17fa23ebf76, 0x8b16fb203055ac76,
+    0xcf42894a5dce35ea, 0x9a6bb0aa55653b2d, 0xe61acf033d1a45df,
+    0xab70fe17c79ac6ca, 0xff77b1fcbebcdc4f, 0xbe5691ef416bd60c,
+    0x8dd01fad907ffc3c, 0xd3515c2831559a83, 0x9d71ac8fada6c9b5,
+    0xea9c227723ee8bcb, 0xaecc49914078536d, 0x823c12795db6ce57,
+    0xc21094364dfb5637, 0x9096ea6f3848984f, 0xd77485cb25823ac7,
+    0xa086cfcd97bf97f4, 0xef340a98172aace5, 0xb23867fb2a35b28e,
+    0x84c8d4dfd2c63f3b, 0xc5dd44271ad3cdba, 0x936b9fcebb25c996,
+    0xdbac6c247d62a584, 0xa3ab66580d5fdaf6, 0xf3e2f893dec3f126,
+    0xb5b5ada8aaff80b8, 0x87625f056c7c4a8b, 0xc9bcff6034c13053,
+    0x964e858c91ba2655, 0xdff9772470297ebd, 0xa6dfbd9fb8e5b88f,
+    0xf8a95fcf88747d94, 0xb94470938fa89bcf, 0x8a08f0f8bf0f156b,
+    0xcdb02555653131b6, 0x993fe2c6d07b7fac, 0xe45c10c42a2b3b06,
+    0xaa242499697392d3, 0xfd87b5f28300ca0e, 0xbce5086492111aeb,
+    0x8cbccc096f5088cc, 0xd1b71758e219652c, 0x9c40000000000000,
+    0xe8d4a51000000000, 0xad78ebc5ac620000, 0x813f3978f8940984,
+    0xc097ce7bc90715b3, 0x8f7e32ce7bea5c70, 0xd5d238a4abe98068,
+    0x9f4f2726179a2245, 0xed63a231d4c4fb27, 0xb0de65388cc8ada8,
+    0x83c7088e1aab65db, 0xc45d1df942711d9a, 0x924d692ca61be758,
+    0xda01ee641a708dea, 0xa26da3999aef774a, 0xf209787bb47d6b85,
+    0xb454e4a179dd1877, 0x865b86925b9bc5c2, 0xc83553c5c8965d3d,
+    0x952ab45cfa97a0b3, 0xde469fbd99a05fe3, 0xa59bc234db398c25,
+    0xf6c69a72a3989f5c, 0xb7dcbf5354e9bece, 0x88fcf317f22241e2,
+    0xcc20ce9bd35c78a5, 0x98165af37b2153df, 0xe2a0b5dc971f303a,
+    0xa8d9d1535ce3b396, 0xfb9b7cd9a4a7443c, 0xbb764c4ca7a44410,
+    0x8bab8eefb6409c1a, 0xd01fef10a657842c, 0x9b10a4e5e9913129,
+    0xe7109bfba19c0c9d, 0xac2820d9623bf429, 0x80444b5e7aa7cf85,
+    0xbf21e44003acdd2d, 0x8e679c2f5e44ff8f, 0xd433179d9c8cb841,
+    0x9e19db92b4e31ba9, 0xeb96bf6ebadf77d9, 0xaf87023b9bf0ee6b,
+};
+constexpr int16_t CACHED_POWERS_E[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+constexpr uint64_t POWERS_OF_10[] = { 1ull,
+    10ull,
+    100ull,
+    1000ull,
+    10000ull,
+    100000ull,
+    1000000ull,
+    10000000ull,
+    100000000ull,
+    1000000000ull,
+    10000000000ull,
+    100000000000ull,
+    1000000000000ull,
+    10000000000000ull,
+    100000000000000ull,
+    1000000000000000ull,
+    10000000000000000ull,
+    100000000000000000ull,
+    1000000000000000000ull,
+    10000000000000000000ull };
+
+/// Returns the cached power c = 10^(-k) such that the binary exponent of the product of c with a number
+/// with exponent e is in the range [-60, -32].
+DiyFp getCachedPower(const int e, int& k) {
+    const double dk = (-61 - e) * 0.30102999566398114 + 347; // 1/log2(10)
+    int ik = int(dk);
+    if (dk - ik > 0.) {
+        ++ik;
+    }
+    const Size index = Size((ik >> 3) + 1);
+    k = -(-348 + int(index << 3));
+    return DiyFp(CACHED_POWERS_F[index], CACHED_POWERS_E[index]);
+}
+
+/// Converts value = mantissa * 10^exponent into double, using extended precision arithmetic.
+///
+/// Based on the DiyFp conversion of the double-conversion library. The error of the result is tracked in
+/// 1/8 of the unit in the last place; if the error could change the rounding of the result, the conversion
+/// fails and the value has to be converted by a slower, exact algorithm.
+/// \param digitCnt Number of decimal digits of the mantissa, at most 19.
+/// \return True if the result is correctly rounded, false otherwise.
+bool toDoubleExtended(const uint64_t mantissa, const int digitCnt, const int exponent, double& value) {
+    SPH_ASSERT(mantissa != 0 && digitCnt <= 19);
+    constexpr int DENOMINATOR = 8;
+    if (exponent < -348 || exponent >= 340) {
+        return false;
+    }
+    const int index = (exponent + 348) / 8;
+    const int adjustment = exponent + 348 - 8 * index;
+    DiyFp x = DiyFp(mantissa, 0).normalize();
+    int error = 0;
+    if (adjustment > 0) {
+        x = x * DiyFp(POWERS_OF_10[adjustment], 0).normalize();
+        if (digitCnt + adjustment > 19) {
+            // the product might not fit into 64 bits
+            error += DENOMINATOR / 2;
+        }
+    }
+    x = x * DiyFp(CACHED_POWERS_F[index], CACHED_POWERS_E[index]);
+    // error of the cached power, error of the rounding and the product of errors
+    error += DENOMINATOR / 2 + DENOMINATOR / 2 + (error == 0 ? 0 : 1);
+    const DiyFp normalized = x.normalize();
+    error <<= x.e - normalized.e;
+
+    // 11 bits are rounded away, unless the result is denormal; leave these cases to the slow path
+    constexpr int ROUNDED_BITS = 64 - 53;
+    const int binaryExponent = normalized.e + ROUNDED_BITS;
+    if (binaryExponent + 52 < -1022 || binaryExponent + 52 > 1022) {
+        return false;
+    }
+    const uint64_t halfWay = (uint64_t(1) << (ROUNDED_BITS - 1)) * DENOMINATOR;
+    const uint64_t roundedBits = (normalized.f & ((uint64_t(1) << ROUNDED_BITS) - 1)) * DENOMINATOR;
+    if (halfWay - error < roundedBits && roundedBits < halfWay + error) {
+        // too close to the half-way point, cannot decide the rounding
+        return false;
+    }
+    uint64_t significand = normalized.f >> ROUNDED_BITS;
+    int biasedExponent = binaryExponent + DiyFp::EXPONENT_BIAS;
+    if (roundedBits >= halfWay + error) {
+        ++significand;
+        if (significand == (DiyFp::HIDDEN_BIT << 1)) {
+            significand >>= 1;
+            ++biasedExponent;
+        }
+    }
+    const uint64_t bits = (uint64_t(biasedExponent) << DiyFp::SIGNIFICAND_SIZE) |
+                          (significand & DiyFp::SIGNIFICAND_MASK);
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+/// Moves the last digit closer to the exact value, as long as the result stays in the rounding interval.
+void roundWeed(char* digits,
+    const int digitCnt,
+    const uint64_t delta,
+    uint64_t rest,
+    const uint64_t tenKappa,
+    const uint64_t wpw) {
+    while (rest < wpw && delta - rest >= tenKappa &&
+           (rest + tenKappa < wpw || wpw - rest > rest + tenKappa - wpw)) {
+        digits[digitCnt - 1]--;
+        rest += tenKappa;
+    }
+}
+
+int countDigits(const uint32_t n) {
+    int count = 1;
+    while (count < 10 && n >= POWERS_OF_10[count]) {
+        ++count;
+    }
+    return count;
+}
+
+/// Generates the digits of the value in the interval [Mp - delta, Mp], as close to W as possible.
+void generateDigits(const DiyFp& W, const DiyFp& Mp, uint64_t delta, Decimal& decimal, int& k) {
+    const DiyFp one(uint64_t(1) << -Mp.e, Mp.e);
+    const DiyFp wpw = Mp - W;
+    uint32_t p1 = uint32_t(Mp.f >> -one.e);
+    uint64_t p2 = Mp.f & (one.f - 1);
+    int kappa = countDigits(p1);
+    int& length = decimal.digitCnt;
+    length = 0;
+    while (kappa > 0) {
+        const uint32_t divisor = uint32_t(POWERS_OF_10[kappa - 1]);
+        const uint32_t d = p1 / divisor;
+        p1 %= divisor;
+        if (d || length) {
+            decimal.digits[length++] = char('0' + d);
+        }
+        kappa--;
+        const uint64_t tmp = (uint64_t(p1) << -one.e) + p2;
+        if (tmp <= delta) {
+            k += kappa;
+            roundWeed(decimal.digits, length, delta, tmp, POWERS_OF_10[kappa] << -one.e, wpw.f);
+            return;
+        }
+    }
+    while (true) {
+        p2 *= 10;
+        delta *= 10;
+        const char d = char(p2 >> -one.e);
+        if (d || length) {
+            decimal.digits[length++] = char('0' + d);
+        }
+        p2 &= one.f - 1;
+        kappa--;
+        if (p2 < delta) {
+            k += kappa;
+            const int index = -kappa;
+            const uint64_t scale = index < 20 ? POWERS_OF_10[index] : 0;
+            roundWeed(decimal.digits, length, delta, p2, one.f, wpw.f * scale);
+            return;
+        }
+    }
+}
+
+/// Finds the shortest decimal representation of the value that reads back as the same value.
+///
+/// Uses the Grisu2 algorithm by F. Loitsch, Printing floating-point numbers quickly and accurately with
+/// integers, 2010. The output always reads back as the same value; in rare cases, it may not be the shortest
+/// one.
+void toShortestDecimal(const double value, Decimal& decimal) {
+    decimal.negative = isNegative(value);
+    if (value == 0.) {
+        decimal.digits[0] = '0';
+        decimal.digitCnt = 1;
+        decimal.exponent = 0;
+        return;
+    }
+    const DiyFp v(std::abs(value));
+    DiyFp minus(0, 0), plus(0, 0);
+    v.getBoundaries(minus, plus);
+
+    int k;
+    const DiyFp c = getCachedPower(plus.e, k);
+    const DiyFp W = v.normalize() * c;
+    DiyFp Wp = plus * c;
+    DiyFp Wm = minus * c;
+    Wm.f++;
+    Wp.f--;
+    generateDigits(W, Wp, Wp.f - Wm.f, decimal, k);
+    decimal.exponent = k + decimal.digitCnt - 1;
+    while (decimal.digitCnt > 1 && decimal.digits[decimal.digitCnt - 1] == '0') {
+        --decimal.digitCnt;
+    }
+}
+
+/// Finds the shortest decimal representation of a single-precision value.
+///
+/// If a value can be represented by n digits, its correctly rounded representation with minDigits >= n
+/// digits is the same representation padded by zeros. Therefore it is sufficient to check the precision of
+/// minDigits and larger.
+void toShortestDecimal(const float value, Decimal& decimal) {
+    constexpr int minDigits = std::numeric_limits<float>::digits10;
+    constexpr int maxDigits = std::numeric_limits<float>::max_digits10;
+    char buffer[40];
+    for (int digitCnt = minDigits; digitCnt <= maxDigits; ++digitCnt) {
+        printScientific(buffer, sizeof(buffer), digitCnt - 1, double(value));
+        if (digitCnt == maxDigits || float(toDouble(buffer, nullptr)) == value) {
+            break;
+        }
+    }
+    splitScientific(buffer, decimal);
+}
+
+char* writeSpecial(char* out, const double value) {
+    if (isNan(value)) {
+        std::memcpy(out, "nan", 3);
+        return out + 3;
+    }
+    SPH_ASSERT(!isFinite(value));
+    if (isNegative(value)) {
+        *out++ = '-';
+    }
+    std::memcpy(out, "inf", 3);
+    return out + 3;
+}
+
+char* writeDecimal(char* out, const Decimal& decimal, const bool scientific) {
+    if (decimal.negative) {
+        *out++ = '-';
+    }
+    const int exponent = decimal.exponent;
+    if (!scientific && exponent >= -5 && exponent < 16) {
+        if (exponent < 0) {
+            // 0.000ddd
+            *out++ = '0';
+            *out++ = '.';
+            for (int i = 0; i < -exponent - 1; ++i) {
+                *out++ = '0';
+            }
+            std::memcpy(out, decimal.digits, decimal.digitCnt);
+            return out + decimal.digitCnt;
+        }
+        const int integerCnt = exponent + 1;
+        if (decimal.digitCnt <= integerCnt) {
+            // ddd000
+            std::memcpy(out, decimal.digits, decimal.digitCnt);
+            out += decimal.digitCnt;
+            for (int i = decimal.digitCnt; i < integerCnt; ++i) {
+                *out++ = '0';
+            }
+            return out;
+        }
+        // ddd.ddd
+        std::memcpy(out, decimal.digits, integerCnt);
+        out += integerCnt;
+        *out++ = '.';
+        std::memcpy(out, decimal.digits + integerCnt, decimal.digitCnt - integerCnt);
+        return out + decimal.digitCnt - integerCnt;
+    }
+
+    // d.ddde+XX
+    *out++ = decimal.digits[0];
+    if (decimal.digitCnt > 1) {
+        *out++ = '.';
+        std::memcpy(out, decimal.digits + 1, decimal.digitCnt - 1);
+        out += decimal.digitCnt - 1;
+    }
+    *out++ = 'e';
+    *out++ = exponent < 0 ? '-' : '+';
+    const int absExponent = std::abs(exponent);
+    if (absExponent >= 100) {
+        *out++ = char('0' + absExponent / 100);
+    }
+    *out++ = char('0' + (absExponent / 10) % 10);
+    *out++ = char('0' + absExponent % 10);
+    return out;
+}
+
+template <typename T>
+char* formatFloatImpl(char* out, const T value, const bool scientific) {
+    if (!isFinite(double(value))) {
+        return writeSpecial(out, double(value));
+    }
+    Decimal decimal;
+    toShortestDecimal(value, decimal);
+    return writeDecimal(out, decimal, scientific);
+}
+
+void appendPadded(Array<char>& buffer, const char* first, const char* last, const Size width) {
+    const Size length = Size(last - first);
+    const Size padding = max(width, length + 1) - length;
+    const Size size = buffer.size();
+    buffer.resize(size + padding + length);
+    std::memset(&buffer[size], ' ', padding);
+    std::memcpy(&buffer[size + padding], first, length);
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------------------------------------
+// TextIo
+// ----------------------------------------------------------------------------------------------------------
+
+const char* TextIo::parseFloat(const char* first, const char* last, double& value) {
+    first = skipSpaces(first, last);
+    const char* p = first;
+    bool negative = false;
+    if (p < last && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+    if (p < last && !isDigit(*p) && *p != '.') {
+        if (matchesIgnoreCase(p, last, "nan")) {
+            value = std::numeric_limits<double>::quiet_NaN();
+            return p + 3;
+        } else if (matchesIgnoreCase(p, last, "infinity")) {
+            value = negative ? negate(INFINITE) : INFINITE;
+            return p + 8;
+        } else if (matchesIgnoreCase(p, last, "inf")) {
+            value = negative ? negate(INFINITE) : INFINITE;
+            return p + 3;
+        } else {
+            return nullptr;
+        }
+    }
+
+    // accumulate up to 19 significant digits, this cannot overflow uint64_t
+    uint64_t mantissa = 0;
+    int significantCnt = 0;
+    int exponent = 0;
+    bool truncated = false;
+    bool hasDigits = false;
+    for (; p < last && isDigit(*p); ++p) {
+        hasDigits = true;
+        if (significantCnt < 19) {
+            mantissa = 10 * mantissa + uint64_t(*p - '0');
+            significantCnt += (mantissa != 0);
+        } else {
+            truncated |= *p != '0';
+            ++exponent;
+        }
+    }
+    if (p < last && *p == '.') {
+        ++p;
+        for (; p < last && isDigit(*p); ++p) {
+            hasDigits = true;
+            if (significantCnt < 19) {
+                mantissa = 10 * mantissa + uint64_t(*p - '0');
+                significantCnt += (mantissa != 0);
+                --exponent;
+            } else {
+                truncated |= *p != '0';
+            }
+        }
+    }
+    if (!hasDigits) {
+        return nullptr;
+    }
+    if (p < last && (*p == 'e' || *p == 'E')) {
+        const char* e = p + 1;
+        bool negativeExponent = false;
+        if (e < last && (*e == '-' || *e == '+')) {
+            negativeExponent = *e == '-';
+            ++e;
+        }
+        if (e < last && isDigit(*e)) {
+            int explicitExponent = 0;
+            for (; e < last && isDigit(*e); ++e) {
+                explicitExponent = min(10 * explicitExponent + (*e - '0'), 100000);
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            p = e;
+        }
+    }
+
+    // Clinger's fast path; both the mantissa and the power of 10 are exactly representable, so the result
+    // is correctly rounded.
+    if (!truncated && mantissa <= (uint64_t(1) << 53) && std::abs(exponent) <= 22) {
+        const double m = double(mantissa);
+        value = exponent >= 0 ? m * EXACT_POWERS_OF_10[exponent] : m / EXACT_POWERS_OF_10[-exponent];
+        if (negative) {
+            value = negate(value);
+        }
+        return p;
+    }
+    if (!truncated && mantissa != 0 && toDoubleExtended(mantissa, significantCnt, exponent, value)) {
+        if (negative) {
+            value = negate(value);
+        }
+        return p;
+    }
+    return parseFloatSlow(first, p, value);
+}
+
+const char* TextIo::parseIndex(const char* first, const char* last, Size& value) {
+    first = skipSpaces(first, last);
+    if (first < last && *first == '+') {
+        ++first;
+    }
+    if (first == last || !isDigit(*first)) {
+        return nullptr;
+    }
+    uint64_t result = 0;
+    for (; first < last && isDigit(*first); ++first) {
+        result = 10 * result + uint64_t(*first - '0');
+        if (result > std::numeric_limits<Size>::max()) {
+            return nullptr;
+        }
+    }
+    value = Size(result);
+    return first;
+}
+
+char* TextIo::formatFloat(char* out, const double value, const bool scientific) {
+    return formatFloatImpl(out, value, scientific);
+}
+
+char* TextIo::formatFloat(char* out, const float value, const bool scientific) {
+    return formatFloatImpl(out, value, scientific);
+}
+
+char* TextIo::formatIndex(char* out, const Size value) {
+    char buffer[MAX_NUMBER_LENGTH];
+    char* p = buffer + MAX_NUMBER_LENGTH;
+    Size v = value;
+    do {
+        *--p = char('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    const std::size_t length = std::size_t(buffer + MAX_NUMBER_LENGTH - p);
+    std::memcpy(out, p, length);
+    return out + length;
+}
+
+void TextIo::appendFloat(Array<char>& buffer, const Float value, const Size width, const bool scientific) {
+    char number[MAX_NUMBER_LENGTH];
+    char* end = formatFloat(number, value, scientific);
+    appendPadded(buffer, number, end, width);
+}
+
+void TextIo::appendIndex(Array<char>& buffer, const Size value, const Size width) {
+    char number[MAX_NUMBER_LENGTH];
+    char* end = formatIndex(number, value);
+    appendPadded(buffer, number, end, width);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// LineIndex
+// ----------------------------------------------------------------------------------------------------------
+
+TextIo::LineIndex::LineIndex(IScheduler& scheduler, ArrayView<const char> text) {
+    if (text.empty()) {
+        return;
+    }
+    // split to chunks of complete lines; use a few chunks per thread to balance the load
+    constexpr std::size_t MIN_CHUNK_SIZE = 1 << 16;
+    const char* begin = &text[0];
+    const char* end = begin + text.size();
+    const Size chunkCnt = min(4 * scheduler.getThreadCnt(), Size(text.size() / MIN_CHUNK_SIZE) + 1);
+    const char* chunkBegin = begin;
+    for (Size i = 0; i < chunkCnt && chunkBegin < end; ++i) {
+        const char* chunkEnd = begin + std::size_t(text.size()) * (i + 1) / chunkCnt;
+        if (chunkEnd <= chunkBegin) {
+            continue;
+        }
+        if (chunkEnd < end) {
+            // move to the beginning of the next line
+            chunkEnd = findLineEnd(chunkEnd - 1, end);
+            chunkEnd = min(chunkEnd + 1, end);
+        }
+        chunks.push(Chunk{ chunkBegin, chunkEnd, 0 });
+        chunkBegin = chunkEnd;
+    }
+
+    // count data lines in each chunk
+    Array<Size> counts(chunks.size());
+    parallelFor(scheduler, 0, chunks.size(), 1, [this, &counts](const Size chunkIdx) {
+        const Chunk& chunk = chunks[chunkIdx];
+        Size count = 0;
+        for (const char* line = chunk.begin; line < chunk.end;) {
+            const char* lineEnd = findLineEnd(line, chunk.end);
+            count += isDataLine(line, lineEnd);
+            line = lineEnd + 1;
+        }
+        counts[chunkIdx] = count;
+    });
+    for (Size i = 0; i < chunks.size(); ++i) {
+        chunks[i].firstLine = lineCnt;
+        lineCnt += counts[i];
+    }
+}
+
+const char* TextIo::LineIndex::findLineEnd(const char* begin, const char* end) {
+    const void* newline = std::memchr(begin, '\n', std::size_t(end - begin));
+    return newline ? static_cast<const char*>(newline) : end;
+}
+
+bool TextIo::LineIndex::isDataLine(const char* begin, const char* end) {
+    begin = skipSpaces(begin, end);
+    return begin < end && *begin != '#' && *begin != '\r';
+}
+
+NAMESPACE_SPH_END
@@ -0,0 +1,188 @@
+#pragma once
+
+/// \file TextIo.h
+/// \brief Fast conversions of numbers to text and back, parallel reading and writing of text files
+/// \author Pavel Sevecek (sevecek at sirrah.troja.mff.cuni.cz)
+/// \date 2016-2021
+
+#include "objects/containers/Array.h"
+#include "objects/wrappers/Optional.h"
+#include "thread/Scheduler.h"
+#include <atomic>
+#include <ostream>
+
+NAMESPACE_SPH_BEGIN
+
+/// \brief Shared implementation of text inputs and outputs.
+///
+/// Numbers are converted without streams, independently of the global locale. Floating-point values are
+/// written using the shortest representation that reads back as the same value, so the text files are
+/// lossless. Files are read by splitting them into chunks of complete lines, which are then parsed in
+/// parallel; output lines are formatted in parallel by blocks and written into the file in order.
+namespace TextIo {
+
+/// \brief Maximal number of characters written by \ref formatFloat and \ref formatIndex.
+constexpr Size MAX_NUMBER_LENGTH = 32;
+
+/// \brief Parses a floating-point value.
+///
+/// Leading spaces and tabs are skipped. Accepts numbers in fixed and scientific format, as well as "inf" and
+/// "nan" strings.
+/// \param first Pointer to the first character of the input.
+/// \param last Pointer past the last character of the input.
+/// \param value Output value.
+/// \return Pointer past the parsed number or nullptr if the input does not start with a number.
+const char* parseFloat(const char* first, const char* last, double& value);
+
+/// \brief Parses an unsigned integer.
+///
+/// Leading spaces and tabs are skipped.
+/// \return Pointer past the parsed number or nullptr if the input does not start with an integer.
+const char* parseIndex(const char* first, const char* last, Size& value);
+
+/// \brief Writes the shortest representation of the value that reads back as the same value.
+///
+/// The output is not null-terminated; the buffer must contain at least \ref MAX_NUMBER_LENGTH characters.
+/// \param out Pointer to the output buffer.
+/// \param value Written value.
+/// \param scientific If true, the value is always written in scientific format; otherwise the format is
+///                   selected similarly to printf's %g specifier.
+/// \return Pointer past the last written character.
+char* formatFloat(char* out, const double value, const bool scientific = false);
+
+/// \brief Writes the shortest representation of a single-precision value.
+///
+/// Overload of \ref formatFloat; the value is written with the precision of float rather than double.
+char* formatFloat(char* out, const float value, const bool scientific = false);
+
+/// \brief Writes an unsigned integer.
+///
+/// The output is not null-terminated; the buffer must contain at least \ref MAX_NUMBER_LENGTH characters.
+/// \return Pointer past the last written character.
+char* formatIndex(char* out, const Size value);
+
+/// \brief Appends a floating-point value to the buffer, right-aligned to given width.
+///
+/// The value is always preceded by at least one space, so that adjacent values cannot merge.
+void appendFloat(Array<char>& buffer, const Float value, const Size width, const bool scientific = false);
+
+/// \brief Appends an unsigned integer to the buffer, right-aligned to given width.
+///
+/// The value is always preceded by at least one space, so that adjacent values cannot merge.
+void appendIndex(Array<char>& buffer, const Size value, const Size width);
+
+/// \brief Index of data lines in a text.
+///
+/// The text is split into chunks of complete lines, the lines in each chunk are counted in parallel. Empty
+/// lines and comments (lines starting with '#') are not considered data lines and are skipped.
+class LineIndex {
+private:
+    struct Chunk {
+        const char* begin;
+        const char* end;
+
+        /// Index of the first data line in the chunk
+        Size firstLine;
+    };
+
+    Array<Chunk> chunks;
+    Size lineCnt = 0;
+
+public:
+    /// \brief Indexes the given text.
+    ///
+    /// The text must be kept alive while the index is in use.
+    LineIndex(IScheduler& scheduler, ArrayView<const char> text);
+
+    /// \brief Returns the number of data lines.
+    Size size() const {
+        return lineCnt;
+    }
+
+    /// \brief Calls the functor for every data line of the text.
+    ///
+    /// Chunks are processed in parallel, lines of a single chunk are processed sequentially.
+    /// \param functor Functor with signature bool(Size lineIdx, const char* begin, const char* end). The
+    ///                range does not include the line terminator. If it returns false, the processing is
+    ///                stopped.
+    /// \return Index of the line for which the functor returned false, or NOTHING on success. If several
+    ///         lines failed, the smallest index is returned.
+    template <typename TFunctor>
+    Optional<Size> forEach(IScheduler& scheduler, TFunctor&& functor) const {
+        std::atomic<Size> failedLine(Size(-1));
+        parallelFor(scheduler, 0, chunks.size(), 1, [this, &functor, &failedLine](const Size chunkIdx) {
+            const Chunk& chunk = chunks[chunkIdx];
+            Size lineIdx = chunk.firstLine;
+            const char* lineBegin = chunk.begin;
+            while (lineBegin < chunk.end) {
+                const char* lineEnd = findLineEnd(lineBegin, chunk.end);
+                const char* next = lineEnd + (lineEnd < chunk.end ? 1 : 0);
+                if (lineEnd > lineBegin && lineEnd[-1] == '\r') {
+                    --lineEnd;
+                }
+                if (isDataLine(lineBegin, lineEnd)) {
+                    if (lineIdx > failedLine) {
+                        // some of the previous lines already failed
+                        return;
+                    }
+                    if (!functor(lineIdx, lineBegin, lineEnd)) {
+                        Size expected = failedLine;
+                        while (lineIdx < expected && !failedLine.compare_exchange_weak(expected, lineIdx)) {
+                        }
+                        return;
+                    }
+                    ++lineIdx;
+                }
+                lineBegin = next;
+            }
+        });
+        if (failedLine != Size(-1)) {
+            return Size(failedLine);
+        } else {
+            return NOTHING;
+        }
+    }
+
+private:
+    static const char* findLineEnd(const char* begin, const char* end);
+
+    static bool isDataLine(const char* begin, const char* end);
+};
+
+/// \brief Formats lines of text in parallel and writes them into the stream.
+///
+/// The lines are formatted by blocks into buffers, which are reused for subsequent blocks, and written into
+/// the stream in order.
+/// \param scheduler Scheduler used to format the lines.
+/// \param stream Output stream.
+/// \param lineCnt Number of lines to write.
+/// \param functor Functor with signature void(Size lineIdx, Array<char>& buffer), appending the line
+///                including the line terminator to the buffer.
+template <typename TFunctor>
+void writeLines(IScheduler& scheduler, std::ostream& stream, const Size lineCnt, TFunctor&& functor) {
+    constexpr Size BLOCK_SIZE = 1024;
+    const Size blockCnt = (lineCnt + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const Size batchSize = min(blockCnt, 4 * scheduler.getThreadCnt());
+    Array<Array<char>> buffers(batchSize);
+    for (Size batchBegin = 0; batchBegin < blockCnt; batchBegin += batchSize) {
+        const Size batchEnd = min(batchBegin + batchSize, blockCnt);
+        parallelFor(scheduler, batchBegin, batchEnd, 1, [&](const Size blockIdx) {
+            Array<char>& buffer = buffers[blockIdx - batchBegin];
+            buffer.clear();
+            const Size to = min((blockIdx + 1) * BLOCK_SIZE, lineCnt);
+            for (Size i = blockIdx * BLOCK_SIZE; i < to; ++i) {
+                functor(i, buffer);
+            }
+        });
+        for (Size blockIdx = batchBegin; blockIdx < batchEnd; ++blockIdx) {
+            const Array<char>& buffer = buffers[blockIdx - batchBegin];
+            if (!buffer.empty()) {
+                stream.write(&buffer[0], buffer.size());
+            }
+        }
+    }
+}
+
+} // namespace TextIo
+
+NAMESPACE_SPH_END
@@ -0,0 +1,67 @@
+#include "io/FloatCodec.h"
+#include "catch.hpp"
+#include "math/rng/Rng.h"
+#include <cstring>
+
+using namespace Sph;
+
+static uint32_t toWord(const float value) {
+    uint32_t word;
+    std::memcpy(&word, &value, sizeof(word));
+    return word;
+}
+
+static void testRoundTrip(ArrayView<const uint32_t> words) {
+    Array<char> data = FloatCodec::encode(words);
+    Array<uint32_t> decoded(words.size());
+    REQUIRE(FloatCodec::decode(data, decoded));
+    REQUIRE(ArrayView<const uint32_t>(decoded) == words);
+}
+
+TEST_CASE("FloatCodec empty", "[floatcodec]") {
+    testRoundTrip(Array<uint32_t>{});
+    testRoundTrip(Array<uint32_t>{ 5 });
+}
+
+TEST_CASE("FloatCodec smooth values", "[floatcodec]") {
+    Array<uint32_t> words(100000);
+    for (Size i = 0; i < words.size(); ++i) {
+        words[i] = toWord(1.f + 1.e-5f * i);
+    }
+    testRoundTrip(words);
+    // should compress well
+    REQUIRE(FloatCodec::encode(words).size() < words.size() * sizeof(uint32_t) / 2);
+
+    words.fill(toWord(2.5f));
+    testRoundTrip(words);
+    REQUIRE(FloatCodec::encode(words).size() < words.size() * sizeof(uint32_t) / 100);
+}
+
+TEST_CASE("FloatCodec random values", "[floatcodec]") {
+    UniformRng rng;
+    Array<uint32_t> words(30000);
+    for (uint32_t& w : words) {
+        w = uint32_t(rng() * 4294967295.);
+    }
+    testRoundTrip(words);
+    // incompressible data should not grow much
+    REQUIRE(FloatCodec::encode(words).size() < words.size() * sizeof(uint32_t) * 1.01);
+}
+
+TEST_CASE("FloatCodec corrupted", "[floatcodec]") {
+    Array<uint32_t> words(1000);
+    for (Size i = 0; i < words.size(); ++i) {
+        words[i] = toWord(float(i % 17));
+    }
+    Array<char> data = FloatCodec::encode(words);
+    Array<uint32_t> decoded(words.size());
+
+    Array<char> truncated = data.clone();
+    truncated.resize(data.size() / 2);
+    REQUIRE_FALSE(FloatCodec::decode(truncated, decoded));
+
+    Array<uint32_t> wrongSize(words.size() + 1);
+    REQUIRE_FALSE(FloatCodec::decode(data, wrongSize));
+
+    REQUIRE_FALSE(FloatCodec::decode(Array<char>{ char(0xf0) }, decoded));
+}
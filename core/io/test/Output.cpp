@@ -1,5 +1,6 @@
 #include "io/Output.h"
 #include "catch.hpp"
+#include "io/AsyncOutput.h"
 #include "io/Column.h"
 #include "io/FileManager.h"
 #include "io/FileSystem.h"
@@ -18,7 +19,9 @@
 #include "timestepping/ISolver.h"
 #include "utils/Config.h"
 #include "utils/Utils.h"
+#include <atomic>
 #include <fstream>
+#include <thread>
 
 using namespace Sph;
 
@@ -105,6 +108,52 @@ TEST_CASE("TextOutput dump&accumulate", "[output]") {
     REQUIRE(almostEqual(density.getValue<Float>(), storage.getValue<Float>(QuantityId::DENSITY)));
 }
 
+TEST_CASE("TextOutput parallel lossless", "[output]") {
+    RandomPathManager manager;
+    Storage storage = Tests::getSolidStorage(10000);
+    Statistics stats;
+    stats.set(StatisticsId::RUN_TIME, 0._f);
+    SharedPtr<ThreadPool> pool = makeShared<ThreadPool>(4);
+    const Flags<OutputQuantityFlag> flags = OutputQuantityFlag::POSITION | OutputQuantityFlag::VELOCITY |
+                                            OutputQuantityFlag::DENSITY |
+                                            OutputQuantityFlag::DEVIATORIC_STRESS;
+
+    Path sequentialPath = manager.getPath("txt");
+    TextOutput sequentialOutput(sequentialPath, "Output", flags);
+    REQUIRE(sequentialOutput.dump(storage, stats));
+    Path parallelPath = manager.getPath("txt");
+    TextOutput parallelOutput(parallelPath, "Output", flags, EMPTY_FLAGS, pool);
+    REQUIRE(parallelOutput.dump(storage, stats));
+    REQUIRE(FileSystem::readFile(sequentialPath) == FileSystem::readFile(parallelPath));
+
+    Storage loaded;
+    TextInput input(flags, pool);
+    REQUIRE(input.load(parallelPath, loaded, stats));
+    REQUIRE(loaded.getParticleCnt() == storage.getParticleCnt());
+    REQUIRE(loaded.getValue<Vector>(QuantityId::POSITION) == storage.getValue<Vector>(QuantityId::POSITION));
+    REQUIRE(loaded.getDt<Vector>(QuantityId::POSITION) == storage.getDt<Vector>(QuantityId::POSITION));
+    REQUIRE(loaded.getValue<Float>(QuantityId::DENSITY) == storage.getValue<Float>(QuantityId::DENSITY));
+    REQUIRE(loaded.getValue<TracelessTensor>(QuantityId::DEVIATORIC_STRESS) ==
+            storage.getValue<TracelessTensor>(QuantityId::DEVIATORIC_STRESS));
+}
+
+TEST_CASE("TextInput invalid line", "[output]") {
+    RandomPathManager manager;
+    Path path = manager.getPath("txt");
+    std::ofstream ofs(path.native());
+    ofs << "# comment\n1 2 3\n\n4 5 x\n";
+    ofs.close();
+
+    TextInput input(OutputQuantityFlag::POSITION);
+    Storage storage;
+    Statistics stats;
+    Outcome result = input.load(path, storage, stats);
+    REQUIRE_FALSE(result);
+    REQUIRE(result.error().find("line 2") != String::npos);
+
+    REQUIRE_FALSE(input.load(manager.getPath("txt"), storage, stats));
+}
+
 TEST_CASE("TextOutput create from settings", "[output]") {
     RandomPathManager manager;
     RunSettings settings;
@@ -430,6 +479,64 @@ TEST_CASE("BinaryOutput backward compatibility", "[output]") {
     testVersion(BinaryIoVersion::V2018_10_24);
     testVersion(BinaryIoVersion::V2021_03_20);
     testVersion(BinaryIoVersion::V2021_08_08);
+    testVersion(BinaryIoVersion::V2026_10_16);
+}
+
+TEST_CASE("BinaryOutput delta checkpoints", "[output]") {
+    RandomPathManager manager;
+    const Path dir = manager.getPath();
+    BinaryOutput output(OutputFile(dir / Path("dump_%d.ssf")), RunTypeEnum::SPH, 3);
+    BinaryOutput fullOutput(OutputFile(dir / Path("full_%d.ssf")));
+
+    Storage storage = Tests::getSolidStorage(20000);
+    Array<Path> paths, fullPaths;
+    for (Size i = 0; i < 5; ++i) {
+        // only some of the particles move, other quantities do not change
+        ArrayView<Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+        ArrayView<Float> u = storage.getValue<Float>(QuantityId::ENERGY);
+        for (Size j = 0; j < 1000; ++j) {
+            r[j] += Vector(0.1_f, 0._f, 0._f);
+            u[j] += 1._f;
+        }
+        Statistics stats;
+        stats.set(StatisticsId::RUN_TIME, Float(i));
+        stats.set(StatisticsId::TIMESTEP_VALUE, 0.5_f);
+        paths.push(output.dump(storage, stats).value());
+        fullPaths.push(fullOutput.dump(storage, stats).value());
+    }
+
+    for (Size i = 0; i < 5; ++i) {
+        const std::size_t size = FileSystem::fileSize(paths[i]);
+        const std::size_t fullSize = FileSystem::fileSize(fullPaths[i]);
+        if (i % 3 == 0) {
+            REQUIRE(size == fullSize);
+        } else {
+            REQUIRE(size < fullSize / 5);
+        }
+
+        Storage loaded, expected;
+        Statistics stats;
+        REQUIRE(BinaryInput().load(fullPaths[i], expected, stats));
+        REQUIRE(BinaryInput().load(paths[i], loaded, stats));
+        REQUIRE(stats.get<Float>(StatisticsId::RUN_TIME) == Float(i));
+        REQUIRE(loaded.getMaterialCnt() == expected.getMaterialCnt());
+        REQUIRE(loaded.getQuantityCnt() == expected.getQuantityCnt());
+        iteratePair<VisitorEnum::ALL_BUFFERS>(loaded, expected, [](auto& b1, auto& b2) { REQUIRE(b1 == b2); });
+
+        Expected<BinaryInput::Info> info = BinaryInput::getInfo(paths[i]);
+        REQUIRE(info);
+        REQUIRE(info->runTime == Float(i));
+        REQUIRE(info->particleCnt == storage.getParticleCnt());
+    }
+
+    // the chain is broken
+    FileSystem::removePath(paths[3]);
+    Storage loaded;
+    Statistics stats;
+    REQUIRE_FALSE(BinaryInput().load(paths[4], loaded, stats));
+    REQUIRE(BinaryInput().load(paths[2], loaded, stats));
+
+    FileSystem::removePath(dir, FileSystem::RemovePathFlag::RECURSIVE);
 }
 
 static void testCompression(CompressionEnum compression) {
@@ -469,6 +576,116 @@ TEST_CASE("CompressedOutput RLE", "[output]") {
     testCompression(CompressionEnum::RLE);
 }
 
+TEST_CASE("CompressedOutput XOR shuffle", "[output]") {
+    testCompression(CompressionEnum::XOR_SHUFFLE);
+}
+
+TEST_CASE("CompressedOutput XOR shuffle parallel", "[output]") {
+    // more particles than a single block
+    Storage storage = Tests::getSolidStorage(100000);
+    Statistics stats;
+    stats.set(StatisticsId::RUN_TIME, 0._f);
+    RandomPathManager manager;
+    SharedPtr<ThreadPool> pool = ThreadPool::getGlobalInstance();
+
+    Path uncompressedPath = manager.getPath("scf");
+    CompressedOutput(uncompressedPath, CompressionEnum::NONE).dump(storage, stats);
+    Path compressedPath = manager.getPath("scf");
+    CompressedOutput compressedOutput(compressedPath, CompressionEnum::XOR_SHUFFLE, RunTypeEnum::SPH, pool);
+    compressedOutput.dump(storage, stats);
+    REQUIRE(FileSystem::fileSize(compressedPath) < FileSystem::fileSize(uncompressedPath));
+
+    Storage uncompressed, compressed;
+    REQUIRE(CompressedInput().load(uncompressedPath, uncompressed, stats));
+    REQUIRE(CompressedInput(pool).load(compressedPath, compressed, stats));
+    REQUIRE(compressed.getParticleCnt() == storage.getParticleCnt());
+    // lossless with respect to the uncompressed format
+    REQUIRE(compressed.getValue<Vector>(QuantityId::POSITION) ==
+            uncompressed.getValue<Vector>(QuantityId::POSITION));
+    REQUIRE(
+        compressed.getDt<Vector>(QuantityId::POSITION) == uncompressed.getDt<Vector>(QuantityId::POSITION));
+    for (QuantityId id : { QuantityId::MASS, QuantityId::DENSITY, QuantityId::ENERGY }) {
+        REQUIRE(compressed.getValue<Float>(id) == uncompressed.getValue<Float>(id));
+    }
+    FileSystem::removePath(uncompressedPath);
+    FileSystem::removePath(compressedPath);
+}
+
+TEST_CASE("CompressedOutput quantized", "[output]") {
+    Storage storage = Tests::getSolidStorage(100000);
+    ArrayView<Vector> r, v, dv;
+    tie(r, v, dv) = storage.getAll<Vector>(QuantityId::POSITION);
+    for (Size i = 0; i < r.size(); ++i) {
+        v[i] = Vector(Sph::sin(r[i][X]), r[i][Y] * r[i][Z], 1._f) * 100._f;
+    }
+    ArrayView<Float> rho = storage.getValue<Float>(QuantityId::DENSITY);
+    ArrayView<Float> D = storage.getValue<Float>(QuantityId::DAMAGE);
+    for (Size i = 0; i < r.size(); ++i) {
+        rho[i] *= 1._f + 0.1_f * Sph::sin(getLength(r[i]));
+        D[i] = Float(i % 7) / 6._f;
+    }
+    Statistics stats;
+    stats.set(StatisticsId::RUN_TIME, 0._f);
+    RandomPathManager manager;
+    SharedPtr<ThreadPool> pool = ThreadPool::getGlobalInstance();
+
+    Path losslessPath = manager.getPath("scf");
+    CompressedOutput(losslessPath, CompressionEnum::XOR_SHUFFLE, RunTypeEnum::SPH, pool).dump(storage, stats);
+    Path quantizedPath = manager.getPath("scf");
+    QuantizationParams params;
+    params.energy.value = 0._f;
+    CompressedOutput(quantizedPath, CompressionEnum::QUANTIZED, RunTypeEnum::SPH, pool, params)
+        .dump(storage, stats);
+    Path nonePath = manager.getPath("scf");
+    CompressedOutput(nonePath, CompressionEnum::NONE).dump(storage, stats);
+    REQUIRE(FileSystem::fileSize(quantizedPath) < FileSystem::fileSize(losslessPath));
+    REQUIRE(FileSystem::fileSize(quantizedPath) < FileSystem::fileSize(nonePath) / 5);
+
+    Expected<CompressedInput::Info> info = CompressedInput::getInfo(quantizedPath);
+    REQUIRE(info);
+    REQUIRE(info->version == CompressedIoVersion::LATEST);
+    REQUIRE(info->compression == CompressionEnum::QUANTIZED);
+    const ErrorBounds& bounds = info->errorBounds;
+    Box box;
+    for (const Vector& p : r) {
+        box.extend(p);
+    }
+    REQUIRE(bounds.position == approx(1.e-4_f * maxElement(box.size()), 1.e-6_f));
+    REQUIRE(bounds.velocity > 0._f);
+    REQUIRE(bounds.density > 0._f);
+    REQUIRE(bounds.energy == 0._f);
+    REQUIRE(bounds.damage == approx(1.e-3_f, 1.e-6_f));
+
+    Storage lossless, quantized;
+    REQUIRE(CompressedInput(pool).load(losslessPath, lossless, stats));
+    REQUIRE(CompressedInput(pool).load(quantizedPath, quantized, stats));
+    REQUIRE(quantized.getParticleCnt() == storage.getParticleCnt());
+    ArrayView<const Vector> r1 = quantized.getValue<Vector>(QuantityId::POSITION);
+    ArrayView<const Vector> v1 = quantized.getDt<Vector>(QuantityId::POSITION);
+    ArrayView<const Vector> r2 = lossless.getValue<Vector>(QuantityId::POSITION);
+    auto checkBound = [](ArrayView<const Float> values, ArrayView<const Float> expected, const Float bound) {
+        for (Size i = 0; i < values.size(); ++i) {
+            REQUIRE(abs(values[i] - expected[i]) <= bound);
+        }
+    };
+    for (Size i = 0; i < r.size(); ++i) {
+        for (Size j = 0; j < 3; ++j) {
+            REQUIRE(abs(r1[i][j] - r[i][j]) <= bounds.position);
+            REQUIRE(abs(v1[i][j] - v[i][j]) <= bounds.velocity);
+        }
+        // smoothing lengths are not quantized
+        REQUIRE(r1[i][H] == r2[i][H]);
+    }
+    checkBound(quantized.getValue<Float>(QuantityId::DENSITY), rho, bounds.density);
+    checkBound(quantized.getValue<Float>(QuantityId::DAMAGE), D, bounds.damage);
+    for (QuantityId id : { QuantityId::MASS, QuantityId::ENERGY }) {
+        REQUIRE(quantized.getValue<Float>(id) == lossless.getValue<Float>(id));
+    }
+    FileSystem::removePath(nonePath);
+    FileSystem::removePath(losslessPath);
+    FileSystem::removePath(quantizedPath);
+}
+
 Storage generateLatestCompressedOutput(bool save = false) {
     BodySettings body1;
     body1.set(BodySettingsId::DENSITY, 1000._f);
@@ -542,6 +759,7 @@ TEST_CASE("CompressedOutput backward compatibility", "[output]") {
     // generateLatestCompressedOutput(true);
     testVersion(CompressedIoVersion::FIRST);
     testVersion(CompressedIoVersion::V2021_08_08);
+    testVersion(CompressedIoVersion::V2026_10_16);
 }
 
 TEST_CASE("CompressedInput getInfo", "[output]") {
@@ -562,6 +780,282 @@ TEST_CASE("CompressedInput getInfo", "[output]") {
     REQUIRE(info->runType == RunTypeEnum::SPH);
 }
 
+TEST_CASE("MappedInput binary", "[output]") {
+    Storage storage = generateLatestOutput();
+    RandomPathManager manager;
+    Path path = manager.getPath("ssf");
+    Statistics stats;
+    stats.set(StatisticsId::RUN_TIME, 12._f);
+    stats.set(StatisticsId::TIMESTEP_VALUE, 0.5_f);
+    stats.set(StatisticsId::WALLCLOCK_TIME, 3600);
+    REQUIRE(BinaryOutput(path).dump(storage, stats));
+    REQUIRE(MappedInput::isSupported(path));
+
+    Storage expected, loaded;
+    Statistics loadedStats;
+    REQUIRE(BinaryInput().load(path, expected, stats));
+    MappedInput input;
+    REQUIRE(input.load(path, loaded, loadedStats));
+    REQUIRE(loaded.getMaterialCnt() == expected.getMaterialCnt());
+    REQUIRE(loaded.getParticleCnt() == expected.getParticleCnt());
+    REQUIRE(loaded.getQuantityCnt() == expected.getQuantityCnt());
+    iteratePair<VisitorEnum::ALL_BUFFERS>(loaded, expected, [](auto& b1, auto& b2) { REQUIRE(b1 == b2); });
+    REQUIRE(loaded.getAttractorCnt() == expected.getAttractorCnt());
+    for (Size i = 0; i < loaded.getAttractorCnt(); ++i) {
+        REQUIRE(attractorsEqual(loaded.getAttractors()[i], expected.getAttractors()[i]));
+    }
+    REQUIRE(loadedStats.get<Float>(StatisticsId::RUN_TIME) == 12._f);
+    REQUIRE(loadedStats.get<Float>(StatisticsId::TIMESTEP_VALUE) == 0.5_f);
+    REQUIRE(loadedStats.get<int>(StatisticsId::WALLCLOCK_TIME) == 3600);
+
+    // range spanning both materials
+    const Size split = *expected.getMaterial(0).sequence().end();
+    const Size from = split - 20;
+    const Size to = split + 10;
+    MappedInput partialInput({ QuantityId::POSITION, QuantityId::DENSITY }, IndexSequence(from, to));
+    Storage partial;
+    REQUIRE(partialInput.load(path, partial, loadedStats));
+    REQUIRE(partial.getParticleCnt() == to - from);
+    REQUIRE(partial.getQuantityCnt() == 3); // including material IDs
+    REQUIRE(partial.getMaterialCnt() == 2);
+    REQUIRE(partial.getQuantity(QuantityId::POSITION).getOrderEnum() == OrderEnum::SECOND);
+    ArrayView<const Vector> r = expected.getValue<Vector>(QuantityId::POSITION);
+    ArrayView<const Vector> v = expected.getDt<Vector>(QuantityId::POSITION);
+    ArrayView<const Float> rho = expected.getValue<Float>(QuantityId::DENSITY);
+    ArrayView<const Vector> partialR = partial.getValue<Vector>(QuantityId::POSITION);
+    ArrayView<const Vector> partialV = partial.getDt<Vector>(QuantityId::POSITION);
+    ArrayView<const Float> partialRho = partial.getValue<Float>(QuantityId::DENSITY);
+    for (Size i = from; i < to; ++i) {
+        REQUIRE(partialR[i - from] == r[i]);
+        REQUIRE(partialV[i - from] == v[i]);
+        REQUIRE(partialRho[i - from] == rho[i]);
+    }
+
+    // loads the same file using the cached index
+    Storage mapped;
+    REQUIRE(partialInput.load(path, mapped, loadedStats));
+    REQUIRE(mapped.getParticleCnt() == to - from);
+
+    Optional<ArrayView<const Float>> mappedRho = input.map<Float>(path, QuantityId::DENSITY, OrderEnum::ZERO);
+    if (mappedRho) {
+        REQUIRE(mappedRho->size() == expected.getMaterial(0).sequence().size());
+        for (Size i = 0; i < mappedRho->size(); ++i) {
+            REQUIRE(mappedRho.value()[i] == rho[i]);
+        }
+    }
+    REQUIRE_FALSE(input.map<Float>(path, QuantityId::DENSITY, OrderEnum::ZERO, 5));
+    REQUIRE_FALSE(input.map<Float>(path, QuantityId::AV_ALPHA, OrderEnum::ZERO));
+
+    REQUIRE_FALSE(input.load(Path("nonexisting_file.ssf"), loaded, loadedStats));
+}
+
+TEST_CASE("MappedInput rewritten file", "[output]") {
+    Storage storage = Tests::getSolidStorage(100);
+    RandomPathManager manager;
+    Path path = manager.getPath("ssf");
+    Statistics stats;
+    REQUIRE(BinaryOutput(path).dump(storage, stats));
+
+    MappedInput input;
+    Storage loaded;
+    REQUIRE(input.load(path, loaded, stats));
+    REQUIRE(loaded.getValue<Float>(QuantityId::DENSITY) == storage.getValue<Float>(QuantityId::DENSITY));
+
+    // same file size, different content
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    storage.getValue<Float>(QuantityId::DENSITY).fill(5._f);
+    REQUIRE(BinaryOutput(path).dump(storage, stats));
+    REQUIRE(input.load(path, loaded, stats));
+    REQUIRE(loaded.getValue<Float>(QuantityId::DENSITY) == storage.getValue<Float>(QuantityId::DENSITY));
+
+    // changing the selection keeps the index
+    input.select({ QuantityId::DENSITY }, IndexSequence(10, 20));
+    REQUIRE(input.load(path, loaded, stats));
+    REQUIRE(loaded.getParticleCnt() == 10);
+    ArrayView<const Float> rho = loaded.getValue<Float>(QuantityId::DENSITY);
+    REQUIRE(std::all_of(rho.begin(), rho.end(), [](const Float value) { return value == 5._f; }));
+}
+
+TEST_CASE("MappedInput binary backward compatibility", "[output]") {
+    for (BinaryIoVersion version : { BinaryIoVersion::FIRST,
+             BinaryIoVersion::V2018_04_07,
+             BinaryIoVersion::V2018_10_24,
+             BinaryIoVersion::V2021_03_20,
+             BinaryIoVersion::V2021_08_08 }) {
+        Path path = RESOURCE_PATH / Path(toString(std::size_t(version)) + ".ssf");
+        Storage expected, loaded;
+        Statistics stats;
+        REQUIRE(BinaryInput().load(path, expected, stats));
+        REQUIRE(MappedInput().load(path, loaded, stats));
+        REQUIRE(loaded.getParticleCnt() == expected.getParticleCnt());
+        REQUIRE(loaded.getQuantityCnt() == expected.getQuantityCnt());
+        REQUIRE(loaded.getAttractorCnt() == expected.getAttractorCnt());
+        iteratePair<VisitorEnum::ALL_BUFFERS>(
+            loaded, expected, [](auto& b1, auto& b2) { REQUIRE(b1 == b2); });
+    }
+}
+
+static void testMappedCompression(const CompressionEnum compression) {
+    Storage storage = Tests::getSolidStorage(1200);
+    Statistics stats;
+    stats.set(StatisticsId::RUN_TIME, 5._f);
+    RandomPathManager manager;
+    Path path = manager.getPath("scf");
+    REQUIRE(CompressedOutput(path, compression).dump(storage, stats));
+
+    Storage expected, loaded;
+    REQUIRE(CompressedInput().load(path, expected, stats));
+    MappedInput input;
+    REQUIRE(input.load(path, loaded, stats));
+    REQUIRE(loaded.getParticleCnt() == expected.getParticleCnt());
+    REQUIRE(loaded.getQuantityCnt() == expected.getQuantityCnt());
+    iteratePair<VisitorEnum::ALL_BUFFERS>(loaded, expected, [](auto& b1, auto& b2) { REQUIRE(b1 == b2); });
+    REQUIRE_FALSE(input.map<Vector>(path, QuantityId::POSITION, OrderEnum::ZERO));
+
+    const Size from = 100;
+    const Size to = 400;
+    Storage partial;
+    REQUIRE(MappedInput({ QuantityId::ENERGY }, IndexSequence(from, to)).load(path, partial, stats));
+    REQUIRE(partial.getParticleCnt() == to - from);
+    REQUIRE_FALSE(partial.has(QuantityId::POSITION));
+    ArrayView<const Float> u = expected.getValue<Float>(QuantityId::ENERGY);
+    ArrayView<const Float> partialU = partial.getValue<Float>(QuantityId::ENERGY);
+    for (Size i = from; i < to; ++i) {
+        REQUIRE(partialU[i - from] == u[i]);
+    }
+}
+
+TEST_CASE("MappedInput compressed", "[output]") {
+    testMappedCompression(CompressionEnum::NONE);
+    testMappedCompression(CompressionEnum::RLE);
+    testMappedCompression(CompressionEnum::XOR_SHUFFLE);
+    testMappedCompression(CompressionEnum::QUANTIZED);
+}
+
+TEST_CASE("ArchiveOutput dump", "[output]") {
+    RandomPathManager manager;
+    const Path path = manager.getPath("sar");
+    ArchiveOutput output(OutputFile{ path });
+
+    Array<Storage> dumped;
+    for (Size i = 0; i < 3; ++i) {
+        Storage storage = generateLatestOutput();
+        ArrayView<Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+        for (Size j = 0; j < r.size(); ++j) {
+            r[j] += Vector(Float(i), 0._f, 0._f);
+        }
+        Statistics stats;
+        stats.set(StatisticsId::RUN_TIME, 10._f * i);
+        stats.set(StatisticsId::TIMESTEP_VALUE, 0.5_f);
+        Expected<Path> dumpPath = output.dump(storage, stats);
+        REQUIRE(dumpPath);
+        REQUIRE(dumpPath.value() == path);
+        dumped.push(std::move(storage));
+    }
+
+    ArchiveInput input;
+    REQUIRE(input.getFrameCnt(path).value() == 3);
+    for (Size i = 0; i < 3; ++i) {
+        Storage loaded;
+        Statistics stats;
+        REQUIRE(input.loadFrame(path, i, loaded, stats));
+        REQUIRE(stats.get<Float>(StatisticsId::RUN_TIME) == 10._f * i);
+        REQUIRE(loaded.getMaterialCnt() == dumped[i].getMaterialCnt());
+        REQUIRE(loaded.getQuantityCnt() == dumped[i].getQuantityCnt());
+        REQUIRE(loaded.getAttractorCnt() == dumped[i].getAttractorCnt());
+        iteratePair<VisitorEnum::ALL_BUFFERS>(
+            loaded, dumped[i], [](auto& b1, auto& b2) { REQUIRE(b1 == b2); });
+        REQUIRE(input.getFrameInfo(path, i)->runTime == 10._f * i);
+        REQUIRE(input.getFrameInfo(path, i)->particleCnt == dumped[i].getParticleCnt());
+    }
+    Storage loaded;
+    Statistics stats;
+    REQUIRE_FALSE(input.loadFrame(path, 3, loaded, stats));
+    REQUIRE_FALSE(input.getFrameInfo(path, 3));
+
+    // last frame
+    REQUIRE(Factory::getInput(path)->load(path, loaded, stats));
+    REQUIRE(stats.get<Float>(StatisticsId::RUN_TIME) == 20._f);
+
+    REQUIRE(input.findFrame(path, -5._f).value() == 0);
+    REQUIRE(input.findFrame(path, 10._f).value() == 1);
+    REQUIRE(input.findFrame(path, 15._f).value() == 1);
+    REQUIRE(input.findFrame(path, 100._f).value() == 2);
+
+    // quantity and particle selection
+    ArchiveInput partialInput({ QuantityId::DENSITY }, IndexSequence(10, 20));
+    REQUIRE(partialInput.loadFrame(path, 1, loaded, stats));
+    REQUIRE(loaded.getParticleCnt() == 10);
+    REQUIRE(loaded.has(QuantityId::DENSITY));
+    REQUIRE_FALSE(loaded.has(QuantityId::POSITION));
+    ArrayView<const Float> rho = dumped[1].getValue<Float>(QuantityId::DENSITY);
+    REQUIRE(ArrayView<const Float>(loaded.getValue<Float>(QuantityId::DENSITY)) == rho.subset(10, 10));
+
+    REQUIRE_FALSE(input.getFrameCnt(Path("nonexisting_file.sar")));
+}
+
+TEST_CASE("ArchiveOutput append", "[output]") {
+    RandomPathManager manager;
+    const Path path = manager.getPath("sar");
+    Storage storage = Tests::getGassStorage(100);
+    Statistics stats;
+
+    ArchiveInput input;
+    {
+        ArchiveOutput output(OutputFile{ path });
+        stats.set(StatisticsId::RUN_TIME, 1._f);
+        REQUIRE(output.dump(storage, stats));
+        REQUIRE(input.getFrameCnt(path).value() == 1);
+
+        // the reader sees frames appended after it indexed the archive
+        stats.set(StatisticsId::RUN_TIME, 2._f);
+        REQUIRE(output.dump(storage, stats));
+        REQUIRE(input.getFrameCnt(path).value() == 2);
+    }
+
+    // resumed run continues in the archive
+    ArchiveOutput output(OutputFile{ path });
+    stats.set(StatisticsId::RUN_TIME, 3._f);
+    REQUIRE(output.dump(storage, stats));
+    REQUIRE(input.getFrameCnt(path).value() == 3);
+    for (Size i = 0; i < 3; ++i) {
+        Storage loaded;
+        REQUIRE(input.loadFrame(path, i, loaded, stats));
+        REQUIRE(stats.get<Float>(StatisticsId::RUN_TIME) == Float(i + 1));
+        REQUIRE(loaded.getParticleCnt() == storage.getParticleCnt());
+    }
+
+    // run resumed from an earlier time replaces the newer frames
+    {
+        ArchiveOutput resumedOutput(OutputFile{ path });
+        stats.set(StatisticsId::RUN_TIME, 2.5_f);
+        REQUIRE(resumedOutput.dump(storage, stats));
+        REQUIRE(input.getFrameCnt(path).value() == 3);
+        REQUIRE(input.getFrameInfo(path, 2)->runTime == 2.5_f);
+        REQUIRE(input.findFrame(path, 2.7_f).value() == 2);
+
+        stats.set(StatisticsId::RUN_TIME, 3.5_f);
+        REQUIRE(resumedOutput.dump(storage, stats));
+        REQUIRE(input.getFrameCnt(path).value() == 4);
+        for (Size i = 0; i < 4; ++i) {
+            REQUIRE(input.getFrameInfo(path, i)->runTime == (i < 2 ? Float(i + 1) : Float(i) + 0.5_f));
+        }
+    }
+
+    // wildcards are removed from the mask
+    ArchiveOutput maskedOutput(OutputFile(path.parentPath() / Path("archive_%d.sar")));
+    Expected<Path> maskedPath = maskedOutput.dump(storage, stats);
+    REQUIRE(maskedPath);
+    REQUIRE(maskedPath.value() == path.parentPath() / Path("archive.sar"));
+    FileSystem::removePath(maskedPath.value());
+
+    // not an archive
+    Path binaryPath = manager.getPath("sar");
+    REQUIRE(BinaryOutput(binaryPath).dump(storage, stats));
+    REQUIRE_FALSE(ArchiveOutput(OutputFile(binaryPath)).dump(storage, stats));
+    REQUIRE_FALSE(input.getFrameCnt(binaryPath));
+}
+
 TEST_CASE("Pkdgrav output", "[output]") {
     BodySettings settings;
     settings.set(BodySettingsId::ENERGY, 50._f);
@@ -619,11 +1113,41 @@ TEST_CASE("Pkdgrav load", "[output]") {
     REQUIRE(perElement(rho) > 2600._f);*/
 }
 
+TEST_CASE("Mpcorp load", "[output]") {
+    RandomPathManager manager;
+    Path path = manager.getPath("dat");
+    std::ofstream ofs(path.native());
+    ofs << "MINOR PLANET CENTER ORBIT DATABASE (MPCORB)\n\n"
+        << "Des'n     H     G   Epoch     M        Peri.      Node       Incl.       e            n           a\n"
+        << "----------------------------------------------------------------------------------------------------\n"
+        << "00001    3.33  0.15 K2555 188.70269   73.27343   80.25221   10.58780  0.0794013  0.21424651   "
+           "2.7660512  0 MPO719049  7330 125 1801-2024 0.65 M-v 30k MPCLINUX   4003      (1) Ceres\n"
+        << "\n"
+        << "00002    4.12  0.15 K2555 168.80064  310.91048  172.88859   34.92832  0.2306460  0.21385698   "
+           "2.7693974  0 MPO802509  8869 122 1804-2024 0.60 M-c 28k MPCLINUX   0000      (2) Pallas\n"
+        << "invalid line\n";
+    ofs.close();
+
+    MpcorpInput input(2700._f, 0.2_f, makeShared<ThreadPool>(4));
+    Storage storage;
+    Statistics stats;
+    REQUIRE(input.load(path, storage, stats));
+    REQUIRE(storage.getParticleCnt() == 2);
+    ArrayView<const Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+    const Float a1 = 2.7660512_f * Constants::au;
+    const Float e1 = 0.0794013_f;
+    REQUIRE(getLength(r[0]) >= a1 * (1._f - e1));
+    REQUIRE(getLength(r[0]) <= a1 * (1._f + e1));
+    REQUIRE(r[0][H] > r[1][H]);
+    REQUIRE(storage.getValue<Size>(QuantityId::FLAG) == Array<Size>({ 3, 0 }));
+}
+
 TEST_CASE("Output to unicode path", "[output]") {
     RunSettings settings;
     settings.set(RunSettingsId::RUN_OUTPUT_PATH, L"output\u03B1"_s);
 
-    for (IoEnum type : { IoEnum::TEXT_FILE, IoEnum::DATA_FILE, IoEnum::BINARY_FILE }) {
+    for (IoEnum type :
+        { IoEnum::TEXT_FILE, IoEnum::DATA_FILE, IoEnum::BINARY_FILE, IoEnum::ARCHIVE_FILE }) {
         settings.set(RunSettingsId::RUN_OUTPUT_TYPE, type);
         String ext = getIoExtension(type).value();
         INFO("Testing type " + ext);
@@ -698,3 +1222,125 @@ TEST_CASE("OutputFile getMaskFromPath", "[output]") {
     REQUIRE_FALSE(OutputFile::getMaskFromPath(Path("")));
     REQUIRE_FALSE(OutputFile::getMaskFromPath(Path("45786")));
 }
+
+namespace {
+class MockOutput : public IOutput {
+private:
+    std::atomic<Size>& writtenCnt;
+    bool fail;
+
+public:
+    MockOutput(const OutputFile& fileMask, std::atomic<Size>& writtenCnt, const bool fail = false)
+        : IOutput(fileMask)
+        , writtenCnt(writtenCnt)
+        , fail(fail) {}
+
+    virtual Expected<Path> dump(const Storage& UNUSED(storage), const Statistics& stats) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ++writtenCnt;
+        if (fail) {
+            throw IoError("write failed");
+        }
+        return paths.getNextPath(stats);
+    }
+};
+} // namespace
+
+TEST_CASE("AsyncOutput dump", "[output]") {
+    RandomPathManager manager;
+    const Path mask = Path(String("async_") + manager.getPath().string() + "_%d.ssf");
+    AsyncOutput output(mask, makeAuto<BinaryOutput>(mask), ThreadPool::getGlobalInstance(), 2);
+
+    Storage storage;
+    storage.insert<Vector>(
+        QuantityId::POSITION, OrderEnum::SECOND, makeArray(Vector(0._f), Vector(1._f), Vector(2._f)));
+    storage.insert<Float>(QuantityId::DENSITY, OrderEnum::FIRST, 0._f);
+    Statistics stats;
+    stats.set(StatisticsId::TIMESTEP_VALUE, 0.1_f);
+    Array<Path> paths;
+    for (Size i = 0; i < 4; ++i) {
+        stats.set(StatisticsId::RUN_TIME, Float(i));
+        storage.getValue<Float>(QuantityId::DENSITY).fill(Float(i));
+        Expected<Path> path = output.dump(storage, stats);
+        REQUIRE(path);
+        paths.push(path.value());
+    }
+    REQUIRE(output.flush());
+
+    for (Size i = 0; i < paths.size(); ++i) {
+        REQUIRE(paths[i] == OutputFile(mask, i).getNextPath(stats));
+        Storage loaded;
+        Statistics loadedStats;
+        REQUIRE(BinaryInput().load(paths[i], loaded, loadedStats));
+        REQUIRE(
+            loaded.getValue<Vector>(QuantityId::POSITION) == storage.getValue<Vector>(QuantityId::POSITION));
+        REQUIRE(perElement(loaded.getValue<Float>(QuantityId::DENSITY)) == Float(i));
+        REQUIRE(loadedStats.get<Float>(StatisticsId::RUN_TIME) == Float(i));
+        FileSystem::removePath(paths[i]);
+    }
+}
+
+TEST_CASE("AsyncOutput archive", "[output]") {
+    RandomPathManager manager;
+    const Path mask = Path(String("async_") + manager.getPath().string() + "_%d.sar");
+    Expected<Path> path = makeUnexpected<Path>("");
+    {
+        AsyncOutput output(mask, makeAuto<ArchiveOutput>(mask), ThreadPool::getGlobalInstance(), 2);
+        Storage storage = Tests::getStorage(50);
+        Statistics stats;
+        stats.set(StatisticsId::RUN_TIME, 0._f);
+        path = output.dump(storage, stats);
+        REQUIRE(path);
+        Expected<Path> nextPath = output.dump(storage, stats);
+        REQUIRE(nextPath);
+        REQUIRE(nextPath.value() == path.value());
+        REQUIRE(output.flush());
+    }
+    // returned path is the path of the archive, not generated from the mask
+    REQUIRE(path->string().find("%d") == String::npos);
+    REQUIRE(path.value() != OutputFile(mask).getNextPath(Statistics()));
+    REQUIRE(FileSystem::pathExists(path.value()));
+    Expected<Size> frameCnt = ArchiveInput().getFrameCnt(path.value());
+    REQUIRE(frameCnt);
+    REQUIRE(frameCnt.value() == 2);
+    FileSystem::removePath(path.value());
+}
+
+TEST_CASE("AsyncOutput limited snapshots", "[output]") {
+    std::atomic<Size> writtenCnt{ 0 };
+    const Path mask("async_%d.ssf");
+    Storage storage;
+    storage.insert<Float>(QuantityId::DENSITY, OrderEnum::ZERO, Array<Float>{ 1._f, 2._f });
+    Statistics stats;
+    stats.set(StatisticsId::RUN_TIME, 0._f);
+    {
+        AsyncOutput output(mask, makeAuto<MockOutput>(mask, writtenCnt), ThreadPool::getGlobalInstance(), 1);
+        for (Size i = 0; i < 3; ++i) {
+            REQUIRE(output.dump(storage, stats));
+        }
+        // with a single staging storage, each dump has to wait for the previous snapshot to be written
+        REQUIRE(writtenCnt >= 2);
+        REQUIRE(output.flush());
+        REQUIRE(writtenCnt == 3);
+        REQUIRE(output.dump(storage, stats));
+    }
+    // destructor writes the remaining snapshot
+    REQUIRE(writtenCnt == 4);
+}
+
+TEST_CASE("AsyncOutput error", "[output]") {
+    std::atomic<Size> writtenCnt{ 0 };
+    const Path mask("async_%d.ssf");
+    Storage storage;
+    storage.insert<Float>(QuantityId::DENSITY, OrderEnum::ZERO, Array<Float>{ 1._f, 2._f });
+    Statistics stats;
+    stats.set(StatisticsId::RUN_TIME, 0._f);
+    AsyncOutput output(
+        mask, makeAuto<MockOutput>(mask, writtenCnt, true), ThreadPool::getGlobalInstance(), 1);
+    REQUIRE(output.dump(storage, stats));
+    REQUIRE_FALSE(output.dump(storage, stats));
+    const Outcome result = output.flush();
+    REQUIRE_FALSE(result);
+    REQUIRE(result.error() == "write failed");
+    REQUIRE(output.flush());
+}
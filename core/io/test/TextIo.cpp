@@ -0,0 +1,207 @@
+#include "io/TextIo.h"
+#include "catch.hpp"
+#include "math/rng/Rng.h"
+#include "thread/Pool.h"
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+using namespace Sph;
+
+static std::string formatString(const double value, const bool scientific = false) {
+    char buffer[TextIo::MAX_NUMBER_LENGTH];
+    char* end = TextIo::formatFloat(buffer, value, scientific);
+    return std::string(buffer, end);
+}
+
+/// Returns the bit pattern of the value; special values are compared bitwise, as std::isnan and similar
+/// functions may be folded into constants when compiled with -ffast-math.
+static uint64_t getBits(const double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static constexpr uint64_t INF_BITS = uint64_t(0x7FF) << 52;
+static constexpr uint64_t SIGN_BIT = uint64_t(1) << 63;
+
+static double fromBits(const uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static bool isNanBits(const uint64_t bits) {
+    return (bits & ~SIGN_BIT) > INF_BITS;
+}
+
+static Optional<double> parseString(const std::string& str) {
+    double value;
+    const char* end = TextIo::parseFloat(str.data(), str.data() + str.size(), value);
+    if (end != str.data() + str.size()) {
+        return NOTHING;
+    }
+    return value;
+}
+
+TEST_CASE("TextIo parseFloat", "[textio]") {
+    REQUIRE(parseString("1.5").value() == 1.5);
+    REQUIRE(parseString("  \t-2.25e-3").value() == -2.25e-3);
+    REQUIRE(parseString("+.5").value() == 0.5);
+    REQUIRE(parseString("3.").value() == 3.);
+    REQUIRE(parseString("1E+10").value() == 1.e10);
+    REQUIRE(parseString("0.1").value() == 0.1);
+    REQUIRE(parseString("123456789012345678901234567890").value() == 123456789012345678901234567890.);
+    REQUIRE(parseString("0.000000000000000000000000000123456789012345678901").value() ==
+            0.000000000000000000000000000123456789012345678901);
+    REQUIRE(parseString("2.2250738585072014e-308").value() == 2.2250738585072014e-308);
+    REQUIRE(getBits(parseString("1e400").value()) == INF_BITS);
+    REQUIRE(getBits(parseString("-inf").value()) == (INF_BITS | SIGN_BIT));
+    REQUIRE(getBits(parseString("Infinity").value()) == INF_BITS);
+    REQUIRE(isNanBits(getBits(parseString("nan").value())));
+    REQUIRE(getBits(parseString("-0").value()) == SIGN_BIT);
+
+    REQUIRE_FALSE(parseString(""));
+    REQUIRE_FALSE(parseString("abc"));
+    REQUIRE_FALSE(parseString("-"));
+    REQUIRE_FALSE(parseString("."));
+
+    // exponent without digits is not a part of the number
+    const std::string str = "2e+x";
+    double value;
+    REQUIRE(TextIo::parseFloat(str.data(), str.data() + str.size(), value) == str.data() + 1);
+    REQUIRE(value == 2.);
+
+    // does not read past the end of the input
+    REQUIRE(TextIo::parseFloat(str.data(), str.data() + 1, value) == str.data() + 1);
+}
+
+TEST_CASE("TextIo parseFloat consistent with strtod", "[textio]") {
+    UniformRng rng;
+    for (Size i = 0; i < 100000; ++i) {
+        const double mantissa = 1. + rng() * 9.;
+        const int exponent = int(rng() * 600) - 300;
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(i % 20);
+        ss << mantissa << "e" << exponent;
+        const std::string str = ss.str();
+        REQUIRE(parseString(str).value() == std::strtod(str.c_str(), nullptr));
+    }
+}
+
+TEST_CASE("TextIo parseIndex", "[textio]") {
+    const std::string str = " 1234 56";
+    Size value;
+    const char* end = TextIo::parseIndex(str.data(), str.data() + str.size(), value);
+    REQUIRE(value == 1234);
+    end = TextIo::parseIndex(end, str.data() + str.size(), value);
+    REQUIRE(value == 56);
+    REQUIRE(end == str.data() + str.size());
+    REQUIRE_FALSE(TextIo::parseIndex(end, end, value));
+
+    const std::string negative = "-5";
+    REQUIRE_FALSE(TextIo::parseIndex(negative.data(), negative.data() + negative.size(), value));
+}
+
+TEST_CASE("TextIo formatFloat", "[textio]") {
+    REQUIRE(formatString(0.) == "0");
+    REQUIRE(formatString(fromBits(SIGN_BIT)) == "-0");
+    REQUIRE(formatString(0.1) == "0.1");
+    REQUIRE(formatString(-2.5) == "-2.5");
+    REQUIRE(formatString(100.) == "100");
+    REQUIRE(formatString(123.456) == "123.456");
+    REQUIRE(formatString(1.e-5) == "0.00001");
+    REQUIRE(formatString(1.e-7) == "1e-07");
+    REQUIRE(formatString(1.e20) == "1e+20");
+    REQUIRE(formatString(1.5e-300) == "1.5e-300");
+    REQUIRE(formatString(1. / 3.) == "0.3333333333333333");
+    REQUIRE(formatString(0.1, true) == "1e-01");
+    REQUIRE(formatString(1234.5, true) == "1.2345e+03");
+    REQUIRE(formatString(fromBits(INF_BITS)) == "inf");
+    REQUIRE(formatString(fromBits(INF_BITS | SIGN_BIT)) == "-inf");
+    REQUIRE(formatString(fromBits(INF_BITS | 1)) == "nan");
+
+    char buffer[TextIo::MAX_NUMBER_LENGTH];
+    char* end = TextIo::formatFloat(buffer, 0.1f);
+    REQUIRE(std::string(buffer, end) == "0.1");
+}
+
+TEST_CASE("TextIo formatFloat roundtrip", "[textio]") {
+    UniformRng rng;
+    for (Size i = 0; i < 100000; ++i) {
+        uint64_t bits = 0;
+        for (Size j = 0; j < 4; ++j) {
+            bits = (bits << 16) | uint64_t(rng() * 65536.);
+        }
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        if ((bits & INF_BITS) == INF_BITS) {
+            // infinity or NaN
+            continue;
+        }
+        for (bool scientific : { false, true }) {
+            const std::string str = formatString(value, scientific);
+            REQUIRE(str.size() <= TextIo::MAX_NUMBER_LENGTH);
+            REQUIRE(parseString(str).value() == value);
+        }
+    }
+}
+
+TEST_CASE("TextIo appendFloat", "[textio]") {
+    Array<char> buffer;
+    TextIo::appendFloat(buffer, 1.5_f, 6);
+    TextIo::appendIndex(buffer, 12, 4);
+    TextIo::appendFloat(buffer, 1._f / 3._f, 6);
+    REQUIRE(std::string(&buffer[0], buffer.size()) == "   1.5  12 " + formatString(1._f / 3._f));
+}
+
+TEST_CASE("TextIo LineIndex", "[textio]") {
+    const std::string text = "# header\n1 2\n\n  # comment\r\n3 4\r\n  \n5 6";
+    for (Size threadCnt : { 1, 4 }) {
+        ThreadPool pool(threadCnt);
+        TextIo::LineIndex lines(pool, ArrayView<const char>(text.data(), Size(text.size())));
+        REQUIRE(lines.size() == 3);
+        Array<std::string> parsed(3);
+        REQUIRE_FALSE(lines.forEach(pool, [&parsed](const Size i, const char* begin, const char* end) {
+            parsed[i] = std::string(begin, end);
+            return true;
+        }));
+        REQUIRE(parsed[0] == "1 2");
+        REQUIRE(parsed[1] == "3 4");
+        REQUIRE(parsed[2] == "5 6");
+
+        Optional<Size> failed = lines.forEach(pool, [](const Size i, const char*, const char*) { //
+            return i != 1;
+        });
+        REQUIRE(failed.value() == 1);
+    }
+
+    ThreadPool pool(1);
+    REQUIRE(TextIo::LineIndex(pool, ArrayView<const char>()).size() == 0);
+}
+
+TEST_CASE("TextIo parallel lines", "[textio]") {
+    // large enough to be split into several chunks
+    const Size lineCnt = 100000;
+    ThreadPool pool(4);
+    std::ostringstream ss;
+    TextIo::writeLines(pool, ss, lineCnt, [](const Size i, Array<char>& buffer) {
+        TextIo::appendIndex(buffer, i, 10);
+        TextIo::appendFloat(buffer, Float(i) / 7._f, 25);
+        buffer.push('\n');
+    });
+    const std::string text = ss.str();
+
+    TextIo::LineIndex lines(pool, ArrayView<const char>(text.data(), Size(text.size())));
+    REQUIRE(lines.size() == lineCnt);
+    Array<Size> indices(lineCnt);
+    Array<double> values(lineCnt);
+    REQUIRE_FALSE(lines.forEach(pool, [&](const Size i, const char* begin, const char* end) {
+        begin = TextIo::parseIndex(begin, end, indices[i]);
+        return begin && TextIo::parseFloat(begin, end, values[i]) == end;
+    }));
+    for (Size i = 0; i < lineCnt; ++i) {
+        REQUIRE(indices[i] == i);
+        REQUIRE(values[i] == double(Float(i) / 7._f));
+    }
+}
@@ -4,6 +4,8 @@
 #include "objects/geometry/Box.h"
 #include "objects/geometry/Indices.h"
 #include "objects/wrappers/AutoPtr.h"
+#include "thread/ThreadLocal.h"
+#include <algorithm>
 
 NAMESPACE_SPH_BEGIN
 
@@ -70,6 +72,9 @@ public:
 inline bool intersectBox(const Box& box, const RaySegment& ray, Interval& segment);
 
 
+struct BvhBuildItem;
+struct BvhBounds;
+
 struct BvhPrimitive {
     /// Generic user data, can be used to store additional information to the primitives.
     Size userData = Size(-1);
@@ -215,18 +220,17 @@ public:
     }
 };
 
-/// \brief Simple bounding volume hierarchy.
+/// \brief Bounding volume hierarchy.
 ///
-/// Interface for finding an intersection of given ray with a set of geometric objects. Currently very
-/// limited and not very optimized. \ref Bvh is explicitly specialized for \ref BvhSphere and \ref BvhBox; if
-/// other geometric primitives are needed, either add the specialization to cpp, or move the implementation to
-/// header.
+/// Interface for finding an intersection of given ray with a set of geometric objects. The hierarchy is
+/// constructed top-down, splitting the nodes using the surface area heuristic (SAH) evaluated in bins of
+/// object centers. The top part of the tree is built in parallel, including the binning of objects in large
+/// nodes. For sets of objects that change only slightly (e.g. particles in subsequent frames of an
+/// animation), the hierarchy can be refitted instead of rebuilt, see \ref refit.
 template <typename TBvhObject>
 class Bvh : public Noncopyable {
 private:
     const Size leafSize;
-    Size nodeCnt = 0;
-    Size leafCnt = 0;
 
     Array<TBvhObject> objects;
 
@@ -239,6 +243,26 @@ private:
 
     Array<BvhNode> nodes;
 
+    /// Indices of objects in the array passed to \ref build, in the order of the stored objects
+    Array<Size> order;
+
+    /// SAH cost of leafs after the last build, relative to the surface area of the root node
+    Float leafCost = 0._f;
+
+    /// Number of bins used to evaluate the SAH
+    static constexpr Size BIN_CNT = 16;
+
+    /// Nodes with more objects are built (and refitted) in parallel
+    static constexpr Size PARALLEL_CNT = 8192;
+
+    /// Maximal depth of nodes split using the SAH; deeper nodes are split by the median to limit the depth
+    static constexpr Size MAX_SAH_DEPTH = 64;
+
+    /// Maximal allowed growth of the leaf cost by \ref refit before the hierarchy is rebuilt
+    static constexpr Float MAX_REFIT_COST_GROWTH = 2._f;
+
+    struct BuildNode;
+
 public:
     explicit Bvh(const Size leafSize = 4)
         : leafSize(leafSize) {}
@@ -248,6 +272,17 @@ public:
     /// This erased previously stored objects.
     void build(Array<TBvhObject>&& objects);
 
+    /// \brief Contructs the BVH from given set of objects, using given scheduler for parallelization.
+    void build(IScheduler& scheduler, Array<TBvhObject>&& objects);
+
+    /// \brief Updates the BVH with given set of objects, keeping the hierarchy created by \ref build.
+    ///
+    /// The objects must be passed in the same order as in \ref build and their number must not change,
+    /// only the geometry of the objects may differ. Bounding boxes of all nodes are recomputed bottom-up.
+    /// If the number of objects changed or the boxes of the nodes grew too much, the BVH is rebuilt instead.
+    /// \return True if the BVH has been refitted, false if it has been rebuilt.
+    bool refit(IScheduler& scheduler, Array<TBvhObject>&& objects);
+
     /// \brief Finds the closest intersection of the ray.
     ///
     /// Returns true if an intersection has been found.
@@ -269,8 +304,48 @@ public:
     /// \brief Returns true if the ray is occluded by some geometry
     bool isOccluded(const RaySegment& ray) const;
 
+    /// \brief Finds all objects with bounding box intersecting given box.
+    ///
+    /// The functor is called for each found object, the order of objects is unspecified. The function does
+    /// not modify the BVH, so multiple queries can be executed concurrently.
+    template <typename TAddOverlap>
+    void getOverlaps(const Box& box, const TAddOverlap& addOverlap) const;
+
     /// \brief Returns the bounding box of all objects in BVH.
     Box getBoundingBox() const;
+
+private:
+    /// \brief Finds intersections of the ray, skipping nodes farther than given distance.
+    ///
+    /// The distance is passed by reference, so that it can be updated by the functor during the traversal.
+    template <typename TAddIntersection>
+    void traverse(const RaySegment& ray, const TAddIntersection& addIntersection, const Float& t_max) const;
+
+    void buildNode(IScheduler& scheduler, ArrayView<BvhBuildItem> items, BuildNode& node, const Size depth);
+
+    void buildSubtree(ArrayView<BvhBuildItem> items,
+        Array<BvhNode>& subtree,
+        const Size start,
+        const Size end,
+        const BvhBounds& bounds,
+        const Size depth);
+
+    /// \brief Splits the objects of an inner node into two groups.
+    ///
+    /// Returns the index of the first object of the right child and the bounds of both children.
+    Size split(IScheduler& scheduler,
+        ArrayView<BvhBuildItem> items,
+        const BvhNode& node,
+        const BvhBounds& bounds,
+        const Size depth,
+        BvhBounds& leftBounds,
+        BvhBounds& rightBounds);
+
+    void copyNodes(IScheduler& scheduler, const BuildNode& node, const Size offset);
+
+    void refitNode(IScheduler& scheduler, const Size nodeIdx);
+
+    Float getLeafCost(IScheduler& scheduler) const;
 };
 
 NAMESPACE_SPH_END
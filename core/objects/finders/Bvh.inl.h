@@ -7,12 +7,68 @@ struct BvhTraversal {
     Float t_min;
 };
 
-struct BvhBuildEntry {
-    Size parent;
-    Size start;
-    Size end;
+/// \brief Bounding box of objects and of their centers.
+struct BvhBounds {
+    Box box;
+    Box centers;
+
+    BvhBounds& operator+=(const BvhBounds& other) {
+        box.extend(other.box);
+        centers.extend(other.centers);
+        return *this;
+    }
 };
 
+/// \brief Bins of object centers along one dimension, used to evaluate the surface area heuristic.
+template <Size BinCnt>
+struct BvhBins {
+    BvhBounds bounds[BinCnt];
+    Size counts[BinCnt] = {};
+
+    BvhBins& operator+=(const BvhBins& other) {
+        for (Size i = 0; i < BinCnt; ++i) {
+            bounds[i] += other.bounds[i];
+            counts[i] += other.counts[i];
+        }
+        return *this;
+    }
+};
+
+/// \brief Object processed by the build; objects are not moved during the build, only these proxies.
+struct BvhBuildItem {
+    Box box;
+    Size index;
+};
+
+INLINE Float getSurfaceArea(const Box& box) {
+    const Vector size = box.size();
+    return 2._f * (size[X] * size[Y] + size[Y] * size[Z] + size[Z] * size[X]);
+}
+
+/// \brief Executes the functor for all indices in the range and sums up the values computed by threads.
+///
+/// Small ranges are processed sequentially.
+template <typename T, typename TFunctor>
+T reduceBvhRange(IScheduler& scheduler,
+    const Size from,
+    const Size to,
+    const Size minParallelCnt,
+    TFunctor&& functor) {
+    T result;
+    if (to - from < minParallelCnt) {
+        for (Size i = from; i < to; ++i) {
+            functor(i, result);
+        }
+        return result;
+    }
+    ThreadLocal<T> locals(scheduler);
+    parallelFor(scheduler, locals, from, to, minParallelCnt / 8, functor);
+    for (const T& local : locals) {
+        result += local;
+    }
+    return result;
+}
+
 bool intersectBox(const Box& box, const RaySegment& ray, Interval& segment) {
     StaticArray<Vector, 2> b = { box.lower(), box.upper() };
     Float tmin = (b[ray.signs[X]][X] - ray.orig[X]) * ray.invDir[X];
@@ -47,10 +103,19 @@ bool intersectBox(const Box& box, const RaySegment& ray, Interval& segment) {
 template <typename TBvhObject>
 template <typename TAddIntersection>
 void Bvh<TBvhObject>::getIntersections(const RaySegment& ray, const TAddIntersection& addIntersection) const {
+    const Float t_max = INFTY;
+    this->traverse(ray, addIntersection, t_max);
+}
+
+template <typename TBvhObject>
+template <typename TAddIntersection>
+void Bvh<TBvhObject>::traverse(const RaySegment& ray,
+    const TAddIntersection& addIntersection,
+    const Float& t_max) const {
     Size closer;
     Size other;
 
-    StaticArray<BvhTraversal, 64> stack;
+    StaticArray<BvhTraversal, 128> stack;
     int stackIdx = 0;
 
     stack[stackIdx].idx = 0;
@@ -58,7 +123,12 @@ void Bvh<TBvhObject>::getIntersections(const RaySegment& ray, const TAddIntersec
 
     while (stackIdx >= 0) {
         const Size idx = stack[stackIdx].idx;
+        const Float t_min = stack[stackIdx].t_min;
         stackIdx--;
+        if (t_min > t_max) {
+            // cannot contain intersections closer than the ones already found
+            continue;
+        }
         const BvhNode& node = nodes[idx];
 
         /// \todo optimization for the single intersection case
@@ -109,12 +179,13 @@ bool Bvh<TBvhObject>::getFirstIntersection(const RaySegment& ray, IntersectionIn
     intersection.t = INFTY;
     intersection.object = nullptr;
 
-    this->getIntersections(ray, [&intersection](IntersectionInfo& current) {
+    auto addIntersection = [&intersection](IntersectionInfo& current) {
         if (current.t < intersection.t) {
             intersection = current;
         }
         return true;
-    });
+    };
+    this->traverse(ray, addIntersection, intersection.t);
     return intersection.object != nullptr;
 }
 
@@ -142,87 +213,323 @@ bool Bvh<TBvhObject>::isOccluded(const RaySegment& ray) const {
 }
 
 template <typename TBvhObject>
-void Bvh<TBvhObject>::build(Array<TBvhObject>&& objs) {
-    objects = std::move(objs);
-    SPH_ASSERT(!objects.empty());
-    nodeCnt = 0;
-    leafCnt = 0;
-
-    StaticArray<BvhBuildEntry, 128> stack;
-    Size stackIdx = 0;
-    constexpr Size UNTOUCHED = 0xffffffff;
-    constexpr Size NO_PARENT = 0xfffffffc;
-    constexpr Size TOUCHED_TWICE = 0xfffffffd;
-
-    // Push the root
-    stack[stackIdx].start = 0;
-    stack[stackIdx].end = objects.size();
-    stack[stackIdx].parent = NO_PARENT;
-    stackIdx++;
+template <typename TAddOverlap>
+void Bvh<TBvhObject>::getOverlaps(const Box& box, const TAddOverlap& addOverlap) const {
+    if (nodes.empty() || !nodes[0].box.overlaps(box)) {
+        return;
+    }
 
-    BvhNode node;
-    Array<BvhNode> buildNodes;
-    buildNodes.reserve(2 * objects.size());
-
-    while (stackIdx > 0) {
-        BvhBuildEntry& nodeEntry = stack[--stackIdx];
-        const Size start = nodeEntry.start;
-        const Size end = nodeEntry.end;
-        const Size primCnt = end - start;
-
-        nodeCnt++;
-        node.start = start;
-        node.primCnt = primCnt;
-        node.rightOffset = UNTOUCHED;
-
-        Box bbox = objects[start].getBBox();
-        const Vector center = objects[start].getCenter();
-        Box boxCenter(center, center);
-        for (Size i = start + 1; i < end; ++i) {
-            bbox.extend(objects[i].getBBox());
-            boxCenter.extend(objects[i].getCenter());
-        }
-        node.box = bbox;
+    StaticArray<Size, 128> stack;
+    int stackIdx = 0;
+    stack[stackIdx] = 0;
 
-        if (primCnt <= leafSize) {
-            node.rightOffset = 0;
-            leafCnt++;
+    while (stackIdx >= 0) {
+        const Size idx = stack[stackIdx];
+        stackIdx--;
+        const BvhNode& node = nodes[idx];
+
+        if (node.rightOffset == 0) {
+            // leaf
+            for (Size primIdx = 0; primIdx < node.primCnt; ++primIdx) {
+                const TBvhObject& obj = objects[node.start + primIdx];
+                if (obj.getBBox().overlaps(box)) {
+                    addOverlap(obj);
+                }
+            }
+        } else {
+            // inner node
+            if (nodes[idx + node.rightOffset].box.overlaps(box)) {
+                stack[++stackIdx] = idx + node.rightOffset;
+            }
+            if (nodes[idx + 1].box.overlaps(box)) {
+                stack[++stackIdx] = idx + 1;
+            }
         }
-        buildNodes.push(node);
+    }
+}
+
+INLINE BvhBounds getBvhBounds(IScheduler& scheduler,
+    ArrayView<const BvhBuildItem> items,
+    const Size from,
+    const Size to,
+    const Size minParallelCnt = Size(-1)) {
+    auto functor = [items](const Size i, BvhBounds& b) {
+        b.box.extend(items[i].box);
+        b.centers.extend(items[i].box.center());
+    };
+    return reduceBvhRange<BvhBounds>(scheduler, from, to, minParallelCnt, functor);
+}
 
-        if (nodeEntry.parent != NO_PARENT) {
-            buildNodes[nodeEntry.parent].rightOffset--;
+/// \brief Node of the top part of the hierarchy, built in parallel.
+template <typename TBvhObject>
+struct Bvh<TBvhObject>::BuildNode {
+    /// Inner node; not used if the node holds a subtree
+    BvhNode node;
+
+    /// Bounding box of objects and their centers
+    BvhBounds bounds;
 
-            if (buildNodes[nodeEntry.parent].rightOffset == TOUCHED_TWICE) {
-                buildNodes[nodeEntry.parent].rightOffset = nodeCnt - 1 - nodeEntry.parent;
+    /// Children of the inner node
+    AutoPtr<BuildNode> left, right;
+
+    /// Subtree built sequentially, stored in the final (depth-first) layout
+    Array<BvhNode> subtree;
+
+    /// Total number of nodes in this part of the hierarchy
+    Size size;
+};
+
+template <typename TBvhObject>
+void Bvh<TBvhObject>::build(Array<TBvhObject>&& objs) {
+    this->build(SEQUENTIAL, std::move(objs));
+}
+
+template <typename TBvhObject>
+void Bvh<TBvhObject>::build(IScheduler& scheduler, Array<TBvhObject>&& objs) {
+    SPH_ASSERT(!objs.empty());
+    const Size objectCnt = objs.size();
+
+    // cache the bounding boxes, they are needed many times during the build
+    Array<BvhBuildItem> items(objectCnt);
+    parallelFor(scheduler, 0, objectCnt, PARALLEL_CNT / 8, [&](const Size i) {
+        items[i].box = objs[i].getBBox();
+        items[i].index = i;
+    });
+
+    BuildNode root;
+    root.node.start = 0;
+    root.node.primCnt = objectCnt;
+    root.bounds = getBvhBounds(scheduler, items, 0, objectCnt);
+    this->buildNode(scheduler, items, root, 0);
+
+    // merge the subtrees into the final array
+    nodes.resize(root.size);
+    this->copyNodes(scheduler, root, 0);
+
+    // reorder the objects, so that each leaf refers to a contiguous range
+    order.resize(objectCnt);
+    objects = objs.clone();
+    parallelFor(scheduler, 0, objectCnt, PARALLEL_CNT / 8, [&](const Size i) {
+        order[i] = items[i].index;
+        objects[i] = objs[order[i]];
+    });
+
+    leafCost = this->getLeafCost(scheduler);
+}
+
+template <typename TBvhObject>
+void Bvh<TBvhObject>::buildNode(IScheduler& scheduler,
+    ArrayView<BvhBuildItem> items,
+    BuildNode& node,
+    const Size depth) {
+    const Size start = node.node.start;
+    const Size end = start + node.node.primCnt;
+    if (end - start <= PARALLEL_CNT) {
+        // small enough to be built by a single thread
+        this->buildSubtree(items, node.subtree, start, end, node.bounds, depth);
+        node.size = node.subtree.size();
+        return;
+    }
+
+    node.left = makeAuto<BuildNode>();
+    node.right = makeAuto<BuildNode>();
+    node.node.box = node.bounds.box;
+    const Size mid =
+        this->split(scheduler, items, node.node, node.bounds, depth, node.left->bounds, node.right->bounds);
+    SPH_ASSERT(mid > start && mid < end);
+    node.left->node.start = start;
+    node.left->node.primCnt = mid - start;
+    node.right->node.start = mid;
+    node.right->node.primCnt = end - mid;
+    scheduler.parallelInvoke([&] { this->buildNode(scheduler, items, *node.left, depth + 1); },
+        [&] { this->buildNode(scheduler, items, *node.right, depth + 1); });
+
+    node.node.rightOffset = 1 + node.left->size;
+    node.size = 1 + node.left->size + node.right->size;
+}
+
+template <typename TBvhObject>
+void Bvh<TBvhObject>::buildSubtree(ArrayView<BvhBuildItem> items,
+    Array<BvhNode>& subtree,
+    const Size start,
+    const Size end,
+    const BvhBounds& bounds,
+    const Size depth) {
+    const Size index = subtree.size();
+    BvhNode& node = subtree.emplaceBack();
+    node.box = bounds.box;
+    node.start = start;
+    node.primCnt = end - start;
+    if (node.primCnt <= leafSize) {
+        node.rightOffset = 0;
+        return;
+    }
+
+    BvhBounds leftBounds, rightBounds;
+    const Size mid = this->split(SEQUENTIAL, items, node, bounds, depth, leftBounds, rightBounds);
+    this->buildSubtree(items, subtree, start, mid, leftBounds, depth + 1);
+    subtree[index].rightOffset = subtree.size() - index;
+    this->buildSubtree(items, subtree, mid, end, rightBounds, depth + 1);
+}
+
+template <typename TBvhObject>
+Size Bvh<TBvhObject>::split(IScheduler& scheduler,
+    ArrayView<BvhBuildItem> items,
+    const BvhNode& node,
+    const BvhBounds& bounds,
+    const Size depth,
+    BvhBounds& leftBounds,
+    BvhBounds& rightBounds) {
+    const Size start = node.start;
+    const Size end = start + node.primCnt;
+    Iterator<BvhBuildItem> first = items.begin() + start;
+    Iterator<BvhBuildItem> last = items.begin() + end;
+
+    // bin the objects along the dimension of the largest extent of centers
+    const Vector extent = bounds.centers.size();
+    const Size dim = argMax(extent);
+    Size mid = start + node.primCnt / 2;
+    if (extent[dim] == 0._f) {
+        // all centers coincide, split arbitrarily
+    } else if (depth < MAX_SAH_DEPTH) {
+        const Float lower = bounds.centers.lower()[dim];
+        const Float scale = BIN_CNT / extent[dim];
+        auto getBin = [lower, scale, dim](const BvhBuildItem& item) {
+            return min(Size((item.box.center()[dim] - lower) * scale), Size(BIN_CNT - 1));
+        };
+
+        using Bins = BvhBins<BIN_CNT>;
+        const Bins bins =
+            reduceBvhRange<Bins>(scheduler, start, end, PARALLEL_CNT, [&](const Size i, Bins& b) {
+                const Size bin = getBin(items[i]);
+                b.bounds[bin].box.extend(items[i].box);
+                b.bounds[bin].centers.extend(items[i].box.center());
+                b.counts[bin]++;
+            });
+
+        // find the split minimizing the sum of surface areas weighted by the number of objects
+        Float rightCosts[BIN_CNT];
+        Box rightBox;
+        Size rightCnt = 0;
+        for (Size bin = BIN_CNT - 1; bin > 0; --bin) {
+            rightBox.extend(bins.bounds[bin].box);
+            rightCnt += bins.counts[bin];
+            rightCosts[bin] = rightCnt > 0 ? getSurfaceArea(rightBox) * rightCnt : INFTY;
+        }
+        Float bestCost = INFTY;
+        Size bestBin = 0;
+        Box leftBox;
+        Size leftCnt = 0;
+        for (Size bin = 0; bin < BIN_CNT - 1; ++bin) {
+            leftBox.extend(bins.bounds[bin].box);
+            leftCnt += bins.counts[bin];
+            if (leftCnt == 0) {
+                continue;
+            }
+            const Float cost = getSurfaceArea(leftBox) * leftCnt + rightCosts[bin + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestBin = bin;
             }
         }
+        SPH_ASSERT(bestCost < INFTY);
 
-        if (node.rightOffset == 0) {
-            continue;
+        // bounds of the children can be merged from the bins
+        leftBounds = rightBounds = BvhBounds();
+        for (Size bin = 0; bin < BIN_CNT; ++bin) {
+            (bin <= bestBin ? leftBounds : rightBounds) += bins.bounds[bin];
         }
+        Iterator<BvhBuildItem> iter = std::partition(first, last, [&](const BvhBuildItem& item) { //
+            return getBin(item) <= bestBin;
+        });
+        SPH_ASSERT(iter != first && iter != last);
+        return start + Size(iter - first);
+    } else {
+        // split by the median to limit the depth of the tree
+        auto compare = [dim](const BvhBuildItem& i1, const BvhBuildItem& i2) {
+            return i1.box.center()[dim] < i2.box.center()[dim];
+        };
+        std::nth_element(first, items.begin() + mid, last, compare);
+    }
+    leftBounds = getBvhBounds(scheduler, items, start, mid, PARALLEL_CNT);
+    rightBounds = getBvhBounds(scheduler, items, mid, end, PARALLEL_CNT);
+    return mid;
+}
 
-        const Size splitDim = argMax(boxCenter.size());
-        const Float split = 0.5_f * (boxCenter.lower()[splitDim] + boxCenter.upper()[splitDim]);
+template <typename TBvhObject>
+void Bvh<TBvhObject>::copyNodes(IScheduler& scheduler, const BuildNode& node, const Size offset) {
+    if (!node.left) {
+        std::copy(node.subtree.begin(), node.subtree.end(), nodes.begin() + offset);
+        return;
+    }
+    nodes[offset] = node.node;
+    scheduler.parallelInvoke([&] { this->copyNodes(scheduler, *node.left, offset + 1); },
+        [&] { this->copyNodes(scheduler, *node.right, offset + 1 + node.left->size); });
+}
 
-        Size mid = start;
-        for (Size i = start; i < end; ++i) {
-            if (objects[i].getCenter()[splitDim] < split) {
-                std::swap(objects[i], objects[mid]);
-                ++mid;
-            }
-        }
+template <typename TBvhObject>
+bool Bvh<TBvhObject>::refit(IScheduler& scheduler, Array<TBvhObject>&& objs) {
+    if (nodes.empty() || objs.size() != order.size()) {
+        this->build(scheduler, std::move(objs));
+        return false;
+    }
 
-        if (mid == start || mid == end) {
-            mid = start + (end - start) / 2;
+    parallelFor(scheduler, 0, objs.size(), PARALLEL_CNT / 8, [&](const Size i) { //
+        objects[i] = objs[order[i]];
+    });
+    this->refitNode(scheduler, 0);
+
+    if (this->getLeafCost(scheduler) > MAX_REFIT_COST_GROWTH * leafCost) {
+        // the hierarchy degraded too much, rebuild from scratch
+        this->build(scheduler, std::move(objs));
+        return false;
+    }
+    return true;
+}
+
+template <typename TBvhObject>
+void Bvh<TBvhObject>::refitNode(IScheduler& scheduler, const Size nodeIdx) {
+    BvhNode& node = nodes[nodeIdx];
+    if (node.rightOffset == 0) {
+        Box box;
+        for (Size i = node.start; i < node.start + node.primCnt; ++i) {
+            box.extend(objects[i].getBBox());
         }
+        node.box = box;
+        return;
+    }
 
-        stack[stackIdx++] = { nodeCnt - 1, mid, end };
-        stack[stackIdx++] = { nodeCnt - 1, start, mid };
+    const Size leftIdx = nodeIdx + 1;
+    const Size rightIdx = nodeIdx + node.rightOffset;
+    if (node.primCnt > PARALLEL_CNT) {
+        scheduler.parallelInvoke([&] { this->refitNode(scheduler, leftIdx); },
+            [&] { this->refitNode(scheduler, rightIdx); });
+    } else {
+        this->refitNode(scheduler, leftIdx);
+        this->refitNode(scheduler, rightIdx);
     }
+    node.box = nodes[leftIdx].box;
+    node.box.extend(nodes[rightIdx].box);
+}
+
+template <typename TBvhObject>
+Float Bvh<TBvhObject>::getLeafCost(IScheduler& scheduler) const {
+    struct Cost {
+        Float value = 0._f;
 
-    SPH_ASSERT(buildNodes.size() == nodeCnt);
-    nodes = std::move(buildNodes);
+        Cost& operator+=(const Cost& other) {
+            value += other.value;
+            return *this;
+        }
+    };
+    const Cost cost =
+        reduceBvhRange<Cost>(scheduler, 0, nodes.size(), PARALLEL_CNT, [this](const Size i, Cost& c) {
+            const BvhNode& node = nodes[i];
+            if (node.rightOffset == 0) {
+                c.value += getSurfaceArea(node.box) * node.primCnt;
+            }
+        });
+    return cost.value / max(getSurfaceArea(nodes[0].box), EPS);
 }
 
 template <typename TBvhObject>
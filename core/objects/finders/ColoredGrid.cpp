@@ -0,0 +1,72 @@
+#include "objects/finders/ColoredGrid.h"
+#include "objects/geometry/Box.h"
+#include "thread/Scheduler.h"
+
+NAMESPACE_SPH_BEGIN
+
+/// Number of bits used to store the cell index in each dimension
+constexpr Size INDEX_BITS = 20;
+
+constexpr Size ColoredGrid::COLOR_CNT;
+
+void ColoredGrid::build(IScheduler& scheduler, ArrayView<const Vector> r, const Float cellSize) {
+    SPH_ASSERT(cellSize > 0._f, cellSize);
+    const Size size = r.size();
+    ThreadLocal<Box> boxTl(scheduler);
+    parallelFor(scheduler, boxTl, 0, size, [r](const Size i, Box& box) { box.extend(r[i]); });
+    const Box box = boxTl.accumulate(Box(), [](const Box& box1, const Box& box2) {
+        Box box = box1;
+        box.extend(box2);
+        return box;
+    });
+
+    // enlarge the cells if the indices would not fit into the key; this does not invalidate the coloring
+    const Size maxIndex = (1 << INDEX_BITS) - 1;
+    const Vector extent = size > 0 ? box.size() : Vector(0._f);
+    const Float actCellSize = max(cellSize, maxElement(extent) / maxIndex);
+
+    keys.resize(size);
+    parallelFor(scheduler, 0, size, [this, r, &box, actCellSize, maxIndex](const Size i) {
+        uint64_t key = 0;
+        Size color = 0;
+        Size stride = 1;
+        for (Size k = 0; k < 3; ++k) {
+            const Size idx = min(Size((r[i][k] - box.lower()[k]) / actCellSize), maxIndex);
+            key |= uint64_t(idx) << (k * INDEX_BITS);
+            color += (idx % 3) * stride;
+            stride *= 3;
+        }
+        keys[i] = key | (uint64_t(color) << (3 * INDEX_BITS));
+    });
+
+    particles.resize(size);
+    parallelFor(scheduler, 0, size, [this](const Size i) { particles[i] = i; });
+    // sort the indices as well, so that the order does not depend on the number of threads
+    parallelSort(scheduler, particles.begin(), particles.end(), [this](const Size i, const Size j) {
+        return keys[i] < keys[j] || (keys[i] == keys[j] && i < j);
+    });
+
+    // find the boundaries of the cells and colors
+    cellOffsets.clear();
+    colorOffsets.resize(COLOR_CNT + 1);
+    Size color = 0;
+    colorOffsets[0] = 0;
+    for (Size k = 0; k < size; ++k) {
+        const uint64_t key = keys[particles[k]];
+        if (k > 0 && key == keys[particles[k - 1]]) {
+            continue;
+        }
+        // new cell
+        const Size cellColor = Size(key >> (3 * INDEX_BITS));
+        while (color < cellColor) {
+            colorOffsets[++color] = cellOffsets.size();
+        }
+        cellOffsets.push(k);
+    }
+    while (color < COLOR_CNT) {
+        colorOffsets[++color] = cellOffsets.size();
+    }
+    cellOffsets.push(size);
+}
+
+NAMESPACE_SPH_END
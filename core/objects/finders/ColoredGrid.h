@@ -0,0 +1,87 @@
+#pragma once
+
+/// \file ColoredGrid.h
+/// \brief Partitioning of particles into colored cells, allowing for concurrent updates without conflicts
+/// \author Pavel Sevecek (sevecek at sirrah.troja.mff.cuni.cz)
+/// \date 2016-2021
+
+#include "objects/containers/Array.h"
+#include "objects/containers/ArrayView.h"
+#include "objects/geometry/Vector.h"
+#include "thread/ThreadLocal.h"
+
+NAMESPACE_SPH_BEGIN
+
+/// \brief Uniform grid of cells, colored so that particles in different cells of the same color never
+/// interact.
+///
+/// Particles are binned into cubic cells with a size equal to the maximal interaction distance. Cells are
+/// assigned one of 27 colors, according to their indices modulo 3. Any particle interacts only with particles
+/// in the same cell or in one of the adjacent cells, so two particles in distinct cells of the same color
+/// never share a neighbor. All cells of a single color can be thus processed concurrently, even if the
+/// processing of a particle modifies the values of its neighbors.
+class ColoredGrid {
+public:
+    /// Number of colors used by the grid
+    static constexpr Size COLOR_CNT = 27;
+
+private:
+    /// Keys of particles, encoding the color and the indices of the cell
+    Array<uint64_t> keys;
+
+    /// Particle indices, sorted by cells
+    Array<Size> particles;
+
+    /// Index of the first particle of each cell; contains one extra element (the number of particles)
+    Array<Size> cellOffsets;
+
+    /// Index of the first cell of each color; contains one extra element (the number of cells)
+    Array<Size> colorOffsets;
+
+public:
+    /// \brief Bins the particles into the colored cells.
+    ///
+    /// \param scheduler Scheduler used to compute the cell indices in parallel.
+    /// \param r Positions of particles.
+    /// \param cellSize Size of the cells. Must be larger than the interaction distance of any particle pair.
+    ///                 The grid can use larger cells if the particles are spread over a large domain.
+    void build(IScheduler& scheduler, ArrayView<const Vector> r, const Float cellSize);
+
+    /// \brief Executes a functor for all particles.
+    ///
+    /// Colors are processed sequentially, cells of the same color are processed in parallel. Particles of a
+    /// single cell are always processed sequentially, by the same thread.
+    /// \param scheduler Scheduler used for parallelization.
+    /// \param storage Thread-local storage passed into the functor.
+    /// \param functor Functor executed for each particle, called with the particle index and the
+    ///                thread-local value.
+    template <typename Type, typename TFunctor>
+    void iterate(IScheduler& scheduler, ThreadLocal<Type>& storage, const TFunctor& functor) const {
+        const Size cellCnt = this->getCellCnt();
+        if (cellCnt == 0) {
+            return;
+        }
+        // recommended granularity is given in particles, convert it to the number of cells
+        const Size granularity =
+            max(scheduler.getRecommendedGranularity() * cellCnt / particles.size(), Size(1));
+        for (Size color = 0; color < COLOR_CNT; ++color) {
+            parallelFor(scheduler,
+                storage,
+                colorOffsets[color],
+                colorOffsets[color + 1],
+                granularity,
+                [this, &functor](const Size cell, Type& value) {
+                    for (Size k = cellOffsets[cell]; k < cellOffsets[cell + 1]; ++k) {
+                        functor(particles[k], value);
+                    }
+                });
+        }
+    }
+
+    /// \brief Returns the number of non-empty cells of the grid.
+    Size getCellCnt() const {
+        return colorOffsets.empty() ? 0 : colorOffsets.back();
+    }
+};
+
+NAMESPACE_SPH_END
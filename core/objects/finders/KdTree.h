@@ -40,9 +40,15 @@ struct KdNode : public Noncopyable {
 /// \brief Inner node of K-d tree
 template <typename TBase>
 struct InnerNode : public TBase {
-    /// Position where the selected dimension is split
+    /// Position where the selected dimension is split; particles of the left child do not exceed this value
     float splitPosition;
 
+    /// \brief Lower bound of particles of the right child in the split dimension.
+    ///
+    /// Equal to \ref splitPosition after the build; may differ if the tree has been refitted, in which case
+    /// the children can overlap in the split dimension.
+    float rightPosition;
+
     /// Index of left child node
     Size left;
 
@@ -66,7 +72,7 @@ struct LeafNode : public TBase {
     Size to;
 
     /// Unused, used so that LeafNode and InnerNode have the same size
-    Size padding;
+    Size padding[2];
 
     LeafNode(const KdNode::Type& type)
         : TBase(type) {}
@@ -145,10 +151,17 @@ private:
 
         /// Maximal depth for which the build is parallelized
         Size maxParallelDepth;
+
+        /// Maximal allowed growth of the summed volume of leaf boxes before the refit falls back to the
+        /// full build.
+        Float maxVolumeGrowth;
     } config;
 
     Box entireBox;
 
+    /// Summed volume of leaf boxes after the last full build
+    Float leafVolume = 0._f;
+
     Array<Size> idxs;
 
     /// Holds all nodes, either \ref InnerNode or \ref LeafNode (depending on the value of \ref type).
@@ -159,11 +172,22 @@ private:
 
     static constexpr Size ROOT_PARENT_NODE = -1;
 
+    /// Maximal overlap of child nodes allowed by the refit, relative to the extent of the parent node
+    static constexpr Float MAX_REFIT_OVERLAP = 0.25_f;
+
 public:
-    explicit KdTree(const Size leafSize = 25, const Size maxParallelDepth = 50) {
+    /// \param leafSize Maximal number of particles in the leaf node
+    /// \param maxParallelDepth Maximal depth for which the build and the refit are parallelized
+    /// \param maxVolumeGrowth Maximal relative growth of the summed volume of leaf boxes allowed by the
+    ///                        refit; if exceeded, the tree is rebuilt.
+    explicit KdTree(const Size leafSize = 25,
+        const Size maxParallelDepth = 50,
+        const Float maxVolumeGrowth = 2._f) {
         SPH_ASSERT(leafSize >= 1);
+        SPH_ASSERT(maxVolumeGrowth >= 1._f);
         config.leafSize = leafSize;
         config.maxParallelDepth = maxParallelDepth;
+        config.maxVolumeGrowth = maxVolumeGrowth;
     }
 
     template <bool FindAll>
@@ -195,6 +219,14 @@ public:
 protected:
     virtual void buildImpl(IScheduler& scheduler, ArrayView<const Vector> points) override;
 
+    /// \brief Updates bounding boxes of all nodes bottom-up, keeping the topology and the leaf membership.
+    ///
+    /// Split positions of inner nodes are replaced by the bounds of child nodes, so that the queries remain
+    /// exact even if the children overlap. The refit fails if the number of points changed, if the overlap
+    /// of children exceeds \ref MAX_REFIT_OVERLAP of the node size in any inner node or if the summed
+    /// volume of leaf boxes grew more than the allowed factor since the last full build.
+    virtual bool refitImpl(IScheduler& scheduler, ArrayView<const Vector> points) override;
+
 private:
     void init();
 
@@ -214,6 +246,8 @@ private:
     bool isSingular(const Size from, const Size to, const Size splitIdx) const;
 
     bool checkBoxes(const Size from, const Size to, const Size mid, const Box& box1, const Box& box2) const;
+
+    Float getLeafVolume() const;
 };
 
 
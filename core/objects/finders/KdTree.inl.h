@@ -37,7 +37,63 @@ void KdTree<TNode, TMetric>::buildImpl(IScheduler& scheduler, ArrayView<const Ve
     // shrink nodes to only the constructed ones
     nodes.resize(nodeCounter);
 
+    leafVolume = this->getLeafVolume();
+
+    SPH_ASSERT(this->sanityCheck(), this->sanityCheck().error());
+}
+
+template <typename TNode, typename TMetric>
+bool KdTree<TNode, TMetric>::refitImpl(IScheduler& scheduler, ArrayView<const Vector> points) {
+    VERBOSE_LOG
+
+    if (nodes.empty() || points.size() != idxs.size()) {
+        // not built yet or particles have been added or removed
+        return false;
+    }
+
+    std::atomic_bool overlapping{ false };
+    auto functor = [this, &overlapping](TNode& node, TNode* left, TNode* right) {
+        if (node.isLeaf()) {
+            LeafNode<TNode>& leaf = reinterpret_cast<LeafNode<TNode>&>(node);
+            Box box;
+            for (Size i = leaf.from; i < leaf.to; ++i) {
+                box.extend(this->values[idxs[i]]);
+            }
+            leaf.box = box;
+        } else {
+            InnerNode<TNode>& inner = reinterpret_cast<InnerNode<TNode>&>(node);
+            inner.box = Box::EMPTY();
+            inner.box.extend(left->box);
+            inner.box.extend(right->box);
+
+            // particles may have crossed the split plane, so update the bounds of the children
+            const Size splitIdx = Size(inner.type);
+            const Float leftMax = left->box.upper()[splitIdx];
+            const Float rightMin = right->box.lower()[splitIdx];
+            inner.splitPosition = float(leftMax);
+            if (inner.splitPosition < leftMax) {
+                inner.splitPosition = std::nextafter(inner.splitPosition, INFINITY);
+            }
+            inner.rightPosition = float(rightMin);
+            if (inner.rightPosition > rightMin) {
+                inner.rightPosition = std::nextafter(inner.rightPosition, -INFINITY);
+            }
+            if (leftMax - rightMin > MAX_REFIT_OVERLAP * inner.box.size()[splitIdx]) {
+                overlapping = true;
+            }
+        }
+        return true;
+    };
+    iterateTree<IterateDirection::BOTTOM_UP>(*this, scheduler, functor, 0, config.maxParallelDepth);
+
+    if (overlapping || this->getLeafVolume() > config.maxVolumeGrowth * leafVolume) {
+        // boxes degraded too much, the tree has to be rebuilt
+        return false;
+    }
+    entireBox = nodes[0].box;
+
     SPH_ASSERT(this->sanityCheck(), this->sanityCheck().error());
+    return true;
 }
 
 template <typename TNode, typename TMetric>
@@ -238,7 +294,7 @@ Size KdTree<TNode, TMetric>::addInner(const Size parent,
     node.box = Box(); // will be computed later
 #endif
 
-    node.splitPosition = float(splitPosition);
+    node.splitPosition = node.rightPosition = float(splitPosition);
 
     if (parent == ROOT_PARENT_NODE) {
         // no need to set up parents
@@ -294,6 +350,17 @@ bool KdTree<TNode, TMetric>::checkBoxes(const Size from,
     return true;
 }
 
+template <typename TNode, typename TMetric>
+Float KdTree<TNode, TMetric>::getLeafVolume() const {
+    Float volume = 0._f;
+    for (const InnerNode<TNode>& node : nodes) {
+        if (node.isLeaf()) {
+            volume += node.box.volume();
+        }
+    }
+    return volume;
+}
+
 /// \brief Object used during traversal.
 ///
 /// Holds an index of the node and squared distance of the bounding box.
@@ -363,7 +430,8 @@ Size KdTree<TNode, TMetric>::find(const Vector& r0,
                 ProcessedNode right = node;
                 node.idx = inner.left;
 
-                const Float dx = splitPosition - r0[splitDimension];
+                // children of a refitted tree can overlap, so the distance can be zero
+                const Float dx = max(inner.rightPosition - r0[splitDimension], 0._f);
                 right.distanceSqr += sqr(dx) - right.sizeSqr[splitDimension];
                 right.sizeSqr[splitDimension] = sqr(dx);
                 if (right.distanceSqr < radiusSqr) {
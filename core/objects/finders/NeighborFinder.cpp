@@ -8,6 +8,15 @@ void IBasicFinder::build(IScheduler& scheduler, ArrayView<const Vector> points)
     this->buildImpl(scheduler, values);
 }
 
+bool IBasicFinder::refit(IScheduler& scheduler, ArrayView<const Vector> points) {
+    values = points;
+    if (this->refitImpl(scheduler, values)) {
+        return true;
+    }
+    this->buildImpl(scheduler, values);
+    return false;
+}
+
 static Order makeRankH(ArrayView<const Vector> values, Flags<FinderFlag> flags) {
     if (flags.has(FinderFlag::MAKE_RANK)) {
         return makeRank(values.size(), [values](const Size i1, const Size i2) { //
@@ -24,4 +33,9 @@ void ISymmetricFinder::build(IScheduler& scheduler, ArrayView<const Vector> poin
     this->buildImpl(scheduler, values);
 }
 
+bool ISymmetricFinder::refit(IScheduler& scheduler, ArrayView<const Vector> points, Flags<FinderFlag> flags) {
+    rank = makeRankH(points, flags);
+    return IBasicFinder::refit(scheduler, points);
+}
+
 NAMESPACE_SPH_END
@@ -49,6 +49,17 @@ public:
     /// \param points View of the array of points in space.
     void build(IScheduler& scheduler, ArrayView<const Vector> points);
 
+    /// \brief Updates the finder after the points moved, re-using the structure created by \ref build.
+    ///
+    /// Finders supporting this operation keep their topology and only update the bounding volumes, which is
+    /// cheaper than the full build. If the update is not possible (the finder has not been built yet, the
+    /// number of points changed, etc.) or the structure would become too inefficient, the finder is rebuilt
+    /// from scratch. In both cases, the subsequent queries return the same neighbors as after \ref build.
+    /// \param scheduler Scheduler that can be used for parallelization.
+    /// \param points View of the array of points in space.
+    /// \return True if the structure has been re-used, false if the finder has been rebuilt.
+    bool refit(IScheduler& scheduler, ArrayView<const Vector> points);
+
     /// \brief Finds all neighbors within given radius from the point given by index.
     ///
     /// Point view passed in \ref build must not be invalidated, in particular the number of particles must
@@ -73,6 +84,14 @@ protected:
     /// \param scheduler Scheduler that can be used for parallelization.
     /// \param points View of the array of points in space.
     virtual void buildImpl(IScheduler& scheduler, ArrayView<const Vector> points) = 0;
+
+    /// \brief Updates the finder for moved points, keeping its structure.
+    ///
+    /// Returns false if the finder cannot be updated, in which case \ref buildImpl is called instead. The
+    /// default implementation does not support the update.
+    virtual bool refitImpl(IScheduler& UNUSED(scheduler), ArrayView<const Vector> UNUSED(points)) {
+        return false;
+    }
 };
 
 enum class FinderFlag {
@@ -109,6 +128,13 @@ public:
         ArrayView<const Vector> points,
         Flags<FinderFlag> flags = FinderFlag::MAKE_RANK);
 
+    /// \brief Updates the struct after the points moved, see \ref IBasicFinder::refit.
+    ///
+    /// The ranks of particles are always recomputed, as smoothing lengths may have changed.
+    bool refit(IScheduler& scheduler,
+        ArrayView<const Vector> points,
+        Flags<FinderFlag> flags = FinderFlag::MAKE_RANK);
+
     /// \brief Constructs the struct with custom predicate for ordering particles.
     template <typename TCompare>
     void buildWithRank(IScheduler& scheduler, ArrayView<const Vector> points, TCompare&& comp) {
@@ -0,0 +1,106 @@
+#include "objects/finders/NeighborList.h"
+#include "thread/ThreadLocal.h"
+#include <atomic>
+
+NAMESPACE_SPH_BEGIN
+
+NeighborList::NeighborList(const Float skin, const Float kernelRadius)
+    : skin(skin)
+    , kernelRadius(kernelRadius) {
+    SPH_ASSERT(skin > 0._f && kernelRadius > 0._f, skin, kernelRadius);
+}
+
+bool NeighborList::needsRebuild(IScheduler& scheduler, ArrayView<const Vector> r) {
+    if (r.size() != r0.size()) {
+        return true;
+    }
+
+    std::atomic<bool> rebuild{ false };
+    scheduler.parallelFor(0, r.size(), scheduler.getRecommendedGranularity(), [&](Size n1, Size n2) {
+        if (rebuild) {
+            return;
+        }
+        for (Size i = n1; i < n2; ++i) {
+            // the skin is consumed both by the displacement of particles and by the growth of their
+            // smoothing lengths; the list is valid as long as the sum of displacements of any two
+            // particles is lower than the remaining skin
+            const Float allowed = 0.5_f * kernelRadius * ((1._f + skin) * r0[i][H] - r[i][H]);
+            if (allowed <= 0._f || getSqrLength(r[i] - r0[i]) > sqr(allowed)) {
+                rebuild = true;
+                return;
+            }
+        }
+    });
+
+    if (!rebuild) {
+        reuseCnt++;
+    }
+    return rebuild;
+}
+
+void NeighborList::build(IScheduler& scheduler, ArrayView<const Vector> r, const Query& query) {
+    struct ThreadData {
+        /// Neighbors returned by the query
+        Array<NeighborRecord> neighs;
+
+        /// Particles processed by this thread
+        Array<Size> particles;
+
+        /// Neighbors of all particles processed by this thread, stored consecutively
+        Array<Size> idxs;
+    };
+    ThreadLocal<ThreadData> threadData(scheduler);
+
+    const Size size = r.size();
+    offsets.resize(size + 1);
+    offsets[0] = 0;
+
+    const Float factor = sqr((1._f + skin) * kernelRadius);
+    parallelFor(scheduler, threadData, 0, size, [&](const Size i, ThreadData& data) {
+        query(i, data.neighs);
+        Size count = 0;
+        for (const NeighborRecord& n : data.neighs) {
+            const Size j = n.index;
+            const Float hbar = 0.5_f * (r[i][H] + r[j][H]);
+            if (i != j && getSqrLength(r[i] - r[j]) < factor * sqr(hbar)) {
+                data.idxs.push(j);
+                ++count;
+            }
+        }
+        data.particles.push(i);
+        // temporarily store the counts, converted to offsets below
+        offsets[i + 1] = count;
+    });
+
+    for (Size i = 0; i < size; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+    neighbors.resize(offsets[size]);
+
+    // copy the thread-local lists into the shared array
+    Array<ThreadData*> datas;
+    for (ThreadData& data : threadData) {
+        datas.push(&data);
+    }
+    parallelFor(scheduler, datas, [this](ThreadData* data) {
+        Size k = 0;
+        for (Size i : data->particles) {
+            const Size count = offsets[i + 1] - offsets[i];
+            if (count == 0) {
+                // the arrays might be empty, avoid creating iterators from null pointers
+                continue;
+            }
+            std::copy(data->idxs.begin() + k, data->idxs.begin() + k + count, neighbors.begin() + offsets[i]);
+            k += count;
+        }
+        SPH_ASSERT(k == data->idxs.size());
+    });
+
+    r0.resize(size);
+    for (Size i = 0; i < size; ++i) {
+        r0[i] = r[i];
+    }
+    buildCnt++;
+}
+
+NAMESPACE_SPH_END
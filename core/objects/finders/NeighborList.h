@@ -0,0 +1,95 @@
+#pragma once
+
+/// \file NeighborList.h
+/// \brief Cached list of neighbor candidates, reused over several time steps
+/// \author Pavel Sevecek (sevecek at sirrah.troja.mff.cuni.cz)
+/// \date 2016-2021
+
+#include "objects/containers/Array.h"
+#include "objects/containers/ArrayView.h"
+#include "objects/finders/NeighborFinder.h"
+#include "objects/wrappers/Function.h"
+
+NAMESPACE_SPH_BEGIN
+
+/// \brief Verlet-style list of neighbor candidates, stored in compressed-row (CSR) format.
+///
+/// The list holds all pairs of particles closer than (1 + skin) * kernelRadius * h_ij at the time of the
+/// build, where h_ij is the symmetrized smoothing length. As long as no particle moved by more than half of
+/// its skin (reduced by the growth of its smoothing length), the list is guaranteed to contain all pairs
+/// within the kernel support, so the neighbor finder does not have to be rebuilt nor queried. The exact
+/// distance check still has to be done by the user of the list.
+///
+/// The validity criterion is purely geometric, so the list remains correct even if particles are added or
+/// removed, as long as the number of particles does not change; changing the particle count always causes a
+/// rebuild.
+class NeighborList {
+public:
+    /// \brief Queries neighbors of i-th particle.
+    ///
+    /// The functor shall find all particles j within radius (1 + skin) * kernelRadius * h_ij. The list of
+    /// neighbors can contain more particles, these are filtered out by the list.
+    using Query = Function<void(const Size i, Array<NeighborRecord>& neighs)>;
+
+private:
+    /// Relative size of the skin, in units of the kernel support
+    Float skin;
+
+    /// Dimensionless radius of the kernel
+    Float kernelRadius;
+
+    /// Positions and smoothing lengths at the time of the last build
+    Array<Vector> r0;
+
+    /// Index of the first neighbor of each particle; contains one extra element (the total neighbor count)
+    Array<Size> offsets;
+
+    /// Neighbor candidates of all particles
+    Array<Size> neighbors;
+
+    /// Number of builds of the list since its construction
+    Size buildCnt = 0;
+
+    /// Number of reuses of the list since its construction
+    Size reuseCnt = 0;
+
+public:
+    /// \param skin Relative size of the skin. Must be a positive number.
+    /// \param kernelRadius Dimensionless radius of the used kernel.
+    NeighborList(const Float skin, const Float kernelRadius);
+
+    /// \brief Checks whether the list has to be rebuilt for given particle positions.
+    ///
+    /// Returns true if the list was not built yet, if the number of particles changed, or if any particle
+    /// moved too far from its position at the time of the last build. If false is returned, the list is
+    /// considered reused, which is reflected by the counter returned by \ref getReuseCnt.
+    bool needsRebuild(IScheduler& scheduler, ArrayView<const Vector> r);
+
+    /// \brief Builds the list, using provided functor to find neighbors of particles.
+    ///
+    /// The query functor is called concurrently for all particles.
+    void build(IScheduler& scheduler, ArrayView<const Vector> r, const Query& query);
+
+    /// \brief Returns the neighbor candidates of given particle.
+    INLINE ArrayView<const Size> getNeighbors(const Size i) const {
+        SPH_ASSERT(i + 1 < offsets.size());
+        return neighbors.view().subset(offsets[i], offsets[i + 1] - offsets[i]);
+    }
+
+    /// \brief Returns the relative size of the skin.
+    Float getSkin() const {
+        return skin;
+    }
+
+    /// \brief Returns the number of (re)builds of the list.
+    Size getBuildCnt() const {
+        return buildCnt;
+    }
+
+    /// \brief Returns the number of time steps the list was reused without rebuilding.
+    Size getReuseCnt() const {
+        return reuseCnt;
+    }
+};
+
+NAMESPACE_SPH_END
@@ -0,0 +1,71 @@
+#include "bench/Session.h"
+#include "math/rng/VectorRng.h"
+#include "objects/finders/Bvh.h"
+#include "thread/Pool.h"
+#include "thread/Tbb.h"
+
+using namespace Sph;
+
+static Array<BvhSphere> getSpheres(const Size cnt, const Vector& offset = Vector(0._f)) {
+    Array<BvhSphere> spheres;
+    VectorRng<UniformRng> rng;
+    for (Size i = 0; i < cnt; ++i) {
+        BvhSphere& s = spheres.emplaceBack(rng() + offset, 0.005_f * (1._f + rng()[X]));
+        s.userData = i;
+    }
+    return spheres;
+}
+
+static void bvhBuild(Benchmark::Context& context, IScheduler& scheduler) {
+    Array<BvhSphere> spheres = getSpheres(1000000);
+    Bvh<BvhSphere> bvh;
+    while (context.running()) {
+        bvh.build(scheduler, spheres.clone());
+        Benchmark::clobberMemory();
+    }
+}
+
+BENCHMARK("Bvh build Sequential", "[bvh]", Benchmark::Context& context) {
+    bvhBuild(context, SEQUENTIAL);
+}
+
+BENCHMARK("Bvh build ThreadPool", "[bvh]", Benchmark::Context& context) {
+    bvhBuild(context, *ThreadPool::getGlobalInstance());
+}
+
+BENCHMARK("Bvh build Tbb", "[bvh]", Benchmark::Context& context) {
+    bvhBuild(context, *Tbb::getGlobalInstance());
+}
+
+BENCHMARK("Bvh refit ThreadPool", "[bvh]", Benchmark::Context& context) {
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+    Bvh<BvhSphere> bvh;
+    bvh.build(pool, getSpheres(1000000));
+    Array<BvhSphere> spheres1 = getSpheres(1000000, Vector(0.001_f));
+    Array<BvhSphere> spheres2 = getSpheres(1000000, Vector(-0.001_f));
+    bool odd = false;
+    while (context.running()) {
+        bvh.refit(pool, odd ? spheres1.clone() : spheres2.clone());
+        odd = !odd;
+        Benchmark::clobberMemory();
+    }
+}
+
+BENCHMARK("Bvh trace", "[bvh]", Benchmark::Context& context) {
+    Bvh<BvhSphere> bvh;
+    bvh.build(*ThreadPool::getGlobalInstance(), getSpheres(1000000));
+    VectorRng<UniformRng> rng;
+    Array<Ray> rays;
+    for (Size i = 0; i < 100000; ++i) {
+        const Vector origin = Vector(rng()[X], rng()[Y], -1._f);
+        rays.emplaceBack(origin, getNormalized(rng() - origin));
+    }
+    while (context.running()) {
+        Size hitCnt = 0;
+        for (const Ray& ray : rays) {
+            IntersectionInfo intersection;
+            hitCnt += Size(bvh.getFirstIntersection(ray, intersection));
+        }
+        Benchmark::doNotOptimize(hitCnt);
+    }
+}
@@ -1,6 +1,8 @@
 #include "objects/finders/Bvh.h"
 #include "catch.hpp"
 #include "math/rng/VectorRng.h"
+#include "thread/Pool.h"
+#include "utils/SequenceTest.h"
 
 using namespace Sph;
 
@@ -107,3 +109,109 @@ TEST_CASE("Bvh many spheres", "[bvh]") {
     REQUIRE(intersection.t < 5._f);
     REQUIRE(intersection.object != nullptr);
 }
+
+static Array<BvhSphere> getSpheres(const Size cnt, const Vector& offset = Vector(0._f)) {
+    Array<BvhSphere> objects;
+    VectorRng<BenzAsphaugRng> rng(1234);
+    for (Size i = 0; i < cnt; ++i) {
+        BvhSphere& s = objects.emplaceBack(10._f * rng() + offset, 0.05_f * rng.getAdditional(3) + 0.01_f);
+        s.userData = i;
+    }
+    return objects;
+}
+
+static Array<Ray> getRays(const Size cnt) {
+    Array<Ray> rays;
+    VectorRng<BenzAsphaugRng> rng(5678);
+    for (Size i = 0; i < cnt; ++i) {
+        const Vector origin = Vector(-5._f, 0._f, 0._f) + 20._f * Vector(0._f, rng()[Y], rng()[Z]);
+        const Vector target = 10._f * rng();
+        rays.emplaceBack(origin, getNormalized(target - origin));
+    }
+    return rays;
+}
+
+static Outcome checkIntersections(const Bvh<BvhSphere>& bvh, ArrayView<const BvhSphere> spheres) {
+    for (const Ray& ray : getRays(100)) {
+        IntersectionInfo expected;
+        expected.t = INFTY;
+        for (const BvhSphere& s : spheres) {
+            IntersectionInfo current;
+            if (s.getIntersection(ray, current) && current.t < expected.t) {
+                expected = current;
+            }
+        }
+        IntersectionInfo intersection;
+        const bool hit = bvh.getFirstIntersection(ray, intersection);
+        if (hit != (expected.object != nullptr)) {
+            return makeFailed("Incorrect hit: {} == {}", hit, expected.object != nullptr);
+        }
+        if (hit && intersection.object->userData != expected.object->userData) {
+            return makeFailed(
+                "Incorrect object: {} == {}", intersection.object->userData, expected.object->userData);
+        }
+    }
+    return SUCCESS;
+}
+
+TEST_CASE("Bvh parallel build", "[bvh]") {
+    Array<BvhSphere> spheres = getSpheres(50000);
+    Bvh<BvhSphere> bvh1;
+    bvh1.build(spheres.clone());
+    Bvh<BvhSphere> bvh2;
+    bvh2.build(*ThreadPool::getGlobalInstance(), spheres.clone());
+    REQUIRE(bvh1.getBoundingBox() == bvh2.getBoundingBox());
+
+    REQUIRE(checkIntersections(bvh1, spheres));
+    REQUIRE(checkIntersections(bvh2, spheres));
+}
+
+TEST_CASE("Bvh refit", "[bvh]") {
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+    Array<BvhSphere> spheres = getSpheres(50000);
+    Bvh<BvhSphere> bvh;
+    // not built yet
+    REQUIRE_FALSE(bvh.refit(pool, spheres.clone()));
+
+    // moved spheres can be refitted
+    spheres = getSpheres(50000, Vector(0.02_f, 0.01_f, 0._f));
+    REQUIRE(bvh.refit(pool, spheres.clone()));
+    REQUIRE(checkIntersections(bvh, spheres));
+
+    // shuffled spheres degrade the hierarchy, so it is rebuilt
+    std::reverse(spheres.begin(), spheres.end());
+    REQUIRE_FALSE(bvh.refit(pool, spheres.clone()));
+    REQUIRE(checkIntersections(bvh, spheres));
+
+    spheres.pop();
+    REQUIRE_FALSE(bvh.refit(pool, spheres.clone()));
+    REQUIRE(checkIntersections(bvh, spheres));
+}
+
+TEST_CASE("Bvh overlaps", "[bvh]") {
+    Array<BvhSphere> spheres = getSpheres(20000);
+    Bvh<BvhSphere> bvh;
+    bvh.build(spheres.clone());
+
+    VectorRng<BenzAsphaugRng> rng(5678);
+    auto test = [&](const Size UNUSED(i)) -> Outcome {
+        const Vector center = 10._f * rng();
+        const Box box(center - 0.5_f * rng(), center + 0.5_f * rng());
+        Array<Size> expected;
+        for (const BvhSphere& s : spheres) {
+            if (s.getBBox().overlaps(box)) {
+                expected.push(s.userData);
+            }
+        }
+        Array<Size> overlaps;
+        bvh.getOverlaps(box, [&overlaps](const BvhSphere& s) { overlaps.push(s.userData); });
+        std::sort(overlaps.begin(), overlaps.end());
+        if (overlaps != expected) {
+            return makeFailed("Incorrect overlaps: {} == {}", overlaps.size(), expected.size());
+        }
+        return SUCCESS;
+    };
+    REQUIRE_SEQUENCE(test, 0, 100);
+
+    bvh.getOverlaps(Box(Vector(20._f), Vector(21._f)), [](const BvhSphere&) { REQUIRE(false); });
+}
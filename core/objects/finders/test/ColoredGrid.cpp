@@ -0,0 +1,61 @@
+#include "objects/finders/ColoredGrid.h"
+#include "catch.hpp"
+#include "objects/finders/KdTree.h"
+#include "objects/geometry/Domain.h"
+#include "sph/initial/Distribution.h"
+#include "thread/Pool.h"
+#include "utils/SequenceTest.h"
+
+using namespace Sph;
+
+TEST_CASE("ColoredGrid iterate", "[finders]") {
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+    BlockDomain domain(Vector(0._f), Vector(2._f, 1._f, 1._f));
+    RandomDistribution distr(1234);
+    Array<Vector> r = distr.generate(pool, 2000, domain);
+    const Float radius = 2._f * r[0][H];
+
+    ColoredGrid grid;
+    grid.build(pool, r, radius);
+    REQUIRE(grid.getCellCnt() > ColoredGrid::COLOR_CNT);
+
+    KdTree<KdNode> finder;
+    finder.build(pool, r);
+
+    // each particle increments counters of itself and all its neighbors; as cells of the same color do not
+    // share any neighbors, no synchronization is needed
+    Array<Size> counts(r.size());
+    counts.fill(0);
+    struct ThreadData {
+        Array<NeighborRecord> neighs;
+    };
+    ThreadLocal<ThreadData> threadData(pool);
+    grid.iterate(pool, threadData, [&](const Size i, ThreadData& data) {
+        finder.findAll(i, radius, data.neighs);
+        for (const NeighborRecord& n : data.neighs) {
+            counts[n.index]++;
+        }
+    });
+
+    Array<NeighborRecord> neighs;
+    auto test = [&](const Size i) -> Outcome {
+        // the neighbor relation is symmetric, so each particle is visited by all its neighbors
+        const Size expected = finder.findAll(i, radius, neighs);
+        if (counts[i] != expected) {
+            return makeFailed("Invalid count of particle {}: {} == {}", i, counts[i], expected);
+        }
+        return SUCCESS;
+    };
+    REQUIRE_SEQUENCE(test, 0, r.size());
+}
+
+TEST_CASE("ColoredGrid empty", "[finders]") {
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+    ColoredGrid grid;
+    grid.build(pool, ArrayView<const Vector>(), 1._f);
+    REQUIRE(grid.getCellCnt() == 0);
+
+    ThreadLocal<Size> threadData(pool, 0);
+    grid.iterate(pool, threadData, [](const Size, Size& cnt) { ++cnt; });
+    REQUIRE(threadData.accumulate() == 0);
+}
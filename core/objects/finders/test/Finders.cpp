@@ -5,6 +5,7 @@
 #include "objects/finders/KdTree.h"
 #include "objects/finders/Octree.h"
 #include "objects/finders/UniformGrid.h"
+#include "math/rng/Rng.h"
 #include "objects/geometry/Domain.h"
 #include "objects/utility/Algorithm.h"
 #include "quantities/Storage.h"
@@ -382,6 +383,65 @@ TEST_CASE("KdTree empty leaf bug", "[finders]") {
     REQUIRE(callbacks.checkedCnt == 3);
 }
 
+static void checkNeighborsBruteForce(ISymmetricFinder& finder, ArrayView<const Vector> r) {
+    BruteForceFinder bf;
+    bf.build(SEQUENTIAL, r);
+    Array<NeighborRecord> neighs, bfNeighs;
+    auto test = [&](const Size i) -> Outcome {
+        finder.findAll(i, 0.7_f, neighs);
+        bf.findAll(i, 0.7_f, bfNeighs);
+        return checkNeighborsEqual(neighs, bfNeighs);
+    };
+    REQUIRE_SEQUENCE(test, 0, r.size());
+}
+
+TEST_CASE("KdTree refit", "[finders]") {
+    HexagonalPacking distr;
+    SphericalDomain domain(Vector(0._f), 2._f);
+    Array<Vector> r = distr.generate(SEQUENTIAL, 1000, domain);
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+
+    KdTree<KdNode> finder;
+    // not built yet, so it cannot be refitted
+    REQUIRE_FALSE(finder.refit(pool, r));
+    REQUIRE(finder.sanityCheck());
+
+    // small displacements keep the tree
+    UniformRng rng;
+    for (Size i = 0; i < r.size(); ++i) {
+        r[i] += 0.02_f * Vector(rng() - 0.5_f, rng() - 0.5_f, rng() - 0.5_f);
+    }
+    REQUIRE(finder.refit(pool, r));
+    REQUIRE(finder.sanityCheck());
+    checkNeighborsBruteForce(finder, r);
+
+    // the refit tree must still work with lower rank
+    Array<NeighborRecord> neighs;
+    Size neighCnt = 0;
+    for (Size i = 0; i < r.size(); ++i) {
+        neighCnt += finder.findLowerRank(i, 0.7_f, neighs);
+    }
+    BruteForceFinder bf;
+    bf.build(SEQUENTIAL, r);
+    Size bfNeighCnt = 0;
+    for (Size i = 0; i < r.size(); ++i) {
+        bfNeighCnt += bf.findAll(i, 0.7_f, neighs) - 1;
+    }
+    REQUIRE(2 * neighCnt == bfNeighCnt);
+
+    // shuffled particles cannot be refitted
+    std::reverse(r.begin(), r.end());
+    REQUIRE_FALSE(finder.refit(pool, r));
+    REQUIRE(finder.sanityCheck());
+    checkNeighborsBruteForce(finder, r);
+
+    // neither can a different number of particles
+    r.pop();
+    REQUIRE_FALSE(finder.refit(pool, r));
+    REQUIRE(finder.sanityCheck());
+    checkNeighborsBruteForce(finder, r);
+}
+
 TEST_CASE("UniformGridFinder", "[finders]") {
     UniformGridFinder finder;
     testFinder(finder);
@@ -0,0 +1,72 @@
+#include "objects/finders/NeighborList.h"
+#include "catch.hpp"
+#include "math/rng/VectorRng.h"
+#include "objects/finders/KdTree.h"
+#include "objects/geometry/Domain.h"
+#include "sph/initial/Distribution.h"
+#include "thread/Pool.h"
+#include "utils/SequenceTest.h"
+
+using namespace Sph;
+
+TEST_CASE("NeighborList rebuild", "[finders]") {
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+    SphericalDomain domain(Vector(0._f), 1._f);
+    HexagonalPacking distr;
+    Array<Vector> r = distr.generate(pool, 1000, domain);
+
+    KdTree<KdNode> finder;
+    finder.build(pool, r);
+    const Float kernelRadius = 2._f;
+    NeighborList list(0.2_f, kernelRadius);
+    REQUIRE(list.needsRebuild(pool, r));
+
+    list.build(pool, r, [&](const Size i, Array<NeighborRecord>& neighs) {
+        finder.findAll(i, 1.2_f * kernelRadius * r[i][H], neighs);
+    });
+    REQUIRE(list.getBuildCnt() == 1);
+    REQUIRE_FALSE(list.needsRebuild(pool, r));
+    REQUIRE(list.getReuseCnt() == 1);
+
+    // small displacement does not invalidate the list
+    VectorRng<UniformRng> rng;
+    for (Size i = 0; i < r.size(); ++i) {
+        const Vector dr = (rng() - Vector(0.5_f)) * 0.05_f * r[i][H];
+        r[i] += setH(dr, 0._f);
+    }
+    REQUIRE_FALSE(list.needsRebuild(pool, r));
+    REQUIRE(list.getReuseCnt() == 2);
+
+    // all actual neighbors must still be in the list
+    finder.build(pool, r);
+    Array<NeighborRecord> neighs;
+    auto test = [&](const Size i) -> Outcome {
+        finder.findAll(i, kernelRadius * r[i][H], neighs);
+        ArrayView<const Size> cached = list.getNeighbors(i);
+        for (const NeighborRecord& n : neighs) {
+            const Float hbar = 0.5_f * (r[i][H] + r[n.index][H]);
+            if (n.index == i || n.distanceSqr >= sqr(kernelRadius * hbar)) {
+                continue;
+            }
+            if (std::find(cached.begin(), cached.end(), n.index) == cached.end()) {
+                return makeFailed("Neighbor {} of particle {} not in the list", n.index, i);
+            }
+        }
+        return SUCCESS;
+    };
+    REQUIRE_SEQUENCE(test, 0, r.size());
+
+    // growing smoothing length consumes the skin
+    r[0][H] *= 1.3_f;
+    REQUIRE(list.needsRebuild(pool, r));
+    r[0][H] /= 1.3_f;
+
+    // large displacement of a single particle
+    r[5][X] += 0.5_f * r[5][H];
+    REQUIRE(list.needsRebuild(pool, r));
+
+    // different particle count
+    r.pop();
+    REQUIRE(list.needsRebuild(pool, r));
+    REQUIRE(list.getReuseCnt() == 2);
+}
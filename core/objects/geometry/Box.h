@@ -72,6 +72,18 @@ public:
         return true;
     }
 
+    /// \brief Checks if the box intersects another box.
+    ///
+    /// Boxes touching by their boundaries are assumed to intersect. Always returns false for empty boxes.
+    INLINE bool overlaps(const Box& other) const {
+        for (int i = 0; i < 3; ++i) {
+            if (other.maxBound[i] < minBound[i] || other.minBound[i] > maxBound[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     /// \brief Clamps all components of the vector to fit within the box
     INLINE Vector clamp(const Vector& v) const {
         SPH_ASSERT(isValid());
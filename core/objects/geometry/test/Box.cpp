@@ -149,3 +149,14 @@ TEST_CASE("Box intersect", "[box]") {
             Box(Vector(0._f, 1._f, 0._f), Vector(1._f, 2._f, 1._f)));
     REQUIRE(box.intersect(Box(Vector(3._f), Vector(4._f))) == Box::EMPTY());
 }
+
+TEST_CASE("Box overlaps", "[box]") {
+    Box box(Vector(0._f), Vector(2._f));
+    REQUIRE(box.overlaps(Box(Vector(1._f), Vector(3._f))));
+    REQUIRE(box.overlaps(Box(Vector(0.5_f), Vector(1._f))));
+    REQUIRE(box.overlaps(Box(Vector(2._f), Vector(3._f))));
+    REQUIRE_FALSE(box.overlaps(Box(Vector(0._f, 0._f, 3._f), Vector(1._f, 1._f, 4._f))));
+    REQUIRE_FALSE(box.overlaps(Box(Vector(-2._f, 0._f, 0._f), Vector(-1._f, 1._f, 1._f))));
+    REQUIRE_FALSE(box.overlaps(Box::EMPTY()));
+    REQUIRE_FALSE(Box::EMPTY().overlaps(box));
+}
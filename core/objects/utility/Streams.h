@@ -1,6 +1,7 @@
 #pragma once
 
 #include "io/Path.h"
+#include <cstring>
 #include <fstream>
 
 NAMESPACE_SPH_BEGIN
@@ -52,6 +53,23 @@ public:
     }
 };
 
+/// \brief Binary output stream appending data to a buffer in memory.
+///
+/// The stream does not own the buffer, it must be kept alive while the stream is used.
+class MemoryBinaryOutputStream : public IBinaryOutputStream {
+private:
+    Array<char>& buffer;
+
+public:
+    explicit MemoryBinaryOutputStream(Array<char>& buffer)
+        : buffer(buffer) {}
+
+    virtual bool write(ArrayView<const char> data) override {
+        buffer.pushAll(data.begin(), data.end());
+        return true;
+    }
+};
+
 class FileTextOutputStream : public ITextOutputStream {
 private:
     std::wofstream ofs;
@@ -95,6 +113,54 @@ public:
     }
 };
 
+/// \brief Binary input stream reading data from a buffer in memory.
+///
+/// The stream does not own the buffer, it must be kept alive while the stream is used.
+class MemoryBinaryInputStream : public IBinaryInputStream {
+private:
+    const char* data;
+    std::size_t size;
+    std::size_t pos = 0;
+
+public:
+    MemoryBinaryInputStream(const char* data, const std::size_t size)
+        : data(data)
+        , size(size) {}
+
+    virtual bool read(ArrayView<char> buffer) override {
+        if (size - pos < buffer.size()) {
+            return false;
+        }
+        if (!buffer.empty()) {
+            std::memcpy(&buffer[0], data + pos, buffer.size());
+        }
+        pos += buffer.size();
+        return true;
+    }
+
+    virtual bool skip(const Size cnt) override {
+        return this->seek(pos + cnt);
+    }
+
+    virtual bool good() const override {
+        return pos <= size;
+    }
+
+    /// \brief Moves the current position to given offset from the beginning of the buffer.
+    bool seek(const std::size_t offset) {
+        if (offset > size) {
+            return false;
+        }
+        pos = offset;
+        return true;
+    }
+
+    /// \brief Returns the current offset from the beginning of the buffer.
+    std::size_t position() const {
+        return pos;
+    }
+};
+
 class FileTextInputStream : public ITextInputStream {
 private:
     std::wifstream ifs;
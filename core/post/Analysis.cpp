@@ -16,6 +16,7 @@
 #include "sph/kernel/Kernel.h"
 #include "system/Factory.h"
 #include "thread/Scheduler.h"
+#include "thread/ThreadLocal.h"
 #include <numeric>
 #include <set>
 
@@ -33,48 +34,88 @@ Array<Size> Post::findNeighborCounts(const Storage& storage, const Float particl
     return counts;
 }
 
-static Size findComponentsImpl(const Post::IComponentChecker& checker,
+/// \brief Returns the root of the union-find tree containing given particle.
+///
+/// Performs path halving, so that subsequent queries are faster. Parent of each particle is never larger
+/// than the particle itself, so the root of each tree is the particle with the lowest index.
+static Size findRoot(ArrayView<std::atomic<Size>> parents, Size i) {
+    while (true) {
+        Size parent = parents[i].load(std::memory_order_relaxed);
+        if (parent == i) {
+            return i;
+        }
+        const Size grandParent = parents[parent].load(std::memory_order_relaxed);
+        if (grandParent != parent) {
+            // may fail if another thread modified the parent concurrently, which is fine
+            parents[i].compare_exchange_weak(parent, grandParent, std::memory_order_relaxed);
+        }
+        i = grandParent;
+    }
+}
+
+/// \brief Merges trees containing given two particles.
+///
+/// The root with the higher index is always linked under the root with the lower index, so the result does
+/// not depend on the order in which the particles are merged.
+static void unite(ArrayView<std::atomic<Size>> parents, Size i, Size j) {
+    while (true) {
+        i = findRoot(parents, i);
+        j = findRoot(parents, j);
+        if (i == j) {
+            return;
+        }
+        if (i < j) {
+            std::swap(i, j);
+        }
+        Size expected = i;
+        if (parents[i].compare_exchange_strong(expected, j, std::memory_order_relaxed)) {
+            return;
+        }
+        // root has been linked by another thread in the meantime, repeat with the new roots
+    }
+}
+
+static Size findComponentsImpl(IScheduler& scheduler,
+    IBasicFinder& finder,
+    Array<std::atomic<Size>>& parents,
+    const Post::IComponentChecker& checker,
     ArrayView<const Vector> r,
     const Float radius,
     Array<Size>& indices) {
-    // initialize stuff
-    indices.resize(r.size());
-    const Size unassigned = Size(-1);
-    indices.fill(unassigned);
-    Size componentIdx = 0;
-
-    Array<Size> stack;
-    Array<NeighborRecord> neighs;
+    const Size particleCnt = r.size();
+    if (parents.size() != particleCnt) {
+        parents = Array<std::atomic<Size>>(particleCnt);
+    }
+    for (Size i = 0; i < particleCnt; ++i) {
+        parents[i].store(i, std::memory_order_relaxed);
+    }
 
-    AutoPtr<IBasicFinder> finder = Factory::getFinder(RunSettings::getDefaults());
-    // the build time is probably negligible compared to the actual search of components, so let's just use
-    // the sequential execution here
-    finder->build(SEQUENTIAL, r);
+    // positions usually change only a little between consecutive calls, so try to reuse the tree
+    finder.refit(scheduler, r);
 
-    for (Size i = 0; i < r.size(); ++i) {
-        if (indices[i] == unassigned) {
-            indices[i] = componentIdx;
-            stack.push(i);
-            // find new neigbours recursively until we find all particles in the component
-            while (!stack.empty()) {
-                const Size index = stack.pop();
-                finder->findAll(index, r[index][H] * radius, neighs);
-                for (auto& n : neighs) {
-                    if (!checker.belong(index, n.index)) {
-                        // do not count as neighbors
-                        continue;
-                    }
-                    if (indices[n.index] == unassigned) {
-                        indices[n.index] = componentIdx;
-                        stack.push(n.index);
-                    }
-                }
+    ThreadLocal<Array<NeighborRecord>> neighsTl(scheduler);
+    parallelFor(scheduler, neighsTl, 0, particleCnt, [&](const Size i, Array<NeighborRecord>& neighs) {
+        finder.findAll(i, r[i][H] * radius, neighs);
+        for (const NeighborRecord& n : neighs) {
+            if (n.index != i && checker.belong(i, n.index)) {
+                unite(parents, i, n.index);
             }
-            componentIdx++;
         }
-    }
+    });
 
-    return componentIdx;
+    // roots are the particles with the lowest index in each component, so numbering the components in the
+    // order of their roots gives the same indices regardless of the scheduler
+    indices.resize(particleCnt);
+    parallelFor(scheduler, 0, particleCnt, [&parents, &indices](const Size i) {
+        indices[i] = findRoot(parents, i);
+    });
+    Size componentCnt = 0;
+    for (Size i = 0; i < particleCnt; ++i) {
+        const Size root = indices[i];
+        SPH_ASSERT(root <= i);
+        indices[i] = (root == i) ? componentCnt++ : indices[root];
+    }
+    return componentCnt;
 }
 
 struct ComponentChecker : public Post::IComponentChecker {
@@ -112,7 +153,13 @@ struct EscapeVelocityComponentChecker : public Post::IComponentChecker {
     }
 };
 
-Size Post::findComponents(const Storage& storage,
+Post::ComponentFinder::ComponentFinder()
+    : finder(Factory::getFinder(RunSettings::getDefaults())) {}
+
+Post::ComponentFinder::~ComponentFinder() = default;
+
+Size Post::ComponentFinder::find(IScheduler& scheduler,
+    const Storage& storage,
     const Float radius,
     const Flags<ComponentFlag> flags,
     Array<Size>& indices) {
@@ -125,7 +172,7 @@ Size Post::findComponents(const Storage& storage,
     }
 
     ArrayView<const Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
-    Size componentCnt = findComponentsImpl(*checker, r, radius, indices);
+    Size componentCnt = findComponentsImpl(scheduler, *finder, parents, *checker, r, radius, indices);
 
     if (flags.has(ComponentFlag::ESCAPE_VELOCITY)) {
         // now we have to merge components with relative velocity lower than the (mutual) escape velocity
@@ -164,8 +211,17 @@ Size Post::findComponents(const Storage& storage,
         velocityChecker.radius = radius;
 
         // run the component finder again, this time for the components found in the first step
+        // (components are not preserved between snapshots, so use a temporary finder)
+        AutoPtr<IBasicFinder> componentFinder = Factory::getFinder(RunSettings::getDefaults());
+        Array<std::atomic<Size>> componentParents;
         Array<Size> velocityIndices;
-        componentCnt = findComponentsImpl(velocityChecker, positions, 50._f, velocityIndices);
+        componentCnt = findComponentsImpl(scheduler,
+            *componentFinder,
+            componentParents,
+            velocityChecker,
+            positions,
+            50._f,
+            velocityIndices);
 
         // We should keep merging the components, as now we could have created a new component that was
         // previously undetected (three bodies bound to their center of gravity, where each two bodies move
@@ -216,19 +272,39 @@ Size Post::findComponents(const Storage& storage,
     return componentCnt;
 }
 
-Size Post::findComponents(const Storage& storage,
+Size Post::ComponentFinder::find(IScheduler& scheduler,
+    const Storage& storage,
     const Float radius,
     const IComponentChecker& checker,
     Array<Size>& indices) {
+    SPH_ASSERT(radius > 0._f);
     ArrayView<const Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
-    return findComponentsImpl(checker, r, radius, indices);
+    return findComponentsImpl(scheduler, *finder, parents, checker, r, radius, indices);
+}
+
+Size Post::findComponents(IScheduler& scheduler,
+    const Storage& storage,
+    const Float radius,
+    const Flags<ComponentFlag> flags,
+    Array<Size>& indices) {
+    return ComponentFinder().find(scheduler, storage, radius, flags, indices);
+}
+
+Size Post::findComponents(IScheduler& scheduler,
+    const Storage& storage,
+    const Float radius,
+    const IComponentChecker& checker,
+    Array<Size>& indices) {
+    return ComponentFinder().find(scheduler, storage, radius, checker, indices);
 }
 
-Array<Size> Post::findLargestComponent(const Storage& storage,
+Array<Size> Post::findLargestComponent(IScheduler& scheduler,
+    const Storage& storage,
     const Float particleRadius,
     const Flags<ComponentFlag> flags) {
     Array<Size> componentIdxs;
-    Post::findComponents(storage, particleRadius, flags | ComponentFlag::SORT_BY_MASS, componentIdxs);
+    Post::findComponents(
+        scheduler, storage, particleRadius, flags | ComponentFlag::SORT_BY_MASS, componentIdxs);
 
     // get the indices of the largest component (with index 0)
     Array<Size> idxs;
@@ -592,9 +668,10 @@ static Array<Float> getComponentValues(const Storage& storage,
     const Post::HistogramParams& params,
     const Post::HistogramId id) {
 
+    SharedPtr<IScheduler> scheduler = Factory::getScheduler();
     Array<Size> components;
     const Size numComponents =
-        findComponents(storage, params.components.radius, params.components.flags, components);
+        findComponents(*scheduler, storage, params.components.radius, params.components.flags, components);
 
     Array<Size> toRemove = processComponentCutoffs(storage, components, numComponents, params);
 
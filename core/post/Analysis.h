@@ -10,6 +10,7 @@
 #include "objects/wrappers/ExtendedEnum.h"
 #include "objects/wrappers/Function.h"
 #include "system/Settings.h"
+#include <atomic>
 
 NAMESPACE_SPH_BEGIN
 
@@ -54,9 +55,62 @@ enum class ComponentFlag {
     SORT_BY_MASS = 1 << 2,
 };
 
+/// \brief Checks if two particles belong to the same component
+struct IComponentChecker : public Polymorphic {
+    virtual bool belong(const Size i, const Size j) const = 0;
+};
+
+/// \brief Finds connected components in consecutive snapshots of a simulation.
+///
+/// Particles are merged using a lock-free union-find structure, while the neighbors are searched in parallel.
+/// Components are numbered in the order of their particle with the lowest index, so the result does not
+/// depend on the scheduler. The object keeps the neighbor finder between calls; if the particle count does
+/// not change, the finder is only refitted to the new positions, which is considerably faster than building
+/// it from scratch.
+class ComponentFinder : public Noncopyable {
+private:
+    AutoPtr<IBasicFinder> finder;
+
+    /// Union-find forest; parent of each particle has lower or equal index.
+    Array<std::atomic<Size>> parents;
+
+public:
+    ComponentFinder();
+
+    ~ComponentFinder();
+
+    /// \brief Finds and marks connected components (a.k.a. separated bodies) in the array of vertices.
+    ///
+    /// \param scheduler Scheduler used for parallelization.
+    /// \param storage Storage containing the particles. Must also contain QuantityId::FLAG if
+    ///                SEPARATE_BY_FLAG option is used.
+    /// \param particleRadius Size of particles in smoothing lengths.
+    /// \param flags Flags specifying connectivity of components, etc; see emum \ref ComponentFlag.
+    /// \param indices[out] Array of indices from 0 to n-1, where n is the number of components. In the array,
+    ///                     i-th index corresponds to component to which i-th particle belongs.
+    /// \return Number of components
+    Size find(IScheduler& scheduler,
+        const Storage& storage,
+        const Float particleRadius,
+        const Flags<ComponentFlag> flags,
+        Array<Size>& indices);
+
+    /// \brief Finds and marks connected components (a.k.a. separated bodies) in the array of vertices.
+    ///
+    /// Overload with a generic checker that returns whether two particles belong to the same component. The
+    /// checker must be symmetric and thread-safe.
+    Size find(IScheduler& scheduler,
+        const Storage& storage,
+        const Float particleRadius,
+        const IComponentChecker& checker,
+        Array<Size>& indices);
+};
+
 /// \brief Finds and marks connected components (a.k.a. separated bodies) in the array of vertices.
 ///
-/// It is a useful function for finding bodies in simulations where we do not merge particles.
+/// It is a useful function for finding bodies in simulations where we do not merge particles. To find
+/// components in a sequence of snapshots, use \ref ComponentFinder instead.
+/// \param scheduler Scheduler used for parallelization.
 /// \param storage Storage containing the particles. Must also contain QuantityId::FLAG if
 ///                SEPARATE_BY_FLAG option is used.
 /// \param particleRadius Size of particles in smoothing lengths.
@@ -64,20 +118,17 @@ enum class ComponentFlag {
 /// \param indices[out] Array of indices from 0 to n-1, where n is the number of components. In the array,
 ///                     i-th index corresponds to component to which i-th particle belongs.
 /// \return Number of components
-Size findComponents(const Storage& storage,
+Size findComponents(IScheduler& scheduler,
+    const Storage& storage,
     const Float particleRadius,
     const Flags<ComponentFlag> flags,
     Array<Size>& indices);
 
-/// \brief Checks if two particles belong to the same component
-struct IComponentChecker : public Polymorphic {
-    virtual bool belong(const Size i, const Size j) const = 0;
-};
-
 /// \brief Finds and marks connected components (a.k.a. separated bodies) in the array of vertices.
 ///
 /// Overload with a generic checker that returns whether two particles belong to the same component.
-Size findComponents(const Storage& storage,
+Size findComponents(IScheduler& scheduler,
+    const Storage& storage,
     const Float particleRadius,
     const IComponentChecker& checker,
     Array<Size>& indices);
@@ -85,7 +136,8 @@ Size findComponents(const Storage& storage,
 /// \brief Returns the indices of particles belonging to the largest remnant.
 ///
 /// The returned indices are sorted.
-Array<Size> findLargestComponent(const Storage& storage,
+Array<Size> findLargestComponent(IScheduler& scheduler,
+    const Storage& storage,
     const Float particleRadius,
     const Flags<ComponentFlag> flags);
 
@@ -675,7 +675,8 @@ Array<Triangle> getSurfaceMesh(IScheduler& scheduler, const Storage& storage, co
     mc.setProgressCallback(config.progressCallback);
 
     Array<Size> components;
-    const Size numComponents = Post::findComponents(storage, 2._f, Post::ComponentFlag::OVERLAP, components);
+    const Size numComponents =
+        Post::findComponents(scheduler, storage, 2._f, Post::ComponentFlag::OVERLAP, components);
 
     // 6. find the surface using marching cubes for each component
     Array<Box> boxes(numComponents);
@@ -2,6 +2,7 @@
 #include "catch.hpp"
 #include "io/FileSystem.h"
 #include "io/Path.h"
+#include "math/rng/Rng.h"
 #include "objects/geometry/Domain.h"
 #include "objects/utility/PerElementWrapper.h"
 #include "physics/Constants.h"
@@ -23,7 +24,8 @@ TEST_CASE("Components simple", "[post]") {
     Array<Size> components;
     Storage storage;
     storage.insert<Vector>(QuantityId::POSITION, OrderEnum::ZERO, std::move(r));
-    Size numComponents = Post::findComponents(storage, 2._f, Post::ComponentFlag::OVERLAP, components);
+    Size numComponents =
+        Post::findComponents(SEQUENTIAL, storage, 2._f, Post::ComponentFlag::OVERLAP, components);
     REQUIRE(numComponents == 3);
     REQUIRE(components == Array<Size>({ 0, 1, 2, 2 }));
 }
@@ -42,7 +44,8 @@ TEST_CASE("Component initconds", "[post]") {
     ArrayView<Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
     Array<Size> components;
     RunSettings settings;
-    const Size numComponents = Post::findComponents(storage, 2._f, Post::ComponentFlag::OVERLAP, components);
+    const Size numComponents =
+        Post::findComponents(SEQUENTIAL, storage, 2._f, Post::ComponentFlag::OVERLAP, components);
     REQUIRE(numComponents == 3);
     REQUIRE(components.size() > 0); // sanity check
 
@@ -77,7 +80,7 @@ TEST_CASE("Component by v_esc", "[post]") {
     const Float m0 = 1._f;
     storage.insert<Float>(QuantityId::MASS, OrderEnum::ZERO, m0);
     Size numComponents =
-        Post::findComponents(storage, 2._f, Post::ComponentFlag::ESCAPE_VELOCITY, components);
+        Post::findComponents(SEQUENTIAL, storage, 2._f, Post::ComponentFlag::ESCAPE_VELOCITY, components);
     // all particles still, one component only
     REQUIRE(numComponents == 1);
     REQUIRE(components == Array<Size>({ 0, 0, 0, 0 }));
@@ -86,16 +89,110 @@ TEST_CASE("Component by v_esc", "[post]") {
     auto v_esc = [m0](const Float dr) { return sqrt(4._f * m0 * Constants::gravity / dr); };
     v[0] = Vector(0.8_f * v_esc(3._f), 0._f, 0._f);
     // too low velocity, nothing should change
-    numComponents = Post::findComponents(storage, 2._f, Post::ComponentFlag::ESCAPE_VELOCITY, components);
+    numComponents =
+        Post::findComponents(SEQUENTIAL, storage, 2._f, Post::ComponentFlag::ESCAPE_VELOCITY, components);
     REQUIRE(numComponents == 1);
 
     v[0] = Vector(1.2_f * v_esc(3._f), 0._f, 0._f);
     // first and last particle are now separated
-    numComponents = Post::findComponents(storage, 2._f, Post::ComponentFlag::ESCAPE_VELOCITY, components);
+    numComponents =
+        Post::findComponents(SEQUENTIAL, storage, 2._f, Post::ComponentFlag::ESCAPE_VELOCITY, components);
     REQUIRE(numComponents == 2);
     REQUIRE(components == Array<Size>({ 0, 1, 1, 1 }));
 }
 
+/// Reference implementation, finding the components using depth-first search
+static Size findComponentsBruteForce(ArrayView<const Vector> r, const Float radius, Array<Size>& indices) {
+    indices.resize(r.size());
+    indices.fill(Size(-1));
+    Size componentCnt = 0;
+    for (Size i = 0; i < r.size(); ++i) {
+        if (indices[i] != Size(-1)) {
+            continue;
+        }
+        Array<Size> stack{ i };
+        indices[i] = componentCnt;
+        while (!stack.empty()) {
+            const Size j = stack.pop();
+            for (Size k = 0; k < r.size(); ++k) {
+                if (indices[k] == Size(-1) && getLength(r[j] - r[k]) < radius * max(r[j][H], r[k][H])) {
+                    indices[k] = componentCnt;
+                    stack.push(k);
+                }
+            }
+        }
+        componentCnt++;
+    }
+    return componentCnt;
+}
+
+static Storage getClusterStorage(const Size particleCnt, const Size seed) {
+    UniformRng rng(seed);
+    Array<Vector> r(particleCnt);
+    for (Size i = 0; i < particleCnt; ++i) {
+        r[i] = Vector(rng(), rng(), rng()) * 20._f;
+        r[i][H] = 0.4_f + 0.2_f * rng();
+    }
+    Storage storage;
+    storage.insert<Vector>(QuantityId::POSITION, OrderEnum::FIRST, std::move(r));
+    storage.insert<Float>(QuantityId::MASS, OrderEnum::ZERO, 1._f);
+    return storage;
+}
+
+TEST_CASE("Components parallel", "[post]") {
+    Storage storage = getClusterStorage(3000, 1234);
+    ArrayView<const Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+
+    Array<Size> expected;
+    const Size expectedCnt = findComponentsBruteForce(r, 2._f, expected);
+    REQUIRE(expectedCnt > 10);       // sanity check
+    REQUIRE(expectedCnt < r.size()); // sanity check
+
+    // components are numbered by the particle with the lowest index, so the indices must match exactly
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+    for (IScheduler* scheduler : { static_cast<IScheduler*>(&SEQUENTIAL), static_cast<IScheduler*>(&pool) }) {
+        Array<Size> components;
+        const Size componentCnt =
+            Post::findComponents(*scheduler, storage, 2._f, Post::ComponentFlag::OVERLAP, components);
+        REQUIRE(componentCnt == expectedCnt);
+        REQUIRE(components == expected);
+    }
+}
+
+TEST_CASE("ComponentFinder snapshots", "[post]") {
+    Storage storage = getClusterStorage(3000, 5678);
+    ArrayView<Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+    ArrayView<Vector> v = storage.getDt<Vector>(QuantityId::POSITION);
+    UniformRng rng;
+    for (Size i = 0; i < r.size(); ++i) {
+        v[i] = Vector(rng() - 0.5_f, rng() - 0.5_f, rng() - 0.5_f);
+    }
+
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+    Post::ComponentFinder finder;
+    for (Size snapshot = 0; snapshot < 5; ++snapshot) {
+        Array<Size> components;
+        const Size componentCnt = finder.find(pool, storage, 2._f, Post::ComponentFlag::OVERLAP, components);
+
+        Array<Size> expected;
+        REQUIRE(componentCnt == findComponentsBruteForce(r, 2._f, expected));
+        REQUIRE(components == expected);
+
+        for (Size i = 0; i < r.size(); ++i) {
+            r[i] += v[i] * 0.2_f;
+        }
+    }
+
+    // also works if the particle count changes
+    Array<Size> toRemove{ 0, 10, 20 };
+    storage.remove(toRemove);
+    Array<Size> components, expected;
+    const Size componentCnt = finder.find(pool, storage, 2._f, Post::ComponentFlag::OVERLAP, components);
+    r = storage.getValue<Vector>(QuantityId::POSITION);
+    REQUIRE(componentCnt == findComponentsBruteForce(r, 2._f, expected));
+    REQUIRE(components == expected);
+}
+
 static Storage getHistogramStorage() {
     Array<Vector> r(10);
     for (Size i = 0; i < r.size(); ++i) {
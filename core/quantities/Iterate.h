@@ -244,7 +244,7 @@ struct StorageVisitor<VisitorEnum::HIGHEST_DERIVATIVES> {
 template <>
 struct StoragePairVisitor<VisitorEnum::HIGHEST_DERIVATIVES> {
     template <typename TValue, typename TFunctor>
-    void visit(Quantity& q1, Quantity& q2, TFunctor&& functor) {
+    void visit(Quantity& q1, Quantity& q2, const QuantityId UNUSED(id), TFunctor&& functor) {
         const OrderEnum order1 = q1.getOrderEnum();
         SPH_ASSERT(order1 == q2.getOrderEnum());
         if (order1 == OrderEnum::FIRST) {
@@ -6,6 +6,7 @@
 #include "quantities/Iterate.h"
 #include "system/Factory.h"
 #include "system/Profiler.h"
+#include "thread/Scheduler.h"
 
 NAMESPACE_SPH_BEGIN
 
@@ -601,6 +602,66 @@ void Storage::zeroHighestDerivatives(IScheduler& scheduler) {
     }
 }
 
+namespace {
+struct CopyBuffersVisitor {
+    template <typename TValue>
+    void visit(const Quantity& source, Quantity& copy, IScheduler& scheduler) {
+        StaticArray<const Array<TValue>&, 3> sourceBuffers = source.getAll<TValue>();
+        StaticArray<Array<TValue>&, 3> copyBuffers = copy.getAll<TValue>();
+        for (Size i = 0; i < sourceBuffers.size(); ++i) {
+            const Array<TValue>& from = sourceBuffers[i];
+            Array<TValue>& to = copyBuffers[i];
+            to.resize(from.size());
+            parallelFor(scheduler, 0, from.size(), [&from, &to](const Size k) INL { to[k] = from[k]; });
+        }
+    }
+};
+} // namespace
+
+void Storage::copyInto(IScheduler& scheduler, Storage& target) const {
+    SPH_ASSERT(&target != this);
+    SPH_ASSERT(target.dependent.empty());
+
+    // check whether the target contains the same quantities, otherwise recreate them
+    bool sameQuantities = target.quantities.size() == quantities.size();
+    auto targetIter = target.quantities.begin();
+    for (auto iter = quantities.begin(); sameQuantities && iter != quantities.end(); ++iter, ++targetIter) {
+        const Quantity& q1 = iter->value();
+        const Quantity& q2 = targetIter->value();
+        sameQuantities = iter->key() == targetIter->key() && q1.getValueEnum() == q2.getValueEnum() &&
+                         q1.getOrderEnum() == q2.getOrderEnum();
+    }
+    if (!sameQuantities) {
+        target.quantities.clear();
+        for (const auto& q : quantities) {
+            target.quantities.insert(q.key(), q.value().createZeros(0));
+        }
+    }
+
+    CopyBuffersVisitor visitor;
+    targetIter = target.quantities.begin();
+    for (const auto& q : quantities) {
+        dispatch(q.value().getValueEnum(), visitor, q.value(), targetIter->value(), scheduler);
+        ++targetIter;
+    }
+
+    target.mats = mats.clone();
+    target.attractors = attractors.clone();
+    target.update();
+}
+
+void Storage::reallocate(IScheduler& scheduler) {
+    iterate<VisitorEnum::ALL_BUFFERS>(*this, [&scheduler](auto& buffer) {
+        using Type = typename std::decay_t<decltype(buffer)>::Type;
+        Array<Type> reallocated(buffer.size());
+        parallelFor(scheduler, 0, buffer.size(), [&reallocated, &buffer](const Size i) INL {
+            reallocated[i] = buffer[i];
+        });
+        buffer = std::move(reallocated);
+    });
+    this->update();
+}
+
 Storage Storage::clone(const Flags<VisitorEnum> buffers) const {
     SPH_ASSERT(!userData, "Cloning storages with user data is currently not supported");
     Storage cloned;
@@ -881,6 +942,46 @@ void Storage::removeSorted(ArrayView<const Size> sortedIdxs, const Flags<ValidFl
     SPH_ASSERT(this->isValid(flags), this->isValid(flags).error());
 }
 
+void Storage::reorder(IScheduler& scheduler, ArrayView<const Size> order, const Flags<IndicesFlag> flags) {
+    const Size particleCnt = this->getParticleCnt();
+    SPH_ASSERT(order.size() == particleCnt, order.size(), particleCnt);
+#ifdef SPH_DEBUG
+    for (const MatRange& mat : mats) {
+        for (Size i = mat.from; i < mat.to; ++i) {
+            SPH_ASSERT(order[i] >= mat.from && order[i] < mat.to, "Particle moved to a different material");
+        }
+    }
+#endif
+
+    iterate<VisitorEnum::ALL_BUFFERS>(*this, [&scheduler, order, particleCnt](auto& buffer) {
+        if (buffer.size() != particleCnt) {
+            // skip empty buffers of partially cloned storages
+            return;
+        }
+        using Type = typename std::decay_t<decltype(buffer)>::Type;
+        Array<Type> reordered(particleCnt);
+        parallelFor(scheduler, 0, particleCnt, [&reordered, &buffer, order](const Size i) INL {
+            reordered[i] = buffer[order[i]];
+        });
+        buffer = std::move(reordered);
+    });
+
+    // material ranges are unchanged, we only need to update the cached view
+    this->update();
+
+    if (userData) {
+        userData->reorder(order);
+    }
+
+    if (flags.has(IndicesFlag::PROPAGATE)) {
+        this->propagate([&scheduler, order](Storage& storage) { //
+            storage.reorder(scheduler, order);
+        });
+    }
+
+    SPH_ASSERT(this->isValid(EMPTY_FLAGS), this->isValid(EMPTY_FLAGS).error());
+}
+
 void Storage::removeAll() {
     this->propagate([](Storage& storage) { storage.removeAll(); });
     *this = Storage();
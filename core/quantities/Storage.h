@@ -131,6 +131,12 @@ public:
     ///
     /// \param idxs Sorted particle indices (in ascending order).
     virtual void remove(ArrayView<const Size> idxs) = 0;
+
+    /// \brief Permutes particle data.
+    ///
+    /// \param order New order of particles; i-th particle after the reordering was order[i]-th particle
+    ///              before the reordering.
+    virtual void reorder(ArrayView<const Size> order) = 0;
 };
 
 /// \brief Exception thrown when accessing missing quantities, casting to different types, etc.
@@ -538,6 +544,29 @@ public:
     /// \param idxs Indices of particles to remove. No need to sort the indices.
     void remove(ArrayView<const Size> idxs, const Flags<IndicesFlag> flags = EMPTY_FLAGS);
 
+    /// \brief Changes the order of particles in the storage.
+    ///
+    /// Permutes values and derivatives of all quantities, including persistent indices, so the reordered
+    /// particles keep their identity. Stored \ref IStorageUserData are reordered as well. Particles cannot be
+    /// moved to a different material, i.e. the permutation must map each material range onto itself, checked
+    /// by assert. The function invalidates any \ref ArrayView to quantity values or derivatives.
+    /// \param scheduler Scheduler used to permute the buffers in parallel.
+    /// \param order New order of particles; i-th particle after the reordering was order[i]-th particle
+    ///              before the reordering.
+    /// \param flags Options of the reordering; only PROPAGATE is applicable.
+    void reorder(IScheduler& scheduler,
+        ArrayView<const Size> order,
+        const Flags<IndicesFlag> flags = EMPTY_FLAGS);
+
+    /// \brief Moves the values and derivatives of all quantities into newly allocated buffers.
+    ///
+    /// The buffers are initialized in parallel. Operating systems usually place a memory page on the NUMA node
+    /// of the thread that first writes into it, so the function places the particle data close to the
+    /// threads processing them, provided the scheduler assigns the same particles to the same threads in
+    /// all parallel loops (see \ref WorkStealingPool). Values of the quantities are unchanged. The function
+    /// invalidates any \ref ArrayView to quantity values or derivatives.
+    void reallocate(IScheduler& scheduler);
+
     /// \brief Removes all particles with all quantities (including materials) from the storage.
     ///
     /// The storage is left is a state as if it was default-constructed. Dependent storages are also cleared.
@@ -552,6 +581,14 @@ public:
     /// parameters in cloned storage will also modify the parameters in the parent storage.
     Storage clone(const Flags<VisitorEnum> buffers) const;
 
+    /// \brief Copies all quantities, materials and attractors into the target storage.
+    ///
+    /// Unlike \ref clone, the function reuses the memory of the target storage if it contains the same
+    /// quantities, so it can be used to repeatedly make snapshots of the storage without reallocating. Values
+    /// are copied in parallel. Materials are shared with this storage. User data and dependent storages are
+    /// not copied and the target storage must not have any dependent storages.
+    void copyInto(IScheduler& scheduler, Storage& target) const;
+
     /// Options for the storage resize
     enum class ResizeFlag {
         /// Empty buffers will not be resized to new values.
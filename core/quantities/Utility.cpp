@@ -1,9 +1,14 @@
 #include "quantities/Utility.h"
+#include "math/Morton.h"
 #include "objects/finders/NeighborFinder.h"
 #include "objects/geometry/Box.h"
 #include "objects/utility/Algorithm.h"
+#include "quantities/IMaterial.h"
+#include "quantities/Iterate.h"
 #include "system/Factory.h"
 #include "thread/Scheduler.h"
+#include "thread/ThreadLocal.h"
+#include <algorithm>
 
 NAMESPACE_SPH_BEGIN
 
@@ -122,5 +127,80 @@ void moveToCenterOfMassFrame(Storage& storage) {
     }
 }
 
+Array<Size> getSpatialOrder(IScheduler& scheduler, const Storage& storage) {
+    const Size particleCnt = storage.getParticleCnt();
+    Array<Size> order(particleCnt);
+    if (particleCnt == 0) {
+        return order;
+    }
+
+    // the box includes the particle radii, so it has non-zero size even for planar or linear setups
+    const Box box = getBoundingBox(storage);
+    ArrayView<const Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+    Array<Size> codes(particleCnt);
+    parallelFor(scheduler, 0, particleCnt, [&order, &codes, &box, r](const Size i) {
+        order[i] = i;
+        codes[i] = morton(r[i], box);
+    });
+
+    auto sortRange = [&order, &codes](const Size from, const Size to) {
+        // sort the indices as well to get a deterministic order for particles with the same code
+        std::sort(order.begin() + from, order.begin() + to, [&codes](const Size i, const Size j) {
+            return codes[i] < codes[j] || (codes[i] == codes[j] && i < j);
+        });
+    };
+    if (storage.getMaterialCnt() > 0) {
+        for (Size matId = 0; matId < storage.getMaterialCnt(); ++matId) {
+            const IndexSequence seq = storage.getMaterial(matId).sequence();
+            sortRange(*seq.begin(), *seq.end());
+        }
+    } else {
+        sortRange(0, particleCnt);
+    }
+    return order;
+}
+
+Float getNonlocalFraction(IScheduler& scheduler, const Storage& storage, const Float radius) {
+    const Size particleCnt = storage.getParticleCnt();
+    if (particleCnt < 2) {
+        return 0._f;
+    }
+    ArrayView<const Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+    ThreadLocal<Size> nonlocalCnt(scheduler, 0);
+    parallelFor(scheduler, nonlocalCnt, 1, particleCnt, [r, radius](const Size i, Size& cnt) {
+        const Float hbar = 0.5_f * (r[i][H] + r[i - 1][H]);
+        if (getSqrLength(r[i] - r[i - 1]) >= sqr(radius * hbar)) {
+            ++cnt;
+        }
+    });
+    return Float(nonlocalCnt.accumulate()) / (particleCnt - 1);
+}
+
+ParticleBackup::ParticleBackup(const Storage& storage, Array<Size>&& particleIdxs)
+    : idxs(std::move(particleIdxs)) {
+    iterate<VisitorEnum::ALL_BUFFERS>(storage, [this](const auto& buffer) {
+        using Type = typename std::decay_t<decltype(buffer)>::Type;
+        Array<Type>& values = buffers.template get<Values<Type>>().values;
+        if (buffer.empty()) {
+            return;
+        }
+        for (Size i : idxs) {
+            values.push(buffer[i]);
+        }
+    });
+}
+
+void ParticleBackup::restore(Storage& storage) {
+    iterate<VisitorEnum::ALL_BUFFERS>(storage, [this](auto& buffer) {
+        using Type = typename std::decay_t<decltype(buffer)>::Type;
+        Values<Type>& saved = buffers.template get<Values<Type>>();
+        if (buffer.empty()) {
+            return;
+        }
+        for (Size i : idxs) {
+            buffer[i] = saved.values[saved.offset++];
+        }
+    });
+}
 
 NAMESPACE_SPH_END
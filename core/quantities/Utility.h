@@ -1,6 +1,8 @@
 #pragma once
 
+#include "objects/containers/Tuple.h"
 #include "quantities/Attractor.h"
+#include "quantities/QuantityHelpers.h"
 #include "quantities/Storage.h"
 
 NAMESPACE_SPH_BEGIN
@@ -29,6 +31,50 @@ void moveInertialFrame(Storage& storage, const Vector& positionOffset, const Vec
 /// total momentum is zero.
 void moveToCenterOfMassFrame(Storage& storage);
 
+/// \brief Returns the order of particles along the Morton curve.
+///
+/// Particles are sorted separately within each material, so the returned order can be passed to \ref
+/// Storage::reorder. Particles close to each other in space are then also close to each other in memory.
+Array<Size> getSpatialOrder(IScheduler& scheduler, const Storage& storage);
+
+/// \brief Returns the fraction of particles that do not interact with their predecessor in the storage.
+///
+/// Serves as a cheap measure of memory locality of particles; the value is close to zero right after the
+/// particles are sorted by \ref getSpatialOrder and increases as particles move.
+/// \param radius Dimensionless interaction radius, in units of smoothing length.
+Float getNonlocalFraction(IScheduler& scheduler, const Storage& storage, const Float radius = 2._f);
+
+/// \brief Copy of all quantities of selected particles.
+///
+/// Allows to undo changes of the selected particles, provided the particles have not been added, removed or
+/// reordered in the meantime.
+class ParticleBackup : public Noncopyable {
+private:
+    template <typename T>
+    struct Values {
+        Array<T> values;
+        Size offset = 0;
+    };
+
+    Array<Size> idxs;
+
+    Tuple<Values<Size>,
+        Values<Float>,
+        Values<Vector>,
+        Values<SymmetricTensor>,
+        Values<TracelessTensor>,
+        Values<Tensor>>
+        buffers;
+
+public:
+    ParticleBackup(const Storage& storage, Array<Size>&& particleIdxs);
+
+    /// \brief Copies the saved values back to the storage.
+    ///
+    /// Storage must contain the same quantities as when the backup was created. Can be only called once.
+    void restore(Storage& storage);
+};
+
 /// \brief Provides generic transform of positions.
 template <typename TPositionFunc>
 void transform(Storage& storage, const TPositionFunc& func) {
@@ -1,6 +1,7 @@
 #include "quantities/Storage.h"
 #include "catch.hpp"
 #include "objects/Exceptions.h"
+#include "objects/utility/Algorithm.h"
 #include "physics/Eos.h"
 #include "quantities/Attractor.h"
 #include "quantities/IMaterial.h"
@@ -8,6 +9,7 @@
 #include "sph/Materials.h"
 #include "system/Factory.h"
 #include "system/Settings.h"
+#include "thread/Pool.h"
 #include "utils/Utils.h"
 
 using namespace Sph;
@@ -424,6 +426,112 @@ TEST_CASE("Storage remove", "[storage]") {
     REQUIRE(storage1.getMaterial(0).sequence() == IndexSequence(0, 2));
 }
 
+TEST_CASE("Storage reorder", "[storage]") {
+    class ReorderedData : public IStorageUserData {
+    public:
+        Array<Size> order;
+
+        virtual void remove(ArrayView<const Size> UNUSED(idxs)) override {}
+
+        virtual void reorder(ArrayView<const Size> newOrder) override {
+            order.clear();
+            order.pushAll(newOrder.begin(), newOrder.end());
+        }
+    };
+
+    SharedPtr<Storage> storage1 = makeShared<Storage>(getMaterial(MaterialEnum::BASALT));
+    storage1->insert<Size>(QuantityId::FLAG, OrderEnum::ZERO, Array<Size>{ 0, 1, 2 });
+    storage1->insert<Float>(QuantityId::ENERGY, OrderEnum::FIRST, Array<Float>{ 3._f, 4._f, 5._f });
+    Storage other(getMaterial(MaterialEnum::BASALT));
+    other.insert<Size>(QuantityId::FLAG, OrderEnum::ZERO, Array<Size>{ 3, 4 });
+    other.insert<Float>(QuantityId::ENERGY, OrderEnum::FIRST, Array<Float>{ 6._f, 7._f });
+    storage1->merge(std::move(other));
+    setPersistentIndices(*storage1);
+    storage1->getDt<Float>(QuantityId::ENERGY) = Array<Float>{ 8._f, 9._f, 10._f, 11._f, 12._f };
+
+    SharedPtr<Storage> storage2 = makeShared<Storage>(storage1->clone(VisitorEnum::ALL_BUFFERS));
+    storage1->addDependent(storage2);
+    SharedPtr<ReorderedData> data = makeShared<ReorderedData>();
+    storage1->setUserData(data);
+
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+    const Array<Size> order{ 2, 0, 1, 4, 3 };
+    storage1->reorder(pool, order, Storage::IndicesFlag::PROPAGATE);
+    REQUIRE(storage1->getValue<Size>(QuantityId::FLAG) == Array<Size>({ 2, 0, 1, 4, 3 }));
+    REQUIRE(storage1->getValue<Size>(QuantityId::PERSISTENT_INDEX) == Array<Size>({ 2, 0, 1, 4, 3 }));
+    REQUIRE(storage1->getValue<Float>(QuantityId::ENERGY) == Array<Float>({ 5._f, 3._f, 4._f, 7._f, 6._f }));
+    REQUIRE(storage1->getDt<Float>(QuantityId::ENERGY) == Array<Float>({ 10._f, 8._f, 9._f, 12._f, 11._f }));
+    REQUIRE(storage1->getMaterial(0).sequence() == IndexSequence(0, 3));
+    REQUIRE(storage1->getMaterial(1).sequence() == IndexSequence(3, 5));
+    REQUIRE(storage1->isValid());
+    REQUIRE(data->order == order);
+    REQUIRE(storage2->getValue<Size>(QuantityId::FLAG) == Array<Size>({ 2, 0, 1, 4, 3 }));
+
+    // particles cannot be moved to another material
+    REQUIRE_SPH_ASSERT(storage1->reorder(pool, Array<Size>{ 3, 0, 1, 2, 4 }));
+}
+
+TEST_CASE("Storage reallocate", "[storage]") {
+    Storage storage(getMaterial(MaterialEnum::BASALT));
+    storage.insert<Vector>(QuantityId::POSITION, OrderEnum::SECOND, Array<Vector>(10000));
+    storage.insert<Float>(QuantityId::MASS, OrderEnum::ZERO, 2._f);
+    ArrayView<Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+    for (Size i = 0; i < r.size(); ++i) {
+        r[i] = Vector(i, 2 * i, 3 * i, 1._f);
+    }
+    storage.getD2t<Vector>(QuantityId::POSITION)[5] = Vector(4._f);
+    const Vector* ptr = &storage.getValue<Vector>(QuantityId::POSITION)[0];
+
+    storage.reallocate(*ThreadPool::getGlobalInstance());
+    REQUIRE(&storage.getValue<Vector>(QuantityId::POSITION)[0] != ptr);
+    r = storage.getValue<Vector>(QuantityId::POSITION);
+    REQUIRE(r.size() == 10000);
+    for (Size i = 0; i < r.size(); ++i) {
+        REQUIRE(r[i] == Vector(i, 2 * i, 3 * i, 1._f));
+    }
+    REQUIRE(storage.getD2t<Vector>(QuantityId::POSITION)[5] == Vector(4._f));
+    REQUIRE(allMatching(storage.getValue<Float>(QuantityId::MASS), [](const Float m) { return m == 2._f; }));
+    REQUIRE(storage.getMaterial(0).sequence() == IndexSequence(0, 10000));
+    REQUIRE(storage.isValid());
+}
+
+TEST_CASE("Storage copyInto", "[storage]") {
+    Storage storage(getMaterial(MaterialEnum::BASALT));
+    storage.insert<Vector>(QuantityId::POSITION, OrderEnum::SECOND, Array<Vector>(5000));
+    storage.insert<Float>(QuantityId::DENSITY, OrderEnum::FIRST, 3._f);
+    ArrayView<Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+    for (Size i = 0; i < r.size(); ++i) {
+        r[i] = Vector(i, 0._f, 0._f, 1._f);
+    }
+    storage.getDt<Float>(QuantityId::DENSITY)[3] = 4._f;
+
+    Storage target;
+    storage.copyInto(*ThreadPool::getGlobalInstance(), target);
+    REQUIRE(target.getParticleCnt() == 5000);
+    REQUIRE(target.getQuantityCnt() == storage.getQuantityCnt());
+    REQUIRE(target.getValue<Vector>(QuantityId::POSITION) == storage.getValue<Vector>(QuantityId::POSITION));
+    REQUIRE(target.getDt<Float>(QuantityId::DENSITY)[3] == 4._f);
+    REQUIRE(target.getQuantity(QuantityId::DENSITY).getOrderEnum() == OrderEnum::FIRST);
+    REQUIRE(target.getMaterialCnt() == 1);
+    REQUIRE(target.isValid());
+
+    // second copy reuses the buffers
+    const Vector* ptr = &target.getValue<Vector>(QuantityId::POSITION)[0];
+    r[7] = Vector(-1._f);
+    storage.copyInto(*ThreadPool::getGlobalInstance(), target);
+    REQUIRE(&target.getValue<Vector>(QuantityId::POSITION)[0] == ptr);
+    REQUIRE(target.getValue<Vector>(QuantityId::POSITION)[7] == Vector(-1._f));
+
+    // different quantities replace the content
+    Storage other;
+    other.insert<Float>(QuantityId::MASS, OrderEnum::ZERO, Array<Float>{ 1._f, 2._f });
+    other.copyInto(*ThreadPool::getGlobalInstance(), target);
+    REQUIRE(target.getParticleCnt() == 2);
+    REQUIRE(target.getQuantityCnt() == 1);
+    REQUIRE(target.has(QuantityId::MASS));
+    REQUIRE(target.getMaterialCnt() == 0);
+}
+
 TEST_CASE("Storage removeAll", "[storage]") {
     Storage storage;
     storage.insert<Float>(QuantityId::FLAG, OrderEnum::ZERO, Array<Float>{ 0 }); // dummy unit
@@ -4,6 +4,9 @@
 #include "quantities/Quantity.h"
 #include "sph/initial/Initial.h"
 #include "tests/Approx.h"
+#include "tests/Setup.h"
+#include "thread/Pool.h"
+#include <random>
 
 using namespace Sph;
 
@@ -72,3 +75,32 @@ TEST_CASE("Utility moveToCenterOfMassSystem", "[utility]") {
     moveToCenterOfMassFrame(storage);
     REQUIRE(getCenterOfMass(storage) == approx(Vector(0._f)));
 }
+
+TEST_CASE("Utility getSpatialOrder", "[utility]") {
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+    Storage storage = Tests::getGassStorage(1000);
+
+    // scramble the particles to simulate a storage after a long run
+    Array<Size> shuffled(storage.getParticleCnt());
+    for (Size i = 0; i < shuffled.size(); ++i) {
+        shuffled[i] = i;
+    }
+    std::mt19937 g(1234);
+    std::shuffle(shuffled.begin(), shuffled.end(), g);
+    storage.reorder(pool, shuffled);
+    REQUIRE(getNonlocalFraction(pool, storage) > 0.8_f);
+
+    Array<Size> order = getSpatialOrder(pool, storage);
+    REQUIRE(order.size() == storage.getParticleCnt());
+    Array<Size> sorted = order.clone();
+    std::sort(sorted.begin(), sorted.end());
+    bool isPermutation = true;
+    for (Size i = 0; i < sorted.size(); ++i) {
+        isPermutation &= sorted[i] == i;
+    }
+    REQUIRE(isPermutation);
+
+    storage.reorder(pool, order);
+    REQUIRE(getNonlocalFraction(pool, storage) < 0.2_f);
+    REQUIRE(storage.isValid());
+}
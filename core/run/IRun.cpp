@@ -4,6 +4,7 @@
 #include "io/Output.h"
 #include "physics/Integrals.h"
 #include "quantities/IMaterial.h"
+#include "quantities/Utility.h"
 #include "run/Trigger.h"
 #include "sph/Diagnostics.h"
 #include "sph/boundary/Boundary.h"
@@ -89,6 +90,58 @@ public:
     }
 };
 
+/// \brief Sorts particles along a space-filling curve to improve the memory locality.
+///
+/// The particles are reordered every given number of time steps, or sooner if the measured locality degrades
+/// by more than the given threshold.
+class ReorderTrigger : public ITrigger {
+private:
+    IScheduler& scheduler;
+
+    /// Number of time steps between reorderings; 0 means the period is not used
+    Size period;
+
+    /// Allowed increase of the nonlocal fraction; see \ref getNonlocalFraction
+    Float threshold;
+
+    /// Nonlocal fraction right after the last reordering
+    Float baseline = 0._f;
+
+    /// Number of time steps since the last reordering
+    Size stepCnt = 0;
+
+    /// Total number of reorderings
+    Size reorderCnt = 0;
+
+public:
+    ReorderTrigger(IScheduler& scheduler, const RunSettings& settings)
+        : scheduler(scheduler) {
+        period = settings.get<int>(RunSettingsId::RUN_REORDER_PERIOD);
+        threshold = settings.get<Float>(RunSettingsId::RUN_REORDER_LOCALITY_THRESHOLD);
+    }
+
+    virtual TriggerEnum type() const override {
+        return TriggerEnum::REPEATING;
+    }
+
+    virtual bool condition(const Storage& storage, const Statistics& UNUSED(stats)) override {
+        ++stepCnt;
+        if (reorderCnt == 0 || (period > 0 && stepCnt >= period)) {
+            return true;
+        }
+        return getNonlocalFraction(scheduler, storage) > baseline + threshold;
+    }
+
+    virtual AutoPtr<ITrigger> action(Storage& storage, Statistics& stats) override {
+        Array<Size> order = getSpatialOrder(scheduler, storage);
+        storage.reorder(scheduler, order, Storage::IndicesFlag::PROPAGATE);
+        baseline = getNonlocalFraction(scheduler, storage);
+        stepCnt = 0;
+        ++reorderCnt;
+        stats.set(StatisticsId::REORDER_COUNT, int(reorderCnt));
+        return nullptr;
+    }
+};
 
 class NullRunCallbacks : public IRunCallbacks {
 public:
@@ -216,6 +269,11 @@ Statistics IRun::run(Storage& input, IRunCallbacks& callbacks) {
     // set uninitilized variables
     setNullToDefaults(storage);
 
+    if (settings.get<bool>(RunSettingsId::RUN_THREAD_NUMA)) {
+        // move the particle data to NUMA nodes of threads processing them
+        storage->reallocate(*scheduler);
+    }
+
     // fetch parameters of run from settings
     const Interval timeRange(
         settings.get<Float>(RunSettingsId::RUN_START_TIME), settings.get<Float>(RunSettingsId::RUN_END_TIME));
@@ -232,6 +290,10 @@ Statistics IRun::run(Storage& input, IRunCallbacks& callbacks) {
     stats.set(StatisticsId::RUN_TIME, timeRange.lower());
     stats.set(StatisticsId::TIMESTEP_VALUE, initialDt);
 
+    if (settings.get<bool>(RunSettingsId::RUN_REORDER_ENABLE)) {
+        triggers.pushBack(makeAuto<ReorderTrigger>(*scheduler, settings));
+    }
+
     callbacks.onSetUp(*storage, stats);
     Outcome result = SUCCESS;
 
@@ -329,6 +391,13 @@ void IRun::setNullToDefaults(SharedPtr<Storage> storage) {
 }
 
 void IRun::tearDownInternal(const Storage& storage, const Statistics& stats) {
+    if (output) {
+        // make sure all output files are written before the run ends
+        const Outcome flushed = output->flush();
+        if (!flushed) {
+            logger->write(flushed.error());
+        }
+    }
     this->tearDown(storage, stats);
 
     triggers.clear();
@@ -48,17 +48,100 @@ VirtualSettings LoadFileJob::getSettings() {
         .setPathType(IVirtualEntry::PathType::INPUT_FILE)
         .setFileFormats(getInputFormats());
     cat.connect("Unit system", "units", units);
+
+    selection.addCategory(connector);
     return connector;
 }
 
+InputSelection::InputSelection() {
+    quantities = EnumWrapper::fromFlags(Flags<OutputQuantityFlag>(OutputQuantityFlag::POSITION,
+        OutputQuantityFlag::VELOCITY,
+        OutputQuantityFlag::SMOOTHING_LENGTH,
+        OutputQuantityFlag::MASS));
+}
+
+InputSelection::~InputSelection() = default;
+
+void InputSelection::addCategory(VirtualSettings& connector) {
+    VirtualSettings::Category& cat = connector.addCategory("Selection");
+    cat.connect("Select quantities", "select_quantities", selectQuantities);
+    cat.connect("Quantities", "quantities", quantities).setEnabler([this] { return selectQuantities; });
+    cat.connect("Select particles", "select_particles", selectParticles);
+    cat.connect("First particle", "first_particle", firstParticle).setEnabler([this] {
+        return selectParticles;
+    });
+    cat.connect("Particle count", "particle_cnt", particleCnt).setEnabler([this] { return selectParticles; });
+}
+
+/// Returns the IDs of stored quantities corresponding to given flags; positions are always loaded.
+static Array<QuantityId> getQuantityIds(const Flags<OutputQuantityFlag> flags) {
+    // velocities and smoothing lengths are stored in positions
+    Array<QuantityId> ids{ QuantityId::POSITION };
+    if (flags.has(OutputQuantityFlag::MASS)) {
+        ids.push(QuantityId::MASS);
+    }
+    if (flags.has(OutputQuantityFlag::PRESSURE)) {
+        ids.push(QuantityId::PRESSURE);
+    }
+    if (flags.has(OutputQuantityFlag::DENSITY)) {
+        ids.push(QuantityId::DENSITY);
+    }
+    if (flags.has(OutputQuantityFlag::ENERGY)) {
+        ids.push(QuantityId::ENERGY);
+    }
+    if (flags.has(OutputQuantityFlag::DEVIATORIC_STRESS)) {
+        ids.push(QuantityId::DEVIATORIC_STRESS);
+    }
+    if (flags.has(OutputQuantityFlag::DAMAGE)) {
+        ids.push(QuantityId::DAMAGE);
+    }
+    if (flags.has(OutputQuantityFlag::ANGULAR_FREQUENCY)) {
+        ids.push(QuantityId::ANGULAR_FREQUENCY);
+    }
+    if (flags.has(OutputQuantityFlag::STRAIN_RATE_CORRECTION_TENSOR)) {
+        ids.push(QuantityId::STRAIN_RATE_CORRECTION_TENSOR);
+    }
+    if (flags.has(OutputQuantityFlag::MATERIAL_ID)) {
+        ids.push(QuantityId::MATERIAL_ID);
+    }
+    return ids;
+}
+
+Outcome InputSelection::load(const Path& path, Storage& storage, Statistics& stats) {
+    if (!MappedInput::isSupported(path)) {
+        AutoPtr<IInput> input = Factory::getInput(path);
+        return input->load(path, storage, stats);
+    }
+
+    if (!mappedInput) {
+        mappedInput = makeAuto<MappedInput>();
+    }
+    mappedInput->select(this->getQuantities(), this->getParticles());
+    return mappedInput->load(path, storage, stats);
+}
+
+Array<QuantityId> InputSelection::getQuantities() const {
+    if (!selectQuantities) {
+        return {};
+    }
+    return getQuantityIds(Flags<OutputQuantityFlag>::fromValue(int(quantities)));
+}
+
+Optional<IndexSequence> InputSelection::getParticles() const {
+    if (!selectParticles) {
+        return NOTHING;
+    }
+    const Size from = Size(max(firstParticle, 0));
+    return IndexSequence(from, from + Size(max(particleCnt, 0)));
+}
+
 void LoadFileJob::evaluate(const RunSettings& UNUSED(global), IRunCallbacks& UNUSED(callbacks)) {
     if (!FileSystem::pathExists(path)) {
         throw InvalidSetup("File '" + path.string() + "' does not exist or cannot be accessed.");
     }
-    AutoPtr<IInput> input = Factory::getInput(path);
     Storage storage;
     Statistics stats;
-    Outcome outcome = input->load(path, storage, stats);
+    Outcome outcome = selection.load(path, storage, stats);
     if (!outcome) {
         throw InvalidSetup(outcome.error());
     }
@@ -104,6 +187,7 @@ VirtualSettings FileSequenceJob::getSettings() {
         .setFileFormats(getInputFormats());
     inputCat.connect("Maximum framerate", "max_fps", maxFps);
 
+    selection.addCategory(connector);
     return connector;
 }
 
@@ -140,43 +224,81 @@ FlatMap<Size, Path> getFileSequence(const Path& firstFile) {
 }
 
 
-void FileSequenceJob::evaluate(const RunSettings& UNUSED(global), IRunCallbacks& callbacks) {
-    AutoPtr<IInput> input = Factory::getInput(firstFile);
-    Storage storage;
-    Statistics stats;
+/// Passes the loaded frame to callbacks and waits to keep the maximal framerate.
+/// \return False if the run has been aborted.
+static bool processFrame(Storage& storage,
+    Statistics& stats,
+    IRunCallbacks& callbacks,
+    const Size index,
+    const Size firstIndex,
+    const Size lastIndex,
+    const Timer& frameTimer,
+    const int maxFps) {
+    stats.set(StatisticsId::INDEX, int(index));
+    if (lastIndex > firstIndex) {
+        stats.set(StatisticsId::RELATIVE_PROGRESS, Float(index - firstIndex) / (lastIndex - firstIndex));
+    } else {
+        stats.set(StatisticsId::RELATIVE_PROGRESS, 1._f);
+    }
 
-    FlatMap<Size, Path> sequence = getFileSequence(firstFile);
-    const Size firstIndex = sequence.begin()->key();
-    const Size lastIndex = (sequence.end() - 1)->key();
-    for (auto& element : sequence) {
-        const Size index = element.key();
+    if (index == firstIndex) {
+        callbacks.onSetUp(storage, stats);
+    }
+    callbacks.onTimeStep(storage, stats);
 
-        Timer frameTimer;
-        Outcome outcome = input->load(element.value(), storage, stats);
-        if (!outcome) {
-            throw InvalidSetup(outcome.error());
-        }
+    if (callbacks.shouldAbortRun()) {
+        return false;
+    }
 
-        stats.set(StatisticsId::INDEX, int(index));
-        if (sequence.size() > 1) {
-            stats.set(StatisticsId::RELATIVE_PROGRESS, Float(index - firstIndex) / (lastIndex - firstIndex));
-        } else {
-            stats.set(StatisticsId::RELATIVE_PROGRESS, 1._f);
-        }
+    const Size elapsed = Size(frameTimer.elapsed(TimerUnit::MILLISECOND));
+    const Size minElapsed = 1000 / maxFps;
+    if (elapsed < minElapsed) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(minElapsed - elapsed));
+    }
+    return true;
+}
 
-        if (index == firstIndex) {
-            callbacks.onSetUp(storage, stats);
-        }
-        callbacks.onTimeStep(storage, stats);
+void FileSequenceJob::evaluate(const RunSettings& UNUSED(global), IRunCallbacks& callbacks) {
+    Storage storage;
+    Statistics stats;
 
-        if (callbacks.shouldAbortRun()) {
-            break;
+    if (ArchiveInput::isSupported(firstFile)) {
+        // all frames are stored in a single file; the number of frames is checked after each frame, so that
+        // frames appended by a running simulation are also loaded
+        ArchiveInput input(selection.getQuantities(), selection.getParticles());
+        Expected<Size> frameCnt = input.getFrameCnt(firstFile);
+        if (!frameCnt) {
+            throw InvalidSetup(frameCnt.error());
         }
-
-        const Size elapsed = Size(frameTimer.elapsed(TimerUnit::MILLISECOND));
-        const Size minElapsed = 1000 / maxFps;
-        if (elapsed < minElapsed) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(minElapsed - elapsed));
+        for (Size index = 0; index < frameCnt.value(); ++index) {
+            Timer frameTimer;
+            Outcome outcome = input.loadFrame(firstFile, index, storage, stats);
+            if (!outcome) {
+                throw InvalidSetup(outcome.error());
+            }
+            if (!processFrame(
+                    storage, stats, callbacks, index, 0, frameCnt.value() - 1, frameTimer, maxFps)) {
+                break;
+            }
+            frameCnt = input.getFrameCnt(firstFile);
+            if (!frameCnt) {
+                throw InvalidSetup(frameCnt.error());
+            }
+        }
+    } else {
+        FlatMap<Size, Path> sequence = getFileSequence(firstFile);
+        const Size firstIndex = sequence.begin()->key();
+        const Size lastIndex = (sequence.end() - 1)->key();
+        for (auto& element : sequence) {
+            Timer frameTimer;
+            Outcome outcome = selection.load(element.value(), storage, stats);
+            if (!outcome) {
+                throw InvalidSetup(outcome.error());
+            }
+            if (!processFrame(
+                    storage, stats, callbacks, element.key(), firstIndex, lastIndex, frameTimer, maxFps)) {
+                break;
+            }
         }
     }
 
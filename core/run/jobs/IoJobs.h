@@ -1,10 +1,12 @@
 #pragma once
 
+#include "objects/utility/IteratorAdapters.h"
 #include "run/Job.h"
 
 NAMESPACE_SPH_BEGIN
 
 class Triangle;
+class MappedInput;
 
 enum class UnitEnum {
     SI,
@@ -14,10 +16,45 @@ enum class UnitEnum {
 
 Float getGravityConstant(const UnitEnum units);
 
+/// \brief Subset of quantities and particles loaded from binary and compressed files.
+///
+/// The selection is exposed as job settings. Files are loaded by \ref MappedInput, kept by the job, so that
+/// the index of the file is reused when the job is evaluated again.
+class InputSelection {
+private:
+    bool selectQuantities = false;
+    EnumWrapper quantities;
+    bool selectParticles = false;
+    int firstParticle = 0;
+    int particleCnt = 1000;
+
+    AutoPtr<MappedInput> mappedInput;
+
+public:
+    InputSelection();
+
+    ~InputSelection();
+
+    /// \brief Adds the selection entries into given settings.
+    void addCategory(VirtualSettings& connector);
+
+    /// \brief Loads the selected data from given file.
+    ///
+    /// Formats not supported by \ref MappedInput are loaded as a whole.
+    Outcome load(const Path& path, Storage& storage, Statistics& stats);
+
+    /// \brief Returns the selected quantities, or an empty array if all quantities are loaded.
+    Array<QuantityId> getQuantities() const;
+
+    /// \brief Returns the selected particles, or NOTHING if all particles are loaded.
+    Optional<IndexSequence> getParticles() const;
+};
+
 class LoadFileJob : public IParticleJob {
 private:
     Path path;
     EnumWrapper units = EnumWrapper(UnitEnum::SI);
+    InputSelection selection;
 
 public:
     LoadFileJob(const Path& path = Path("file.ssf"))
@@ -53,6 +90,8 @@ private:
 
     int maxFps = 10;
 
+    InputSelection selection;
+
 public:
     FileSequenceJob(const String& name, const Path& firstFile = Path("file_0000.ssf"))
         : IParticleJob(name)
@@ -683,7 +683,7 @@ VirtualSettings ExtractComponentJob::getSettings() {
     return connector;
 }
 
-void ExtractComponentJob::evaluate(const RunSettings& UNUSED(global), IRunCallbacks& UNUSED(callbacks)) {
+void ExtractComponentJob::evaluate(const RunSettings& global, IRunCallbacks& UNUSED(callbacks)) {
     Storage storage = std::move(this->getInput<ParticleData>("particles")->storage);
 
     // allow using this for storage without masses --> add ad hoc mass if it's missing
@@ -691,8 +691,9 @@ void ExtractComponentJob::evaluate(const RunSettings& UNUSED(global), IRunCallba
         storage.insert<Float>(QuantityId::MASS, OrderEnum::ZERO, 1._f);
     }
 
+    SharedPtr<IScheduler> scheduler = Factory::getScheduler(global);
     Array<Size> components;
-    Post::findComponents(storage, factor, Post::ComponentFlag::SORT_BY_MASS, components);
+    Post::findComponents(*scheduler, storage, factor, Post::ComponentFlag::SORT_BY_MASS, components);
 
     Array<Size> toRemove;
     for (Size i = 0; i < components.size(); ++i) {
@@ -793,7 +794,7 @@ VirtualSettings MergeComponentsJob::getSettings() {
     return connector;
 }
 
-void MergeComponentsJob::evaluate(const RunSettings& UNUSED(global), IRunCallbacks& UNUSED(callbacks)) {
+void MergeComponentsJob::evaluate(const RunSettings& global, IRunCallbacks& UNUSED(callbacks)) {
     SharedPtr<ParticleData> particles = this->getInput<ParticleData>("particles");
     Storage& input = particles->storage;
 
@@ -807,7 +808,8 @@ void MergeComponentsJob::evaluate(const RunSettings& UNUSED(global), IRunCallbac
     if (ConnectivityEnum(connectivity) == ConnectivityEnum::ESCAPE_VELOCITY) {
         flags = Post::ComponentFlag::ESCAPE_VELOCITY;
     }
-    const Size componentCount = Post::findComponents(input, factor, flags, components);
+    SharedPtr<IScheduler> scheduler = Factory::getScheduler(global);
+    const Size componentCount = Post::findComponents(*scheduler, input, factor, flags, components);
 
     ArrayView<const Float> m = input.getValue<Float>(QuantityId::MASS);
     ArrayView<const Vector> r = input.getValue<Vector>(QuantityId::POSITION);
@@ -913,12 +915,12 @@ VirtualSettings EmplaceComponentsAsFlagsJob::getSettings() {
     return connector;
 }
 
-void EmplaceComponentsAsFlagsJob::evaluate(const RunSettings& UNUSED(global),
-    IRunCallbacks& UNUSED(callbacks)) {
+void EmplaceComponentsAsFlagsJob::evaluate(const RunSettings& global, IRunCallbacks& UNUSED(callbacks)) {
     Storage fragments = std::move(this->getInput<ParticleData>("fragments")->storage);
 
+    SharedPtr<IScheduler> scheduler = Factory::getScheduler(global);
     Array<Size> components;
-    Post::findComponents(fragments, factor, Post::ComponentFlag::SORT_BY_MASS, components);
+    Post::findComponents(*scheduler, fragments, factor, Post::ComponentFlag::SORT_BY_MASS, components);
 
     Storage original = std::move(this->getInput<ParticleData>("original")->storage);
     if (!original.has(QuantityId::FLAG)) {
@@ -93,7 +93,8 @@ static void addGravityCategory(VirtualSettings& connector, RunSettings& settings
     gravityCat.connect<EnumWrapper>("Gravity solver", settings, RunSettingsId::GRAVITY_SOLVER);
     gravityCat.connect<Float>("Opening angle", settings, RunSettingsId::GRAVITY_OPENING_ANGLE)
         .setEnabler([&settings] {
-            return settings.get<GravityEnum>(RunSettingsId::GRAVITY_SOLVER) == GravityEnum::BARNES_HUT;
+            const GravityEnum solver = settings.get<GravityEnum>(RunSettingsId::GRAVITY_SOLVER);
+            return solver == GravityEnum::BARNES_HUT || solver == GravityEnum::FAST_MULTIPOLE;
         });
     gravityCat.connect<int>("Multipole order", settings, RunSettingsId::GRAVITY_MULTIPOLE_ORDER);
     gravityCat.connect<EnumWrapper>("Softening kernel", settings, RunSettingsId::GRAVITY_KERNEL);
@@ -275,6 +276,14 @@ VirtualSettings SphJob::getSettings() {
         .setEnabler([this] {
             return settings.get<SolverEnum>(RunSettingsId::SPH_SOLVER_TYPE) == SolverEnum::ASYMMETRIC_SOLVER;
         });
+    solverCat.connect<bool>("Cache neighbor lists", settings, RunSettingsId::SPH_USE_NEIGHBOR_LIST);
+    solverCat.connect<Float>("Neighbor list skin", settings, RunSettingsId::SPH_NEIGHBOR_LIST_SKIN)
+        .setEnabler([this] { return settings.get<bool>(RunSettingsId::SPH_USE_NEIGHBOR_LIST); });
+    solverCat
+        .connect<bool>("Colored accumulation", settings, RunSettingsId::SPH_SYMMETRIC_COLORED_ACCUMULATION)
+        .setEnabler([this] {
+            return settings.get<SolverEnum>(RunSettingsId::SPH_SOLVER_TYPE) == SolverEnum::SYMMETRIC_SOLVER;
+        });
     solverCat
         .connect<bool>("Apply correction tensor", settings, RunSettingsId::SPH_STRAIN_RATE_CORRECTION_TENSOR)
         .setEnabler(stressEnabler);
@@ -624,6 +633,7 @@ VirtualSettings PositionBasedJob::getSettings() {
     VirtualSettings::Category& solverCat = connector.addCategory("Solver");
     solverCat.connect<int>("Iteration count", settings, RunSettingsId::PBD_ITERATION_COUNT);
     solverCat.connect<Float>("Relaxation parameter", settings, RunSettingsId::PBD_RELAXATION_PARAMETER);
+    solverCat.connect<bool>("Gauss-Seidel iterations", settings, RunSettingsId::PBD_GAUSS_SEIDEL);
     solverCat.connect<EnumWrapper>("Neighbor finder", settings, RunSettingsId::SPH_FINDER);
 
     addGravityCategory(connector, settings);
@@ -29,6 +29,16 @@ void GhostParticlesData::remove(ArrayView<const Size> idxs) {
     }
 }
 
+void GhostParticlesData::reorder(ArrayView<const Size> order) {
+    Array<Size> inverse(order.size());
+    for (Size i = 0; i < order.size(); ++i) {
+        inverse[order[i]] = i;
+    }
+    for (Ghost& g : ghosts) {
+        g.index = inverse[g.index];
+    }
+}
+
 GhostParticles::GhostParticles(SharedPtr<IDomain> domain, const Float searchRadius, const Float minimalDist)
     : domain(std::move(domain)) {
     SPH_ASSERT(this->domain);
@@ -64,6 +64,8 @@ public:
     }
 
     virtual void remove(ArrayView<const Size> idxs) override;
+
+    virtual void reorder(ArrayView<const Size> order) override;
 };
 
 /// \brief Adds ghost particles symmetrically for each SPH particle close to boundary.
@@ -36,6 +36,20 @@ template void Accumulated::insert<SymmetricTensor>(const QuantityId, const Order
 template void Accumulated::insert<TracelessTensor>(const QuantityId, const OrderEnum, const BufferSource);
 
 void Accumulated::initialize(IScheduler& scheduler, const Size size) {
+    if (scheduler.hasStaticAssignment()) {
+        // clear the resized buffers in parallel, so that the memory pages are first touched by the threads
+        // that later accumulate the values
+        for (Element& e : buffers) {
+            forValue(e.buffer, [&scheduler, size](auto& values) {
+                using T = typename std::decay_t<decltype(values)>::Type;
+                if (values.size() != size) {
+                    values.resize(size);
+                    parallelFor(scheduler, 0, size, [&values](const Size i) INL { values[i] = T(0._f); });
+                }
+            });
+        }
+    }
+
     parallelFor(scheduler, buffers, [size](Element& e) {
         forValue(e.buffer, [size](auto& values) {
             using T = typename std::decay_t<decltype(values)>::Type;
@@ -93,6 +93,29 @@ void DerivativeHolder::require(AutoPtr<IDerivative>&& derivative) {
     derivatives.insert(std::move(derivative));
 }
 
+AutoPtr<IDerivative> DerivativeHolder::release(const std::type_info& type) {
+    SPH_ASSERT(needsCreate, "Cannot remove derivatives after the holder has been initialized");
+    for (auto iter = derivatives.begin(); iter != derivatives.end(); ++iter) {
+        const IDerivative& value = **iter;
+        if (typeid(value) == type) {
+            AutoPtr<IDerivative> derivative = std::move(*iter);
+            derivatives.erase(iter);
+            return derivative;
+        }
+    }
+    return nullptr;
+}
+
+bool DerivativeHolder::contains(const std::type_info& type) const {
+    for (const AutoPtr<IDerivative>& d : derivatives) {
+        const IDerivative& value = *d;
+        if (typeid(value) == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void DerivativeHolder::initialize(IScheduler& scheduler, const Storage& input) {
     if (needsCreate) {
         // lazy buffer creation
@@ -110,6 +133,12 @@ void DerivativeHolder::initialize(IScheduler& scheduler, const Storage& input) {
     }
 }
 
+void DerivativeHolder::initializeShared(const Storage& input, Accumulated& shared) {
+    for (const auto& deriv : derivatives) {
+        deriv->initialize(input, shared);
+    }
+}
+
 void DerivativeHolder::eval(const Size idx, ArrayView<const Size> neighs, ArrayView<const Vector> grads) {
     SPH_ASSERT(neighs.size() == grads.size());
     for (const auto& deriv : derivatives) {
@@ -180,8 +180,11 @@ private:
                 // sort primarily by phases
                 return d1->phase() < d2->phase();
             }
-            // used sorting of pointers for order within the same phase
-            return &*d1 < &*d2;
+            // within the same phase, sort by types; each type is stored at most once and the order does not
+            // depend on the memory layout, so the derivatives are summed up in the same order in every run
+            const IDerivative& v1 = *d1;
+            const IDerivative& v2 = *d2;
+            return typeid(v1).before(typeid(v2));
         }
     };
 
@@ -204,9 +207,25 @@ public:
     /// If derivative has the same type, but different internal state, exception InvalidState is thrown.
     virtual void require(AutoPtr<IDerivative>&& derivative);
 
+    /// \brief Removes the derivative of given type from the holder and returns it.
+    ///
+    /// Returns nullptr if the holder does not contain a derivative of this type. Can be only called before
+    /// the holder is initialized.
+    virtual AutoPtr<IDerivative> release(const std::type_info& type);
+
+    /// \brief Returns true if the holder contains a derivative of given type.
+    bool contains(const std::type_info& type) const;
+
     /// \brief Initialize derivatives before loop.
     virtual void initialize(IScheduler& scheduler, const Storage& input);
 
+    /// \brief Initialize derivatives before loop, using buffers of another holder.
+    ///
+    /// The derivatives accumulate directly into the provided buffers, the buffers of this holder are not
+    /// allocated at all. The shared buffers must be already initialized by a holder with the same set of
+    /// derivatives. The caller is responsible for avoiding concurrent writes into the same elements.
+    void initializeShared(const Storage& input, Accumulated& shared);
+
     /// \brief Evaluates all held derivatives for given particle.
     void eval(const Size idx, ArrayView<const Size> neighs, ArrayView<const Vector> grads);
 
@@ -123,6 +123,24 @@ public:
         });
     }
 
+    /// \brief Evaluates the derivative for a single particle pair.
+    ///
+    /// Used by \ref FusedDerivative to evaluate several derivatives in a single loop over neighbors. The pair
+    /// is skipped if it does not satisfy the criteria given by the flags.
+    template <bool Symmetrize>
+    INLINE void evalPair(const Size i, const Size j, const Vector& grad) {
+        SPH_ASSERT(!Symmetrize || !C);
+        if (reduce && (idxs[i] != idxs[j] || reduce[i] == 0._f || reduce[j] == 0._f)) {
+            return;
+        }
+        if (!Symmetrize && C) {
+            SPH_ASSERT(C[i] != SymmetricTensor::null());
+            derived()->template eval<false>(i, j, C[i] * grad);
+        } else {
+            derived()->template eval<Symmetrize>(i, j, grad);
+        }
+    }
+
 private:
     template <typename TFunctor>
     INLINE void sum(const Size i,
@@ -253,6 +271,23 @@ public:
         });
     }
 
+    /// \brief Evaluates the force and heating for a single particle pair and adds them to given values.
+    ///
+    /// Used by \ref FusedDerivative; the caller is responsible for multiplying the values by the masses and
+    /// adding them to the accumulated buffers. The pair is skipped if it does not satisfy the criteria given
+    /// by the flags.
+    template <bool Symmetrize>
+    INLINE void evalPair(const Size i, const Size j, const Vector& grad, Vector& f, Float& de) {
+        if (reduce && (idxs[i] != idxs[j] || reduce[i] == 0._f || reduce[j] == 0._f)) {
+            return;
+        }
+        Vector fij;
+        Float deij;
+        tieToTuple(fij, deij) = derived()->template eval<Symmetrize>(i, j, grad);
+        f += fij;
+        de += deij;
+    }
+
 private:
     template <typename TFunctor>
     INLINE void sum(const Size i,
@@ -2,6 +2,8 @@
 #include "objects/Exceptions.h"
 #include "sph/Materials.h"
 #include "sph/equations/DerivativeHelpers.h"
+#include "sph/equations/FusedDerivative.h"
+#include "sph/equations/av/Standard.h"
 #include "sph/kernel/Kernel.h"
 #include "system/Factory.h"
 #include "thread/Scheduler.h"
@@ -435,4 +437,49 @@ void ConstSmoothingLength::finalize(IScheduler& scheduler, Storage& storage, con
 
 void ConstSmoothingLength::create(Storage& UNUSED(storage), IMaterial& UNUSED(material)) const {}
 
+
+/// \brief Fuses derivatives of the standard equations for solids and fluids, see \ref getStandardEquations.
+///
+/// Only the largest combination contained in the holder is fused, other derivatives are kept unchanged.
+template <typename TVelocityDiscr, typename TForceDiscr>
+static void fuseStandardDerivatives(DerivativeHolder& derivatives) {
+    using Divergence = VelocityDivergence<TVelocityDiscr>;
+    using Gradient = VelocityGradient<TVelocityDiscr>;
+    using Pressure = PressureGradient<TForceDiscr>;
+    using Stress = StressDivergence<TForceDiscr>;
+    using AV = StandardAV::Derivative;
+
+    // solids
+    if (fuseDerivatives<Divergence, Gradient, Pressure, Stress, AV>(derivatives) ||
+        fuseDerivatives<Divergence, Gradient, Pressure, Stress>(derivatives)) {
+        return;
+    }
+    // fluids
+    if (!fuseDerivatives<Divergence, Pressure, AV>(derivatives)) {
+        fuseDerivatives<Divergence, Pressure>(derivatives);
+    }
+}
+
+void EquationHolder::setDerivatives(DerivativeHolder& derivatives, const RunSettings& settings) const {
+    for (const auto& term : terms) {
+        term->setDerivatives(derivatives, settings);
+    }
+
+    if (!settings.get<bool>(RunSettingsId::SPH_FUSED_DERIVATIVES)) {
+        return;
+    }
+    const DiscretizationEnum formulation =
+        settings.get<DiscretizationEnum>(RunSettingsId::SPH_DISCRETIZATION);
+    switch (formulation) {
+    case DiscretizationEnum::STANDARD:
+        fuseStandardDerivatives<CenterDensityDiscr, StandardForceDiscr>(derivatives);
+        break;
+    case DiscretizationEnum::BENZ_ASPHAUG:
+        fuseStandardDerivatives<NeighborDensityDiscr, BenzAsphaugForceDiscr>(derivatives);
+        break;
+    default:
+        NOT_IMPLEMENTED;
+    }
+}
+
 NAMESPACE_SPH_END
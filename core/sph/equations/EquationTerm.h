@@ -274,11 +274,10 @@ public:
     }
 
     /// \brief Calls \ref EquationTerm::setDerivatives for all stored equation terms.
-    void setDerivatives(DerivativeHolder& derivatives, const RunSettings& settings) const {
-        for (const auto& term : terms) {
-            term->setDerivatives(derivatives, settings);
-        }
-    }
+    ///
+    /// If enabled by \ref RunSettingsId::SPH_FUSED_DERIVATIVES, common combinations of the required
+    /// derivatives are then replaced by a \ref FusedDerivative.
+    void setDerivatives(DerivativeHolder& derivatives, const RunSettings& settings) const;
 
     /// \brief Calls \ref EquationTerm::initialize for all stored equation terms.
     void initialize(IScheduler& scheduler, Storage& storage, const Float t) {
@@ -0,0 +1,157 @@
+#pragma once
+
+/// \file FusedDerivative.h
+/// \brief Evaluation of several derivatives in a single loop over neighbors
+/// \author Pavel Sevecek (sevecek at sirrah.troja.mff.cuni.cz)
+/// \date 2016-2021
+
+#include "sph/equations/DerivativeHelpers.h"
+
+NAMESPACE_SPH_BEGIN
+
+/// \brief Derivative evaluating several other derivatives in a single pass over the neighbors.
+///
+/// Derivatives held by \ref DerivativeHolder are evaluated one by one, each using a virtual call and a
+/// separate loop over neighbors. This derivative combines a set of derivatives known at compile time; the
+/// neighbors are visited only once and terms of all derivatives are evaluated for each particle pair,
+/// allowing the compiler to inline the terms and share the loaded quantities. The forces and heating of all
+/// fused accelerations are summed up and written into the accumulated buffers once per pair.
+///
+/// Fused derivatives must derive either from \ref DerivativeTemplate or \ref AccelerationTemplate and at
+/// least one of them must be an acceleration.
+template <typename... TDerivatives>
+class FusedDerivative : public IAcceleration {
+    static_assert(AnyTrue<std::is_base_of<IAcceleration, TDerivatives>::value...>::value,
+        "At least one of fused derivatives must be an acceleration");
+
+private:
+    Tuple<AutoPtr<TDerivatives>...> derivatives;
+
+    ArrayView<Vector> dv;
+    ArrayView<Float> du;
+    ArrayView<const Float> m;
+
+public:
+    explicit FusedDerivative(AutoPtr<TDerivatives>&&... derivatives)
+        : derivatives(std::move(derivatives)...) {}
+
+    virtual void create(Accumulated& results) override {
+        forEach(derivatives, [&results](auto& derivative) { derivative->create(results); });
+    }
+
+    virtual void initialize(const Storage& input, Accumulated& results) override {
+        forEach(derivatives, [&input, &results](auto& derivative) { derivative->initialize(input, results); });
+
+        dv = results.getBuffer<Vector>(QuantityId::POSITION, OrderEnum::SECOND);
+        du = results.getBuffer<Float>(QuantityId::ENERGY, OrderEnum::FIRST);
+        m = input.getValue<Float>(QuantityId::MASS);
+    }
+
+    virtual void evalNeighs(const Size i, ArrayView<const Size> neighs, ArrayView<const Vector> grads) override {
+        SPH_ASSERT(neighs.size() == grads.size());
+        for (Size k = 0; k < neighs.size(); ++k) {
+            const Size j = neighs[k];
+            Vector f(0._f);
+            Float de = 0._f;
+            forEach(derivatives, [i, j, &grads, k, &f, &de](auto& derivative) INL {
+                evalPair<false>(*derivative, i, j, grads[k], f, de);
+            });
+            dv[i] += m[j] * f;
+            du[i] += m[j] * de;
+        }
+    }
+
+    virtual void evalSymmetric(const Size i,
+        ArrayView<const Size> neighs,
+        ArrayView<const Vector> grads) override {
+        SPH_ASSERT(neighs.size() == grads.size());
+        for (Size k = 0; k < neighs.size(); ++k) {
+            const Size j = neighs[k];
+            Vector f(0._f);
+            Float de = 0._f;
+            forEach(derivatives, [i, j, &grads, k, &f, &de](auto& derivative) INL {
+                evalPair<true>(*derivative, i, j, grads[k], f, de);
+            });
+            dv[i] += m[j] * f;
+            dv[j] -= m[i] * f;
+            du[i] += m[j] * de;
+            du[j] += m[i] * de;
+        }
+    }
+
+    virtual void evalAcceleration(const Size i,
+        ArrayView<const Size> neighs,
+        ArrayView<const Vector> grads,
+        ArrayView<Vector> dvk) override {
+        SPH_ASSERT(neighs.size() == grads.size() && neighs.size() == dvk.size());
+        for (Size k = 0; k < neighs.size(); ++k) {
+            const Size j = neighs[k];
+            Vector f(0._f);
+            Float de = 0._f;
+            // only accelerations are evaluated here, other derivatives have been already computed
+            forEach(derivatives, [i, j, &grads, k, &f, &de](auto& derivative) INL {
+                evalForce(*derivative, i, j, grads[k], f, de);
+            });
+            dvk[k] += m[j] * f;
+        }
+    }
+
+private:
+    template <bool Symmetrize, typename TDerived>
+    INLINE static void evalPair(DerivativeTemplate<TDerived>& derivative,
+        const Size i,
+        const Size j,
+        const Vector& grad,
+        Vector& UNUSED(f),
+        Float& UNUSED(de)) {
+        derivative.template evalPair<Symmetrize>(i, j, grad);
+    }
+
+    template <bool Symmetrize, typename TDerived>
+    INLINE static void evalPair(AccelerationTemplate<TDerived>& derivative,
+        const Size i,
+        const Size j,
+        const Vector& grad,
+        Vector& f,
+        Float& de) {
+        derivative.template evalPair<Symmetrize>(i, j, grad, f, de);
+    }
+
+    template <typename TDerived>
+    INLINE static void evalForce(DerivativeTemplate<TDerived>& UNUSED(derivative),
+        const Size UNUSED(i),
+        const Size UNUSED(j),
+        const Vector& UNUSED(grad),
+        Vector& UNUSED(f),
+        Float& UNUSED(de)) {}
+
+    template <typename TDerived>
+    INLINE static void evalForce(AccelerationTemplate<TDerived>& derivative,
+        const Size i,
+        const Size j,
+        const Vector& grad,
+        Vector& f,
+        Float& de) {
+        derivative.template evalPair<false>(i, j, grad, f, de);
+    }
+};
+
+/// \brief Replaces the given derivatives in the holder with a single \ref FusedDerivative.
+///
+/// The derivatives are fused only if the holder contains all of them, otherwise the holder is unchanged.
+/// Must be called before the holder is initialized.
+/// \return True if the derivatives have been fused, false otherwise.
+template <typename... TDerivatives>
+bool fuseDerivatives(DerivativeHolder& holder) {
+    const bool contained[] = { holder.contains(typeid(TDerivatives))... };
+    for (bool c : contained) {
+        if (!c) {
+            return false;
+        }
+    }
+    holder.require(makeAuto<FusedDerivative<TDerivatives...>>(
+        dynamicCast<TDerivatives>(holder.release(typeid(TDerivatives)))...));
+    return true;
+}
+
+NAMESPACE_SPH_END
@@ -37,8 +37,7 @@ private:
 
         template <bool Symmetrize>
         INLINE void eval(const Size i, const Size j, const Vector& UNUSED(grad)) {
-            // there is no need to use this in asymmetric solver, since we already know all the neighbors
-            SPH_ASSERT(Symmetrize);
+            // asymmetric evaluation is used by solvers evaluating only a subset of particles
             neighCnts[i]++;
             if (Symmetrize) {
                 neighCnts[j]++;
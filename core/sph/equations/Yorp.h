@@ -24,9 +24,9 @@ public:
 
     virtual void initialize(IScheduler& UNUSED(scheduler), Storage& UNUSED(storage)) override {}
 
-    virtual void finalize(IScheduler& UNUSED(scheduler), Storage& storage) override {
+    virtual void finalize(IScheduler& scheduler, Storage& storage) override {
         if (idxs.empty() || (stepCounter % recomputationPeriod == 0)) {
-            idxs = Post::findLargestComponent(storage, 2._f, Post::ComponentFlag::OVERLAP);
+            idxs = Post::findLargestComponent(scheduler, storage, 2._f, Post::ComponentFlag::OVERLAP);
         }
         stepCounter++;
 
@@ -100,6 +100,24 @@ TEST_CASE("Setting derivatives", "[equationterm]") {
     REQUIRE(TestDerivative::initialized);
 }
 
+TEST_CASE("EquationHolder fused derivatives", "[equationterm]") {
+    RunSettings settings;
+    settings.set(RunSettingsId::SPH_SOLVER_FORCES, ForceEnum::PRESSURE | ForceEnum::SOLID_STRESS);
+    EquationHolder eqs = getStandardEquations(settings);
+
+    settings.set(RunSettingsId::SPH_FUSED_DERIVATIVES, true);
+    DerivativeHolder fused;
+    eqs.setDerivatives(fused, settings);
+    settings.set(RunSettingsId::SPH_FUSED_DERIVATIVES, false);
+    DerivativeHolder separate;
+    eqs.setDerivatives(separate, settings);
+
+    // velocity divergence, velocity gradient, pressure gradient, stress divergence and AV fused into one
+    REQUIRE(separate.getDerivativeCnt() == 5);
+    REQUIRE(fused.getDerivativeCnt() == 1);
+    REQUIRE(fused.isSymmetric());
+}
+
 TEST_CASE("EquationHolder operators", "[equationterm]") {
     EquationHolder eqs;
     REQUIRE(eqs.getTermCnt() == 0);
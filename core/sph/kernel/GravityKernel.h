@@ -78,6 +78,37 @@ public:
             return pow<3>(hInv) * r * grad;
         }
     }
+
+    /// \brief Computes gradients for a batch of particle pairs.
+    ///
+    /// The k-th result is the gradient divided by the distance vector, i.e. grad(r, h[k]) is equal to
+    /// r * result[k] for vector r with squared length rSqr[k]. Table lookups are batched, allowing to use
+    /// vector gather instructions.
+    void gradBatch(const Float* rSqr, const Float* h, Float* result, const Size count) const {
+        constexpr Size CHUNK_SIZE = 64;
+        const Float radiusSqr = sqr(close.radius());
+        Float qSqr[CHUNK_SIZE];
+        Float interpolated[CHUNK_SIZE];
+        for (Size from = 0; from < count; from += CHUNK_SIZE) {
+            const Size chunk = min(CHUNK_SIZE, count - from);
+            if (close.isInit()) {
+                for (Size k = 0; k < chunk; ++k) {
+                    SPH_ASSERT(h[from + k] > 0._f);
+                    qSqr[k] = rSqr[from + k] / sqr(h[from + k]);
+                }
+                close.gradImplBatch(qSqr, interpolated, chunk);
+            } else {
+                std::fill(qSqr, qSqr + chunk, 0._f);
+            }
+            for (Size k = 0; k < chunk; ++k) {
+                if (qSqr[k] + EPS >= radiusSqr) {
+                    result[from + k] = 1._f / (rSqr[from + k] * sqrt(rSqr[from + k]));
+                } else {
+                    result[from + k] = interpolated[k] / pow<3>(h[from + k]);
+                }
+            }
+        }
+    }
 };
 
 template <>
@@ -0,0 +1,109 @@
+#include "sph/kernel/Kernel.h"
+
+NAMESPACE_SPH_BEGIN
+
+namespace Detail {
+
+#ifdef __AVX2__
+
+#ifdef SPH_SINGLE_PRECISION
+
+/// Processes the largest multiple of 8 values, returns the number of processed values.
+static Size interpolateLutAvx(const float* table,
+    const float qSqrToIdx,
+    const float radSqr,
+    const float* qSqr,
+    float* result,
+    const Size count) {
+    const __m256 toIdx = _mm256_set1_ps(qSqrToIdx);
+    const __m256 rad = _mm256_set1_ps(radSqr);
+    const __m256 one = _mm256_set1_ps(1.f);
+    // gathers all lanes; the masked variant avoids reading the uninitialized source of _mm256_i32gather_ps
+    const __m256 all = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    Size k = 0;
+    for (; k + 8 <= count; k += 8) {
+        const __m256 q = _mm256_loadu_ps(qSqr + k);
+        // points outside of the support are mapped to the first entry and zeroed afterwards
+        const __m256 inside = _mm256_cmp_ps(q, rad, _CMP_LT_OQ);
+        const __m256 floatIdx = _mm256_mul_ps(toIdx, _mm256_and_ps(q, inside));
+        const __m256i idx = _mm256_cvttps_epi32(floatIdx);
+        const __m256 ratio = _mm256_sub_ps(floatIdx, _mm256_cvtepi32_ps(idx));
+        const __m256 value1 = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), table, idx, all, sizeof(float));
+        const __m256 value2 =
+            _mm256_mask_i32gather_ps(_mm256_setzero_ps(), table + 1, idx, all, sizeof(float));
+        const __m256 value =
+            _mm256_add_ps(_mm256_mul_ps(value1, _mm256_sub_ps(one, ratio)), _mm256_mul_ps(value2, ratio));
+        _mm256_storeu_ps(result + k, _mm256_and_ps(value, inside));
+    }
+    return k;
+}
+
+#else
+
+/// Processes the largest multiple of 4 values, returns the number of processed values.
+static Size interpolateLutAvx(const double* table,
+    const double qSqrToIdx,
+    const double radSqr,
+    const double* qSqr,
+    double* result,
+    const Size count) {
+    const __m256d toIdx = _mm256_set1_pd(qSqrToIdx);
+    const __m256d rad = _mm256_set1_pd(radSqr);
+    const __m256d one = _mm256_set1_pd(1.);
+    // gathers all lanes; the masked variant avoids reading the uninitialized source of _mm256_i32gather_pd
+    const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    Size k = 0;
+    for (; k + 4 <= count; k += 4) {
+        const __m256d q = _mm256_loadu_pd(qSqr + k);
+        // points outside of the support are mapped to the first entry and zeroed afterwards
+        const __m256d inside = _mm256_cmp_pd(q, rad, _CMP_LT_OQ);
+        const __m256d floatIdx = _mm256_mul_pd(toIdx, _mm256_and_pd(q, inside));
+        const __m128i idx = _mm256_cvttpd_epi32(floatIdx);
+        const __m256d ratio = _mm256_sub_pd(floatIdx, _mm256_cvtepi32_pd(idx));
+        const __m256d value1 =
+            _mm256_mask_i32gather_pd(_mm256_setzero_pd(), table, idx, all, sizeof(double));
+        const __m256d value2 =
+            _mm256_mask_i32gather_pd(_mm256_setzero_pd(), table + 1, idx, all, sizeof(double));
+        const __m256d value =
+            _mm256_add_pd(_mm256_mul_pd(value1, _mm256_sub_pd(one, ratio)), _mm256_mul_pd(value2, ratio));
+        _mm256_storeu_pd(result + k, _mm256_and_pd(value, inside));
+    }
+    return k;
+}
+
+#endif
+
+#else
+
+static Size interpolateLutAvx(const Float*, const Float, const Float, const Float*, Float*, const Size) {
+    // AVX2 not available, everything is processed by the scalar loop
+    return 0;
+}
+
+#endif
+
+void interpolateLut(ArrayView<const Float> table,
+    const Float qSqrToIdx,
+    const Float radSqr,
+    const Float* qSqr,
+    Float* result,
+    const Size count) {
+    const Size processed = interpolateLutAvx(&table[0], qSqrToIdx, radSqr, qSqr, result, count);
+    for (Size k = processed; k < count; ++k) {
+        SPH_ASSERT(qSqr[k] >= 0._f);
+        if (SPH_UNLIKELY(qSqr[k] >= radSqr)) {
+            // outside of kernel support
+            result[k] = 0._f;
+            continue;
+        }
+        const Float floatIdx = qSqrToIdx * qSqr[k];
+        const Size idx1 = Size(floatIdx);
+        SPH_ASSERT(idx1 + 1 < table.size());
+        const Float ratio = floatIdx - Float(idx1);
+        result[k] = table[idx1] * (1._f - ratio) + table[idx1 + 1] * ratio;
+    }
+}
+
+} // namespace Detail
+
+NAMESPACE_SPH_END
@@ -6,10 +6,29 @@
 /// \date 2016-2021
 
 #include "objects/containers/Array.h"
+#include "objects/containers/ArrayView.h"
 #include "objects/geometry/Vector.h"
 
 NAMESPACE_SPH_BEGIN
 
+namespace Detail {
+/// \brief Interpolates values stored in a look-up table for a batch of squared distances.
+///
+/// Uses AVX2 gather instructions if available. Distances outside of the table (qSqr >= radSqr) yield zero.
+/// \param table Look-up table with tabulated values, the values must be tabulated uniformly in qSqr.
+/// \param qSqrToIdx Conversion factor from squared distance to the table index.
+/// \param radSqr Squared radius of the kernel support.
+/// \param qSqr Input squared distances.
+/// \param result Output interpolated values.
+/// \param count Number of values to interpolate.
+void interpolateLut(ArrayView<const Float> table,
+    const Float qSqrToIdx,
+    const Float radSqr,
+    const Float* qSqr,
+    Float* result,
+    const Size count);
+} // namespace Detail
+
 /// \brief Base class for all SPH kernels.
 ///
 /// Provides an interface for computing kernel values and gradients. All derived class must implement method
@@ -35,6 +54,41 @@ public:
         return r * pow<D + 2>(hInv) * impl().gradImpl(getSqrLength(r) * sqr(hInv));
     }
 
+    /// \brief Computes kernel values of a particle and all its neighbors at once.
+    ///
+    /// Uses the smoothing length symmetrized between the particles, i.e. the k-th value is equal to
+    /// value(r1 - r[neighs[k]], 0.5 * (r1[H] + r[neighs[k]][H])). Derived kernels can hide the function
+    /// to provide a faster implementation.
+    /// \param r1 Position and smoothing length of the particle.
+    /// \param r Positions and smoothing lengths of all particles.
+    /// \param neighs Indices of the neighbors.
+    /// \param values Output kernel values, must have the same size as neighs.
+    INLINE void valueBatch(const Vector& r1,
+        ArrayView<const Vector> r,
+        ArrayView<const Size> neighs,
+        ArrayView<Float> values) const noexcept {
+        SPH_ASSERT(values.size() == neighs.size());
+        for (Size k = 0; k < neighs.size(); ++k) {
+            const Vector& r2 = r[neighs[k]];
+            values[k] = this->value(r1 - r2, 0.5_f * (r1[H] + r2[H]));
+        }
+    }
+
+    /// \brief Computes kernel gradients of a particle and all its neighbors at once.
+    ///
+    /// Analogous to \ref valueBatch, the k-th gradient is equal to
+    /// grad(r1 - r[neighs[k]], 0.5 * (r1[H] + r[neighs[k]][H])).
+    INLINE void gradBatch(const Vector& r1,
+        ArrayView<const Vector> r,
+        ArrayView<const Size> neighs,
+        ArrayView<Vector> grads) const noexcept {
+        SPH_ASSERT(grads.size() == neighs.size());
+        for (Size k = 0; k < neighs.size(); ++k) {
+            const Vector& r2 = r[neighs[k]];
+            grads[k] = this->grad(r1 - r2, 0.5_f * (r1[H] + r2[H]));
+        }
+    }
+
 private:
     INLINE const TDerived& impl() const noexcept {
         return static_cast<const TDerived&>(*this);
@@ -142,6 +196,69 @@ public:
 
         return grads[idx1] * (1._f - ratio) + grads[idx2] * ratio;
     }
+
+    /// \brief Computes gradImpl for a batch of squared distances, using vector gather instructions.
+    INLINE void gradImplBatch(const Float* qSqr, Float* result, const Size count) const noexcept {
+        SPH_ASSERT(isInit());
+        Detail::interpolateLut(grads, qSqrToIdx, sqr(rad), qSqr, result, count);
+    }
+
+    /// \brief Computes kernel values of a particle and all its neighbors at once.
+    ///
+    /// Gives the same results as the generic implementation, but the table lookups of the whole neighbor
+    /// list are batched, allowing to use vector gather instructions.
+    INLINE void valueBatch(const Vector& r1,
+        ArrayView<const Vector> r,
+        ArrayView<const Size> neighs,
+        ArrayView<Float> result) const noexcept {
+        SPH_ASSERT(result.size() == neighs.size());
+        auto functor = [&result](const Size k, const Vector& UNUSED(dr), const Float hInv, const Float w) INL {
+            result[k] = pow<D>(hInv) * w;
+        };
+        this->evalBatch(values, r1, r, neighs, functor);
+    }
+
+    /// \brief Computes kernel gradients of a particle and all its neighbors at once.
+    ///
+    /// Gives the same results as the generic implementation, but the table lookups of the whole neighbor
+    /// list are batched, allowing to use vector gather instructions.
+    INLINE void gradBatch(const Vector& r1,
+        ArrayView<const Vector> r,
+        ArrayView<const Size> neighs,
+        ArrayView<Vector> result) const noexcept {
+        SPH_ASSERT(result.size() == neighs.size());
+        auto functor = [&result](const Size k, const Vector& dr, const Float hInv, const Float g) INL {
+            result[k] = dr * pow<D + 2>(hInv) * g;
+        };
+        this->evalBatch(grads, r1, r, neighs, functor);
+    }
+
+private:
+    template <typename TFunctor>
+    INLINE void evalBatch(ArrayView<const Float> table,
+        const Vector& r1,
+        ArrayView<const Vector> r,
+        ArrayView<const Size> neighs,
+        const TFunctor& functor) const noexcept {
+        SPH_ASSERT(isInit());
+        // process the neighbors in chunks, so that the temporary buffers fit into the stack
+        constexpr Size CHUNK_SIZE = 64;
+        Float qSqr[CHUNK_SIZE];
+        Float hInv[CHUNK_SIZE];
+        Float interpolated[CHUNK_SIZE];
+        for (Size from = 0; from < neighs.size(); from += CHUNK_SIZE) {
+            const Size count = min(CHUNK_SIZE, neighs.size() - from);
+            for (Size k = 0; k < count; ++k) {
+                const Vector& r2 = r[neighs[from + k]];
+                hInv[k] = 1._f / (0.5_f * (r1[H] + r2[H]));
+                qSqr[k] = getSqrLength(r1 - r2) * sqr(hInv[k]);
+            }
+            Detail::interpolateLut(table, qSqrToIdx, sqr(rad), qSqr, interpolated, count);
+            for (Size k = 0; k < count; ++k) {
+                functor(from + k, r1 - r[neighs[from + k]], hInv[k], interpolated[k]);
+            }
+        }
+    }
 };
 
 
@@ -642,6 +759,22 @@ public:
         return kernel.grad(r1 - r2, 0.5_f * (r1[H] + r2[H]));
     }
 
+    /// \brief Computes kernel values of a particle and all its neighbors at once.
+    INLINE void valueBatch(const Vector& r1,
+        ArrayView<const Vector> r,
+        ArrayView<const Size> neighs,
+        ArrayView<Float> values) const {
+        kernel.valueBatch(r1, r, neighs, values);
+    }
+
+    /// \brief Computes kernel gradients of a particle and all its neighbors at once.
+    INLINE void gradBatch(const Vector& r1,
+        ArrayView<const Vector> r,
+        ArrayView<const Size> neighs,
+        ArrayView<Vector> grads) const {
+        kernel.gradBatch(r1, r, neighs, grads);
+    }
+
     INLINE Float radius() const {
         return kernel.radius();
     }
@@ -26,3 +26,37 @@ BENCHMARK("LutKernel random", "[kernel]", Benchmark::Context& context) {
         }
     }
 }
+
+static void benchmarkBatch(Benchmark::Context& context, const bool sequential) {
+    LutKernel<3> kernel(CubicSpline<3>{});
+    UniformRng rng;
+    Array<Vector> r(1000);
+    for (Size i = 0; i < r.size(); ++i) {
+        // sweep over the kernel support, same as in the scalar sequential benchmark
+        const Float x = sequential ? kernel.radius() * Float(i) / r.size() : 3._f * rng();
+        r[i] = Vector(x, 0._f, 0._f, 1._f);
+    }
+    Array<Size> neighs(r.size());
+    for (Size i = 0; i < neighs.size(); ++i) {
+        neighs[i] = i;
+    }
+    Array<Float> values(r.size());
+    Array<Vector> grads(r.size());
+    while (context.running()) {
+        for (Size i = 0; i < 10; ++i) {
+            kernel.valueBatch(Vector(0._f, 0._f, 0._f, 1._f), r, neighs, values);
+            kernel.gradBatch(Vector(0._f, 0._f, 0._f, 1._f), r, neighs, grads);
+            Benchmark::doNotOptimize(values[0]);
+            Benchmark::doNotOptimize(grads[0]);
+            Benchmark::clobberMemory();
+        }
+    }
+}
+
+BENCHMARK("LutKernel sequential batch", "[kernel]", Benchmark::Context& context) {
+    benchmarkBatch(context, true);
+}
+
+BENCHMARK("LutKernel random batch", "[kernel]", Benchmark::Context& context) {
+    benchmarkBatch(context, false);
+}
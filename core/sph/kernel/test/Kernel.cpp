@@ -1,6 +1,7 @@
 #include "sph/kernel/Kernel.h"
 #include "catch.hpp"
 #include "math/Functional.h"
+#include "math/rng/VectorRng.h"
 #include "objects/wrappers/Flags.h"
 #include "system/Factory.h"
 #include "system/Settings.h"
@@ -327,6 +328,56 @@ TEST_CASE("Lut kernel", "[kernel]") {
     REQUIRE(lut3.radius() == 2._f);
 }
 
+TEST_CASE("Lut kernel batch", "[kernel]") {
+    LutKernel<3> lut(WendlandC2{});
+    CubicSpline<3> exact;
+
+    // particles at various distances, including pairs outside of the kernel support
+    VectorRng<UniformRng> rng;
+    Array<Vector> r(203);
+    for (Size i = 0; i < r.size(); ++i) {
+        r[i] = setH(5._f * rng() - Vector(2.5_f), 0.5_f + rng()[H]);
+    }
+    Array<Size> neighs(r.size() - 1);
+    for (Size k = 0; k < neighs.size(); ++k) {
+        neighs[k] = k + 1;
+    }
+
+    Array<Float> values(neighs.size());
+    Array<Vector> grads(neighs.size());
+    lut.valueBatch(r[0], r, neighs, values);
+    lut.gradBatch(r[0], r, neighs, grads);
+    Array<Float> exactValues(neighs.size());
+    Array<Vector> exactGrads(neighs.size());
+    exact.valueBatch(r[0], r, neighs, exactValues);
+    exact.gradBatch(r[0], r, neighs, exactGrads);
+
+    LutKernel<3> cubicLut(CubicSpline<3>{});
+    Array<Vector> cubicGrads(neighs.size());
+    cubicLut.gradBatch(r[0], r, neighs, cubicGrads);
+
+    auto test = [&](const Size k) -> Outcome {
+        const Size j = neighs[k];
+        const Float h = 0.5_f * (r[0][H] + r[j][H]);
+        if (values[k] != approx(lut.value(r[0] - r[j], h))) {
+            return makeFailed("Invalid value: {} == {}", values[k], lut.value(r[0] - r[j], h));
+        }
+        if (grads[k] != approx(lut.grad(r[0] - r[j], h))) {
+            return makeFailed("Invalid gradient: {} == {}", grads[k], lut.grad(r[0] - r[j], h));
+        }
+        // the compiler may contract the operations differently in the batch loop
+        if (exactValues[k] != approx(exact.value(r[0] - r[j], h)) ||
+            exactGrads[k] != approx(exact.grad(r[0] - r[j], h))) {
+            return makeFailed("Invalid generic batch evaluation");
+        }
+        if (cubicGrads[k] != approx(exactGrads[k], 1.e-5_f)) {
+            return makeFailed("Invalid LUT approximation: {} == {}", cubicGrads[k], exactGrads[k]);
+        }
+        return SUCCESS;
+    };
+    REQUIRE_SEQUENCE(test, 0, neighs.size());
+}
+
 /*TEST_CASE("Print kernels", "[kernel]") {
     std::ofstream valueOfs("kernels.txt");
     std::ofstream gradOfs("grads.txt");
@@ -66,6 +66,9 @@ IAsymmetricSolver::IAsymmetricSolver(IScheduler& scheduler,
     if (settings.get<bool>(RunSettingsId::SPH_ASYMMETRIC_COMPUTE_RADII_HASH_MAP)) {
         radiiMap.emplace();
     }
+    if (settings.get<bool>(RunSettingsId::SPH_USE_NEIGHBOR_LIST)) {
+        neighborList.emplace(settings.get<Float>(RunSettingsId::SPH_NEIGHBOR_LIST_SKIN), kernel.radius());
+    }
 }
 
 void IAsymmetricSolver::integrate(Storage& storage, Statistics& stats) {
@@ -101,6 +104,10 @@ void IAsymmetricSolver::create(Storage& storage, IMaterial& material) const {
     this->sanityCheck(storage);
 }
 
+void IAsymmetricSolver::setActiveParticles(ArrayView<const Size> active) {
+    activeParticles = active;
+}
+
 Float IAsymmetricSolver::getMaxSearchRadius(const Storage& storage) const {
     ArrayView<const Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
     Float maxH = 0._f;
@@ -112,7 +119,7 @@ Float IAsymmetricSolver::getMaxSearchRadius(const Storage& storage) const {
 
 RawPtr<const IBasicFinder> IAsymmetricSolver::getFinder(ArrayView<const Vector> r) {
     VERBOSE_LOG
-    finder->build(scheduler, r);
+    finder->refit(scheduler, r);
     return &*finder;
 }
 
@@ -150,20 +157,40 @@ void AsymmetricSolver::beforeLoop(Storage& storage, Statistics& stats) {
     derivatives.initialize(scheduler, storage);
 }
 
-void AsymmetricSolver::loop(Storage& storage, Statistics& UNUSED(stats)) {
+void AsymmetricSolver::loop(Storage& storage, Statistics& stats) {
     VERBOSE_LOG
 
     // (re)build neighbor-finding structure; this needs to be done after all equations
     // are initialized in case some of them modify smoothing lengths
     ArrayView<Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
-    const IBasicFinder& actFinder = *this->getFinder(r);
-
-    // precompute the search radii
+    RawPtr<const IBasicFinder> actFinder;
     Float maxRadius = 0._f;
-    if (radiiMap) {
-        radiiMap->build(r, kernel.radius());
+    if (neighborList) {
+        // the finder is only needed to (re)build the cached lists
+        if (neighborList->needsRebuild(scheduler, r)) {
+            actFinder = this->getFinder(r);
+
+            // the radii hash map is not used here, as the enlarged search radius can reach beyond the
+            // neighboring cells
+            maxRadius = this->getMaxSearchRadius(storage);
+            const Float factor = 1._f + neighborList->getSkin();
+            neighborList->build(scheduler, r, [this, r, maxRadius, factor, actFinder](const Size i,
+                                                  Array<NeighborRecord>& neighs) {
+                const Float radius = 0.5_f * factor * (r[i][H] * kernel.radius() + maxRadius);
+                actFinder->findAll(i, radius, neighs);
+            });
+        }
+        stats.set(StatisticsId::NEIGHBOR_LIST_BUILDS, int(neighborList->getBuildCnt()));
+        stats.set(StatisticsId::NEIGHBOR_LIST_REUSES, int(neighborList->getReuseCnt()));
     } else {
-        maxRadius = this->getMaxSearchRadius(storage);
+        actFinder = this->getFinder(r);
+
+        // precompute the search radii
+        if (radiiMap) {
+            radiiMap->build(r, kernel.radius());
+        } else {
+            maxRadius = this->getMaxSearchRadius(storage);
+        }
     }
 
     ArrayView<Size> neighs = storage.getValue<Size>(QuantityId::NEIGHBOR_CNT);
@@ -171,34 +198,57 @@ void AsymmetricSolver::loop(Storage& storage, Statistics& UNUSED(stats)) {
     // we need to symmetrize kernel in smoothing lenghts to conserve momentum
     SymmetrizeSmoothingLengths<const LutKernel<DIMENSIONS>&> symmetrizedKernel(kernel);
 
-    auto functor = [this, r, &neighs, maxRadius, &symmetrizedKernel, &actFinder](Size i, ThreadData& data) {
-        // max possible radius of r[j]
-        const Float neighborRadius = radiiMap ? radiiMap->getRadius(r[i]) : maxRadius;
-        SPH_ASSERT(neighborRadius > 0._f);
-
-        // max possible value of kernel.radius() * hbar
-        const Float radius = 0.5_f * (r[i][H] * kernel.radius() + neighborRadius);
-
-        actFinder.findAll(i, radius, data.neighs);
+    auto functor = [this, r, &neighs, maxRadius, &symmetrizedKernel, actFinder](Size i, ThreadData& data) {
         data.grads.clear();
         data.idxs.clear();
-        for (auto& n : data.neighs) {
-            const Size j = n.index;
+        auto addNeighbor = [&](const Size j, const Float distSqr) INL {
             const Float hbar = 0.5_f * (r[i][H] + r[j][H]);
             SPH_ASSERT(hbar > EPS, hbar);
-            if (i == j || n.distanceSqr >= sqr(kernel.radius() * hbar)) {
+            if (i == j || distSqr >= sqr(kernel.radius() * hbar)) {
                 // aren't actual neighbors
-                continue;
+                return;
             }
-            const Vector gr = symmetrizedKernel.grad(r[i], r[j]);
-            SPH_ASSERT(isReal(gr) && dot(gr, r[i] - r[j]) <= 0._f, gr, r[i] - r[j]);
-            data.grads.emplaceBack(gr);
             data.idxs.emplaceBack(j);
+        };
+        if (neighborList) {
+            for (const Size j : neighborList->getNeighbors(i)) {
+                addNeighbor(j, getSqrLength(r[i] - r[j]));
+            }
+        } else {
+            // max possible radius of r[j]
+            const Float neighborRadius = radiiMap ? radiiMap->getRadius(r[i]) : maxRadius;
+            SPH_ASSERT(neighborRadius > 0._f);
+
+            // max possible value of kernel.radius() * hbar
+            const Float radius = 0.5_f * (r[i][H] * kernel.radius() + neighborRadius);
+
+            actFinder->findAll(i, radius, data.neighs);
+            for (const NeighborRecord& n : data.neighs) {
+                addNeighbor(n.index, n.distanceSqr);
+            }
         }
+        // compute gradients of all neighbors at once
+        data.grads.resize(data.idxs.size());
+        symmetrizedKernel.gradBatch(r[i], r, data.idxs, data.grads);
+#ifdef SPH_DEBUG
+        for (Size k = 0; k < data.idxs.size(); ++k) {
+            const Vector& gr = data.grads[k];
+            const Size j = data.idxs[k];
+            SPH_ASSERT(isReal(gr) && dot(gr, r[i] - r[j]) <= 0._f, gr, r[i] - r[j]);
+        }
+#endif
         derivatives.eval(i, data.idxs, data.grads);
         neighs[i] = data.idxs.size();
     };
-    parallelFor(scheduler, threadData, 0, r.size(), functor);
+    if (activeParticles) {
+        // evaluate only the requested particles; derivatives of other particles remain zero
+        ArrayView<const Size> active = activeParticles;
+        parallelFor(scheduler, threadData, 0, active.size(), [&functor, active](Size k, ThreadData& data) {
+            functor(active[k], data);
+        });
+    } else {
+        parallelFor(scheduler, threadData, 0, r.size(), functor);
+    }
 }
 
 void AsymmetricSolver::afterLoop(Storage& storage, Statistics& stats) {
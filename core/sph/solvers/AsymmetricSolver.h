@@ -5,6 +5,7 @@
 /// \author Pavel Sevecek (sevecek at sirrah.troja.mff.cuni.cz)
 /// \date 2016-2021
 
+#include "objects/finders/NeighborList.h"
 #include "objects/geometry/Indices.h"
 #include "sph/equations/Derivative.h"
 #include "sph/equations/EquationTerm.h"
@@ -61,6 +62,12 @@ protected:
     /// Hash map used to determine search radii of particles.
     Optional<RadiiHashMap> radiiMap;
 
+    /// Cached lists of neighbor candidates; empty if the caching is disabled.
+    Optional<NeighborList> neighborList;
+
+    /// Particles with evaluated derivatives; null view means all particles.
+    ArrayView<const Size> activeParticles;
+
 public:
     IAsymmetricSolver(IScheduler& scheduler, const RunSettings& settings, const EquationHolder& eqs);
 
@@ -68,6 +75,8 @@ public:
 
     virtual void create(Storage& storage, IMaterial& material) const override;
 
+    virtual void setActiveParticles(ArrayView<const Size> active) override;
+
 protected:
     Float getMaxSearchRadius(const Storage& storage) const;
 
@@ -131,7 +131,11 @@ EnergyConservingSolver::EnergyConservingSolver(IScheduler& scheduler,
     partitioner =
         makeAuto<BlendingPartitioner<SmoothlyDiminishingPartitioner, MonotonicDiminishingPartitioner>>();
 
-    eqs.setDerivatives(derivatives, settings);
+    // the energy changes are computed from differences of velocities, amplifying round-off differences of
+    // the accelerations, so the derivatives are not fused to keep the results independent of the setting
+    RunSettings separate = settings;
+    separate.set(RunSettingsId::SPH_FUSED_DERIVATIVES, false);
+    eqs.setDerivatives(derivatives, separate);
 }
 
 EnergyConservingSolver::EnergyConservingSolver(IScheduler& scheduler,
@@ -175,13 +179,20 @@ void EnergyConservingSolver::loop(Storage& storage, Statistics& UNUSED(stats)) {
                 // aren't actual neighbors
                 continue;
             }
-            const Vector gr = symmetrizedKernel.grad(r[i], r[j]);
-            SPH_ASSERT(isReal(gr) && dot(gr, r[i] - r[j]) < 0._f, gr, r[i] - r[j]);
-
             neighList[i].push(j);
-            gradList[i].push(gr);
         }
 
+        // compute gradients of all neighbors at once
+        gradList[i].resize(neighList[i].size());
+        symmetrizedKernel.gradBatch(r[i], r, neighList[i], gradList[i]);
+#ifdef SPH_DEBUG
+        for (Size k = 0; k < neighList[i].size(); ++k) {
+            const Vector& gr = gradList[i][k];
+            const Size j = neighList[i][k];
+            SPH_ASSERT(isReal(gr) && dot(gr, r[i] - r[j]) < 0._f, gr, r[i] - r[j]);
+        }
+#endif
+
         derivatives.eval(i, neighList[i], gradList[i]);
     };
     parallelFor(scheduler, threadData, 0, r.size(), evalDerivatives);
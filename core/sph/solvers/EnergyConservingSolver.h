@@ -23,7 +23,16 @@ public:
 /// \brief Derivative holder, splitting the registered derivatives into accelerations and the rest.
 class AccelerationSeparatingHolder : public DerivativeHolder {
 private:
-    FlatSet<RawPtr<IAcceleration>> accelerations;
+    struct Less {
+        INLINE bool operator()(const RawPtr<IAcceleration>& a1, const RawPtr<IAcceleration>& a2) const {
+            // sort by types to get the same order of summation in every run, see DerivativeHolder
+            const IAcceleration& v1 = *a1;
+            const IAcceleration& v2 = *a2;
+            return typeid(v1).before(typeid(v2));
+        }
+    };
+
+    FlatSet<RawPtr<IAcceleration>, Less> accelerations;
 
 public:
     virtual void require(AutoPtr<IDerivative>&& derivative) override {
@@ -34,6 +43,14 @@ public:
         DerivativeHolder::require(std::move(derivative));
     }
 
+    virtual AutoPtr<IDerivative> release(const std::type_info& type) override {
+        AutoPtr<IDerivative> derivative = DerivativeHolder::release(type);
+        if (RawPtr<IAcceleration> a = dynamicCast<IAcceleration>(derivative.get())) {
+            accelerations.erase(accelerations.find(a));
+        }
+        return derivative;
+    }
+
     void evalAccelerations(const Size idx,
         ArrayView<const Size> neighs,
         ArrayView<const Vector> grads,
@@ -68,7 +68,7 @@ void GravitySolver<TSphSolver>::loop(Storage& storage, Statistics& stats) {
 
     // build gravity tree
     Timer timer;
-    gravity->build(this->scheduler, storage);
+    gravity->refit(this->scheduler, storage);
     stats.set(StatisticsId::GRAVITY_BUILD_TIME, int(timer.elapsed(TimerUnit::MILLISECOND)));
 
     // get acceleration buffer corresponding to first thread (to save some memory + time)
@@ -5,12 +5,12 @@
 #include "system/Factory.h"
 #include "system/Statistics.h"
 #include "system/Timer.h"
-#include "thread/ThreadLocal.h"
 
 NAMESPACE_SPH_BEGIN
 
 PositionBasedSolver::PositionBasedSolver(IScheduler& scheduler, const RunSettings& settings)
-    : scheduler(scheduler) {
+    : scheduler(scheduler)
+    , threadData(scheduler) {
     poly6 = Poly6();
     spiky = SpikyKernel();
 
@@ -19,6 +19,7 @@ PositionBasedSolver::PositionBasedSolver(IScheduler& scheduler, const RunSetting
 
     iterCnt = settings.get<int>(RunSettingsId::PBD_ITERATION_COUNT);
     eps = settings.get<Float>(RunSettingsId::PBD_RELAXATION_PARAMETER);
+    gaussSeidel = settings.get<bool>(RunSettingsId::PBD_GAUSS_SEIDEL);
 }
 
 PositionBasedSolver::~PositionBasedSolver() = default;
@@ -39,29 +40,28 @@ void PositionBasedSolver::evalHydro(Storage& storage, Statistics& stats) {
     Array<Vector> r1(r.size());
     parallelFor(scheduler, 0, r.size(), [&r, &r1, &v, dt](Size i) { r1[i] = r[i] + v[i] * dt; });
 
-    // find neighbors
-    finder->build(scheduler, r1);
-    neighbors.resize(r.size());
-    ThreadLocal<Array<NeighborRecord>> neighsTl(scheduler);
-    parallelFor(scheduler, neighsTl, 0, r.size(), [this, &r1](Size i, Array<NeighborRecord>& neighs) {
-        finder->findAll(r1[i], r1[i][H], neighs);
-        neighbors[i].resize(neighs.size());
-        for (Size j = 0; j < neighs.size(); ++j) {
-            neighbors[i][j] = neighs[j].index;
-        }
-    });
+    this->findNeighbors(r1);
 
     ArrayView<const Float> m = storage.getValue<Float>(QuantityId::MASS);
     ArrayView<Float> rho1 = storage.getValue<Float>(QuantityId::DENSITY);
-    for (Size iter = 0; iter < iterCnt; ++iter) {
-        doIteration(r1, rho1, m);
+    if (gaussSeidel) {
+        this->colorNeighbors();
+        this->evalDensities(r1, rho1, m);
+        this->evalMultipliers(r1, rho1);
+        for (Size iter = 0; iter < iterCnt; ++iter) {
+            doGaussSeidelIteration(r1, rho1, m);
+        }
+    } else {
+        for (Size iter = 0; iter < iterCnt; ++iter) {
+            doIteration(r1, rho1, m);
+        }
     }
 
     // velocity update (& other auxiliary quantities)
     ArrayView<Size> neighCnt = storage.getValue<Size>(QuantityId::NEIGHBOR_CNT);
     parallelFor(scheduler, 0, r.size(), [this, &neighCnt, &r, &v, &r1, dt](Size i) {
         v[i] = clearH((r1[i] - r[i]) / dt);
-        neighCnt[i] = neighbors[i].size();
+        neighCnt[i] = neighbors.offsets[i + 1] - neighbors.offsets[i];
     });
     stats.set(StatisticsId::SPH_EVAL_TIME, int(timer.elapsed(TimerUnit::MILLISECOND)));
 }
@@ -69,7 +69,7 @@ void PositionBasedSolver::evalHydro(Storage& storage, Statistics& stats) {
 void PositionBasedSolver::evalGravity(Storage& storage, Statistics& stats) {
     Timer timer;
     ArrayView<Vector> dv = storage.getD2t<Vector>(QuantityId::POSITION);
-    gravity->build(scheduler, storage);
+    gravity->refit(scheduler, storage);
     gravity->evalSelfGravity(scheduler, dv, stats);
     stats.set(StatisticsId::GRAVITY_EVAL_TIME, int(timer.elapsed(TimerUnit::MILLISECOND)));
 }
@@ -78,12 +78,120 @@ void PositionBasedSolver::create(Storage& storage, IMaterial& UNUSED(material))
     storage.insert<Size>(QuantityId::NEIGHBOR_CNT, OrderEnum::ZERO, 0);
 }
 
-void PositionBasedSolver::doIteration(Array<Vector>& r1, ArrayView<Float> rho1, ArrayView<const Float> m) {
+void PositionBasedSolver::findNeighbors(ArrayView<const Vector> r1) {
+    finder->build(scheduler, r1);
+    const Size particleCnt = r1.size();
+
+    // neighbors are first stored in thread-local buffers, so that the search is done in a single pass
+    Size index = 0;
+    for (ThreadData& data : threadData) {
+        data.indices.clear();
+        data.index = index++;
+    }
+    neighbors.offsets.resize(particleCnt + 1);
+    neighborSources.resize(particleCnt);
+    neighborStarts.resize(particleCnt);
+    parallelFor(scheduler, threadData, 0, particleCnt, [this, &r1](const Size i, ThreadData& data) {
+        finder->findAll(r1[i], r1[i][H], data.neighs);
+        neighborSources[i] = data.index;
+        neighborStarts[i] = data.indices.size();
+        for (const NeighborRecord& n : data.neighs) {
+            data.indices.push(n.index);
+        }
+        neighbors.offsets[i + 1] = data.neighs.size();
+    });
+
+    neighbors.offsets[0] = 0;
+    for (Size i = 0; i < particleCnt; ++i) {
+        neighbors.offsets[i + 1] += neighbors.offsets[i];
+    }
+    neighbors.indices.resize(neighbors.offsets[particleCnt]);
+    parallelFor(scheduler, 0, particleCnt, [this](const Size i) {
+        const Array<Size>& source = threadData.value(neighborSources[i]).indices;
+        const Size cnt = neighbors.offsets[i + 1] - neighbors.offsets[i];
+        std::copy(source.begin() + neighborStarts[i],
+            source.begin() + neighborStarts[i] + cnt,
+            neighbors.indices.begin() + neighbors.offsets[i]);
+    });
+}
+
+void PositionBasedSolver::colorNeighbors() {
+    const Size particleCnt = neighbors.offsets.size() - 1;
+
+    // the neighbor lists do not have to be symmetric, so find also the particles listing given particle
+    Array<Size> reverseOffsets(particleCnt + 1);
+    reverseOffsets.fill(0);
+    for (Size j : neighbors.indices) {
+        reverseOffsets[j + 1]++;
+    }
+    for (Size i = 0; i < particleCnt; ++i) {
+        reverseOffsets[i + 1] += reverseOffsets[i];
+    }
+    Array<Size> reverseIndices(neighbors.indices.size());
+    Array<Size> next(particleCnt);
+    std::copy(reverseOffsets.begin(), reverseOffsets.begin() + particleCnt, next.begin());
+    for (Size i = 0; i < particleCnt; ++i) {
+        for (Size k = neighbors.offsets[i]; k < neighbors.offsets[i + 1]; ++k) {
+            const Size j = neighbors.indices[k];
+            reverseIndices[next[j]++] = i;
+        }
+    }
+
+    // greedy coloring, assigning the lowest color not used by any already colored neighbor
+    const Size NO_COLOR = Size(-1);
+    Array<Size> particleColors(particleCnt);
+    particleColors.fill(NO_COLOR);
+    Array<Size> usedBy;
+    Size colorCnt = 0;
+    for (Size i = 0; i < particleCnt; ++i) {
+        auto markUsed = [&](const Size j) {
+            if (j != i && particleColors[j] != NO_COLOR) {
+                usedBy[particleColors[j]] = i;
+            }
+        };
+        for (Size k = neighbors.offsets[i]; k < neighbors.offsets[i + 1]; ++k) {
+            markUsed(neighbors.indices[k]);
+        }
+        for (Size k = reverseOffsets[i]; k < reverseOffsets[i + 1]; ++k) {
+            markUsed(reverseIndices[k]);
+        }
+        Size color = 0;
+        while (color < colorCnt && usedBy[color] == i) {
+            ++color;
+        }
+        if (color == colorCnt) {
+            usedBy.push(NO_COLOR);
+            ++colorCnt;
+        }
+        particleColors[i] = color;
+    }
+
+    // group the particles by colors
+    colors.offsets.resize(colorCnt + 1);
+    colors.offsets.fill(0);
+    for (Size color : particleColors) {
+        colors.offsets[color + 1]++;
+    }
+    for (Size c = 0; c < colorCnt; ++c) {
+        colors.offsets[c + 1] += colors.offsets[c];
+    }
+    colors.indices.resize(particleCnt);
+    next.resize(colorCnt);
+    std::copy(colors.offsets.begin(), colors.offsets.begin() + colorCnt, next.begin());
+    for (Size i = 0; i < particleCnt; ++i) {
+        colors.indices[next[particleColors[i]]++] = i;
+    }
+}
+
+void PositionBasedSolver::evalDensities(ArrayView<const Vector> r1,
+    ArrayView<Float> rho1,
+    ArrayView<const Float> m) {
     drho1.resize(rho1.size());
     parallelFor(scheduler, 0, r1.size(), [this, &r1, &rho1, &m](Size i) {
         rho1[i] = 0;
         drho1[i] = Vector(0._f);
-        for (Size j : neighbors[i]) {
+        for (Size k = neighbors.offsets[i]; k < neighbors.offsets[i + 1]; ++k) {
+            const Size j = neighbors.indices[k];
             rho1[i] += m[j] * poly6.value(r1[i] - r1[j], r1[j][H]);
             drho1[i] += m[j] * spiky.grad(r1[i] - r1[j], r1[j][H]);
         }
@@ -92,25 +200,68 @@ void PositionBasedSolver::doIteration(Array<Vector>& r1, ArrayView<Float> rho1,
         // lazy initialization
         rho0.pushAll(rho1.begin(), rho1.end());
     }
+}
+
+INLINE Float PositionBasedSolver::getLambda(const Size i,
+    ArrayView<const Vector> r1,
+    ArrayView<const Float> rho1) const {
+    const Float C = rho1[i] / rho0[i] - 1;
+    Float sumGradC = 0;
+    for (Size k = neighbors.offsets[i]; k < neighbors.offsets[i + 1]; ++k) {
+        const Size j = neighbors.indices[k];
+        sumGradC += getSqrLength(drho1[j] / rho0[j]);
+    }
+    return -C / (sumGradC + eps / sqr(r1[i][H]));
+}
+
+INLINE Vector PositionBasedSolver::getCorrection(const Size i, ArrayView<const Vector> r1) const {
+    Vector dp(0._f);
+    for (Size k = neighbors.offsets[i]; k < neighbors.offsets[i + 1]; ++k) {
+        const Size j = neighbors.indices[k];
+        dp += (lambda[i] + lambda[j]) * spiky.grad(r1[i] - r1[j], r1[j][H]);
+    }
+    return dp;
+}
+
+void PositionBasedSolver::evalMultipliers(ArrayView<const Vector> r1, ArrayView<const Float> rho1) {
     lambda.resize(r1.size());
-    parallelFor(scheduler, 0, r1.size(), [this, &rho1, &r1](Size i) {
-        const Float C = rho1[i] / rho0[i] - 1;
-        Float sumGradC = 0;
-        for (Size j : neighbors[i]) {
-            sumGradC += getSqrLength(drho1[j] / rho0[j]);
-        }
-        lambda[i] = -C / (sumGradC + eps / sqr(r1[i][H]));
+    parallelFor(scheduler, 0, r1.size(), [this, &rho1, &r1](Size i) { //
+        lambda[i] = this->getLambda(i, r1, rho1);
     });
+}
+
+void PositionBasedSolver::doIteration(Array<Vector>& r1, ArrayView<Float> rho1, ArrayView<const Float> m) {
+    this->evalDensities(r1, rho1, m);
+    this->evalMultipliers(r1, rho1);
     dp.resize(r1.size());
-    parallelFor(scheduler, 0, r1.size(), [this, &r1](Size i) {
-        dp[i] = Vector(0._f);
-        for (Size j : neighbors[i]) {
-            dp[i] += (lambda[i] + lambda[j]) * spiky.grad(r1[i] - r1[j], r1[j][H]);
-        }
+    parallelFor(scheduler, 0, r1.size(), [this, &r1](Size i) { //
+        dp[i] = this->getCorrection(i, r1);
     });
     parallelFor(scheduler, 0, r1.size(), [this, &r1, &m](Size i) { //
         r1[i] += m[i] / rho0[i] * dp[i];
     });
 }
 
+void PositionBasedSolver::doGaussSeidelIteration(Array<Vector>& r1,
+    ArrayView<Float> rho1,
+    ArrayView<const Float> m) {
+    // Particles of the same color are not neighbors, so the particles only read values of particles with
+    // different colors and can be processed in parallel. Particles of processed colors already use the
+    // updated positions, densities and multipliers of their neighbors.
+    for (Size c = 0; c < colors.offsets.size() - 1; ++c) {
+        parallelFor(scheduler, colors.offsets[c], colors.offsets[c + 1], [this, &r1, &rho1, &m](Size k) {
+            const Size i = colors.indices[k];
+            rho1[i] = 0;
+            drho1[i] = Vector(0._f);
+            for (Size l = neighbors.offsets[i]; l < neighbors.offsets[i + 1]; ++l) {
+                const Size j = neighbors.indices[l];
+                rho1[i] += m[j] * poly6.value(r1[i] - r1[j], r1[j][H]);
+                drho1[i] += m[j] * spiky.grad(r1[i] - r1[j], r1[j][H]);
+            }
+            lambda[i] = this->getLambda(i, r1, rho1);
+            r1[i] += m[i] / rho0[i] * this->getCorrection(i, r1);
+        });
+    }
+}
+
 NAMESPACE_SPH_END
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "sph/kernel/Kernel.h"
+#include "thread/ThreadLocal.h"
 #include "timestepping/ISolver.h"
 
 NAMESPACE_SPH_BEGIN
@@ -16,7 +17,41 @@ private:
     LutKernel<3> poly6;
     LutKernel<3> spiky;
 
-    Array<Array<Size>> neighbors;
+    /// Neighbors of particles in compressed sparse row format
+    struct {
+        /// Index of the first neighbor of each particle; has one more element than the number of particles
+        Array<Size> offsets;
+
+        /// Indices of neighbors, stored consecutively for all particles
+        Array<Size> indices;
+    } neighbors;
+
+    /// Particles grouped by colors of the neighbor graph; neighboring particles never share a color
+    struct {
+        /// Index of the first particle of each color; has one more element than the number of colors
+        Array<Size> offsets;
+
+        /// Indices of particles, sorted by their colors
+        Array<Size> indices;
+    } colors;
+
+    struct ThreadData {
+        /// Neighbors for parallelized queries
+        Array<NeighborRecord> neighs;
+
+        /// Indices of neighbors found by this thread
+        Array<Size> indices;
+
+        /// Index of this storage in the thread-local container
+        Size index;
+    };
+
+    ThreadLocal<ThreadData> threadData;
+
+    /// Thread-local storage and position within it holding the neighbors of each particle
+    Array<Size> neighborSources;
+    Array<Size> neighborStarts;
+
     Array<Float> rho0;
     Array<Vector> drho1;
     Array<Float> lambda;
@@ -24,6 +59,7 @@ private:
 
     Size iterCnt;
     Float eps;
+    bool gaussSeidel;
 
 public:
     PositionBasedSolver(IScheduler& scheduler, const RunSettings& settings);
@@ -39,7 +75,29 @@ private:
 
     void evalGravity(Storage& storage, Statistics& stats);
 
+    /// \brief Finds neighbors of all particles, storing them in compressed rows.
+    void findNeighbors(ArrayView<const Vector> r1);
+
+    /// \brief Greedily colors the neighbor graph, so that particles of the same color are not neighbors.
+    void colorNeighbors();
+
+    /// \brief Computes the densities and their gradients of all particles.
+    void evalDensities(ArrayView<const Vector> r1, ArrayView<Float> rho1, ArrayView<const Float> m);
+
+    /// \brief Computes the Lagrange multipliers of all particles.
+    void evalMultipliers(ArrayView<const Vector> r1, ArrayView<const Float> rho1);
+
+    /// \brief Performs a Jacobi iteration, updating the positions of all particles at once.
     void doIteration(Array<Vector>& r1, ArrayView<Float> rho1, ArrayView<const Float> m);
+
+    /// \brief Performs a Gauss-Seidel iteration, updating the positions of particles color by color.
+    void doGaussSeidelIteration(Array<Vector>& r1, ArrayView<Float> rho1, ArrayView<const Float> m);
+
+    /// \brief Computes the Lagrange multiplier of i-th particle.
+    Float getLambda(const Size i, ArrayView<const Vector> r1, ArrayView<const Float> rho1) const;
+
+    /// \brief Computes the position correction of i-th particle.
+    Vector getCorrection(const Size i, ArrayView<const Vector> r1) const;
 };
 
 NAMESPACE_SPH_END
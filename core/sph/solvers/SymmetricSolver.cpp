@@ -11,6 +11,13 @@
 
 NAMESPACE_SPH_BEGIN
 
+/// Returns the largest smoothing length of particles.
+static Float getMaxH(IScheduler& scheduler, ArrayView<const Vector> r) {
+    ThreadLocal<Float> maxHTl(scheduler, 0._f);
+    parallelFor(scheduler, maxHTl, 0, r.size(), [r](const Size i, Float& maxH) { maxH = max(maxH, r[i][H]); });
+    return maxHTl.accumulate(0._f, [](const Float h1, const Float h2) { return max(h1, h2); });
+}
+
 template <Size Dim>
 SymmetricSolver<Dim>::SymmetricSolver(IScheduler& scheduler,
     const RunSettings& settings,
@@ -29,6 +36,13 @@ SymmetricSolver<Dim>::SymmetricSolver(IScheduler& scheduler,
     // to h_i, and we thus never "miss" a particle.
     finder = Factory::getFinder(settings);
 
+    if (settings.get<bool>(RunSettingsId::SPH_USE_NEIGHBOR_LIST)) {
+        neighborList.emplace(settings.get<Float>(RunSettingsId::SPH_NEIGHBOR_LIST_SKIN), kernel.radius());
+    }
+    if (settings.get<bool>(RunSettingsId::SPH_SYMMETRIC_COLORED_ACCUMULATION)) {
+        coloring.emplace();
+    }
+
     equations += eqs;
 
     // add term counting number of neighbors
@@ -106,68 +120,165 @@ void SymmetricSolver<Dim>::create(Storage& storage, IMaterial& material) const {
 }
 
 template <Size Dim>
-void SymmetricSolver<Dim>::loop(Storage& storage, Statistics& UNUSED(stats)) {
+void SymmetricSolver<Dim>::setActiveParticles(ArrayView<const Size> active) {
+    activeParticles = active;
+}
+
+template <Size Dim>
+void SymmetricSolver<Dim>::loop(Storage& storage, Statistics& stats) {
     MEASURE_SCOPE("SymmetricSolver::loop");
+    if (activeParticles) {
+        this->loopActive(storage);
+        return;
+    }
     // (re)build neighbor-finding structure; this needs to be done after all equations
     // are initialized in case some of them modify smoothing lengths
     ArrayView<Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
-    finder->build(scheduler, r);
+    if (neighborList) {
+        // the finder is only needed to (re)build the cached lists
+        if (neighborList->needsRebuild(scheduler, r)) {
+            PROFILE_SCOPE("SymmetricSolver build neighbor list");
+            finder->refit(scheduler, r);
+            const Float searchRadius = (1._f + neighborList->getSkin()) * kernel.radius();
+            neighborList->build(scheduler, r, [this, r, searchRadius](const Size i, Array<NeighborRecord>& neighs) {
+                finder->findLowerRank(i, r[i][H] * searchRadius, neighs);
+            });
+        }
+        stats.set(StatisticsId::NEIGHBOR_LIST_BUILDS, int(neighborList->getBuildCnt()));
+        stats.set(StatisticsId::NEIGHBOR_LIST_REUSES, int(neighborList->getReuseCnt()));
+    } else {
+        finder->refit(scheduler, r);
+    }
 
     // here we use a kernel symmetrized in smoothing lengths:
     // \f$ W_ij(r_i - r_j, 0.5(h[i] + h[j]) \f$
     SymmetrizeSmoothingLengths<LutKernel<Dim>> symmetrizedKernel(kernel);
 
     auto functor = [this, r, &symmetrizedKernel](const Size i, ThreadData& data) {
-        finder->findLowerRank(i, r[i][H] * kernel.radius(), data.neighs);
         data.grads.clear();
         data.idxs.clear();
-        for (auto& n : data.neighs) {
-            const Size j = n.index;
+        auto addNeighbor = [&](const Size j) INL {
             const Float hbar = 0.5_f * (r[i][H] + r[j][H]);
-            SPH_ASSERT(hbar > EPS && hbar <= r[i][H], hbar, r[i][H]);
+            SPH_ASSERT(hbar > EPS, hbar);
             if (getSqrLength(r[i] - r[j]) >= sqr(kernel.radius() * hbar)) {
                 // aren't actual neighbors
-                continue;
+                return;
             }
-            const Vector gr = symmetrizedKernel.grad(r[i], r[j]);
-            SPH_ASSERT(isReal(gr) && dot(gr, r[i] - r[j]) <= 0._f, gr, getLength(r[i] - r[j]));
-            data.grads.emplaceBack(gr);
             data.idxs.emplaceBack(j);
+        };
+        if (neighborList) {
+            // pairs are assigned to particles according to the ranks at the time the list was built, so
+            // h[j] is not necessarily lower than h[i]; each pair is still visited only once
+            for (const Size j : neighborList->getNeighbors(i)) {
+                addNeighbor(j);
+            }
+        } else {
+            finder->findLowerRank(i, r[i][H] * kernel.radius(), data.neighs);
+            for (const NeighborRecord& n : data.neighs) {
+                SPH_ASSERT(r[n.index][H] <= r[i][H], r[n.index][H], r[i][H]);
+                addNeighbor(n.index);
+            }
+        }
+        // compute gradients of all neighbors at once
+        data.grads.resize(data.idxs.size());
+        symmetrizedKernel.gradBatch(r[i], r, data.idxs, data.grads);
+#ifdef SPH_DEBUG
+        for (Size k = 0; k < data.idxs.size(); ++k) {
+            const Vector& gr = data.grads[k];
+            const Size j = data.idxs[k];
+            SPH_ASSERT(isReal(gr) && dot(gr, r[i] - r[j]) <= 0._f, gr, getLength(r[i] - r[j]));
         }
+#endif
         data.derivatives.evalSymmetric(i, data.idxs, data.grads);
     };
     PROFILE_SCOPE("GenericSolver main loop");
-    parallelFor(scheduler, threadData, 0, r.size(), functor);
+    if (coloring) {
+        // interacting pairs are never further than the kernel support of the largest particle
+        const Float maxH = getMaxH(scheduler, r);
+        coloring->build(scheduler, r, kernel.radius() * maxH);
+        coloring->iterate(scheduler, threadData, functor);
+    } else {
+        parallelFor(scheduler, threadData, 0, r.size(), functor);
+    }
+}
+
+template <Size Dim>
+void SymmetricSolver<Dim>::loopActive(Storage& storage) {
+    // the cached lists only contain neighbors with lower rank, so the finder is used directly
+    ArrayView<Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+    finder->refit(scheduler, r);
+
+    // max possible value of kernel.radius() * hbar is reached for the particle with the largest h
+    const Float maxH = getMaxH(scheduler, r);
+
+    SymmetrizeSmoothingLengths<LutKernel<Dim>> symmetrizedKernel(kernel);
+
+    auto functor = [this, r, maxH, &symmetrizedKernel](const Size i, ThreadData& data) {
+        data.grads.clear();
+        data.idxs.clear();
+        const Float radius = 0.5_f * kernel.radius() * (r[i][H] + maxH);
+        finder->findAll(i, radius, data.neighs);
+        for (const NeighborRecord& n : data.neighs) {
+            const Size j = n.index;
+            const Float hbar = 0.5_f * (r[i][H] + r[j][H]);
+            SPH_ASSERT(hbar > EPS, hbar);
+            if (i == j || n.distanceSqr >= sqr(kernel.radius() * hbar)) {
+                // aren't actual neighbors
+                continue;
+            }
+            data.idxs.emplaceBack(j);
+        }
+        data.grads.resize(data.idxs.size());
+        symmetrizedKernel.gradBatch(r[i], r, data.idxs, data.grads);
+
+        // only the derivatives of particle i are modified, so the accumulation is safe even if the buffers
+        // are shared by threads
+        data.derivatives.eval(i, data.idxs, data.grads);
+    };
+    PROFILE_SCOPE("GenericSolver active loop");
+    ArrayView<const Size> active = activeParticles;
+    parallelFor(scheduler, threadData, 0, active.size(), [&functor, active](Size k, ThreadData& data) {
+        functor(active[k], data);
+    });
 }
 
 template <Size Dim>
 void SymmetricSolver<Dim>::beforeLoop(Storage& storage, Statistics& UNUSED(stats)) {
     // clear thread local storages
     PROFILE_SCOPE("GenericSolver::beforeLoop");
-    for (ThreadData& data : threadData) {
-        data.derivatives.initialize(scheduler, storage);
+    if (coloring) {
+        // all threads accumulate into the buffers of the first thread
+        DerivativeHolder& first = threadData.value(0).derivatives;
+        first.initialize(scheduler, storage);
+        for (ThreadData& data : threadData) {
+            if (&data.derivatives != &first) {
+                data.derivatives.initializeShared(storage, first.getAccumulated());
+            }
+        }
+    } else {
+        for (ThreadData& data : threadData) {
+            data.derivatives.initialize(scheduler, storage);
+        }
     }
 }
 
 template <Size Dim>
 void SymmetricSolver<Dim>::afterLoop(Storage& storage, Statistics& stats) {
-    Accumulated* first = nullptr;
-
-    // sum up thread local accumulated values
-    Array<Accumulated*> threadLocalAccumulated;
-    for (ThreadData& data : threadData) {
-        if (!first) {
-            first = &data.derivatives.getAccumulated();
-        } else {
-            SPH_ASSERT(first != nullptr);
-            threadLocalAccumulated.push(&data.derivatives.getAccumulated());
+    Accumulated& first = threadData.value(0).derivatives.getAccumulated();
+
+    if (!coloring) {
+        // sum up thread local accumulated values
+        Array<Accumulated*> threadLocalAccumulated;
+        for (ThreadData& data : threadData) {
+            if (&data.derivatives.getAccumulated() != &first) {
+                threadLocalAccumulated.push(&data.derivatives.getAccumulated());
+            }
         }
+        first.sum(scheduler, threadLocalAccumulated);
     }
-    SPH_ASSERT(first != nullptr);
-    first->sum(scheduler, threadLocalAccumulated);
 
     // store them to storage
-    first->store(scheduler, storage);
+    first.store(scheduler, storage);
 
     // compute neighbor statistics
     MinMaxMean neighs;
@@ -182,7 +293,7 @@ void SymmetricSolver<Dim>::afterLoop(Storage& storage, Statistics& stats) {
 template <Size Dim>
 RawPtr<const IBasicFinder> SymmetricSolver<Dim>::getFinder(ArrayView<const Vector> r) {
     /// \todo same thing as in AsymmetricSolver -> move to shared parent?
-    finder->build(scheduler, r);
+    finder->refit(scheduler, r);
     return &*finder;
 }
 
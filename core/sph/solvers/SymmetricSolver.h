@@ -5,6 +5,8 @@
 /// \author Pavel Sevecek (sevecek at sirrah.troja.mff.cuni.cz)
 /// \date 2016-2021
 
+#include "objects/finders/ColoredGrid.h"
+#include "objects/finders/NeighborList.h"
 #include "sph/equations/Derivative.h"
 #include "sph/equations/EquationTerm.h"
 #include "sph/kernel/Kernel.h"
@@ -27,6 +29,9 @@ class ISymmetricFinder;
 /// buffers where the computed derivatives are accumulated) and cannot be use when more than one pass over
 /// particle neighbors is needed to compute the derivative (unless the user constructs two SymmetricSolvers
 /// with different sets of equations).
+/// The memory overhead can be avoided by enabling the colored accumulation. Particles are then processed in
+/// groups that have no common neighbors (see \ref ColoredGrid) and all threads accumulate the derivatives
+/// into the buffers of the first thread.
 template <Size Dim>
 class SymmetricSolver : public ISolver {
 protected:
@@ -62,6 +67,16 @@ protected:
     /// Selected SPH kernel
     LutKernel<Dim> kernel;
 
+    /// Cached lists of neighbor candidates; empty if the caching is disabled.
+    Optional<NeighborList> neighborList;
+
+    /// Partitioning of particles used by the colored accumulation; empty if the accumulation uses
+    /// thread-local buffers.
+    Optional<ColoredGrid> coloring;
+
+    /// Indices of particles with required derivatives; null view means all particles.
+    ArrayView<const Size> activeParticles;
+
 public:
     /// \brief Creates a symmetric solver, given the list of equations to solve
     ///
@@ -84,9 +99,18 @@ public:
 
     virtual void create(Storage& storage, IMaterial& material) const override;
 
+    /// \brief Restricts the evaluation of derivatives to a subset of particles.
+    ///
+    /// Pairs of an active and an inactive particle would be visited from one side only, so the derivatives
+    /// of active particles are evaluated asymmetrically, using all neighbors of the particle.
+    virtual void setActiveParticles(ArrayView<const Size> active) override;
+
 protected:
     virtual void loop(Storage& storage, Statistics& stats);
 
+    /// \brief Evaluates derivatives of active particles, see \ref setActiveParticles.
+    void loopActive(Storage& storage);
+
     /// \todo there functions HAVE to be called, so it doesn't make sense to have them virtual - instead split
     /// it into a mandatory function and another one (empty by default) than can be overriden
     virtual void beforeLoop(Storage& storage, Statistics& stats);
@@ -1,4 +1,5 @@
 #include "bench/Session.h"
+#include "quantities/Utility.h"
 #include "sph/solvers/AsymmetricSolver.h"
 #include "sph/solvers/EnergyConservingSolver.h"
 #include "sph/solvers/GravitySolver.h"
@@ -11,6 +12,7 @@
 #include "timestepping/TimeStepping.h"
 #include <atomic>
 #include <iostream>
+#include <random>
 
 using namespace Sph;
 
@@ -59,3 +61,55 @@ BENCHMARK("GravitySolver simple", "[solvers]", Benchmark::Context& context) {
     GravitySolver<AsymmetricSolver> solver(pool, settings, getStandardEquations(settings));
     benchmarkSolver(solver, context);
 }
+
+BENCHMARK("SymmetricSolver fused derivatives", "[solvers]", Benchmark::Context& context) {
+    RunSettings settings;
+    settings.set(RunSettingsId::SPH_FUSED_DERIVATIVES, true);
+    Tbb& pool = *Tbb::getGlobalInstance();
+    SymmetricSolver<DIMENSIONS> solver(pool, settings, getStandardEquations(settings));
+    benchmarkSolver(solver, context);
+}
+
+BENCHMARK("AsymmetricSolver fused derivatives", "[solvers]", Benchmark::Context& context) {
+    RunSettings settings;
+    settings.set(RunSettingsId::SPH_FUSED_DERIVATIVES, true);
+    Tbb& pool = *Tbb::getGlobalInstance();
+    AsymmetricSolver solver(pool, settings, getStandardEquations(settings));
+    benchmarkSolver(solver, context);
+}
+
+static void benchmarkOrder(const bool reorder, Benchmark::Context& context) {
+    RunSettings settings;
+    Tbb& pool = *Tbb::getGlobalInstance();
+    AsymmetricSolver solver(pool, settings, getStandardEquations(settings));
+    BodySettings body;
+    body.set(BodySettingsId::DENSITY, 100._f).set(BodySettingsId::ENERGY, 10._f);
+    Storage storage = Tests::getSolidStorage(1000000, body);
+    solver.create(storage, storage.getMaterial(0));
+
+    // particles of a long-running impact are scattered in memory; simulate it by shuffling the particles
+    Array<Size> order(storage.getParticleCnt());
+    for (Size i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::mt19937 g(1234);
+    std::shuffle(order.begin(), order.end(), g);
+    storage.reorder(pool, order);
+
+    if (reorder) {
+        storage.reorder(pool, getSpatialOrder(pool, storage));
+    }
+
+    Statistics stats;
+    while (context.running()) {
+        solver.integrate(storage, stats);
+    }
+}
+
+BENCHMARK("AsymmetricSolver scattered particles", "[solvers]", Benchmark::Context& context) {
+    benchmarkOrder(false, context);
+}
+
+BENCHMARK("AsymmetricSolver reordered particles", "[solvers]", Benchmark::Context& context) {
+    benchmarkOrder(true, context);
+}
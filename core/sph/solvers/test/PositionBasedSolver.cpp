@@ -0,0 +1,95 @@
+#include "sph/solvers/PositionBasedSolver.h"
+#include "catch.hpp"
+#include "math/rng/VectorRng.h"
+#include "quantities/Quantity.h"
+#include "system/Statistics.h"
+#include "tests/Setup.h"
+#include "thread/Pool.h"
+
+using namespace Sph;
+
+/// Moves the particles by the velocities computed by the solver, returning the mean density error.
+static Float advanceAndGetDensityError(Storage& storage, ArrayView<const Float> rho0, const Float dt) {
+    ArrayView<Vector> r, v, dv;
+    tie(r, v, dv) = storage.getAll<Vector>(QuantityId::POSITION);
+    ArrayView<const Float> m = storage.getValue<Float>(QuantityId::MASS);
+    for (Size i = 0; i < r.size(); ++i) {
+        r[i] += v[i] * dt;
+        v[i] = Vector(0._f);
+    }
+    LutKernel<3> poly6 = Poly6();
+    Float error = 0._f;
+    for (Size i = 0; i < r.size(); ++i) {
+        Float rho = 0._f;
+        for (Size j = 0; j < r.size(); ++j) {
+            rho += m[j] * poly6.value(r[i] - r[j], r[j][H]);
+        }
+        error += abs(rho / rho0[i] - 1._f);
+    }
+    return error / r.size();
+}
+
+static Array<Float> getRestDensities(const Storage& storage) {
+    ArrayView<const Vector> r = storage.getValue<Vector>(QuantityId::POSITION);
+    ArrayView<const Float> m = storage.getValue<Float>(QuantityId::MASS);
+    LutKernel<3> poly6 = Poly6();
+    Array<Float> rho0(r.size());
+    for (Size i = 0; i < r.size(); ++i) {
+        rho0[i] = 0._f;
+        for (Size j = 0; j < r.size(); ++j) {
+            rho0[i] += m[j] * poly6.value(r[i] - r[j], r[j][H]);
+        }
+    }
+    return rho0;
+}
+
+static Storage solve(IScheduler& scheduler, const Size iterCnt, const bool gaussSeidel, Float& error) {
+    BodySettings body;
+    body.set(BodySettingsId::DENSITY, 1._f).set(BodySettingsId::ENERGY, 1._f);
+    Storage storage = Tests::getGassStorage(1000, body, 1._f);
+    RunSettings settings;
+    settings.set(RunSettingsId::GRAVITY_SOLVER, GravityEnum::BRUTE_FORCE)
+        .set(RunSettingsId::PBD_ITERATION_COUNT, int(iterCnt))
+        .set(RunSettingsId::PBD_RELAXATION_PARAMETER, 0.1_f)
+        .set(RunSettingsId::PBD_GAUSS_SEIDEL, gaussSeidel);
+    PositionBasedSolver solver(scheduler, settings);
+    solver.create(storage, storage.getMaterial(0));
+
+    const Float dt = 0.01_f;
+    Statistics stats;
+    stats.set(StatisticsId::TIMESTEP_VALUE, dt);
+
+    // first step initializes the rest densities
+    solver.integrate(storage, stats);
+    const Array<Float> rho0 = getRestDensities(storage);
+    REQUIRE(advanceAndGetDensityError(storage, rho0, dt) < 1.e-6_f);
+
+    // perturb the velocities, so that the constraints have to be enforced
+    ArrayView<Vector> v = storage.getDt<Vector>(QuantityId::POSITION);
+    VectorRng<BenzAsphaugRng> rng(1234);
+    for (Size i = 0; i < v.size(); ++i) {
+        v[i] = 3._f * (rng() - Vector(0.5_f));
+    }
+    solver.integrate(storage, stats);
+    error = advanceAndGetDensityError(storage, rho0, dt);
+    return storage;
+}
+
+TEST_CASE("PositionBasedSolver Gauss-Seidel", "[positionbased]") {
+    ThreadPool pool(4);
+    Float initialError, jacobiError, sequentialError, parallelError;
+    solve(pool, 0, false, initialError);
+    solve(pool, 4, false, jacobiError);
+    Storage sequential = solve(SEQUENTIAL, 4, true, sequentialError);
+    Storage parallel = solve(pool, 4, true, parallelError);
+
+    // particles of the same color are independent, so the result does not depend on the number of threads
+    REQUIRE(sequentialError == parallelError);
+    ArrayView<const Vector> r1 = sequential.getValue<Vector>(QuantityId::POSITION);
+    ArrayView<const Vector> r2 = parallel.getValue<Vector>(QuantityId::POSITION);
+    REQUIRE(std::equal(r1.begin(), r1.end(), r2.begin()));
+
+    // both methods reduce the error, Gauss-Seidel iterations propagate the corrections faster
+    REQUIRE(jacobiError < initialError);
+    REQUIRE(parallelError < jacobiError);
+}
@@ -210,13 +210,105 @@ static void testSolverEquivalency(const Float eps) {
     });
 }
 
+/// Checks that all buffers of two storages with the same quantities match up to given tolerance.
+static void requireEqualBuffers(Storage& st1, Storage& st2, const Float eps) {
+    bool match = true;
+    iteratePair<VisitorEnum::ALL_BUFFERS>(st1, st2, [&match, eps](auto& ar1, auto& ar2) {
+        for (Size i = 0; i < ar1.size(); ++i) {
+            match &= Sph::almostEqual(ar1[i], ar2[i], eps);
+        }
+    });
+    REQUIRE(match);
+}
+
 TEST_CASE("Symmetric/asymmetric equivalency", "[solvers]") {
     // Symmetric and asymmetric solvers should be equivalent (the difference is just in implementation)
     testSolverEquivalency<SymmetricSolver<3>, AsymmetricSolver>(EPS);
 }
 
+TEMPLATE_TEST_CASE("Solvers neighbor list", "[solvers]", SymmetricSolver<3>, AsymmetricSolver) {
+    // cached neighbor lists should only affect the performance, not the results
+    SharedPtr<Storage> st1 = solveGassBall<TestType>(RunSettings::getDefaults(), EMPTY_FLAGS);
+    RunSettings settings;
+    settings.set(RunSettingsId::SPH_USE_NEIGHBOR_LIST, true);
+    SharedPtr<Storage> st2 = solveGassBall<TestType>(settings, EMPTY_FLAGS);
+
+    requireEqualBuffers(*st1, *st2, EPS);
+}
+
+TEMPLATE_TEST_CASE("Solvers fused derivatives",
+    "[solvers]",
+    SymmetricSolver<3>,
+    AsymmetricSolver,
+    EnergyConservingSolver) {
+    // fused derivatives are evaluated in a single loop, the results should be the same up to round-off errors
+    SharedPtr<Storage> st1 = solveGassBall<TestType>(RunSettings::getDefaults(), EMPTY_FLAGS);
+    RunSettings settings;
+    settings.set(RunSettingsId::SPH_FUSED_DERIVATIVES, true);
+    SharedPtr<Storage> st2 = solveGassBall<TestType>(settings, EMPTY_FLAGS);
+
+    requireEqualBuffers(*st1, *st2, EPS);
+}
+
+TEST_CASE("Symmetric solver colored accumulation", "[solvers]") {
+    // the order of accumulation differs, but the results should be the same up to round-off errors
+    SharedPtr<Storage> st1 = solveGassBall<SymmetricSolver<3>>(RunSettings::getDefaults(), EMPTY_FLAGS);
+    RunSettings settings;
+    settings.set(RunSettingsId::SPH_SYMMETRIC_COLORED_ACCUMULATION, true);
+    SharedPtr<Storage> st2 = solveGassBall<SymmetricSolver<3>>(settings, EMPTY_FLAGS);
+
+    requireEqualBuffers(*st1, *st2, EPS);
+}
+
 TEST_CASE("Asymmetric/Energy conserving similarity", "[solvers]") {
     // Asymmetric and energy conserving solver are slightly different, but they should generally produce
     // similar results
     testSolverEquivalency<AsymmetricSolver, EnergyConservingSolver>(0.11_f); /// \todo can we do better?
 }
+
+TEMPLATE_TEST_CASE("Solvers active particles", "[solvers]", SymmetricSolver<3>, AsymmetricSolver) {
+    RunSettings settings;
+    settings.set(RunSettingsId::SPH_SOLVER_FORCES, ForceEnum::PRESSURE)
+        .set(RunSettingsId::SPH_ADAPTIVE_SMOOTHING_LENGTH, EMPTY_FLAGS);
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+    TestType solver(pool, settings, getStandardEquations(settings));
+
+    BodySettings body;
+    body.set(BodySettingsId::DENSITY, 10._f).set(BodySettingsId::ENERGY, 1.e4_f);
+    Storage all = Tests::getGassStorage(200, body, 1._f);
+    solver.create(all, all.getMaterial(0));
+    Storage subset = all.clone(VisitorEnum::ALL_BUFFERS);
+
+    Statistics stats;
+    solver.integrate(all, stats);
+
+    Array<Size> active;
+    for (Size i = 0; i < subset.getParticleCnt(); i += 3) {
+        active.push(i);
+    }
+    solver.setActiveParticles(active);
+    solver.integrate(subset, stats);
+    solver.setActiveParticles(nullptr);
+
+    // derivatives of active particles have to match the evaluation of all particles
+    ArrayView<const Vector> dv1 = all.getD2t<Vector>(QuantityId::POSITION);
+    ArrayView<const Vector> dv2 = subset.getD2t<Vector>(QuantityId::POSITION);
+    ArrayView<const Float> du1 = all.getDt<Float>(QuantityId::ENERGY);
+    ArrayView<const Float> du2 = subset.getDt<Float>(QuantityId::ENERGY);
+    ArrayView<const Size> neighs1 = all.getValue<Size>(QuantityId::NEIGHBOR_CNT);
+    ArrayView<const Size> neighs2 = subset.getValue<Size>(QuantityId::NEIGHBOR_CNT);
+    auto test = [&](const Size k) -> Outcome {
+        const Size i = active[k];
+        if (dv1[i] != approx(dv2[i], 1.e-10_f)) {
+            return makeFailed("Different acceleration: {} == {}", dv1[i], dv2[i]);
+        }
+        if (du1[i] != approx(du2[i], 1.e-10_f)) {
+            return makeFailed("Different energy derivative: {} == {}", du1[i], du2[i]);
+        }
+        if (neighs1[i] != neighs2[i]) {
+            return makeFailed("Different neighbor count: {} == {}", neighs1[i], neighs2[i]);
+        }
+        return SUCCESS;
+    };
+    REQUIRE_SEQUENCE(test, 0, active.size());
+}
@@ -3,8 +3,10 @@
 #include "gravity/BruteForceGravity.h"
 #include "gravity/CachedGravity.h"
 #include "gravity/Collision.h"
+#include "gravity/FastMultipole.h"
 #include "gravity/SphericalGravity.h"
 #include "gravity/SymmetricGravity.h"
+#include "io/AsyncOutput.h"
 #include "io/LogWriter.h"
 #include "io/Logger.h"
 #include "io/Output.h"
@@ -40,6 +42,7 @@
 #include "thread/OpenMp.h"
 #include "thread/Pool.h"
 #include "thread/Tbb.h"
+#include "thread/WorkStealing.h"
 #include "timestepping/TimeStepCriterion.h"
 #include "timestepping/TimeStepping.h"
 
@@ -175,6 +178,8 @@ AutoPtr<ITimeStepping> Factory::getTimeStepping(const RunSettings& settings,
         return makeAuto<ModifiedMidpointMethod>(storage, settings);
     case TimesteppingEnum::RUNGE_KUTTA:
         return makeAuto<RungeKutta>(storage, settings);
+    case TimesteppingEnum::BLOCK:
+        return makeAuto<BlockTimeStepping>(storage, settings);
     default:
         NOT_IMPLEMENTED;
     }
@@ -212,37 +217,86 @@ AutoPtr<ISymmetricFinder> Factory::getFinder(const RunSettings& settings) {
     }
 }
 
+/// Returns the global instance of the pool if it is still used and has the same thread count, otherwise
+/// creates a new pool.
+template <typename TPool, typename... TArgs>
+static SharedPtr<TPool> getPool(WeakPtr<TPool>& weakGlobal,
+    const Size threadCnt,
+    const Size granularity,
+    TArgs&&... args) {
+    if (SharedPtr<TPool> global = weakGlobal.lock()) {
+        if (global->getThreadCnt() == threadCnt) {
+            // scheduler is already used by some component and has the same thread count, we can reuse the
+            // instance instead of creating a new one
+            global->setGranularity(granularity);
+            return global;
+        }
+    }
+
+    SharedPtr<TPool> newPool = makeShared<TPool>(threadCnt, granularity, std::forward<TArgs>(args)...);
+    weakGlobal = newPool;
+    return newPool;
+}
+
 SharedPtr<IScheduler> Factory::getScheduler(const RunSettings& settings) {
     const Size threadCnt = settings.get<int>(RunSettingsId::RUN_THREAD_CNT);
     const Size granularity = settings.get<int>(RunSettingsId::RUN_THREAD_GRANULARITY);
     if (threadCnt == 1) {
         // optimization - use directly SequentialScheduler instead of thread pool with 1 thread
         return SequentialScheduler::getGlobalInstance();
-    } else {
+    }
+
+    // settings created before the scheduler could be selected do not contain the entries
+    SchedulerEnum id =
+        settings.getOr<SchedulerEnum>(RunSettingsId::RUN_THREAD_SCHEDULER, SchedulerEnum::DEFAULT);
+    if (settings.getOr<bool>(RunSettingsId::RUN_THREAD_NUMA, false)) {
+        if (id != SchedulerEnum::DEFAULT && id != SchedulerEnum::WORK_STEALING) {
+            throw InvalidSetup("NUMA-aware mode is only supported by the work-stealing scheduler.");
+        }
+        static WeakPtr<WorkStealingPool> weakNuma;
+        return getPool(weakNuma, threadCnt, granularity, true);
+    }
+
+    if (id == SchedulerEnum::DEFAULT) {
+#ifdef SPH_USE_TBB
+        id = SchedulerEnum::TBB;
+#elif defined(SPH_USE_OPENMP)
+        id = SchedulerEnum::OPENMP;
+#else
+        id = SchedulerEnum::THREAD_POOL;
+#endif
+    }
+
+    switch (id) {
+    case SchedulerEnum::TBB: {
 #ifdef SPH_USE_TBB
         SharedPtr<Tbb> scheduler = Tbb::getGlobalInstance();
         scheduler->setGranularity(granularity);
         return scheduler;
-#elif SPH_USE_OPENMP
+#else
+        throw InvalidSetup("Code was compiled without TBB support.");
+#endif
+    }
+    case SchedulerEnum::OPENMP: {
+#ifdef SPH_USE_OPENMP
         SharedPtr<OmpScheduler> scheduler = OmpScheduler::getGlobalInstance();
         scheduler->setGranularity(granularity);
         return scheduler;
 #else
-        static WeakPtr<ThreadPool> weakGlobal = ThreadPool::getGlobalInstance();
-        if (SharedPtr<ThreadPool> global = weakGlobal.lock()) {
-            if (global->getThreadCnt() == threadCnt) {
-                // scheduler is already used by some component and has the same thread count, we can reuse the
-                // instance instead of creating a new one
-                global->setGranularity(granularity);
-                return global;
-            }
-        }
-
-        SharedPtr<ThreadPool> newPool = makeShared<ThreadPool>(threadCnt, granularity);
-        weakGlobal = newPool;
-        return newPool;
+        throw InvalidSetup("Code was compiled without OpenMP support.");
 #endif
     }
+    case SchedulerEnum::THREAD_POOL: {
+        static WeakPtr<ThreadPool> weakGlobal = ThreadPool::getGlobalInstance();
+        return getPool(weakGlobal, threadCnt, granularity);
+    }
+    case SchedulerEnum::WORK_STEALING: {
+        static WeakPtr<WorkStealingPool> weakGlobal;
+        return getPool(weakGlobal, threadCnt, granularity);
+    }
+    default:
+        NOT_IMPLEMENTED;
+    }
 }
 
 AutoPtr<IUvMapping> Factory::getUvMapping(const RunSettings& settings) {
@@ -384,14 +438,20 @@ AutoPtr<IGravity> Factory::getGravity(const RunSettings& settings) {
     case GravityEnum::BRUTE_FORCE:
         gravity = makeAuto<BruteForceGravity>(std::move(kernel));
         break;
-    case GravityEnum::BARNES_HUT: {
+    case GravityEnum::BARNES_HUT:
+    case GravityEnum::FAST_MULTIPOLE: {
         const Float theta = settings.get<Float>(RunSettingsId::GRAVITY_OPENING_ANGLE);
         const MultipoleOrder order =
             MultipoleOrder(settings.get<int>(RunSettingsId::GRAVITY_MULTIPOLE_ORDER));
         const Size leafSize = settings.get<int>(RunSettingsId::FINDER_LEAF_SIZE);
         const Size maxDepth = settings.get<int>(RunSettingsId::FINDER_MAX_PARALLEL_DEPTH);
         const Float constant = settings.get<Float>(RunSettingsId::GRAVITY_CONSTANT);
-        gravity = makeAuto<BarnesHut>(theta, order, std::move(kernel), leafSize, maxDepth, constant);
+        if (id == GravityEnum::BARNES_HUT) {
+            gravity = makeAuto<BarnesHut>(theta, order, std::move(kernel), leafSize, maxDepth, constant);
+        } else {
+            gravity =
+                makeAuto<FastMultipole>(theta, order, std::move(kernel), leafSize, maxDepth, constant);
+        }
         break;
     }
     default:
@@ -596,12 +656,11 @@ AutoPtr<ILogWriter> Factory::getLogWriter(SharedPtr<ILogger> logger, const RunSe
     }
 }
 
-AutoPtr<IOutput> Factory::getOutput(const RunSettings& settings) {
+/// Creates the output writing the files immediately, using given scheduler to process the data.
+static AutoPtr<IOutput> getSyncOutput(const RunSettings& settings,
+    const OutputFile& file,
+    const SharedPtr<IScheduler>& scheduler) {
     const IoEnum id = settings.get<IoEnum>(RunSettingsId::RUN_OUTPUT_TYPE);
-    const Path outputPath(settings.get<String>(RunSettingsId::RUN_OUTPUT_PATH));
-    const Path fileMask(settings.get<String>(RunSettingsId::RUN_OUTPUT_NAME));
-    const Size firstIndex = settings.get<int>(RunSettingsId::RUN_OUTPUT_FIRST_INDEX);
-    const OutputFile file(outputPath / fileMask, firstIndex);
     switch (id) {
     case IoEnum::NONE:
         return makeAuto<NullOutput>();
@@ -609,15 +668,35 @@ AutoPtr<IOutput> Factory::getOutput(const RunSettings& settings) {
         const String name = settings.get<String>(RunSettingsId::RUN_NAME);
         const Flags<OutputQuantityFlag> flags =
             settings.getFlags<OutputQuantityFlag>(RunSettingsId::RUN_OUTPUT_QUANTITIES);
-        return makeAuto<TextOutput>(file, name, flags);
+        return makeAuto<TextOutput>(file, name, flags, EMPTY_FLAGS, scheduler);
     }
     case IoEnum::BINARY_FILE: {
         const RunTypeEnum runType = settings.get<RunTypeEnum>(RunSettingsId::RUN_TYPE);
-        return makeAuto<BinaryOutput>(file, runType);
+        const Size checkpointPeriod = settings.get<int>(RunSettingsId::RUN_OUTPUT_CHECKPOINT_PERIOD);
+        return makeAuto<BinaryOutput>(file, runType, checkpointPeriod);
+    }
+    case IoEnum::ARCHIVE_FILE: {
+        const RunTypeEnum runType = settings.get<RunTypeEnum>(RunSettingsId::RUN_TYPE);
+        return makeAuto<ArchiveOutput>(file, runType);
     }
     case IoEnum::DATA_FILE: {
         const RunTypeEnum runType = settings.get<RunTypeEnum>(RunSettingsId::RUN_TYPE);
-        return makeAuto<CompressedOutput>(file, CompressionEnum::NONE /*TODO*/, runType);
+        const CompressionEnum compression =
+            settings.get<CompressionEnum>(RunSettingsId::RUN_OUTPUT_COMPRESSION);
+        QuantizationParams quantization;
+        quantization.position.value = settings.get<Float>(RunSettingsId::RUN_OUTPUT_ERROR_POSITION);
+        quantization.position.relative =
+            settings.get<bool>(RunSettingsId::RUN_OUTPUT_ERROR_POSITION_RELATIVE);
+        quantization.velocity.value = settings.get<Float>(RunSettingsId::RUN_OUTPUT_ERROR_VELOCITY);
+        quantization.velocity.relative =
+            settings.get<bool>(RunSettingsId::RUN_OUTPUT_ERROR_VELOCITY_RELATIVE);
+        quantization.density.value = settings.get<Float>(RunSettingsId::RUN_OUTPUT_ERROR_DENSITY);
+        quantization.density.relative = settings.get<bool>(RunSettingsId::RUN_OUTPUT_ERROR_DENSITY_RELATIVE);
+        quantization.energy.value = settings.get<Float>(RunSettingsId::RUN_OUTPUT_ERROR_ENERGY);
+        quantization.energy.relative = settings.get<bool>(RunSettingsId::RUN_OUTPUT_ERROR_ENERGY_RELATIVE);
+        quantization.damage.value = settings.get<Float>(RunSettingsId::RUN_OUTPUT_ERROR_DAMAGE);
+        quantization.damage.relative = settings.get<bool>(RunSettingsId::RUN_OUTPUT_ERROR_DAMAGE_RELATIVE);
+        return makeAuto<CompressedOutput>(file, compression, runType, scheduler, quantization);
     }
     case IoEnum::VTK_FILE: {
         const Flags<OutputQuantityFlag> flags =
@@ -627,7 +706,7 @@ AutoPtr<IOutput> Factory::getOutput(const RunSettings& settings) {
     case IoEnum::PKDGRAV_INPUT: {
         PkdgravParams pkd;
         pkd.omega = settings.get<Vector>(RunSettingsId::FRAME_ANGULAR_FREQUENCY);
-        return makeAuto<PkdgravOutput>(file, std::move(pkd));
+        return makeAuto<PkdgravOutput>(file, std::move(pkd), scheduler);
     }
 #ifdef SPH_USE_VDB
     case IoEnum::VDB_FILE:
@@ -638,21 +717,42 @@ AutoPtr<IOutput> Factory::getOutput(const RunSettings& settings) {
     }
 }
 
+AutoPtr<IOutput> Factory::getOutput(const RunSettings& settings) {
+    const Path outputPath(settings.get<String>(RunSettingsId::RUN_OUTPUT_PATH));
+    const Path fileMask(settings.get<String>(RunSettingsId::RUN_OUTPUT_NAME));
+    const Size firstIndex = settings.get<int>(RunSettingsId::RUN_OUTPUT_FIRST_INDEX);
+    const OutputFile file(outputPath / fileMask, firstIndex);
+    const IoEnum id = settings.get<IoEnum>(RunSettingsId::RUN_OUTPUT_TYPE);
+    if (id != IoEnum::NONE && settings.get<bool>(RunSettingsId::RUN_OUTPUT_ASYNC_ENABLE)) {
+        const Size snapshotCnt = settings.get<int>(RunSettingsId::RUN_OUTPUT_ASYNC_SNAPSHOT_CNT);
+        if (snapshotCnt == 0) {
+            throw InvalidSetup("Asynchronous output needs at least one snapshot.");
+        }
+        // the files are written on a background thread, which must not use the scheduler of the run, as it is
+        // used by the simulation at the same time
+        AutoPtr<IOutput> output = getSyncOutput(settings, file, SequentialScheduler::getGlobalInstance());
+        return makeAuto<AsyncOutput>(file, std::move(output), getScheduler(settings), snapshotCnt);
+    }
+    return getSyncOutput(settings, file, getScheduler(settings));
+}
+
 AutoPtr<IInput> Factory::getInput(const Path& path) {
     const String ext = path.extension().string();
     if (ext == "ssf") {
         return makeAuto<BinaryInput>();
     } else if (ext == "sdf" || ext == "scf") { // .scf is an older extension of this format
-        return makeAuto<CompressedInput>();
+        return makeAuto<CompressedInput>(ThreadPool::getGlobalInstance());
+    } else if (ext == "sar") {
+        return makeAuto<ArchiveInput>();
     } else if (ext == "h5") {
         return makeAuto<Hdf5Input>();
     } else if (ext == "tab") {
-        return makeAuto<TabInput>();
+        return makeAuto<TabInput>(ThreadPool::getGlobalInstance());
     } else if (ext == "dat") {
-        return makeAuto<MpcorpInput>();
+        return makeAuto<MpcorpInput>(2700._f, 0.2_f, ThreadPool::getGlobalInstance());
     } else {
         if (ext.size() > 3 && ext.substr(ext.size() - 3) == ".bt") {
-            return makeAuto<PkdgravInput>();
+            return makeAuto<PkdgravInput>(ThreadPool::getGlobalInstance());
         }
     }
     throw InvalidSetup("Unknown file type: " + path.string());
@@ -1,5 +1,6 @@
 #include "system/Profiler.h"
 #include "io/Logger.h"
+#include "thread/Numa.h"
 #include <algorithm>
 
 NAMESPACE_SPH_BEGIN
@@ -8,6 +9,11 @@ NAMESPACE_SPH_BEGIN
 AutoPtr<Profiler> Profiler::instance;
 
 Profiler::Profiler() {
+    const Size nodeCnt = NumaTopology::getInstance().getNodeCnt();
+    for (Size i = 0; i < nodeCnt; ++i) {
+        numaRecords.push(makeAuto<NumaRecord>());
+    }
+
     cpuUsage.thread = std::thread([this] {
         while (!quitting) {
             const Optional<Float> usage = getCpuUsage();
@@ -42,6 +48,17 @@ Array<ScopeStatistics> Profiler::getStatistics() const {
     return stats;
 }
 
+Array<NumaStatistics> Profiler::getNumaStatistics() const {
+    Array<NumaStatistics> stats;
+    for (Size node = 0; node < numaRecords.size(); ++node) {
+        stats.push(NumaStatistics{ node, numaRecords[node]->busyTime, numaRecords[node]->remoteTime });
+    }
+    if (std::all_of(stats.begin(), stats.end(), [](const NumaStatistics& s) { return s.busyTime == 0; })) {
+        return Array<NumaStatistics>();
+    }
+    return stats;
+}
+
 void Profiler::printStatistics(ILogger& logger) const {
     Array<ScopeStatistics> stats = this->getStatistics();
     for (ScopeStatistics& s : stats) {
@@ -52,6 +69,15 @@ void Profiler::printStatistics(ILogger& logger) const {
            << std::fixed << 100._f * s.cpuUsage << "%";
         logger.write(String::fromAscii(ss.str().c_str()));
     }
+
+    for (const NumaStatistics& s : this->getNumaStatistics()) {
+        std::stringstream ss;
+        const std::string name = "NUMA node " + std::to_string(s.node);
+        ss << std::setw(45) << std::left << name << " | " << std::setw(10) << std::right
+           << s.busyTime << "mus   | remote: " << std::setw(8) << std::right << std::setprecision(3)
+           << std::fixed << 100._f * s.remoteTime / max<uint64_t>(s.busyTime, 1) << "%";
+        logger.write(String::fromAscii(ss.str().c_str()));
+    }
 }
 #endif
 
@@ -87,6 +87,18 @@ struct ScopeStatistics {
     Float cpuUsage;
 };
 
+struct NumaStatistics {
+    /// Index of the NUMA node
+    Size node;
+
+    /// Time spent by threads of the node in parallel jobs (in mus)
+    uint64_t busyTime;
+
+    /// Time spent in jobs assigned to a different node (in mus). The memory accessed by these jobs is likely
+    /// to be located on the other node.
+    uint64_t remoteTime;
+};
+
 
 /// Profiler object implemented as singleton.
 class Profiler : public Noncopyable {
@@ -107,6 +119,14 @@ private:
     // map of profiled scopes, its key being a string = name of the scope
     std::map<String, ScopeRecord> records;
 
+    struct NumaRecord {
+        std::atomic<uint64_t> busyTime{ 0 };
+        std::atomic<uint64_t> remoteTime{ 0 };
+    };
+
+    // work done by each NUMA node, only recorded by NUMA-aware schedulers
+    Array<AutoPtr<NumaRecord>> numaRecords;
+
     struct {
         String currentScope;
         std::thread thread;
@@ -138,15 +158,35 @@ public:
         });
     }
 
+    /// \brief Adds time spent by a thread on given NUMA node processing a parallel job.
+    ///
+    /// \param node NUMA node of the thread.
+    /// \param elapsed Duration of the job in microseconds.
+    /// \param remote True if the job was assigned to a different node and stolen by this thread.
+    void recordNumaWork(const Size node, const uint64_t elapsed, const bool remote) {
+        SPH_ASSERT(node < numaRecords.size());
+        numaRecords[node]->busyTime += elapsed;
+        if (remote) {
+            numaRecords[node]->remoteTime += elapsed;
+        }
+    }
+
     /// Returns the array of scope statistics, sorted by elapsed time.
     Array<ScopeStatistics> getStatistics() const;
 
+    /// Returns the work done by each NUMA node. Empty if no NUMA-aware scheduler has been used.
+    Array<NumaStatistics> getNumaStatistics() const;
+
     /// Prints statistics into the logger.
     void printStatistics(ILogger& logger) const;
 
     /// Clears all records, mainly for testing purposes
     void clear() {
         records.clear();
+        for (auto& record : numaRecords) {
+            record->busyTime = 0;
+            record->remoteTime = 0;
+        }
     }
 };
 
@@ -64,6 +64,10 @@ static RegisterEnum<TimesteppingEnum> sTimestepping({
         "modified_midpoint",
         "Modified midpoint method with constant number of substeps." },
     //{ TimesteppingEnum::BULIRSCH_STOER, "bulirsch_stoer", "Bulirsch-Stoer integrator" },
+    { TimesteppingEnum::BLOCK,
+        "block",
+        "Hierarchical timestepping, advancing particles with individual time steps. Derivatives are only "
+        "evaluated for particles at the beginning of their time step." },
 });
 
 static RegisterEnum<TimeStepCriterionEnum> sTimeStepCriterion({
@@ -253,6 +257,10 @@ static RegisterEnum<GravityEnum> sGravity({
     { GravityEnum::BARNES_HUT,
         "barnes_hut",
         "Barnes-Hut algorithm approximating gravity by multipole expansion (up to octupole order)." },
+    { GravityEnum::FAST_MULTIPOLE,
+        "fast_multipole",
+        "Fast multipole method, translating multipole expansions of distant nodes into local expansions "
+        "evaluated at particles. Uses the same opening angle and multipole order as Barnes-Hut." },
 });
 
 static RegisterEnum<GravityKernelEnum> sGravityKernel({
@@ -319,6 +327,11 @@ static RegisterEnum<IoEnum> sIo({
         "state_file",
         "Save output data into binary file. This data dump is lossless and can be use to restart run from "
         "saved snapshot. Stores values, all derivatives and materials of the storage." },
+    { IoEnum::ARCHIVE_FILE,
+        "archive_file",
+        "Save all output data into a single archive file. Each snapshot is stored in the same format as "
+        "the state file and can be used to restart the run. The archive can be read while the run is "
+        "still writing it." },
     { IoEnum::TEXT_FILE, "text_file", "Save output data into formatted human-readable text file" },
     { IoEnum::VTK_FILE,
         "vtk_file",
@@ -335,6 +348,21 @@ static RegisterEnum<IoEnum> sIo({
 #endif
 });
 
+static RegisterEnum<CompressionEnum> sCompression({
+    { CompressionEnum::NONE, "none", "No compression." },
+    { CompressionEnum::RLE, "rle", "Repeated values are stored only once with the number of repetitions." },
+    { CompressionEnum::XOR_SHUFFLE,
+        "xor_shuffle",
+        "Lossless compression of floating-point values. Particles are sorted along a space-filling curve, "
+        "adjacent values are XOR-ed, bytes are shuffled and compressed by an LZ77-type coder. Data are compressed "
+        "in parallel." },
+    { CompressionEnum::QUANTIZED,
+        "quantized",
+        "Lossy compression with bounded errors, see run.output.error.* entries. Values are quantized, particles are "
+        "sorted along a space-filling curve and each value is stored as a difference from the previous particle. "
+        "Intended for outputs only used for visualization." },
+});
+
 Optional<String> getIoExtension(const IoEnum type) {
     switch (type) {
     case IoEnum::NONE:
@@ -355,6 +383,8 @@ Optional<String> getIoExtension(const IoEnum type) {
         return String("dat");
     case IoEnum::VDB_FILE:
         return String("vdb");
+    case IoEnum::ARCHIVE_FILE:
+        return String("sar");
     default:
         NOT_IMPLEMENTED;
     }
@@ -377,6 +407,8 @@ Optional<IoEnum> getIoEnum(const String& ext) {
         return IoEnum::MPCORP_FILE;
     } else if (ext == "vdb") {
         return IoEnum::VDB_FILE;
+    } else if (ext == "sar") {
+        return IoEnum::ARCHIVE_FILE;
     } else {
         return NOTHING;
     }
@@ -402,6 +434,8 @@ String getIoDescription(const IoEnum type) {
         return "mpcorp dump";
     case IoEnum::VDB_FILE:
         return "OpenVDB grid";
+    case IoEnum::ARCHIVE_FILE:
+        return "SPH run archive";
     default:
         NOT_IMPLEMENTED;
     }
@@ -427,6 +461,8 @@ Flags<IoCapability> getIoCapabilities(const IoEnum type) {
         return IoCapability::INPUT;
     case IoEnum::VDB_FILE:
         return IoCapability::OUTPUT;
+    case IoEnum::ARCHIVE_FILE:
+        return IoCapability::INPUT | IoCapability::OUTPUT;
     default:
         NOT_IMPLEMENTED;
     }
@@ -449,6 +485,16 @@ static RegisterEnum<UvMapEnum> sUv({
     { UvMapEnum::SPHERICAL, "spherical", "Spherical mapping." },
 });
 
+static RegisterEnum<SchedulerEnum> sScheduler({
+    { SchedulerEnum::DEFAULT, "default", "TBB or OpenMP scheduler if enabled, thread pool otherwise." },
+    { SchedulerEnum::THREAD_POOL, "thread_pool", "Thread pool with a single task queue." },
+    { SchedulerEnum::WORK_STEALING,
+        "work_stealing",
+        "Thread pool with per-thread task queues, idle threads steal tasks of other threads." },
+    { SchedulerEnum::TBB, "tbb", "Intel Threading Building Blocks. Available only if compiled with TBB." },
+    { SchedulerEnum::OPENMP, "openmp", "OpenMP scheduler. Available only if compiled with OpenMP." },
+});
+
 
 // clang-format off
 template<>
@@ -483,11 +529,56 @@ const RunSettings& getDefaultSettings() {
     { RunSettingsId::RUN_OUTPUT_QUANTITIES, "run.output.quantitites", DEFAULT_QUANTITY_IDS,
         "List of quantities to write to output file. Applicable for text and VTK outputs, binary output always stores "
         "all quantitites. Can be one or more values from:\n" + EnumMap::getDesc<OutputQuantityFlag>() },
+    { RunSettingsId::RUN_OUTPUT_COMPRESSION,        "run.output.compression",   CompressionEnum::NONE,
+        "Compression of quantities in data files. Can be one of the following:\n" + EnumMap::getDesc<CompressionEnum>() },
+    { RunSettingsId::RUN_OUTPUT_ERROR_POSITION,     "run.output.error.position", 1.e-4_f,
+        "Maximal error of particle positions in data files with quantized compression. Smoothing lengths are "
+        "stored without quantization. Zero means the positions are not quantized." },
+    { RunSettingsId::RUN_OUTPUT_ERROR_POSITION_RELATIVE, "run.output.error.position_relative", true,
+        "If true, the error of positions is relative to the size of the bounding box of particles, otherwise it "
+        "is an absolute error." },
+    { RunSettingsId::RUN_OUTPUT_ERROR_VELOCITY,     "run.output.error.velocity", 1.e-3_f,
+        "Maximal error of particle velocities in data files with quantized compression. Zero means the velocities "
+        "are not quantized." },
+    { RunSettingsId::RUN_OUTPUT_ERROR_VELOCITY_RELATIVE, "run.output.error.velocity_relative", true,
+        "If true, the error of velocities is relative to the range of velocities, otherwise it is an absolute "
+        "error." },
+    { RunSettingsId::RUN_OUTPUT_ERROR_DENSITY,      "run.output.error.density", 1.e-3_f,
+        "Maximal error of density in data files with quantized compression. Zero means the density is not "
+        "quantized." },
+    { RunSettingsId::RUN_OUTPUT_ERROR_DENSITY_RELATIVE, "run.output.error.density_relative", true,
+        "If true, the error of density is relative to the range of densities, otherwise it is an absolute error." },
+    { RunSettingsId::RUN_OUTPUT_ERROR_ENERGY,       "run.output.error.energy",  1.e-3_f,
+        "Maximal error of specific internal energy in data files with quantized compression. Zero means the "
+        "energy is not quantized." },
+    { RunSettingsId::RUN_OUTPUT_ERROR_ENERGY_RELATIVE, "run.output.error.energy_relative", true,
+        "If true, the error of energy is relative to the range of energies, otherwise it is an absolute error." },
+    { RunSettingsId::RUN_OUTPUT_ERROR_DAMAGE,       "run.output.error.damage",  1.e-3_f,
+        "Maximal error of damage in data files with quantized compression. Zero means the damage is not "
+        "quantized." },
+    { RunSettingsId::RUN_OUTPUT_ERROR_DAMAGE_RELATIVE, "run.output.error.damage_relative", false,
+        "If true, the error of damage is relative to the range of damage, otherwise it is an absolute error." },
+    { RunSettingsId::RUN_OUTPUT_CHECKPOINT_PERIOD,  "run.output.checkpoint_period", 1,
+        "Number of binary dumps between two full dumps. Dumps in between are written as delta checkpoints, only "
+        "storing blocks of data that changed since the previous dump. Delta checkpoints can be loaded as regular "
+        "binary files, provided all previous dumps up to the last full dump are kept. If 1, all dumps are full." },
+    { RunSettingsId::RUN_OUTPUT_ASYNC_ENABLE,       "run.output.async.enable",  false,
+        "If true, output files are written on a background thread while the simulation continues. Particle data "
+        "are copied into a snapshot, so the simulation only waits for the copy." },
+    { RunSettingsId::RUN_OUTPUT_ASYNC_SNAPSHOT_CNT, "run.output.async.snapshot_cnt", 1,
+        "Maximal number of snapshots of particle data held in memory when writing the output asynchronously. When "
+        "all of them are waiting to be written, the simulation waits for the output." },
     { RunSettingsId::RUN_THREAD_CNT,                "run.thread.cnt",           0,
         "Number of threads used by the simulation. 0 means all available threads are used." },
     { RunSettingsId::RUN_THREAD_GRANULARITY,        "run.thread.granularity",   1000,
         "Number of particles processed by one thread in a single batch. Lower number can help to distribute tasks "
         "between threads more evenly, higher number means faster processing of particles within single thread." },
+    { RunSettingsId::RUN_THREAD_SCHEDULER,          "run.thread.scheduler",     SchedulerEnum::DEFAULT,
+        "Scheduler used to parallelize the simulation. Can be one of the following:\n" + EnumMap::getDesc<SchedulerEnum>() },
+    { RunSettingsId::RUN_THREAD_NUMA,               "run.thread.numa",          false,
+        "If true, worker threads are pinned to CPUs and each thread processes the same particles in all parallel "
+        "loops, so that the particle data are stored in the memory of the NUMA node of the thread. Only supported by "
+        "the work-stealing scheduler." },
     { RunSettingsId::RUN_LOGGER,                    "run.logger",               LoggerEnum::STD_OUT,
         "Type of a log generated by the simulation. Can be one of the following:\n" + EnumMap::getDesc<LoggerEnum>() },
     { RunSettingsId::RUN_LOGGER_FILE,               "run.logger.file",          "log.txt"_s,
@@ -514,6 +605,15 @@ const RunSettings& getDefaultSettings() {
         "Seed of the random number generator (if applicable)." },
     { RunSettingsId::RUN_DIAGNOSTICS_INTERVAL,      "run.diagnostics_interval", 0.1_f,
         "Time period (in run time) of running diagnostics of the run. 0 means the diagnostics are run every time step." },
+    { RunSettingsId::RUN_REORDER_ENABLE,            "run.reorder.enable",       false,
+        "If true, particles in the storage are periodically sorted along a space-filling curve, so that particles "
+        "close to each other in space are also close to each other in memory." },
+    { RunSettingsId::RUN_REORDER_PERIOD,            "run.reorder.period",       100,
+        "Number of time steps between two subsequent reorderings of particles. 0 means the particles are only "
+        "reordered when the memory locality degrades." },
+    { RunSettingsId::RUN_REORDER_LOCALITY_THRESHOLD, "run.reorder.locality_threshold", 0.2_f,
+        "Particles are reordered if the fraction of particles that do not interact with their predecessor in "
+        "memory increases by more than this value since the last reordering." },
 
     /// SPH solvers
     { RunSettingsId::SPH_SOLVER_TYPE,               "sph.solver.type",                  SolverEnum::SYMMETRIC_SOLVER,
@@ -532,6 +632,23 @@ const RunSettings& getDefaultSettings() {
         "If true, the SPH solver computes a hash map connecting position in space with required search radius. "
         "Otherwise, the radius is determined from the maximal smoothing length in the simulation. Used only by "
         "the AsymmetricSolver." },
+    { RunSettingsId::SPH_USE_NEIGHBOR_LIST,         "sph.neighbor_list.enable", false,
+        "If true, the SPH solver caches the lists of neighbor candidates and reuses them in subsequent time steps, "
+        "as long as the particles do not move too far. The neighbor finder is then rebuilt only when necessary. "
+        "Used by the SymmetricSolver and AsymmetricSolver." },
+    { RunSettingsId::SPH_NEIGHBOR_LIST_SKIN,        "sph.neighbor_list.skin",   0.2_f,
+        "Relative size of the skin of cached neighbor lists, in units of the kernel support. Larger value allows "
+        "to reuse the lists for more time steps, but increases the number of candidate pairs." },
+    { RunSettingsId::SPH_SYMMETRIC_COLORED_ACCUMULATION, "sph.symmetric.colored_accumulation", false,
+        "If true, the symmetric solver partitions particles into colored cells and processes cells of the same "
+        "color concurrently, accumulating all derivatives into a single shared buffer. This avoids allocating "
+        "buffers for each thread, reducing the memory overhead for large thread counts. Used only by the "
+        "SymmetricSolver." },
+    { RunSettingsId::SPH_FUSED_DERIVATIVES,         "sph.fused_derivatives",    false,
+        "If true, common combinations of derivatives (pressure, stress, velocity divergence and gradient, "
+        "artificial viscosity) are evaluated by a single fused derivative, using only one loop over neighbors. "
+        "Other combinations of derivatives are evaluated separately. The results differ from the separate "
+        "evaluation by round-off errors. Not used by the energy-conserving solver." },
     { RunSettingsId::SPH_USE_XSPH,                  "sph.xsph.enable",          false,
         "Enables the XSPH modification" },
     { RunSettingsId::SPH_XSPH_EPSILON,              "sph.xsph.epsilon",         1._f,
@@ -614,6 +731,10 @@ const RunSettings& getDefaultSettings() {
         "Number of iterations per time step taken by the position based solver." },
     { RunSettingsId::PBD_RELAXATION_PARAMETER, "pbd.relaxation_parameter", 50._f,
         "Relaxation parameter used to stabilize the method." },
+    { RunSettingsId::PBD_GAUSS_SEIDEL, "pbd.gauss_seidel", false,
+        "If true, the position based solver uses Gauss-Seidel iterations, processing particles of the same "
+        "color of the neighbor graph in parallel. Gauss-Seidel iterations converge faster than the default "
+        "Jacobi iterations." },
 
     /// Global parameters of N-body simulations
     { RunSettingsId::NBODY_INERTIA_TENSOR,          "nbody.inertia_tensor",     false,
@@ -678,6 +799,9 @@ const RunSettings& getDefaultSettings() {
         "Repel strength used by the soft-body solver" },
     { RunSettingsId::SOFT_FRICTION_STRENGTH,    "soft.friction_strength",  0.01_f,
         "Friction strength used by the soft-body solver" },
+    { RunSettingsId::SOFT_CONTACT_SKIN,         "soft.contact_skin",      0.2_f,
+        "Relative width of the skin added to particle radii when building the contact list of the soft-body "
+        "solver. Larger values make the evaluation slower, but the list is rebuilt less often." },
 
     /// Timestepping parameters
     { RunSettingsId::TIMESTEPPING_INTEGRATOR,       "timestep.integrator",      TimesteppingEnum::PREDICTOR_CORRECTOR,
@@ -706,6 +830,9 @@ const RunSettings& getDefaultSettings() {
         "Applicable for modified midpoint method. Specified the number of sub-steps within one time step." },
     { RunSettingsId::TIMESTEPPING_BS_ACCURACY,      "timestep.bs.accuracy",     1.e-3_f,
         "Required relative accuracy (epsilon value) of the Bulirsch-Stoer integrator." },
+    { RunSettingsId::TIMESTEPPING_BLOCK_MAX_LEVEL,  "timestep.block.max_level", 8,
+        "Applicable for block timestepping. Maximal level of particle time steps; the smallest time step is "
+        "2^level times smaller than the largest one." },
     { RunSettingsId::SAVE_PARTICLE_TIMESTEPS,       "save_particle_timesteps",  false,
         "If true, time steps determined for each particle are stored in the 'time step' quantity." },
 
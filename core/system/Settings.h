@@ -571,7 +571,10 @@ enum class TimesteppingEnum {
     MODIFIED_MIDPOINT,
 
     /// Bulirsch-Stoer integrator
-    BULIRSCH_STOER
+    BULIRSCH_STOER,
+
+    /// Hierarchical (block) timestepping with individual time steps of particles
+    BLOCK,
 };
 
 enum class TimeStepCriterionEnum {
@@ -799,6 +802,9 @@ enum class GravityEnum {
 
     /// Use Barnes-Hut algorithm, approximating gravity by multipole expansion (up to octupole order)
     BARNES_HUT,
+
+    /// Use fast multipole method, translating multipole expansions of distant nodes into local expansions
+    FAST_MULTIPOLE,
 };
 
 enum class GravityKernelEnum {
@@ -895,6 +901,10 @@ enum class IoEnum {
 
     /// OpenVDB grid
     VDB_FILE = 9,
+
+    /// Single file containing all snapshots of the run, stored in the same format as \ref BINARY_FILE. New
+    /// snapshots are appended to the file and each of them can be loaded without reading the others.
+    ARCHIVE_FILE = 10,
 };
 
 /// \brief Returns the file extension associated with given IO type.
@@ -921,6 +931,23 @@ enum class IoCapability {
 /// \brief Returns the capabilities of given file format.
 Flags<IoCapability> getIoCapabilities(const IoEnum type);
 
+/// \brief Compression of quantities in \ref IoEnum::DATA_FILE.
+enum class CompressionEnum {
+    /// Values are stored without compression
+    NONE,
+
+    /// Repeated values are only stored once with the number of repetitions
+    RLE,
+
+    /// Particles are sorted along a space-filling curve, each value is XOR-ed with the previous one, bytes
+    /// are shuffled and compressed by an LZ77-type coder. Lossless, compressed in parallel.
+    XOR_SHUFFLE,
+
+    /// Values are quantized with given error bounds, particles are sorted along a space-filling curve and each
+    /// quantized value is stored as a difference from the value of the previous particle. Lossy, intended for
+    /// outputs only used for visualization.
+    QUANTIZED,
+};
 
 enum class OutputSpacing {
     /// Constant time between consecutive output times
@@ -952,6 +979,23 @@ enum class UvMapEnum {
     SPHERICAL,
 };
 
+enum class SchedulerEnum {
+    /// Scheduler selected at compile time; TBB or OpenMP if enabled, otherwise \ref ThreadPool
+    DEFAULT,
+
+    /// Thread pool with a single task queue, see \ref ThreadPool
+    THREAD_POOL,
+
+    /// Thread pool with per-thread task queues and work stealing, see \ref WorkStealingPool
+    WORK_STEALING,
+
+    /// Scheduler using Intel Threading Building Blocks, requires compiling with SPH_USE_TBB
+    TBB,
+
+    /// Scheduler using OpenMP, requires compiling with SPH_USE_OPENMP
+    OPENMP,
+};
+
 /// Settings relevant for whole run of the simulation
 enum class RunSettingsId {
     /// User-specified name of the run, used in some output files
@@ -994,6 +1038,51 @@ enum class RunSettingsId {
     /// List of quantities to write to text output. Binary output always stores all quantitites.
     RUN_OUTPUT_QUANTITIES,
 
+    /// Compression of quantities in data files, see \ref CompressionEnum.
+    RUN_OUTPUT_COMPRESSION,
+
+    /// Maximal error of particle positions in data files compressed by \ref CompressionEnum::QUANTIZED. Zero
+    /// means the positions are stored without quantization.
+    RUN_OUTPUT_ERROR_POSITION,
+
+    /// If true, \ref RUN_OUTPUT_ERROR_POSITION is relative to the size of the bounding box of particles.
+    RUN_OUTPUT_ERROR_POSITION_RELATIVE,
+
+    /// Maximal error of particle velocities in quantized data files.
+    RUN_OUTPUT_ERROR_VELOCITY,
+
+    /// If true, \ref RUN_OUTPUT_ERROR_VELOCITY is relative to the range of velocities.
+    RUN_OUTPUT_ERROR_VELOCITY_RELATIVE,
+
+    /// Maximal error of density in quantized data files.
+    RUN_OUTPUT_ERROR_DENSITY,
+
+    /// If true, \ref RUN_OUTPUT_ERROR_DENSITY is relative to the range of densities.
+    RUN_OUTPUT_ERROR_DENSITY_RELATIVE,
+
+    /// Maximal error of specific internal energy in quantized data files.
+    RUN_OUTPUT_ERROR_ENERGY,
+
+    /// If true, \ref RUN_OUTPUT_ERROR_ENERGY is relative to the range of energies.
+    RUN_OUTPUT_ERROR_ENERGY_RELATIVE,
+
+    /// Maximal error of damage in quantized data files.
+    RUN_OUTPUT_ERROR_DAMAGE,
+
+    /// If true, \ref RUN_OUTPUT_ERROR_DAMAGE is relative to the range of damage.
+    RUN_OUTPUT_ERROR_DAMAGE_RELATIVE,
+
+    /// Number of binary dumps between two full dumps. Dumps in between are written as delta checkpoints,
+    /// storing only the data changed since the previous dump. If 1, all dumps are full.
+    RUN_OUTPUT_CHECKPOINT_PERIOD,
+
+    /// If true, output files are written on a background thread while the simulation continues.
+    RUN_OUTPUT_ASYNC_ENABLE,
+
+    /// Maximal number of snapshots of particle data held in memory when writing the output asynchronously.
+    /// When all of them are waiting to be written, the simulation waits for the output.
+    RUN_OUTPUT_ASYNC_SNAPSHOT_CNT,
+
     /// Number of threads used by the code. If 0, all available threads are used.
     RUN_THREAD_CNT,
 
@@ -1002,6 +1091,14 @@ enum class RunSettingsId {
     /// thread.
     RUN_THREAD_GRANULARITY,
 
+    /// Scheduler used to parallelize the run, see \ref SchedulerEnum. Not used if \ref RUN_THREAD_CNT is 1.
+    RUN_THREAD_SCHEDULER,
+
+    /// If true, worker threads are pinned to CPUs and each thread processes the same particles in all
+    /// parallel loops, keeping the particle data in the memory of its NUMA node. Requires the work-stealing
+    /// scheduler.
+    RUN_THREAD_NUMA,
+
     /// Selected logger of a run, see LoggerEnum
     RUN_LOGGER,
 
@@ -1044,6 +1141,18 @@ enum class RunSettingsId {
     /// time step.
     RUN_DIAGNOSTICS_INTERVAL,
 
+    /// If true, particles in the storage are periodically sorted along a space-filling curve, improving the
+    /// memory locality of particle neighbors.
+    RUN_REORDER_ENABLE,
+
+    /// Number of time steps between two subsequent reorderings of particles. 0 means the particles are
+    /// only reordered when the memory locality degrades, see RUN_REORDER_LOCALITY_THRESHOLD.
+    RUN_REORDER_PERIOD,
+
+    /// Particles are reordered if the fraction of particles that do not interact with their predecessor in
+    /// memory increases by more than this value since the last reordering.
+    RUN_REORDER_LOCALITY_THRESHOLD,
+
     /// Selected solver for computing derivatives of physical variables.
     SPH_SOLVER_TYPE,
 
@@ -1066,6 +1175,24 @@ enum class RunSettingsId {
     /// the AsymmetricSolver.
     SPH_ASYMMETRIC_COMPUTE_RADII_HASH_MAP,
 
+    /// If true, the SPH solver caches the lists of neighbor candidates and reuses them in subsequent time
+    /// steps, as long as the particles do not move too far. Used by the SymmetricSolver and AsymmetricSolver.
+    SPH_USE_NEIGHBOR_LIST,
+
+    /// Relative size of the skin of cached neighbor lists, in units of the kernel support. Larger value
+    /// allows to reuse the lists for more time steps, but increases the number of candidate pairs.
+    SPH_NEIGHBOR_LIST_SKIN,
+
+    /// If true, the symmetric solver partitions particles into colored cells and processes cells of the same
+    /// color concurrently, accumulating all derivatives into a single shared buffer. This reduces the memory
+    /// overhead of thread-local buffers. Used only by the SymmetricSolver.
+    SPH_SYMMETRIC_COLORED_ACCUMULATION,
+
+    /// If true, common combinations of derivatives (pressure, stress, velocity divergence and gradient,
+    /// artificial viscosity) are evaluated by a single fused derivative, using only one loop over neighbors.
+    /// Other combinations of derivatives are evaluated separately.
+    SPH_FUSED_DERIVATIVES,
+
     /// Index of SPH Kernel, see KernelEnum
     SPH_KERNEL,
 
@@ -1186,6 +1313,10 @@ enum class RunSettingsId {
     /// Relaxation parameter used to stabilize the method.
     PBD_RELAXATION_PARAMETER,
 
+    /// If true, the position based solver uses Gauss-Seidel iterations, processing particles of the same
+    /// color of the neighbor graph in parallel. Otherwise, Jacobi iterations are used.
+    PBD_GAUSS_SEIDEL,
+
     /// If true, all particles have also a moment of inertia, representing a non-homogeneous mass
     /// distribution. Otherwise, particles are spherical with inertia tensor I = 2/5 mr^2
     NBODY_INERTIA_TENSOR,
@@ -1260,6 +1391,10 @@ enum class RunSettingsId {
     /// Magnitude of the friction force for the soft-body solver
     SOFT_FRICTION_STRENGTH,
 
+    /// Relative width of the skin added to particle radii when building the contact list of the soft-body
+    /// solver. The list is rebuilt once a particle moves by more than the skin width.
+    SOFT_CONTACT_SKIN,
+
     /// Selected timestepping integrator
     TIMESTEPPING_INTEGRATOR,
 
@@ -1302,6 +1437,10 @@ enum class RunSettingsId {
     /// Required relative accuracy of the Bulirsch-Stoer integrator.
     TIMESTEPPING_BS_ACCURACY,
 
+    /// Maximal level of the block timestepping. The smallest time step of particles is 2^level times smaller
+    /// than the largest one.
+    TIMESTEPPING_BLOCK_MAX_LEVEL,
+
     /// Stores per-particle time steps
     SAVE_PARTICLE_TIMESTEPS,
 
@@ -128,12 +128,24 @@ enum class StatisticsId {
     /// Wallclock time spend on computing last timestep
     TIMESTEP_ELAPSED,
 
+    /// Number of substeps made in the last timestep by the block timestepping
+    TIMESTEP_SUBSTEP_COUNT,
+
     /// Total number of particles in the run
     PARTICLE_COUNT,
 
+    /// Number of reorderings of particles along a space-filling curve since the start of the run
+    REORDER_COUNT,
+
     /// Number of neighbors (min, max, mean)
     NEIGHBOR_COUNT,
 
+    /// Number of builds of cached neighbor lists since the start of the run
+    NEIGHBOR_LIST_BUILDS,
+
+    /// Number of time steps the cached neighbor lists were reused without rebuilding
+    NEIGHBOR_LIST_REUSES,
+
     /// Wallclock duration of evaluation of SPH derivatives
     SPH_EVAL_TIME,
 
@@ -0,0 +1,112 @@
+#include "thread/Numa.h"
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+NAMESPACE_SPH_BEGIN
+
+/// Parses list of ranges used by sysfs, for example "0-3,8,10-11".
+static Array<Size> parseCpuList(const std::string& list) {
+    Array<Size> values;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        const std::size_t dash = range.find('-');
+        try {
+            if (dash == std::string::npos) {
+                values.push(std::stoul(range));
+            } else {
+                const Size from = std::stoul(range.substr(0, dash));
+                const Size to = std::stoul(range.substr(dash + 1));
+                for (Size i = from; i <= to; ++i) {
+                    values.push(i);
+                }
+            }
+        } catch (const std::exception&) {
+            return Array<Size>();
+        }
+    }
+    return values;
+}
+
+static Array<Size> readCpuList(const std::string& path) {
+    std::ifstream ifs(path);
+    std::string line;
+    if (!ifs || !std::getline(ifs, line)) {
+        return Array<Size>();
+    }
+    return parseCpuList(line);
+}
+
+NumaTopology::NumaTopology() {
+#ifdef __linux__
+    const Array<Size> nodes = readCpuList("/sys/devices/system/node/online");
+    for (Size node : nodes) {
+        Array<Size> cpus = readCpuList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!cpus.empty()) {
+            // skip nodes with memory only
+            nodeCpus.push(std::move(cpus));
+        }
+    }
+#endif
+    if (nodeCpus.empty()) {
+        // topology not available, assume single node
+        const Size cpuCnt = std::max(std::thread::hardware_concurrency(), 1u);
+        nodeCpus.push(Array<Size>(cpuCnt));
+        for (Size i = 0; i < cpuCnt; ++i) {
+            nodeCpus[0][i] = i;
+        }
+    }
+
+    for (Size node = 0; node < nodeCpus.size(); ++node) {
+        for (Size cpu : nodeCpus[node]) {
+            if (cpu >= cpuNodes.size()) {
+                cpuNodes.resizeAndSet(cpu + 1, 0);
+            }
+            cpuNodes[cpu] = node;
+        }
+    }
+}
+
+Size NumaTopology::getNode(const Size cpu) const {
+    // CPUs not listed in sysfs (offline, etc.) are assigned to the first node
+    return cpu < cpuNodes.size() ? cpuNodes[cpu] : 0;
+}
+
+Array<Size> NumaTopology::getOrderedCpus() const {
+    Array<Size> cpus;
+    for (const Array<Size>& node : nodeCpus) {
+        cpus.pushAll(node);
+    }
+    return cpus;
+}
+
+const NumaTopology& NumaTopology::getInstance() {
+    static NumaTopology instance;
+    return instance;
+}
+
+bool pinCurrentThread(const Size cpu) {
+#ifdef __linux__
+    if (cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+#else
+    MARK_USED(cpu);
+    return false;
+#endif
+}
+
+NAMESPACE_SPH_END
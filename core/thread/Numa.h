@@ -0,0 +1,54 @@
+#pragma once
+
+/// \file Numa.h
+/// \brief Topology of NUMA nodes and pinning of threads
+/// \author Pavel Sevecek (sevecek at sirrah.troja.mff.cuni.cz)
+/// \date 2016-2021
+
+#include "objects/containers/Array.h"
+
+NAMESPACE_SPH_BEGIN
+
+/// \brief Assignment of CPUs to NUMA nodes of the machine.
+///
+/// On Linux, the topology is read from sysfs. If the information is not available (or on other platforms),
+/// all CPUs are assumed to belong to a single node.
+class NumaTopology {
+private:
+    /// CPUs belonging to each node
+    Array<Array<Size>> nodeCpus;
+
+    /// Node of each CPU, indexed by the CPU number
+    Array<Size> cpuNodes;
+
+public:
+    NumaTopology();
+
+    /// \brief Returns the number of NUMA nodes with at least one CPU.
+    Size getNodeCnt() const {
+        return nodeCpus.size();
+    }
+
+    /// \brief Returns the node of given CPU.
+    Size getNode(const Size cpu) const;
+
+    /// \brief Returns all CPUs of given node.
+    ArrayView<const Size> getCpus(const Size node) const {
+        return nodeCpus[node];
+    }
+
+    /// \brief Returns all CPUs, sorted by their nodes.
+    ///
+    /// Assigning threads to CPUs in this order puts threads with adjacent indices on the same node.
+    Array<Size> getOrderedCpus() const;
+
+    /// \brief Returns the topology of this machine.
+    static const NumaTopology& getInstance();
+};
+
+/// \brief Restricts the calling thread to given CPU.
+///
+/// \return True if the thread has been pinned, false if pinning is not supported or if it failed.
+bool pinCurrentThread(const Size cpu);
+
+NAMESPACE_SPH_END
@@ -9,6 +9,7 @@
 #include "objects/containers/Array.h"
 #include "objects/utility/IteratorAdapters.h"
 #include "objects/wrappers/Function.h"
+#include <algorithm>
 
 NAMESPACE_SPH_BEGIN
 
@@ -63,6 +64,14 @@ public:
 
     /// \brief Executes two functors concurrently.
     virtual void parallelInvoke(const Functor& task1, const Functor& task2) = 0;
+
+    /// \brief Returns true if the ranges of \ref parallelFor are assigned to threads deterministically.
+    ///
+    /// In such a case, the same indices are processed by the same threads in subsequent loops, so it is
+    /// beneficial to first touch the allocated memory in parallel, rather than from a single thread.
+    virtual bool hasStaticAssignment() const {
+        return false;
+    }
 };
 
 /// \brief Dummy scheduler that simply executes the submitted tasks sequentially on calling thread.
@@ -156,4 +165,39 @@ void parallelInvoke(IScheduler& scheduler, TFunctor1&& func1, TFunctor2&& func2)
     scheduler.parallelInvoke(std::forward<TFunctor1>(func1), std::forward<TFunctor2>(func2));
 }
 
+/// \brief Sorts the elements in range [first, last) concurrently.
+///
+/// The range is split into chunks, one for each thread, which are sorted independently and then merged
+/// pairwise, merging disjoint pairs of chunks in parallel. Like std::sort, the function does not preserve the
+/// order of equal elements.
+/// \param scheduler Scheduler used for parallelization.
+/// \param first Random-access iterator to the first sorted element.
+/// \param last Random-access iterator to one-past-last sorted element.
+/// \param comparator Binary predicate with signature bool operator()(const T&, const T&), returning true if
+///                   the first element goes before the second one.
+template <typename TIterator, typename TComparator>
+void parallelSort(IScheduler& scheduler, TIterator first, TIterator last, const TComparator& comparator) {
+    const Size size = Size(last - first);
+    const Size threadCnt = max(scheduler.getThreadCnt(), Size(1));
+    const Size chunkSize = max((size + threadCnt - 1) / threadCnt, scheduler.getRecommendedGranularity());
+    if (size <= chunkSize) {
+        std::sort(first, last, comparator);
+        return;
+    }
+
+    const Size chunkCnt = (size + chunkSize - 1) / chunkSize;
+    parallelFor(scheduler, 0, chunkCnt, 1, [first, size, chunkSize, &comparator](const Size k) {
+        std::sort(first + k * chunkSize, first + min((k + 1) * chunkSize, size), comparator);
+    });
+    for (Size width = chunkSize; width < size; width *= 2) {
+        const Size mergeCnt = (size + 2 * width - 1) / (2 * width);
+        parallelFor(scheduler, 0, mergeCnt, 1, [first, size, width, &comparator](const Size k) {
+            const Size from = 2 * k * width;
+            const Size mid = min(from + width, size);
+            const Size to = min(from + 2 * width, size);
+            std::inplace_merge(first + from, first + mid, first + to, comparator);
+        });
+    }
+}
+
 NAMESPACE_SPH_END
@@ -0,0 +1,538 @@
+#include "thread/WorkStealing.h"
+#include "objects/wrappers/Finally.h"
+#include "system/Profiler.h"
+#include "thread/Numa.h"
+
+NAMESPACE_SPH_BEGIN
+
+SharedPtr<WorkStealingPool> WorkStealingPool::globalInstance;
+
+/// \brief Set of jobs, allowing to wait until all of them are finished.
+class WorkStealingPool::JobGroup {
+public:
+    /// Number of unfinished jobs of the group.
+    std::atomic<int> pending{ 0 };
+
+protected:
+    std::exception_ptr caughtException = nullptr;
+    std::mutex exceptionMutex;
+
+public:
+    virtual ~JobGroup() = default;
+
+    /// \brief Saves exception thrown by one of the jobs, replacing the previous one.
+    virtual void setException(std::exception_ptr exception) {
+        std::unique_lock<std::mutex> lock(exceptionMutex);
+        caughtException = exception;
+    }
+
+    /// \brief Called when one of the jobs of the group is finished.
+    virtual void finish(WorkStealingPool& pool) {
+        if (pending.fetch_sub(1) == 1) {
+            pool.notifyDone();
+        }
+    }
+
+    void rethrow() {
+        if (caughtException) {
+            std::rethrow_exception(caughtException);
+        }
+    }
+};
+
+/// \brief Task submitted into the pool.
+///
+/// Tasks submitted while another task is executed become the child tasks, the parent task is finished once
+/// all its children are finished.
+class WorkStealingTask : public ITask, public WorkStealingPool::JobGroup, public Shareable<WorkStealingTask> {
+private:
+    WorkStealingPool& pool;
+
+    SharedPtr<WorkStealingTask> parent;
+
+public:
+    WorkStealingTask(WorkStealingPool& pool, const SharedPtr<WorkStealingTask>& parent)
+        : pool(pool)
+        , parent(parent) {
+        // the task itself
+        pending = 1;
+        if (parent) {
+            SPH_ASSERT(!parent->completed()); // cannot add children to already finished task
+            ++parent->pending;
+        }
+    }
+
+    ~WorkStealingTask() {
+        SPH_ASSERT(this->completed());
+    }
+
+    virtual void wait() override {
+        pool.wait(*this);
+        this->rethrow();
+    }
+
+    virtual bool completed() const override {
+        return pending == 0;
+    }
+
+    virtual void setException(std::exception_ptr exception) override {
+        // the exception propagates to the top-most task
+        if (parent) {
+            parent->setException(exception);
+        } else {
+            JobGroup::setException(exception);
+        }
+    }
+
+    virtual void finish(WorkStealingPool& pool) override {
+        if (pending.fetch_sub(1) == 1) {
+            if (parent) {
+                parent->finish(pool);
+            }
+            pool.notifyDone();
+        }
+    }
+};
+
+/// \brief Unit of work executed by a worker.
+struct WorkStealingPool::Job {
+    /// Task submitted using \ref submit, nullptr for jobs of \ref parallelFor and \ref parallelInvoke.
+    SharedPtr<WorkStealingTask> task;
+
+    /// Callable of a submitted task.
+    Function<void()> callable;
+
+    /// Functor of \ref parallelInvoke.
+    const Functor* functor = nullptr;
+
+    /// Functor and range of \ref parallelFor.
+    const RangeFunctor* rangeFunctor = nullptr;
+    Size from = 0;
+    Size to = 0;
+    Size granularity = 0;
+
+    /// Group notified when the job is finished.
+    JobGroup* group = nullptr;
+
+    /// Task executed by the thread that created the job, parent of tasks submitted by the job.
+    WorkStealingTask* context = nullptr;
+
+    /// NUMA node the job has been assigned to, or Size(-1) if the job was not assigned to any node.
+    Size node = Size(-1);
+};
+
+struct WorkStealingPool::Worker {
+    /// Jobs pushed by this worker
+    WorkStealingDeque<Job*> deque;
+
+    /// Jobs assigned to this worker by other threads
+    std::queue<Job*> mailbox;
+    std::mutex mailboxMutex;
+    std::atomic<Size> mailboxCnt{ 0 };
+
+    /// State of the generator used to select the victims of stealing
+    uint32_t seed;
+
+    /// CPU and NUMA node of the worker, only used in NUMA-aware mode
+    Size cpu = 0;
+    Size node = 0;
+
+    AutoPtr<std::thread> thread;
+};
+
+namespace {
+
+struct WorkerContext {
+    /// Owner of this thread
+    WorkStealingPool* parentPool = nullptr;
+
+    /// Index of this thread in the parent pool
+    Size index = Size(-1);
+
+    /// Task currently processed by this thread
+    WorkStealingTask* current = nullptr;
+};
+
+thread_local WorkerContext workerContext;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(const Size numThreads, const Size granularity, const bool numa)
+    : granularity(granularity)
+    , numa(numa) {
+    const Size threadCnt = numThreads == 0 ? std::thread::hardware_concurrency() : numThreads;
+    SPH_ASSERT(threadCnt > 0);
+    const NumaTopology& topology = NumaTopology::getInstance();
+    const Array<Size> cpus = topology.getOrderedCpus();
+    workers.resize(threadCnt);
+    for (Size i = 0; i < threadCnt; ++i) {
+        workers[i] = makeAuto<Worker>();
+        workers[i]->seed = 2654435761u * (i + 1);
+        if (numa) {
+            // if there are more workers than CPUs, assign the extra workers cyclically
+            workers[i]->cpu = cpus[i % cpus.size()];
+            workers[i]->node = topology.getNode(workers[i]->cpu);
+        }
+    }
+
+    // start the threads after all workers are created, as they access deques of each other
+    for (Size i = 0; i < threadCnt; ++i) {
+        workers[i]->thread = makeAuto<std::thread>([this, i] { this->run(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    this->waitForAll();
+    stop = true;
+    {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepVar.notify_all();
+    }
+    for (auto& worker : workers) {
+        if (worker->thread->joinable()) {
+            worker->thread->join();
+        }
+    }
+}
+
+SharedPtr<ITask> WorkStealingPool::submit(const Function<void()>& task) {
+    WorkStealingTask* current = workerContext.parentPool == this ? workerContext.current : nullptr;
+    SharedPtr<WorkStealingTask> handle =
+        makeShared<WorkStealingTask>(*this, current ? current->sharedFromThis() : nullptr);
+    ++tasksLeft;
+
+    Job* job = new Job();
+    job->task = handle;
+    job->callable = task;
+    job->group = &*handle;
+    job->context = &*handle;
+    this->push(job);
+    return handle;
+}
+
+Optional<Size> WorkStealingPool::getThreadIdx() const {
+    if (workerContext.parentPool != this) {
+        // thread either belongs to different pool or isn't a worker thread
+        return NOTHING;
+    }
+    return workerContext.index;
+}
+
+Size WorkStealingPool::getThreadCnt() const {
+    return workers.size();
+}
+
+Size WorkStealingPool::getRecommendedGranularity() const {
+    return granularity;
+}
+
+void WorkStealingPool::parallelFor(const Size from,
+    const Size to,
+    const Size granularity,
+    const RangeFunctor& functor) {
+    SPH_ASSERT(to >= from);
+    SPH_ASSERT(granularity > 0);
+    if (from == to) {
+        return;
+    }
+
+    JobGroup group;
+    const bool isWorker = workerContext.parentPool == this;
+    if (numa && !isWorker) {
+        this->distribute(from, to, granularity, functor, group);
+    } else {
+        group.pending = 1;
+        Job* job = new Job();
+        job->rangeFunctor = &functor;
+        job->from = from;
+        job->to = to;
+        job->granularity = granularity;
+        job->group = &group;
+        if (isWorker) {
+            // process the range directly, the split parts are pushed into the deque of this worker
+            job->context = workerContext.current;
+            this->execute(job);
+        } else {
+            this->push(job);
+        }
+    }
+    this->wait(group);
+    group.rethrow();
+}
+
+void WorkStealingPool::parallelInvoke(const Functor& task1, const Functor& task2) {
+    JobGroup group;
+    group.pending = 1;
+    Job* job = new Job();
+    job->functor = &task1;
+    job->group = &group;
+    job->context = workerContext.parentPool == this ? workerContext.current : nullptr;
+    this->push(job);
+
+    // execute the second functor directly; the first one is either stolen by another worker, or processed
+    // by this thread once the second functor is finished
+    std::exception_ptr caughtException = nullptr;
+    try {
+        task2();
+    } catch (...) {
+        caughtException = std::current_exception();
+    }
+    this->wait(group);
+    if (caughtException) {
+        std::rethrow_exception(caughtException);
+    }
+    group.rethrow();
+}
+
+void WorkStealingPool::waitForAll() {
+    std::unique_lock<std::mutex> lock(doneMutex);
+    ++waitingCnt;
+    doneVar.wait(lock, [this] { return tasksLeft == 0; });
+    --waitingCnt;
+}
+
+SharedPtr<WorkStealingPool> WorkStealingPool::getGlobalInstance() {
+    if (!globalInstance) {
+        globalInstance = makeShared<WorkStealingPool>();
+    }
+    return globalInstance;
+}
+
+void WorkStealingPool::run(const Size index) {
+    // setup the thread
+    workerContext.parentPool = this;
+    workerContext.index = index;
+    if (numa) {
+        // failure is not critical, the worker is just not pinned
+        pinCurrentThread(workers[index]->cpu);
+    }
+
+    Size idleCnt = 0;
+    while (!stop) {
+        if (Job* job = this->findJob(index)) {
+            this->execute(job);
+            idleCnt = 0;
+            continue;
+        }
+        if (++idleCnt < 64) {
+            // spin for a while before going to sleep, new jobs are often pushed shortly
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        ++sleepingCnt;
+        // jobs pushed concurrently might not wake this thread up, so we wake up periodically
+        sleepVar.wait_for(lock, std::chrono::milliseconds(1), [this, index] {
+            if (stop || injectedCnt > 0 || workers[index]->mailboxCnt > 0) {
+                return true;
+            }
+            for (auto& worker : workers) {
+                if (!worker->deque.empty()) {
+                    return true;
+                }
+            }
+            return false;
+        });
+        --sleepingCnt;
+        idleCnt = 0;
+    }
+}
+
+void WorkStealingPool::push(Job* job) {
+    if (workerContext.parentPool == this) {
+        workers[workerContext.index]->deque.push(job);
+    } else {
+        std::unique_lock<std::mutex> lock(injectedMutex);
+        injected.push(job);
+        ++injectedCnt;
+    }
+    if (sleepingCnt > 0) {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepVar.notify_one();
+    }
+}
+
+WorkStealingPool::Job* WorkStealingPool::findJob(const Size index) {
+    // first process the jobs of this worker, most recent first
+    Worker& self = *workers[index];
+    if (Job* job = self.deque.pop()) {
+        return job;
+    }
+
+    // then the jobs assigned to this worker by other threads
+    if (self.mailboxCnt > 0) {
+        std::unique_lock<std::mutex> lock(self.mailboxMutex);
+        if (!self.mailbox.empty()) {
+            Job* job = self.mailbox.front();
+            self.mailbox.pop();
+            --self.mailboxCnt;
+            return job;
+        }
+    }
+
+    if (Job* job = this->steal(index)) {
+        return job;
+    }
+
+    // finally check the jobs submitted from other threads
+    if (injectedCnt > 0) {
+        std::unique_lock<std::mutex> lock(injectedMutex);
+        if (!injected.empty()) {
+            Job* job = injected.front();
+            injected.pop();
+            --injectedCnt;
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+WorkStealingPool::Job* WorkStealingPool::steal(const Size index) {
+    // steal from other workers, starting at a random victim
+    Worker& self = *workers[index];
+    const Size workerCnt = workers.size();
+    self.seed ^= self.seed << 13;
+    self.seed ^= self.seed >> 17;
+    self.seed ^= self.seed << 5;
+    const Size offset = self.seed % workerCnt;
+
+    // in NUMA-aware mode, try to steal from the workers on the same node first
+    const Size passCnt = numa ? 2 : 1;
+    for (Size pass = 0; pass < passCnt; ++pass) {
+        for (Size k = 0; k < workerCnt; ++k) {
+            const Size victim = (offset + k) % workerCnt;
+            if (victim == index || (numa && (workers[victim]->node == self.node) != (pass == 0))) {
+                continue;
+            }
+            if (Job* job = workers[victim]->deque.steal()) {
+                return job;
+            }
+            if (workers[victim]->mailboxCnt > 0) {
+                // steal also the jobs assigned to the victim that it has not started yet
+                std::unique_lock<std::mutex> lock(workers[victim]->mailboxMutex);
+                if (!workers[victim]->mailbox.empty()) {
+                    Job* job = workers[victim]->mailbox.front();
+                    workers[victim]->mailbox.pop();
+                    --workers[victim]->mailboxCnt;
+                    return job;
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
+void WorkStealingPool::distribute(const Size from,
+    const Size to,
+    const Size granularity,
+    const RangeFunctor& functor,
+    JobGroup& group) {
+    // blocks are aligned to the granularity, so that they are split into the same chunks as in the default mode
+    const Size workerCnt = workers.size();
+    const Size chunkCnt = (to - from + granularity - 1) / granularity;
+    const Size blockCnt = min(workerCnt, chunkCnt);
+    group.pending = blockCnt;
+    for (Size k = 0; k < blockCnt; ++k) {
+        Job* job = new Job();
+        job->rangeFunctor = &functor;
+        job->from = from + (k * chunkCnt / blockCnt) * granularity;
+        job->to = min(from + ((k + 1) * chunkCnt / blockCnt) * granularity, to);
+        job->granularity = granularity;
+        job->group = &group;
+        job->node = workers[k]->node;
+
+        Worker& worker = *workers[k];
+        std::unique_lock<std::mutex> lock(worker.mailboxMutex);
+        worker.mailbox.push(job);
+        ++worker.mailboxCnt;
+    }
+    // jobs are assigned to specific workers, so we have to wake up all of them
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    sleepVar.notify_all();
+}
+
+void WorkStealingPool::execute(Job* job) {
+    // this may be called from within another job, so we override the current task for this scope only
+    WorkStealingTask* callingTask = workerContext.current;
+    workerContext.current = job->context;
+    auto guard = finally([callingTask] { workerContext.current = callingTask; });
+
+#ifdef SPH_PROFILE
+    Timer timer;
+#endif
+
+    try {
+        if (job->rangeFunctor) {
+            // split the range recursively, so that the largest parts are stolen first
+            Size n1 = job->from;
+            Size n2 = job->to;
+            while (n2 - n1 > job->granularity) {
+                const Size chunkCnt = (n2 - n1 + job->granularity - 1) / job->granularity;
+                const Size mid = n1 + (chunkCnt / 2) * job->granularity;
+                Job* split = new Job();
+                split->rangeFunctor = job->rangeFunctor;
+                split->from = mid;
+                split->to = n2;
+                split->granularity = job->granularity;
+                split->group = job->group;
+                split->context = job->context;
+                split->node = job->node;
+                ++job->group->pending;
+                this->push(split);
+                n2 = mid;
+            }
+            (*job->rangeFunctor)(n1, n2);
+        } else if (job->functor) {
+            (*job->functor)();
+        } else {
+            job->callable();
+        }
+    } catch (...) {
+        job->group->setException(std::current_exception());
+    }
+
+#ifdef SPH_PROFILE
+    if (numa) {
+        const Size node = workers[workerContext.index]->node;
+        const bool remote = job->node != Size(-1) && job->node != node;
+        Profiler::getInstance().recordNumaWork(node, timer.elapsed(TimerUnit::MICROSECOND), remote);
+    }
+#endif
+
+    const bool isTask = bool(job->task);
+    job->group->finish(*this);
+    delete job;
+
+    if (isTask && --tasksLeft == 0) {
+        this->notifyDone();
+    }
+}
+
+void WorkStealingPool::wait(JobGroup& group) {
+    if (workerContext.parentPool == this) {
+        // worker thread, we can work on other jobs in the meantime
+        const Size index = workerContext.index;
+        while (group.pending > 0) {
+            if (Job* job = this->findJob(index)) {
+                this->execute(job);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    } else {
+        std::unique_lock<std::mutex> lock(doneMutex);
+        ++waitingCnt;
+        doneVar.wait(lock, [&group] { return group.pending == 0; });
+        --waitingCnt;
+    }
+}
+
+void WorkStealingPool::notifyDone() {
+    if (waitingCnt > 0) {
+        std::unique_lock<std::mutex> lock(doneMutex);
+        doneVar.notify_all();
+    }
+}
+
+NAMESPACE_SPH_END
@@ -0,0 +1,289 @@
+#pragma once
+
+/// \file WorkStealing.h
+/// \brief Thread pool with per-thread task queues and work stealing
+/// \author Pavel Sevecek (sevecek at sirrah.troja.mff.cuni.cz)
+/// \date 2016-2021
+
+#include "math/MathUtils.h"
+#include "objects/containers/Array.h"
+#include "objects/wrappers/AutoPtr.h"
+#include "objects/wrappers/Optional.h"
+#include "thread/Scheduler.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+NAMESPACE_SPH_BEGIN
+
+/// \brief Lock-free double-ended queue for work stealing.
+///
+/// Implementation of the dynamic circular deque of Chase & Lev (2005), using the memory orderings of Le et
+/// al. (2013). Elements are pushed and popped by a single owning thread at the bottom of the deque, any other
+/// thread can concurrently steal elements from the top. The owner thus processes the most recently pushed
+/// elements, while thieves take the oldest ones, which are typically also the largest.
+///
+/// When full, the deque allocates a buffer with twice the capacity. Previous buffers are kept until the deque
+/// is destroyed, as they might be still accessed by thieves.
+/// \tparam T Stored type, must be trivially copyable. Default-constructed value is returned when the deque is
+///           empty or the stealing fails, so it should not be stored in the deque.
+template <typename T>
+class WorkStealingDeque : public Noncopyable {
+    static_assert(std::is_trivially_copyable<T>::value, "Elements of the deque must be trivially copyable");
+
+private:
+    class Buffer : public Noncopyable {
+    private:
+        std::atomic<T>* data;
+        int64_t mask;
+
+    public:
+        explicit Buffer(const Size capacity)
+            : data(new std::atomic<T>[capacity])
+            , mask(capacity - 1) {
+            SPH_ASSERT(isPower2(capacity));
+        }
+
+        ~Buffer() {
+            delete[] data;
+        }
+
+        INLINE int64_t capacity() const {
+            return mask + 1;
+        }
+
+        INLINE T load(const int64_t i) const {
+            return data[i & mask].load(std::memory_order_relaxed);
+        }
+
+        INLINE void store(const int64_t i, const T value) {
+            data[i & mask].store(value, std::memory_order_relaxed);
+        }
+    };
+
+    alignas(64) std::atomic<int64_t> top{ 0 };
+    alignas(64) std::atomic<int64_t> bottom{ 0 };
+    std::atomic<Buffer*> buffer;
+
+    /// All allocated buffers, only accessed by the owner.
+    Array<AutoPtr<Buffer>> buffers;
+
+public:
+    explicit WorkStealingDeque(const Size initialCapacity = 256) {
+        buffers.push(makeAuto<Buffer>(initialCapacity));
+        buffer.store(&*buffers.back(), std::memory_order_relaxed);
+    }
+
+    /// \brief Adds an element to the bottom of the deque.
+    ///
+    /// May be only called by the owner.
+    void push(const T value) {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        Buffer* actBuffer = buffer.load(std::memory_order_relaxed);
+        if (b - t > actBuffer->capacity() - 1) {
+            actBuffer = this->grow(actBuffer, t, b);
+        }
+        actBuffer->store(b, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /// \brief Removes an element from the bottom of the deque.
+    ///
+    /// May be only called by the owner. Returns the default-constructed value if the deque is empty.
+    T pop() {
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Buffer* actBuffer = buffer.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            // empty deque
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return T();
+        }
+        T value = actBuffer->load(b);
+        if (t == b) {
+            // last element, we might race with a thief
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                value = T();
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    /// \brief Removes an element from the top of the deque.
+    ///
+    /// Can be called by any thread. Returns the default-constructed value if the deque is empty or if
+    /// another thread removed the element first.
+    T steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return T();
+        }
+        Buffer* actBuffer = buffer.load(std::memory_order_acquire);
+        const T value = actBuffer->load(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return T();
+        }
+        return value;
+    }
+
+    /// \brief Checks whether the deque is empty.
+    ///
+    /// The result is only approximate if the deque is concurrently modified.
+    bool empty() const {
+        return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+    }
+
+private:
+    Buffer* grow(Buffer* oldBuffer, const int64_t t, const int64_t b) {
+        AutoPtr<Buffer> newBuffer = makeAuto<Buffer>(2 * oldBuffer->capacity());
+        for (int64_t i = t; i < b; ++i) {
+            newBuffer->store(i, oldBuffer->load(i));
+        }
+        Buffer* result = &*newBuffer;
+        buffers.push(std::move(newBuffer));
+        buffer.store(result, std::memory_order_release);
+        return result;
+    }
+};
+
+/// \brief Thread pool with per-thread task queues and work stealing.
+///
+/// Contrary to \ref ThreadPool, tasks are not stored in a single shared queue. Each worker owns a lock-free
+/// deque, tasks submitted from a worker thread are pushed into the deque of the worker without any locking.
+/// Idle workers steal tasks from the deques of other workers. Only tasks submitted from threads not owned by
+/// the pool go through a shared queue protected by a mutex.
+///
+/// Function \ref parallelFor splits the range recursively, pushing one half into the deque and continuing
+/// with the other half, so that large chunks of work are stolen first. Function \ref parallelInvoke executes
+/// the second functor directly by the calling thread. Worker threads waiting for a task to finish process
+/// other tasks in the meantime.
+///
+/// The pool can optionally run in NUMA-aware mode. Workers are then pinned to CPUs, so that workers with
+/// adjacent indices run on the same NUMA node, and idle workers steal from workers of the same node first.
+/// Function \ref parallelFor called from a thread not belonging to the pool splits the range into contiguous
+/// blocks, one for each worker. Unless stolen, a given part of the range is thus always processed by the same
+/// worker, which keeps the processed memory on the node of the worker (given the first-touch placement of
+/// memory pages used by the operating system).
+class WorkStealingPool : public IScheduler {
+    friend class WorkStealingTask;
+
+private:
+    struct Job;
+    class JobGroup;
+    struct Worker;
+
+    /// Workers owned by this pool
+    Array<AutoPtr<Worker>> workers;
+
+    /// Selected granularity of the parallel processing.
+    Size granularity;
+
+    /// Whether the workers are pinned and ranges are statically assigned to workers.
+    bool numa;
+
+    /// Tasks submitted from threads not belonging to the pool.
+    std::queue<Job*> injected;
+    std::mutex injectedMutex;
+    std::atomic<Size> injectedCnt{ 0 };
+
+    /// Used to put idle workers to sleep.
+    std::condition_variable sleepVar;
+    std::mutex sleepMutex;
+    std::atomic<Size> sleepingCnt{ 0 };
+
+    /// Used by threads not belonging to the pool to wait for tasks.
+    std::condition_variable doneVar;
+    std::mutex doneMutex;
+    std::atomic<Size> waitingCnt{ 0 };
+
+    /// Number of submitted tasks that have not finished yet.
+    std::atomic<Size> tasksLeft{ 0 };
+
+    /// Set to true if the workers should stop
+    std::atomic<bool> stop{ false };
+
+    /// Global instance of the pool.
+    static SharedPtr<WorkStealingPool> globalInstance;
+
+public:
+    /// \brief Initialize the pool given the number of threads to use.
+    ///
+    /// \param numThreads Number of worker threads; if zero, all available threads are used.
+    /// \param granularity Default granularity of the parallel processing.
+    /// \param numa If true, the pool is NUMA-aware, see \ref WorkStealingPool.
+    WorkStealingPool(const Size numThreads = 0, const Size granularity = 1000, const bool numa = false);
+
+    ~WorkStealingPool();
+
+    virtual SharedPtr<ITask> submit(const Function<void()>& task) override;
+
+    virtual Optional<Size> getThreadIdx() const override;
+
+    virtual Size getThreadCnt() const override;
+
+    virtual Size getRecommendedGranularity() const override;
+
+    virtual void parallelFor(const Size from,
+        const Size to,
+        const Size granularity,
+        const RangeFunctor& functor) override;
+
+    virtual void parallelInvoke(const Functor& task1, const Functor& task2) override;
+
+    /// \brief Ranges are statically assigned to workers in NUMA-aware mode.
+    virtual bool hasStaticAssignment() const override {
+        return numa;
+    }
+
+    /// \brief Blocks until all submitted tasks has been finished.
+    void waitForAll();
+
+    /// \brief Modifies the default granularity of the pool.
+    void setGranularity(const Size newGranularity) {
+        granularity = newGranularity;
+    }
+
+    /// \brief Returns the global instance of the pool.
+    ///
+    /// Other instances can be constructed if needed.
+    static SharedPtr<WorkStealingPool> getGlobalInstance();
+
+private:
+    /// Main loop of the worker threads.
+    void run(const Size index);
+
+    /// Adds the job into the deque of the calling worker or into the shared queue.
+    void push(Job* job);
+
+    /// Splits the range into contiguous blocks and sends one block to each worker.
+    void distribute(const Size from,
+        const Size to,
+        const Size granularity,
+        const RangeFunctor& functor,
+        JobGroup& group);
+
+    /// Returns a job stolen from other workers, or nullptr if no job has been stolen.
+    Job* steal(const Size index);
+
+    /// Returns a job to process, or nullptr if no job is available.
+    Job* findJob(const Size index);
+
+    void execute(Job* job);
+
+    /// Processes other jobs (if called by a worker) or sleeps until the group is finished.
+    void wait(JobGroup& group);
+
+    /// Notifies threads not belonging to the pool that a group has been finished.
+    void notifyDone();
+};
+
+NAMESPACE_SPH_END
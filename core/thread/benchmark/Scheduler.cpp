@@ -0,0 +1,104 @@
+#include "bench/Session.h"
+#include "thread/OpenMp.h"
+#include "thread/Pool.h"
+#include "thread/Tbb.h"
+#include "thread/WorkStealing.h"
+
+using namespace Sph;
+
+/// Many small tasks, measuring the overhead of the scheduling itself.
+static void benchmarkFineParallelFor(IScheduler& scheduler, Benchmark::Context& context) {
+    const Size N = 1000000;
+    Array<Float> values(N);
+    values.fill(1._f);
+    while (context.running()) {
+        parallelFor(scheduler, 0, N, 100, [&values](const Size i) { values[i] = sqrt(values[i] + 1._f); });
+        Benchmark::clobberMemory();
+    }
+}
+
+/// Tasks with very different durations, requiring load balancing between threads.
+static void benchmarkUnbalancedParallelFor(IScheduler& scheduler, Benchmark::Context& context) {
+    const Size N = 10000;
+    Array<Float> values(N);
+    values.fill(0._f);
+    while (context.running()) {
+        parallelFor(scheduler, 0, N, 10, [&values](const Size i) {
+            Float sum = 0._f;
+            for (Size j = 0; j < (i % 100) * (i % 100); ++j) {
+                sum += sqrt(Float(j));
+            }
+            values[i] = sum;
+        });
+        Benchmark::clobberMemory();
+    }
+}
+
+static Size fibonacci(IScheduler& scheduler, const Size n) {
+    if (n < 16) {
+        return n < 2 ? n : fibonacci(scheduler, n - 1) + fibonacci(scheduler, n - 2);
+    }
+    Size f1, f2;
+    parallelInvoke(
+        scheduler, [&] { f1 = fibonacci(scheduler, n - 1); }, [&] { f2 = fibonacci(scheduler, n - 2); });
+    return f1 + f2;
+}
+
+/// Recursive parallelism, similar to the construction of K-d tree.
+static void benchmarkNestedParallelInvoke(IScheduler& scheduler, Benchmark::Context& context) {
+    while (context.running()) {
+        Benchmark::doNotOptimize(fibonacci(scheduler, 28));
+    }
+}
+
+BENCHMARK("ThreadPool fine parallelFor", "[scheduler]", Benchmark::Context& context) {
+    benchmarkFineParallelFor(*ThreadPool::getGlobalInstance(), context);
+}
+
+BENCHMARK("WorkStealingPool fine parallelFor", "[scheduler]", Benchmark::Context& context) {
+    benchmarkFineParallelFor(*WorkStealingPool::getGlobalInstance(), context);
+}
+
+BENCHMARK("ThreadPool unbalanced parallelFor", "[scheduler]", Benchmark::Context& context) {
+    benchmarkUnbalancedParallelFor(*ThreadPool::getGlobalInstance(), context);
+}
+
+BENCHMARK("WorkStealingPool unbalanced parallelFor", "[scheduler]", Benchmark::Context& context) {
+    benchmarkUnbalancedParallelFor(*WorkStealingPool::getGlobalInstance(), context);
+}
+
+BENCHMARK("ThreadPool nested parallelInvoke", "[scheduler]", Benchmark::Context& context) {
+    benchmarkNestedParallelInvoke(*ThreadPool::getGlobalInstance(), context);
+}
+
+BENCHMARK("WorkStealingPool nested parallelInvoke", "[scheduler]", Benchmark::Context& context) {
+    benchmarkNestedParallelInvoke(*WorkStealingPool::getGlobalInstance(), context);
+}
+
+#ifdef SPH_USE_TBB
+BENCHMARK("Tbb fine parallelFor", "[scheduler]", Benchmark::Context& context) {
+    benchmarkFineParallelFor(*Tbb::getGlobalInstance(), context);
+}
+
+BENCHMARK("Tbb unbalanced parallelFor", "[scheduler]", Benchmark::Context& context) {
+    benchmarkUnbalancedParallelFor(*Tbb::getGlobalInstance(), context);
+}
+
+BENCHMARK("Tbb nested parallelInvoke", "[scheduler]", Benchmark::Context& context) {
+    benchmarkNestedParallelInvoke(*Tbb::getGlobalInstance(), context);
+}
+#endif
+
+#ifdef SPH_USE_OPENMP
+BENCHMARK("OmpScheduler fine parallelFor", "[scheduler]", Benchmark::Context& context) {
+    benchmarkFineParallelFor(*OmpScheduler::getGlobalInstance(), context);
+}
+
+BENCHMARK("OmpScheduler unbalanced parallelFor", "[scheduler]", Benchmark::Context& context) {
+    benchmarkUnbalancedParallelFor(*OmpScheduler::getGlobalInstance(), context);
+}
+
+BENCHMARK("OmpScheduler nested parallelInvoke", "[scheduler]", Benchmark::Context& context) {
+    benchmarkNestedParallelInvoke(*OmpScheduler::getGlobalInstance(), context);
+}
+#endif
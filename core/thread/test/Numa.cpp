@@ -0,0 +1,63 @@
+#include "thread/Numa.h"
+#include "catch.hpp"
+#include "objects/utility/Algorithm.h"
+#include "thread/WorkStealing.h"
+#include "utils/Utils.h"
+
+using namespace Sph;
+
+TEST_CASE("NumaTopology", "[thread]") {
+    const NumaTopology& topology = NumaTopology::getInstance();
+    REQUIRE(topology.getNodeCnt() >= 1);
+
+    Size cpuCnt = 0;
+    for (Size node = 0; node < topology.getNodeCnt(); ++node) {
+        ArrayView<const Size> cpus = topology.getCpus(node);
+        REQUIRE_FALSE(cpus.empty());
+        for (Size cpu : cpus) {
+            REQUIRE(topology.getNode(cpu) == node);
+        }
+        cpuCnt += cpus.size();
+    }
+
+    const Array<Size> ordered = topology.getOrderedCpus();
+    REQUIRE(ordered.size() == cpuCnt);
+    for (Size i = 1; i < ordered.size(); ++i) {
+        REQUIRE(topology.getNode(ordered[i - 1]) <= topology.getNode(ordered[i]));
+    }
+}
+
+#ifdef __linux__
+TEST_CASE("Pin thread", "[thread]") {
+    const Size cpu = NumaTopology::getInstance().getCpus(0)[0];
+    bool pinned = false;
+    std::thread thread([cpu, &pinned] { pinned = pinCurrentThread(cpu); });
+    thread.join();
+    REQUIRE(pinned);
+}
+#endif
+
+TEST_CASE("WorkStealingPool NUMA parallelFor", "[thread]") {
+    WorkStealingPool pool(4, 100, true);
+    REQUIRE(pool.hasStaticAssignment());
+
+    const Size N = 10000;
+    Array<std::atomic<Size>> counts(N);
+    for (Size i = 0; i < N; ++i) {
+        counts[i] = 0;
+    }
+    parallelFor(pool, 0, N, 7, [&counts](const Size i) { ++counts[i]; });
+    REQUIRE(allMatching(counts, [](const Size c) { return c == 1; }));
+
+    // range smaller than the number of workers
+    std::atomic<Size> sum{ 0 };
+    parallelFor(pool, 5, 8, 1, [&sum](const Size i) { sum += i; });
+    REQUIRE(sum == 18);
+
+    // nested loops are processed by the calling worker first
+    sum = 0;
+    parallelFor(pool, 0, 100, 1, [&pool, &sum](const Size i) {
+        parallelFor(pool, 0, 100, 1, [&sum, i](const Size j) { sum += i * j; });
+    });
+    REQUIRE_THREAD_SAFE(sum == 24502500);
+}
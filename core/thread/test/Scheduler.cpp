@@ -3,14 +3,16 @@
 #include "thread/Pool.h"
 #include "thread/Tbb.h"
 #include "thread/ThreadLocal.h"
+#include "thread/WorkStealing.h"
+#include "utils/SequenceTest.h"
 #include "utils/Utils.h"
 
 using namespace Sph;
 
 #if defined(SPH_USE_OPENMP)
-#define SCHEDULERS ThreadPool, Tbb, OmpScheduler
+#define SCHEDULERS ThreadPool, WorkStealingPool, Tbb, OmpScheduler
 #else
-#define SCHEDULERS ThreadPool, Tbb
+#define SCHEDULERS ThreadPool, WorkStealingPool, Tbb
 #endif
 
 
@@ -171,6 +173,26 @@ TEMPLATE_TEST_CASE("Nested parallelInvoke", "[thread]", SCHEDULERS) {
 }
 
 
+TEMPLATE_TEST_CASE("ParallelSort", "[thread]", SCHEDULERS) {
+    // use more threads than available cores, so that the chunks are merged even on single-core machines
+    TestType scheduler(4);
+    // size is a prime, so the values are a permutation of [0, size)
+    const Size size = 100003;
+    Array<Size> values(size);
+    for (Size i = 0; i < size; ++i) {
+        values[i] = Size((uint64_t(i) * 7919) % size);
+    }
+    parallelSort(scheduler, values.begin(), values.end(), [](const Size i, const Size j) { return i < j; });
+
+    auto test = [&](const Size i) -> Outcome {
+        if (values[i] != i) {
+            return makeFailed("Invalid order: {} == {}", values[i], i);
+        }
+        return SUCCESS;
+    };
+    REQUIRE_SEQUENCE(test, 0, size);
+}
+
 TEST_CASE("ThreadLocal value initialization", "[thread]") {
     ThreadPool scheduler;
     ThreadLocal<Size> tl(scheduler, 5);
@@ -0,0 +1,174 @@
+#include "thread/WorkStealing.h"
+#include "catch.hpp"
+#include "objects/utility/Algorithm.h"
+#include "utils/Utils.h"
+
+using namespace Sph;
+
+TEST_CASE("WorkStealingDeque push pop", "[thread]") {
+    WorkStealingDeque<Size*> deque(4);
+    REQUIRE(deque.empty());
+    REQUIRE(deque.pop() == nullptr);
+    REQUIRE(deque.steal() == nullptr);
+
+    Array<Size> values(100);
+    for (Size i = 0; i < values.size(); ++i) {
+        values[i] = i;
+        // exceeds the initial capacity, checks that the deque grows
+        deque.push(&values[i]);
+    }
+    REQUIRE_FALSE(deque.empty());
+
+    // owner pops the most recent elements, thieves steal the oldest ones
+    REQUIRE(*deque.pop() == 99);
+    REQUIRE(*deque.steal() == 0);
+    REQUIRE(*deque.steal() == 1);
+    REQUIRE(*deque.pop() == 98);
+    for (Size i = 2; i < 98; ++i) {
+        REQUIRE(*deque.steal() == i);
+    }
+    REQUIRE(deque.empty());
+    REQUIRE(deque.pop() == nullptr);
+    REQUIRE(deque.steal() == nullptr);
+}
+
+TEST_CASE("WorkStealingDeque concurrent steal", "[thread]") {
+    const Size N = 100000;
+    Array<Size> values(N);
+    Array<std::atomic<Size>> counts(N);
+    for (Size i = 0; i < N; ++i) {
+        values[i] = i;
+        counts[i] = 0;
+    }
+
+    WorkStealingDeque<Size*> deque(16);
+    std::atomic_bool done{ false };
+    auto thief = [&] {
+        while (!done || !deque.empty()) {
+            if (Size* value = deque.steal()) {
+                ++counts[*value];
+            }
+        }
+    };
+    std::thread thief1(thief);
+    std::thread thief2(thief);
+
+    // owner concurrently pushes and pops
+    for (Size i = 0; i < N; ++i) {
+        deque.push(&values[i]);
+        if (i % 3 == 0) {
+            if (Size* value = deque.pop()) {
+                ++counts[*value];
+            }
+        }
+    }
+    while (Size* value = deque.pop()) {
+        ++counts[*value];
+    }
+    done = true;
+    thief1.join();
+    thief2.join();
+
+    // each element must be processed exactly once
+    REQUIRE(allMatching(counts, [](const Size c) { return c == 1; }));
+}
+
+TEST_CASE("WorkStealingPool submit task", "[thread]") {
+    WorkStealingPool pool;
+    REQUIRE_THREAD_SAFE(pool.getThreadCnt() == std::thread::hardware_concurrency());
+    std::atomic<uint64_t> sum{ 0 };
+    for (Size i = 0; i <= 100; ++i) {
+        pool.submit([&sum, i] { sum += i; });
+    }
+    pool.waitForAll();
+    REQUIRE_THREAD_SAFE(sum == 5050);
+}
+
+TEST_CASE("WorkStealingPool submit nested", "[thread]") {
+    WorkStealingPool pool(2);
+    std::atomic_bool innerRun{ false };
+    auto rootTask = pool.submit([&pool, &innerRun] {
+        REQUIRE_THREAD_SAFE(pool.getThreadIdx());
+        pool.submit([&innerRun] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            innerRun = true;
+        });
+    });
+    // root task is finished only after its child
+    rootTask->wait();
+    REQUIRE_THREAD_SAFE(innerRun);
+    REQUIRE_THREAD_SAFE(rootTask->completed());
+}
+
+TEST_CASE("WorkStealingPool wait for child", "[thread]") {
+    WorkStealingPool pool(1);
+    SharedPtr<ITask> taskChild;
+    std::atomic_bool childFinished{ false };
+    // single worker has to process the child task while waiting for it
+    auto taskRoot = pool.submit([&pool, &taskChild, &childFinished] {
+        taskChild = pool.submit([&childFinished] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            childFinished = true;
+        });
+        taskChild->wait();
+    });
+    taskRoot->wait();
+
+    REQUIRE_THREAD_SAFE(taskRoot->completed());
+    REQUIRE_THREAD_SAFE(taskChild->completed());
+    REQUIRE_THREAD_SAFE(childFinished);
+}
+
+namespace {
+class WorkStealingException : public std::exception {
+    virtual const char* what() const noexcept override {
+        return "exception";
+    }
+};
+} // namespace
+
+TEST_CASE("WorkStealingPool task throw", "[thread]") {
+    WorkStealingPool pool;
+    auto task = pool.submit([&pool] {
+        pool.submit([] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            throw WorkStealingException();
+        });
+    });
+    REQUIRE_THROWS_AS(task->wait(), WorkStealingException);
+}
+
+TEST_CASE("WorkStealingPool parallelFor throw", "[thread]") {
+    WorkStealingPool pool;
+    std::atomic<Size> executeCnt{ 0 };
+    auto functor = [&executeCnt](Size i) {
+        ++executeCnt;
+        // last index of a chunk, so that only the throwing call is interrupted
+        if (i == 509) {
+            throw WorkStealingException();
+        }
+    };
+    REQUIRE_THROWS_AS(parallelFor(pool, 0, 1000, 10, functor), WorkStealingException);
+    // other chunks are still processed
+    REQUIRE_THREAD_SAFE(executeCnt == 1000);
+
+    REQUIRE_THROWS_AS(
+        parallelInvoke(
+            pool, [] {}, [] { throw WorkStealingException(); }),
+        WorkStealingException);
+}
+
+TEST_CASE("WorkStealingPool parallelFor granularity", "[thread]") {
+    WorkStealingPool pool(4);
+    std::mutex mutex;
+    Array<Size> sizes;
+    pool.parallelFor(0, 1003, 100, [&](Size n1, Size n2) {
+        std::unique_lock<std::mutex> lock(mutex);
+        sizes.push(n2 - n1);
+    });
+    std::sort(sizes.begin(), sizes.end());
+    // ranges are split into chunks of the given granularity, except for the last one
+    REQUIRE(sizes.size() == 11);
+    REQUIRE(sizes[0] == 3);
+    REQUIRE(std::all_of(sizes.begin() + 1, sizes.end(), [](Size s) { return s == 100; }));
+}
@@ -53,6 +53,17 @@ public:
     ///           algorithm (for example LeapFrog uses drift step dt/2).
     virtual void collide(Storage& UNUSED(storage), Statistics& UNUSED(stats), const Float UNUSED(dt)) {}
 
+    /// \brief Restricts the evaluation of derivatives to a subset of particles.
+    ///
+    /// Used by timestepping algorithms with individual time steps of particles, see \ref BlockTimeStepping.
+    /// Derivatives of particles outside of the subset are not used after the following call of \ref
+    /// integrate, so the solver does not have to evaluate them. Solvers that cannot evaluate derivatives of
+    /// a subset of particles may ignore the function and compute the derivatives of all particles.
+    ///
+    /// \param active Indices of particles with required derivatives. Null view means all particles. The
+    ///               referenced array must be kept alive until the next call of the function.
+    virtual void setActiveParticles(ArrayView<const Size> UNUSED(active)) {}
+
     /// \brief Initializes all quantities needed by the solver in the storage.
     ///
     /// When called, storage already contains particle positions and their masses. All remaining quantities
@@ -2,6 +2,7 @@
 #include "quantities/Attractor.h"
 #include "quantities/IMaterial.h"
 #include "quantities/Iterate.h"
+#include "quantities/Utility.h"
 #include "system/Factory.h"
 #include "system/Profiler.h"
 #include "system/Statistics.h"
@@ -51,29 +52,38 @@ void ITimeStepping::step(IScheduler& scheduler, ISolver& solver, Statistics& sta
     }
 
     // update time step
-    CriterionId criterionId = CriterionId::INITIAL_VALUE;
-    if (criterion) {
-        Array<TimeStep> dts;
-        if (saveParticleTimeSteps) {
-            dts.resizeAndSet(storage->getParticleCnt(), TimeStep{ LARGE, CriterionId::MAXIMAL_VALUE });
-        }
-        const TimeStep result = criterion->compute(scheduler, *storage, maxTimeStep, stats, dts);
-        timeStep = result.value;
-        criterionId = result.id;
-        if (saveParticleTimeSteps) {
-            ArrayView<Float> values = storage->getValue<Float>(QuantityId::TIME_STEP);
-            ArrayView<Size> critIds = storage->getValue<Size>(QuantityId::TIME_STEP_CRITERION);
-            parallelFor(scheduler, 0, dts.size(), [&values, &critIds, &dts](const Size i) {
-                values[i] = dts[i].value;
-                critIds[i] = Size(dts[i].id);
-            });
-        }
-    }
+    const TimeStep result = this->computeTimeStep(scheduler, stats);
+    timeStep = result.value;
     stats.set(StatisticsId::TIMESTEP_VALUE, timeStep);
-    stats.set(StatisticsId::TIMESTEP_CRITERION, criterionId);
+    stats.set(StatisticsId::TIMESTEP_CRITERION, result.id);
     stats.set(StatisticsId::TIMESTEP_ELAPSED, int(timer.elapsed(TimerUnit::MILLISECOND)));
 }
 
+/// Saves the time steps of individual particles into the storage
+static void saveTimeSteps(IScheduler& scheduler, Storage& storage, ArrayView<const TimeStep> dts) {
+    ArrayView<Float> values = storage.getValue<Float>(QuantityId::TIME_STEP);
+    ArrayView<Size> critIds = storage.getValue<Size>(QuantityId::TIME_STEP_CRITERION);
+    parallelFor(scheduler, 0, dts.size(), [&values, &critIds, &dts](const Size i) {
+        values[i] = dts[i].value;
+        critIds[i] = Size(dts[i].id);
+    });
+}
+
+TimeStep ITimeStepping::computeTimeStep(IScheduler& scheduler, Statistics& stats) {
+    if (!criterion) {
+        return TimeStep{ timeStep, CriterionId::INITIAL_VALUE };
+    }
+    Array<TimeStep> dts;
+    if (saveParticleTimeSteps) {
+        dts.resizeAndSet(storage->getParticleCnt(), TimeStep{ LARGE, CriterionId::MAXIMAL_VALUE });
+    }
+    const TimeStep result = criterion->compute(scheduler, *storage, maxTimeStep, stats, dts);
+    if (saveParticleTimeSteps) {
+        saveTimeSteps(scheduler, *storage, dts);
+    }
+    return result;
+}
+
 //-----------------------------------------------------------------------------------------------------------
 // Helper functions for stepping
 //-----------------------------------------------------------------------------------------------------------
@@ -634,4 +644,165 @@ void BulirschStoer::stepParticles(IScheduler& UNUSED(scheduler), ISolver& solver
     (void)stats;
 }
 
+//-----------------------------------------------------------------------------------------------------------
+// BlockTimeStepping implementation
+//-----------------------------------------------------------------------------------------------------------
+
+BlockTimeStepping::BlockTimeStepping(const SharedPtr<Storage>& storage, const RunSettings& settings)
+    : ITimeStepping(storage, settings) {
+    SPH_ASSERT(storage->getQuantityCnt() > 0); // quantities must already been emplaced
+    maxLevel = settings.get<int>(RunSettingsId::TIMESTEPPING_BLOCK_MAX_LEVEL);
+
+    // we need to keep the derivatives of particles during their time step
+    derivatives = makeShared<Storage>(storage->clone(VisitorEnum::HIGHEST_DERIVATIVES));
+    storage->addDependent(derivatives);
+}
+
+BlockTimeStepping::~BlockTimeStepping() = default;
+
+void BlockTimeStepping::computeLevels(IScheduler& scheduler, Statistics& stats) {
+    const Size particleCnt = storage->getParticleCnt();
+    levels.resize(particleCnt);
+    levelCnt = 0;
+    if (!criterion) {
+        // no criterion, all particles are advanced by the same time step
+        levels.fill(0);
+        criterionId = CriterionId::INITIAL_VALUE;
+        return;
+    }
+
+    Array<TimeStep> dts;
+    dts.resizeAndSet(particleCnt, TimeStep{ LARGE, CriterionId::MAXIMAL_VALUE });
+    const TimeStep result = criterion->compute(scheduler, *storage, maxTimeStep, stats, dts);
+    criterionId = result.id;
+    if (saveParticleTimeSteps) {
+        saveTimeSteps(scheduler, *storage, dts);
+    }
+
+    // the time step of the iteration is given by the largest time step of particles, but it has to be small
+    // enough to resolve the smallest time steps by the finest level
+    Float largestStep = 0._f;
+    for (const TimeStep& dt : dts) {
+        largestStep = max(largestStep, dt.value);
+    }
+    timeStep = min(maxTimeStep, largestStep, result.value * Float(1 << maxLevel));
+
+    for (Size i = 0; i < particleCnt; ++i) {
+        Size level = 0;
+        while (level < maxLevel && timeStep / Float(1 << level) > dts[i].value) {
+            ++level;
+        }
+        levels[i] = level;
+        levelCnt = max(levelCnt, level);
+    }
+}
+
+void BlockTimeStepping::integrateActive(IScheduler& scheduler, ISolver& solver, Statistics& stats) {
+    const Size particleCnt = storage->getParticleCnt();
+    const bool partial = active.size() < particleCnt;
+    AutoPtr<ParticleBackup> inactive;
+    if (partial) {
+        // the solver initializes and finalizes equations, materials and boundary conditions of all particles
+        // (smoothing lengths, damage, velocities, ...); save the inactive particles to keep them unchanged
+        Array<Size> inactiveIdxs;
+        for (Size i = 0, k = 0; i < particleCnt; ++i) {
+            if (k < active.size() && active[k] == i) {
+                ++k;
+            } else {
+                inactiveIdxs.push(i);
+            }
+        }
+        inactive = makeAuto<ParticleBackup>(*storage, std::move(inactiveIdxs));
+        solver.setActiveParticles(active);
+    }
+
+    storage->zeroHighestDerivatives(scheduler);
+    solver.integrate(*storage, stats);
+
+    if (partial) {
+        solver.setActiveParticles(nullptr);
+    }
+
+    if (storage->getParticleCnt() != particleCnt) {
+        // particles have been added or removed, so the indices are no longer valid; evaluate derivatives of
+        // all particles (unless all of them have been already evaluated) and advance them by the finest time
+        // step until the end of the iteration
+        if (partial) {
+            storage->zeroHighestDerivatives(scheduler);
+            solver.integrate(*storage, stats);
+        }
+        active.resize(storage->getParticleCnt());
+        for (Size i = 0; i < active.size(); ++i) {
+            active[i] = i;
+        }
+        levels.resize(active.size());
+        levels.fill(levelCnt);
+    } else if (partial) {
+        inactive->restore(*storage);
+    }
+
+    // save the derivatives of active particles, used until the end of their time step
+    iteratePair<VisitorEnum::HIGHEST_DERIVATIVES>(*storage, *derivatives, [this, &scheduler](auto& d, auto& s) {
+        parallelFor(scheduler, 0, active.size(), [this, &d, &s](const Size k) {
+            const Size i = active[k];
+            s[i] = d[i];
+        });
+    });
+}
+
+void BlockTimeStepping::stepParticles(IScheduler& scheduler, ISolver& solver, Statistics& stats) {
+    VERBOSE_LOG
+
+    // evaluate all particles at the beginning of the iteration and bin them into levels
+    active.resize(storage->getParticleCnt());
+    for (Size i = 0; i < active.size(); ++i) {
+        active[i] = i;
+    }
+    this->integrateActive(scheduler, solver, stats);
+    this->computeLevels(scheduler, stats);
+
+    const Size substepCnt = 1 << levelCnt;
+    const Float dt = timeStep / substepCnt;
+    for (Size substep = 0; substep < substepCnt; ++substep) {
+        if (substep > 0) {
+            // evaluate particles at the beginning of their time step
+            active.clear();
+            for (Size i = 0; i < levels.size(); ++i) {
+                if (substep % (1 << (levelCnt - levels[i])) == 0) {
+                    active.push(i);
+                }
+            }
+            this->integrateActive(scheduler, solver, stats);
+        }
+
+        PROFILE_SCOPE("BlockTimeStepping::step")
+        // advance velocities, using saved derivatives for all particles
+        stepSecondOrder(*storage,
+            *derivatives,
+            scheduler,
+            [dt](auto& UNUSED(r), auto& v, const auto& UNUSED(dv), const auto& cdv) INL {
+                using Type = typename std::decay_t<decltype(v)>;
+                v += Type(cdv * dt);
+            });
+        solver.collide(*storage, stats, dt);
+        // drift all particles
+        stepSecondOrder(*storage, scheduler, [dt](auto& r, auto& v, const auto& UNUSED(dv)) INL {
+            using Type = typename std::decay_t<decltype(v)>;
+            r += Type(v * dt);
+        });
+        stepFirstOrder(*storage, *derivatives, scheduler, [dt](auto& x, auto& UNUSED(dx), const auto& cdx) INL {
+            using Type = typename std::decay_t<decltype(x)>;
+            x += Type(cdx * dt);
+        });
+    }
+    stats.set(StatisticsId::TIMESTEP_SUBSTEP_COUNT, int(substepCnt));
+
+    SPH_ASSERT(storage->isValid());
+}
+
+TimeStep BlockTimeStepping::computeTimeStep(IScheduler& UNUSED(scheduler), Statistics& UNUSED(stats)) {
+    // time step has been already determined at the beginning of the iteration
+    return TimeStep{ timeStep, criterionId };
+}
+
 NAMESPACE_SPH_END
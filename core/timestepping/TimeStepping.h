@@ -9,6 +9,7 @@
 #include "objects/containers/Array.h"
 #include "objects/geometry/Vector.h"
 #include "objects/wrappers/SharedPtr.h"
+#include "timestepping/TimeStepCriterion.h"
 
 NAMESPACE_SPH_BEGIN
 
@@ -84,6 +85,12 @@ public:
 
 protected:
     virtual void stepParticles(IScheduler& scheduler, ISolver& solver, Statistics& stats) = 0;
+
+    /// \brief Computes the time step used in the next iteration.
+    ///
+    /// Called by \ref step after the particles are advanced. By default, the time step is computed using the
+    /// criterion, optionally also saving the time steps of individual particles into the storage.
+    virtual TimeStep computeTimeStep(IScheduler& scheduler, Statistics& stats);
 };
 
 
@@ -168,4 +175,61 @@ protected:
     virtual void stepParticles(IScheduler& scheduler, ISolver& solver, Statistics& stats) override;
 };
 
+/// \brief Hierarchical timestepping with individual time steps of particles.
+///
+/// Particles are binned into levels according to their time steps determined by the criterion; particles on
+/// level \f$l\f$ are advanced with time step \f$\Delta t / 2^l\f$, where \f$\Delta t\f$ is the time step of
+/// the whole iteration. The iteration is divided into substeps with the time step of the finest level. In
+/// each substep, derivatives are only required for active particles, i.e. particles at the beginning of
+/// their time step; solvers can use this to skip the evaluation of other particles, see \ref
+/// ISolver::setActiveParticles. All particles are drifted in each substep, inactive particles use the
+/// derivatives computed at the beginning of their time step, so that active particles interact with
+/// predicted values of their neighbors.
+///
+/// Quantities of inactive particles are restored after derivatives of active particles are evaluated, so
+/// that they are not modified by equations, materials or boundary conditions of the solver.
+///
+/// Derivatives of all particles are evaluated at the beginning of the iteration, where the levels are
+/// determined. Time steps of particles can therefore only change at the boundaries of the iteration.
+/// Individual steps are integrated using the first-order kick-drift scheme, i.e. velocities are advanced
+/// first and particles are then drifted with the new velocities.
+class BlockTimeStepping : public ITimeStepping {
+private:
+    /// Derivatives evaluated at the beginning of the time step of each particle. Holds only highest-order
+    /// derivatives, other buffers are empty.
+    SharedPtr<Storage> derivatives;
+
+    /// Maximal allowed level of particles.
+    Size maxLevel;
+
+    /// Time step levels of particles.
+    Array<Size> levels;
+
+    /// Number of levels used in the current iteration, i.e. the maximal level of particles.
+    Size levelCnt = 0;
+
+    /// Indices of particles active in the current substep.
+    Array<Size> active;
+
+    /// Criterion that determined the time step of the last iteration.
+    CriterionId criterionId = CriterionId::INITIAL_VALUE;
+
+public:
+    BlockTimeStepping(const SharedPtr<Storage>& storage, const RunSettings& settings);
+
+    ~BlockTimeStepping() override;
+
+protected:
+    virtual void stepParticles(IScheduler& scheduler, ISolver& solver, Statistics& stats) override;
+
+    virtual TimeStep computeTimeStep(IScheduler& scheduler, Statistics& stats) override;
+
+private:
+    /// Determines the time step of the iteration and the levels of particles.
+    void computeLevels(IScheduler& scheduler, Statistics& stats);
+
+    /// Evaluates derivatives of active particles and saves them.
+    void integrateActive(IScheduler& scheduler, ISolver& solver, Statistics& stats);
+};
+
 NAMESPACE_SPH_END
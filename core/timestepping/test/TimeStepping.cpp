@@ -303,6 +303,81 @@ TEST_CASE("ModifiedMidpoint", "[timestepping]") {
     }
 }
 
+TEST_CASE("BlockTimeStepping", "[timestepping]") {
+    RunSettings settings;
+    testAll<BlockTimeStepping>(settings);
+}
+
+TEST_CASE("BlockTimeStepping levels", "[timestepping]") {
+    // particles in a homogeneous field with different accelerations, so that they are assigned different
+    // time step levels by the acceleration criterion
+    struct LevelSolver : public ISolver {
+        Size evalCnt = 0;
+        Size partialCnt = 0;
+
+        virtual void integrate(Storage& storage, Statistics&) override {
+            ArrayView<Vector> r, v, dv;
+            tie(r, v, dv) = storage.getAll<Vector>(QuantityId::POSITION);
+            // modifies all particles, like the finalization of materials
+            ArrayView<Float> D = storage.getValue<Float>(QuantityId::DAMAGE);
+            for (Size i = 0; i < r.size(); ++i) {
+                dv[i] = Vector(0._f, 0._f, pow(4._f, Float(i)));
+                D[i] += 1._f;
+            }
+            ++evalCnt;
+        }
+
+        virtual void setActiveParticles(ArrayView<const Size> active) override {
+            if (active) {
+                ++partialCnt;
+            }
+        }
+
+        virtual void create(Storage&, IMaterial&) const override {
+            NOT_IMPLEMENTED;
+        }
+    };
+
+    SharedPtr<Storage> storage = makeShared<Storage>(getMaterial(MaterialEnum::BASALT));
+    Array<Vector> points;
+    for (Size i = 0; i < 3; ++i) {
+        points.push(Vector(Float(i), 0._f, 0._f, 1._f));
+    }
+    storage->insert<Vector>(QuantityId::POSITION, OrderEnum::SECOND, std::move(points));
+    storage->insert<Float>(QuantityId::DAMAGE, OrderEnum::FIRST, 0._f);
+
+    RunSettings settings;
+    settings.set(RunSettingsId::TIMESTEPPING_INITIAL_TIMESTEP, 1._f);
+    settings.set(RunSettingsId::TIMESTEPPING_MAX_TIMESTEP, 1._f);
+    settings.set(RunSettingsId::TIMESTEPPING_CRITERION, TimeStepCriterionEnum::ACCELERATION);
+    settings.set(RunSettingsId::TIMESTEPPING_DERIVATIVE_FACTOR, 1._f);
+    settings.set(RunSettingsId::TIMESTEPPING_MAX_INCREASE, INFTY);
+    BlockTimeStepping timestepping(storage, settings);
+    LevelSolver solver;
+    Statistics stats;
+    ThreadPool& pool = *ThreadPool::getGlobalInstance();
+
+    timestepping.step(pool, solver, stats);
+    // time steps of particles are 1, 1/2 and 1/4, requiring 4 substeps
+    REQUIRE(stats.get<int>(StatisticsId::TIMESTEP_SUBSTEP_COUNT) == 4);
+    REQUIRE(solver.evalCnt == 4);
+    // the first evaluation is done for all particles
+    REQUIRE(solver.partialCnt == 3);
+    REQUIRE(timestepping.getTimeStep() == approx(1._f));
+
+    // all particles are advanced to the same time, velocities correspond to constant accelerations
+    ArrayView<const Vector> v = storage->getDt<Vector>(QuantityId::POSITION);
+    for (Size i = 0; i < 3; ++i) {
+        REQUIRE(v[i][Z] == approx(pow(4._f, Float(i))));
+    }
+
+    // quantities are only modified by evaluations where the particles are active
+    ArrayView<const Float> D = storage->getValue<Float>(QuantityId::DAMAGE);
+    REQUIRE(D[0] == 1._f);
+    REQUIRE(D[1] == 2._f);
+    REQUIRE(D[2] == 4._f);
+}
+
 /// \todo test timestepping of other quantities (first order and sanity check that zero-order quantities
 /// remain unchanged).
 
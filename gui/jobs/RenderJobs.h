@@ -71,6 +71,8 @@ struct AnimationFrame : public IStorageUserData {
     Array<IRenderOutput::Label> labels;
 
     virtual void remove(ArrayView<const Size> UNUSED(idxs)) override {}
+
+    virtual void reorder(ArrayView<const Size> UNUSED(order)) override {}
 };
 
 class AnimationJob : public IImageJob {
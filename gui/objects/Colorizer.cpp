@@ -324,7 +324,8 @@ void ComponentIdColorizer::initialize(const Storage& storage, const RefEnum ref)
 
     cached.r = current.clone();
 
-    const Size numComponents = Post::findComponents(storage, 2.5_f, connectivity, components);
+    SharedPtr<IScheduler> scheduler = Factory::getScheduler();
+    const Size numComponents = finder.find(*scheduler, storage, 2.5_f, connectivity, components);
 
     // sort by the smallest index in each component
     compIdxs.resize(numComponents);
@@ -897,6 +897,9 @@ class ComponentIdColorizer : public IdColorizerTemplate<ComponentIdColorizer> {
 private:
     Flags<Post::ComponentFlag> connectivity;
 
+    /// Reused between snapshots to avoid rebuilding the neighbor finder
+    Post::ComponentFinder finder;
+
     Array<Size> components;
     Array<Size> compIdxs;
 
@@ -138,7 +138,8 @@ void RayMarcher::initialize(const Storage& storage,
         BvhSphere& s = spheres.emplaceBack(cached.attractors[i].position, cached.attractors[i].radius);
         s.userData = particleCnt + i;
     }
-    bvh.build(std::move(spheres));
+    // particles usually move only slightly between frames, so try to re-use the hierarchy
+    bvh.refit(*scheduler, std::move(spheres));
 
     finder = Factory::getFinder(RunSettings::getDefaults());
     finder->build(*scheduler, cached.r);
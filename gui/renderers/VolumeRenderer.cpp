@@ -95,7 +95,7 @@ void VolumeRenderer::initialize(const Storage& storage, const IColorizer& colori
         spheres.push(sphere);
     }
 
-    bvh.build(std::move(spheres));
+    bvh.refit(*scheduler, std::move(spheres));
 
     cached.maxDistance = 0;
     for (const Attractor& a : storage.getAttractors()) {
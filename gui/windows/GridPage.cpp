@@ -170,7 +170,8 @@ public:
         : storage(storage) {
         const Flags<Post::ComponentFlag> flags =
             Post::ComponentFlag::OVERLAP | Post::ComponentFlag::SORT_BY_MASS;
-        maxIdx = Post::findComponents(storage, 2._f, flags, indices);
+        SharedPtr<IScheduler> scheduler = Factory::getScheduler(RunSettings::getDefaults());
+        maxIdx = Post::findComponents(*scheduler, storage, 2._f, flags, indices);
     }
 
     Storage getComponent(const Size idx) {
@@ -28,7 +28,7 @@ using namespace Sph;
 static Expected<Storage> parsePkdgravOutput(const Path& path) {
     Storage storage;
     Statistics stats;
-    PkdgravInput io;
+    PkdgravInput io(ThreadPool::getGlobalInstance());
     Outcome result = io.load(path, storage, stats);
     if (!result) {
         return makeUnexpected<Storage>(result.error());
@@ -196,7 +196,7 @@ int ssfToVelocity(const Path& filePath, const Path& outPath) {
     }
 
     // convert to system with center at LR
-    Array<Size> idxs = Post::findLargestComponent(storage, 2._f, EMPTY_FLAGS);
+    Array<Size> idxs = Post::findLargestComponent(*Factory::getScheduler(), storage, 2._f, EMPTY_FLAGS);
     ArrayView<const Float> m = storage.getValue<Float>(QuantityId::MASS);
     ArrayView<Vector> r, v, dv;
     tie(r, v, dv) = storage.getAll<Vector>(QuantityId::POSITION);
@@ -241,7 +241,7 @@ void ssfToVelDir(const Path& filePath, const Path& outPath) {
     }
 
     // convert to system with center at LR
-    Array<Size> idxs = Post::findLargestComponent(storage, 2._f, EMPTY_FLAGS);
+    Array<Size> idxs = Post::findLargestComponent(*Factory::getScheduler(), storage, 2._f, EMPTY_FLAGS);
     ArrayView<const Float> m = storage.getValue<Float>(QuantityId::MASS);
     ArrayView<Vector> r, v, dv;
     tie(r, v, dv) = storage.getAll<Vector>(QuantityId::POSITION);
@@ -668,8 +668,12 @@ void origComponents(const Path& lastDumpPath, const Path& firstDumpPath, const P
 
     // use last dump to find components
     Array<Size> components;
-    Post::findComponents(
-        lastDump, 2._f, Post::ComponentFlag::ESCAPE_VELOCITY | Post::ComponentFlag::SORT_BY_MASS, components);
+    SharedPtr<IScheduler> scheduler = Factory::getScheduler();
+    Post::findComponents(*scheduler,
+        lastDump,
+        2._f,
+        Post::ComponentFlag::ESCAPE_VELOCITY | Post::ComponentFlag::SORT_BY_MASS,
+        components);
 
     // "colorize" the flag quantity using the components
     SPH_ASSERT(firstDump.getParticleCnt() == components.size());
@@ -695,8 +699,9 @@ void extractLr(const Path& inputPath, const Path& outputPath) {
     }
 
     Array<Size> components;
+    SharedPtr<IScheduler> scheduler = Factory::getScheduler();
     const Size componentCnt =
-        Post::findComponents(storage, 1.5_f, Post::ComponentFlag::SORT_BY_MASS, components);
+        Post::findComponents(*scheduler, storage, 1.5_f, Post::ComponentFlag::SORT_BY_MASS, components);
     std::cout << "Component cnt = " << componentCnt << std::endl;
 
     Array<Size> toRemove;
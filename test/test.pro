@@ -19,16 +19,20 @@ INCLUDEPATH += ../core $$PREFIX/include/catch2
 
 SOURCES += \
     ../core/common/test/Traits.cpp \
+    ../core/gravity/test/AggregateSolver.cpp \
     ../core/gravity/test/BarnesHut.cpp \
     ../core/gravity/test/BruteForceGravity.cpp \
+    ../core/gravity/test/FastMultipole.cpp \
     ../core/gravity/test/Moments.cpp \
     ../core/gravity/test/NBodySolver.cpp \
     ../core/io/test/FileManager.cpp \
     ../core/io/test/FileSystem.cpp \
+    ../core/io/test/FloatCodec.cpp \
     ../core/io/test/Logger.cpp \
     ../core/io/test/Output.cpp \
     ../core/io/test/Path.cpp \
     ../core/io/test/Serializer.cpp \
+    ../core/io/test/TextIo.cpp \
     ../core/math/rng/test/Rng.cpp \
     ../core/math/rng/test/VectorRng.cpp \
     ../core/math/test/AffineMatrix.cpp \
@@ -52,8 +56,10 @@ SOURCES += \
     ../core/objects/containers/test/Queue.cpp \
     ../core/objects/containers/test/Tuple.cpp \
     ../core/objects/finders/test/BruteForceFinder.cpp \
+    ../core/objects/finders/test/ColoredGrid.cpp \
     ../core/objects/finders/test/Finders.cpp \
     ../core/objects/finders/test/IncrementalFinder.cpp \
+    ../core/objects/finders/test/NeighborList.cpp \
     ../core/objects/finders/test/Order.cpp \
     ../core/objects/finders/test/Bvh.cpp \
     ../core/objects/geometry/test/AntisymmetricTensor.cpp \
@@ -133,6 +139,7 @@ SOURCES += \
     ../core/sph/solvers/test/EquilbriumSolver.cpp \
     ../core/sph/solvers/test/GravitySolver.cpp \
     ../core/sph/solvers/test/Impact.cpp \
+    ../core/sph/solvers/test/PositionBasedSolver.cpp \
     ../core/sph/solvers/test/Solvers.cpp \
     ../core/sph/solvers/test/StandardSets.cpp \
     ../core/sph/solvers/test/AsymmetricSolver.cpp \
@@ -146,7 +153,9 @@ SOURCES += \
     ../core/system/test/Timer.cpp \
     ../core/thread/test/AtomicFloat.cpp \
     ../core/thread/test/CheckFunction.cpp \
+    ../core/thread/test/Numa.cpp \
     ../core/thread/test/Pool.cpp \
+    ../core/thread/test/WorkStealing.cpp \
     ../core/timestepping/test/TimeStepCriterion.cpp \
     ../core/timestepping/test/TimeStepping.cpp \
     main.cpp \